@@ -0,0 +1,49 @@
+//
+//  jr_bench_allocations.cpp
+//  JRImageEngine
+//
+//  Buffer memory obtained from the system per render. The first render fills
+//  JRBufferPool; from the second on, a steady-state render should allocate
+//  zero bytes and serve every tile and intermediate from idle blocks.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_allocations.cpp -o jr_bench_allocations
+//
+
+#include "jr_BufferPool.h"
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static const int kSize = 3000;
+static const int kFrames = 5;
+
+int main()
+{
+	std::vector<uint8_t> data(size_t(kSize) * kSize * 4);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = uint8_t((i * 7 + i / 4099) & 0xff);
+	}
+	JRImageRef image = JRImage::imageWithBitmapData(data, size_t(kSize) * 4, kSize, kSize, kJRFormatRGBA8);
+	image = image->applyingFilter("CIColorControls", { { kJRInputSaturationKey, 1.2 } });
+	image = image->applyingGaussianBlur(3.0)->applyingGaussianBlur(1.5);
+	image = image->applying(JRAffineTransformMakeScale(0.75, 0.75))->applyingFilter("CISepiaTone", {});
+	JRRect rect = image->extent();
+
+	std::shared_ptr<JRBufferPool> pool = JRBufferPool::sharedPool();
+	JRContextRef context = JRContext::context();
+	printf("%d x %d source, blur -> blur -> scale -> sepia\n", kSize, kSize);
+	printf("%6s %10s %12s %12s %10s %12s\n", "frame", "ms", "allocations", "new MB", "reuses", "idle MB");
+	for (int frame = 0; frame < kFrames; frame++) {
+		JRBufferPool::Statistics before = pool->statistics();
+		auto start = std::chrono::steady_clock::now();
+		context->createBitmap(image, rect);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		JRBufferPool::Statistics after = pool->statistics();
+		printf("%6d %10.1f %12zu %12.1f %10zu %12.1f\n", frame, ms, after.allocations - before.allocations,
+			   double(after.allocatedBytes - before.allocatedBytes) / (1 << 20), after.reuses - before.reuses,
+			   double(after.idleBytes) / (1 << 20));
+	}
+	return 0;
+}
@@ -0,0 +1,138 @@
+//
+//  jr_bench_budget.cpp
+//  JRImageEngine
+//
+//  A service under bursty load: 16 requests arrive at once on 16 threads and
+//  share one context, twelve small colour grades and four large blurs. It
+//  runs a few bursts without a budget, then with a JRRenderBudget. The report
+//  is p50 and p99 latency, the peak of live buffer memory, the idle pool
+//  memory left after the bursts, and the budget's queue and degradations. Before that, it prints the estimated peak of a
+//  few graphs next to the measured one, and renders a large blur under a
+//  budget too small for it. That render goes in bands and must match the
+//  render without a budget to one 8-bit step, as renderBands does.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_budget.cpp -o jr_bench_budget
+//
+
+#include "jr_BufferPool.h"
+#include "jr_ImageEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+static const size_t kSmallRequests = 12;
+static const size_t kLargeRequests = 4;
+static const int kBursts = 3;
+static const size_t kBudget = size_t(256) << 20;
+
+static JRImageRef JRSource(int width, int height)
+{
+	std::vector<uint8_t> data(size_t(width) * height * 4);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (i & 3) == 3 ? 255 : uint8_t((i * 13 + i / 7919) & 0xff);
+	}
+	return JRImage::imageWithBitmapData(std::move(data), size_t(width) * 4, width, height, kJRFormatRGBA8);
+}
+
+static JRImageRef JRGrade(const JRImageRef& source)
+{
+	return source->applyingFilter("CIColorControls", { { "inputSaturation", 1.2 } })
+		->applyingFilter("CISepiaTone", { { kJRInputIntensityKey, 0.3 } });
+}
+
+/// 模糊后叠在原图上: 原图有两个使用者, 会被物化
+static JRImageRef JRBlurOver(const JRImageRef& source)
+{
+	JRImageRef blurred = source->clampingToExtent()->applyingGaussianBlur(12.0)->cropping(source->extent());
+	JRImageRef graded = source->applyingFilter("CIExposureAdjust", { { kJRInputEVKey, 0.3 } });
+	return blurred->applyingFilter("CIMultiplyBlendMode", { { kJRInputBackgroundImageKey, graded } });
+}
+
+static size_t JRMegabytes(size_t bytes)
+{
+	return bytes >> 20;
+}
+
+int main()
+{
+	std::shared_ptr<JRBufferPool> pool = JRBufferPool::sharedPool();
+	JRImageRef small = JRSource(1024, 768);
+	JRImageRef large = JRSource(4096, 3072);
+
+	/// 估计与实测: 预算足够大时预留的就是估计值
+	printf("%-24s %12s %12s\n", "graph", "estimated", "measured");
+	const std::pair<const char*, JRImageRef> graphs[] = {
+		{ "grade 1024x768", JRGrade(small) },
+		{ "grade 4096x3072", JRGrade(large) },
+		{ "blur over 4096x3072", JRBlurOver(large) },
+	};
+	for (const auto& graph : graphs) {
+		JRContextOptions options;
+		options.renderBudget = std::make_shared<JRRenderBudget>(SIZE_MAX);
+		JRContextRef context = JRContext::context(options);
+		pool->purge();
+		pool->resetPeakLiveBytes();
+		context->createBitmap(graph.second, graph.second->extent());
+		printf("%-24s %9zu MB %9zu MB\n", graph.first, JRMegabytes(options.renderBudget->statistics().largestReservation),
+			   JRMegabytes(pool->statistics().peakLiveBytes));
+	}
+
+	/// 预算只有整幅渲染的一小部分: 改为条带, 与整幅渲染最多差 1
+	JRContextOptions tight;
+	tight.renderBudget = std::make_shared<JRRenderBudget>(size_t(96) << 20);
+	pool->purge();
+	pool->resetPeakLiveBytes();
+	auto banded = JRContext::context(tight)->createBitmap(JRBlurOver(large), large->extent());
+	size_t bandedPeak = pool->statistics().peakLiveBytes;
+	auto expected = JRContext::context()->createBitmap(JRBlurOver(large), large->extent());
+	int difference = 0;
+	for (size_t i = 0; i < expected->data.size(); i++) {
+		difference = std::max(difference, std::abs(int(expected->data[i]) - int(banded->data[i])));
+	}
+	JRRenderBudget::Statistics fitted = tight.renderBudget->statistics();
+	printf("\nbudget of %zu MB: %zu in bands, %zu with smaller tiles, %zu alone; peak %zu MB, max difference %d\n",
+		   JRMegabytes(tight.renderBudget->bytes()), fitted.bands, fitted.smallerTiles, fitted.exclusive, JRMegabytes(bandedPeak), difference);
+
+	printf("\n%zu requests per burst, %d bursts\n", kSmallRequests + kLargeRequests, kBursts);
+	printf("%-16s %10s %10s %10s %10s %8s %8s %8s\n", "", "p50", "p99", "peak live", "idle", "queued", "depth", "bands");
+	for (int budgeted = 0; budgeted < 2; budgeted++) {
+		JRContextOptions options;
+		if (budgeted) {
+			options.renderBudget = std::make_shared<JRRenderBudget>(kBudget);
+		}
+		JRContextRef context = JRContext::context(options);
+		pool->purge();
+		pool->resetPeakLiveBytes();
+		std::vector<double> latencies;
+		for (int burst = 0; burst < kBursts; burst++) {
+			std::vector<double> burstLatencies(kSmallRequests + kLargeRequests);
+			std::vector<std::thread> clients;
+			for (size_t i = 0; i < burstLatencies.size(); i++) {
+				clients.emplace_back([&, i]() {
+					bool isLarge = i % 4 == 3;
+					JRImageRef image = isLarge ? JRBlurOver(large) : JRGrade(small);
+					auto start = std::chrono::steady_clock::now();
+					context->createBitmap(image, image->extent());
+					burstLatencies[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+				});
+			}
+			for (std::thread& client : clients) {
+				client.join();
+			}
+			latencies.insert(latencies.end(), burstLatencies.begin(), burstLatencies.end());
+		}
+		std::sort(latencies.begin(), latencies.end());
+		double p50 = latencies[latencies.size() / 2];
+		double p99 = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+		JRRenderBudget::Statistics statistics = budgeted ? options.renderBudget->statistics() : JRRenderBudget::Statistics();
+		/// 有预算时空闲块也算在预算内
+		JRBufferPool::Statistics memory = pool->statistics();
+		printf("%-16s %8.0fms %8.0fms %7zu MB %7zu MB %8zu %8zu %8zu\n", budgeted ? "256 MB budget" : "no budget", p50, p99,
+			   JRMegabytes(memory.peakLiveBytes), JRMegabytes(memory.idleBytes), statistics.waited, statistics.peakQueueDepth, statistics.bands);
+	}
+	return difference <= 1 ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+//
+//  jr_bench_cache.cpp
+//  JRImageEngine
+//
+//  An interactive edit: the same chain is rebuilt every frame and only the
+//  last parameter changes. Without a cache every frame renders the whole
+//  chain; with JRContextOptions::cacheBudget the unchanged prefix is reused.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_cache.cpp -o jr_bench_cache
+//
+
+#include "jr_ImageEngine.h"
+#include "jr_RenderCache.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static const int kSize = 2048;
+static const int kFrames = 8;
+
+static JRImageRef JRMakeFrame(const JRImageRef& source, double intensity)
+{
+	JRImageRef image = source->applyingFilter("CIColorControls", { { kJRInputSaturationKey, 1.3 }, { kJRInputContrastKey, 1.1 } });
+	image = image->applyingGaussianBlur(4.0);
+	image = image->applyingFilter("CIExposureAdjust", { { kJRInputEVKey, 0.3 } });
+	return image->applyingFilter("CISepiaTone", { { kJRInputIntensityKey, intensity } });
+}
+
+static double JRRenderFrames(const JRContextRef& context, const JRImageRef& source, std::vector<uint8_t>& last)
+{
+	JRRect rect = JRRectMake(0, 0, kSize, kSize);
+	double total = 0;
+	for (int frame = 0; frame <= kFrames; frame++) {
+		JRImageRef image = JRMakeFrame(source, 0.1 * frame);
+		auto start = std::chrono::steady_clock::now();
+		std::shared_ptr<JRBitmap> bitmap = context->createBitmap(image, rect);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		/// 第 0 帧是冷启动, 不计入平均
+		if (frame == 0) {
+			printf("  first frame %8.1f ms\n", ms);
+		} else {
+			total += ms;
+		}
+		last = bitmap->data;
+	}
+	return total / kFrames;
+}
+
+int main()
+{
+	std::vector<uint8_t> data(size_t(kSize) * kSize * 4);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = uint8_t((i * 7 + i / 4099) & 0xff);
+	}
+	JRImageRef source = JRImage::imageWithBitmapData(data, size_t(kSize) * 4, kSize, kSize, kJRFormatRGBA8);
+	std::vector<uint8_t> uncachedPixels;
+	std::vector<uint8_t> cachedPixels;
+
+	printf("%d x %d, colour controls -> blur(4) -> exposure -> sepia(changing)\n", kSize, kSize);
+	printf("no cache\n");
+	double uncached = JRRenderFrames(JRContext::context(), source, uncachedPixels);
+	printf("  next frames %8.1f ms\n", uncached);
+
+	JRContextOptions options;
+	options.cacheBudget = size_t(512) << 20;
+	JRContextRef context = JRContext::context(options);
+	printf("cache budget %zu MB\n", options.cacheBudget >> 20);
+	double cached = JRRenderFrames(context, source, cachedPixels);
+	JRRenderCache::Statistics statistics = context->cache()->statistics();
+	printf("  next frames %8.1f ms (%.1fx), %zu hits, %zu misses, %zu MB\n", cached, uncached / cached,
+		   statistics.hits, statistics.misses, statistics.bytes >> 20);
+
+	int maximum = 0;
+	for (size_t i = 0; i < cachedPixels.size(); i++) {
+		maximum = std::max(maximum, std::abs(int(cachedPixels[i]) - int(uncachedPixels[i])));
+	}
+	printf("largest difference from uncached: %d/255\n", maximum);
+	return 0;
+}
@@ -0,0 +1,124 @@
+//
+//  jr_bench_colorcube.cpp
+//  JRImageEngine
+//
+//  A 10-filter colour grade rendered exactly (every stage per pixel, fused)
+//  and baked into a colour cube, next to a single CIColorInvert. The baked
+//  grade should cost about one cube lookup per pixel, whatever the length
+//  of the chain. It also applies a cube to pixels holding NaN and infinity,
+//  at the scalar level and at the best one, and fails unless both give the
+//  same result.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_colorcube.cpp -o jr_bench_colorcube
+//
+
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+static const int kSize = 2048;
+static const int kRuns = 5;
+
+static double JRBestMilliseconds(const JRContextRef& context, const JRImageRef& image, std::vector<uint8_t>& bitmap)
+{
+	double best = 1e9;
+	for (int run = 0; run < kRuns; run++) {
+		auto start = std::chrono::steady_clock::now();
+		context->render(image, bitmap.data(), size_t(kSize) * 4, { 0, 0, kSize, kSize }, kJRFormatRGBA8);
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+/// 非有限值: 每个通道轮流放 NaN 和 ±Inf, 像素数不是 8 的倍数, 向量主体和尾部都会经过
+static bool JRNonFiniteMatchesScalar()
+{
+	const int dimension = 17;
+	std::vector<float> cells(size_t(dimension) * dimension * dimension * 4);
+	for (size_t i = 0; i < cells.size(); i += 4) {
+		size_t cell = i / 4;
+		cells[i] = float(cell % dimension) / (dimension - 1);
+		cells[i + 1] = float(cell / dimension % dimension) / (dimension - 1);
+		cells[i + 2] = 1.0f - float(cell / (dimension * dimension)) / (dimension - 1);
+		cells[i + 3] = 1.0f;
+	}
+	std::shared_ptr<const JRColorCube> cube = JRColorCube::cubeWithData(dimension, std::move(cells));
+
+	const float specials[] = { std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+							   -std::numeric_limits<float>::infinity(), 0.25f, 2.0f, -0.5f };
+	std::vector<float> pixels;
+	for (int channel = 0; channel < 4; channel++) {
+		for (float special : specials) {
+			float pixel[4] = { 0.2f, 0.5f, 0.7f, 1.0f };
+			pixel[channel] = special;
+			pixels.insert(pixels.end(), pixel, pixel + 4);
+		}
+	}
+	pixels.insert(pixels.end(), { 0.1f, 0.2f, 0.3f, 0.5f, 0.4f, 0.4f, 0.4f, 0.4f, 0.0f, 0.0f, 0.0f, 0.0f });
+
+	JRSIMDLevel best = JRSIMDSupportedLevel();
+	std::vector<float> scalar = pixels, vector = pixels;
+	JRSIMDSetMaximumLevel(kJRSIMDLevelScalar);
+	cube->apply(scalar.data(), scalar.size() / 4);
+	JRSIMDSetMaximumLevel(best);
+	cube->apply(vector.data(), vector.size() / 4);
+
+	size_t mismatches = 0;
+	for (size_t i = 0; i < scalar.size(); i++) {
+		bool same = std::isnan(scalar[i]) ? std::isnan(vector[i]) : memcmp(&scalar[i], &vector[i], sizeof(float)) == 0;
+		mismatches += same ? 0 : 1;
+	}
+	printf("NaN / Inf pixels, %s against scalar: %zu mismatches\n", JRSIMDLevelName(best), mismatches);
+	return mismatches == 0;
+}
+
+int main()
+{
+	std::vector<uint8_t> data(size_t(kSize) * kSize * 4);
+	for (int y = 0; y < kSize; y++) {
+		for (int x = 0; x < kSize; x++) {
+			uint8_t* p = &data[(size_t(y) * kSize + x) * 4];
+			p[0] = uint8_t(x * 255 / kSize);
+			p[1] = uint8_t(y * 255 / kSize);
+			p[2] = uint8_t((x + y) * 127 / kSize);
+			p[3] = 255;
+		}
+	}
+	JRImageRef source = JRImage::imageWithBitmapData(data, size_t(kSize) * 4, kSize, kSize, kJRFormatRGBA8);
+	JRImageRef grade = source;
+	for (int i = 0; i < 10; i++) {
+		switch (i % 4) {
+			case 0: grade = grade->applyingFilter("CIColorControls", { { kJRInputContrastKey, 1.05 }, { kJRInputSaturationKey, 1.1 } }); break;
+			case 1: grade = grade->applyingFilter("CISepiaTone", { { kJRInputIntensityKey, 0.15 } }); break;
+			case 2: grade = grade->applyingFilter("CIExposureAdjust", { { kJRInputEVKey, 0.1 } }); break;
+			case 3: grade = grade->applyingFilter("CIColorInvert", {}); break;
+		}
+	}
+
+	JRContextOptions exactOptions;
+	exactOptions.bakesColorCubes = false;
+	JRContextRef exact = JRContext::context(exactOptions);
+	JRContextRef baked = JRContext::context();
+	std::vector<uint8_t> a(data.size()), b(data.size());
+	double pixels = double(kSize) * kSize;
+
+	printf("%d x %d, SIMD %s\n", kSize, kSize, JRSIMDLevelName(JRSIMDActiveLevel()));
+	double single = JRBestMilliseconds(exact, source->applyingFilter("CIColorInvert", {}), a);
+	double exactMs = JRBestMilliseconds(exact, grade, a);
+	double bakedMs = JRBestMilliseconds(baked, grade, b);
+	printf("%22s %8.1f ms %8.2f ns/px\n", "1 filter", single, single * 1e6 / pixels);
+	printf("%22s %8.1f ms %8.2f ns/px\n", "10 filters, exact", exactMs, exactMs * 1e6 / pixels);
+	printf("%22s %8.1f ms %8.2f ns/px\n", "10 filters, baked", bakedMs, bakedMs * 1e6 / pixels);
+
+	int maxError = 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		maxError = std::max(maxError, std::abs(int(a[i]) - int(b[i])));
+	}
+	printf("max difference %d / 255\n", maxError);
+	return JRNonFiniteMatchesScalar() ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+//
+//  jr_bench_colorspace.cpp
+//  JRImageEngine
+//
+//  Checks JRSRGBToLinear and JRLinearToSRGB against the exact transfer
+//  functions for every float from 2^-14 to 64 (smaller values fall on the
+//  linear segments), and checks that the SIMD kernels match the scalar
+//  code bit for bit. Then times the conversions against pow(), and a
+//  colour-managed render against the same recipe with managesColor off.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_colorspace.cpp -o jr_bench_colorspace
+//
+
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static const int kSize = 2048;
+static const int kRuns = 5;
+
+static double JRExactToLinear(double x)
+{
+	return x <= 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4);
+}
+
+static double JRExactToSRGB(double x)
+{
+	return x <= 0.0031308 ? x * 12.92 : 1.055 * std::pow(x, 1 / 2.4) - 0.055;
+}
+
+static float JRFloatWithBits(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, 4);
+	return value;
+}
+
+/* Runs 'row' over every float in [2^-14, 64] in RGB, 4096 pixels at a time,
+ * at the scalar level and at 'level'. Returns the largest relative error
+ * against 'exact', or -1 if the two levels differ. */
+static double JRMaximumError(void (*row)(float*, size_t), double (*exact)(double), JRSIMDLevel level)
+{
+	const uint32_t first = 0x38800000u, last = 0x42800000u;
+	std::vector<float> scalar(4096 * 4), vector(4096 * 4);
+	double maxError = 0;
+	for (uint32_t bits = first; bits <= last; ) {
+		size_t n = 0;
+		for (; n < 4096 * 3 && bits <= last; n++, bits++) {
+			scalar[n / 3 * 4 + n % 3] = JRFloatWithBits(bits);
+		}
+		size_t count = (n + 2) / 3;
+		vector = scalar;
+		JRSIMDSetMaximumLevel(kJRSIMDLevelScalar);
+		row(scalar.data(), count);
+		JRSIMDSetMaximumLevel(level);
+		row(vector.data(), count);
+		if (memcmp(scalar.data(), vector.data(), count * 4 * sizeof(float)) != 0) {
+			return -1;
+		}
+		for (size_t k = 0; k < n; k++) {
+			double reference = exact(JRFloatWithBits(bits - uint32_t(n - k)));
+			maxError = std::max(maxError, std::fabs(scalar[k / 3 * 4 + k % 3] - reference) / reference);
+		}
+	}
+	return maxError;
+}
+
+static void JRPowToLinearRow(float* p, size_t count)
+{
+	for (size_t i = 0; i < count; i++, p += 4) {
+		for (int c = 0; c < 3; c++) {
+			p[c] = p[c] <= 0.04045f ? p[c] / 12.92f : std::pow((p[c] + 0.055f) / 1.055f, 2.4f);
+		}
+	}
+}
+
+static double JRRowNanoseconds(void (*row)(float*, size_t))
+{
+	std::vector<float> pixels(size_t(kSize) * 4);
+	double best = 1e9;
+	for (int run = 0; run < kRuns; run++) {
+		for (size_t i = 0; i < pixels.size(); i++) {
+			pixels[i] = float(i % 1021) / 1020.0f;
+		}
+		auto start = std::chrono::steady_clock::now();
+		for (int y = 0; y < 256; y++) {
+			row(pixels.data(), kSize);
+		}
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		best = std::min(best, ns / (256.0 * kSize));
+	}
+	return best;
+}
+
+static double JRBestMilliseconds(const JRContextRef& context, const JRImageRef& image, std::vector<uint8_t>& bitmap)
+{
+	double best = 1e9;
+	for (int run = 0; run < kRuns; run++) {
+		auto start = std::chrono::steady_clock::now();
+		context->render(image, bitmap.data(), size_t(kSize) * 4, { 0, 0, kSize, kSize }, kJRFormatRGBA8);
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+int main()
+{
+	JRSIMDLevel supported = JRSIMDSupportedLevel();
+	printf("relative error, every float in [2^-14, 64], bound %g\n", double(kJRSRGBTransferMaximumError));
+	double a = JRMaximumError(JRSRGBToLinearRow, JRExactToLinear, supported);
+	double b = JRMaximumError(JRLinearToSRGBRow, JRExactToSRGB, supported);
+	if (a < 0 || b < 0) {
+		printf("%s differs from scalar\n", JRSIMDLevelName(supported));
+		return 1;
+	}
+	printf("%22s %.2e\n%22s %.2e\n", "to linear", a, "to sRGB", b);
+	JRSIMDSetMaximumLevel(supported);
+
+	printf("\nns per pixel, %s\n", JRSIMDLevelName(supported));
+	printf("%22s %8.2f\n", "pow()", JRRowNanoseconds(JRPowToLinearRow));
+	printf("%22s %8.2f\n", "JRSRGBToLinearRow", JRRowNanoseconds(JRSRGBToLinearRow));
+	printf("%22s %8.2f\n", "JRLinearToSRGBRow", JRRowNanoseconds(JRLinearToSRGBRow));
+
+	std::vector<uint8_t> data(size_t(kSize) * kSize * 4);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = i % 4 == 3 ? 255 : uint8_t(i * 7919 >> 3);
+	}
+	JRImageRef source = JRImage::imageWithBitmapData(data, size_t(kSize) * 4, kSize, kSize, kJRFormatRGBA8);
+	JRImageRef managed = source->matchedToWorkingSpace(kJRColorSpaceSRGB)
+		->applyingFilter("CIExposureAdjust", { { kJRInputEVKey, 0.5 } })
+		->matchedFromWorkingSpace(kJRColorSpaceSRGB);
+	JRImageRef roundTrip = source->matchedToWorkingSpace(kJRColorSpaceSRGB)->matchedFromWorkingSpace(kJRColorSpaceSRGB);
+
+	JRContextOptions unmanagedOptions;
+	unmanagedOptions.managesColor = false;
+	JRContextRef context = JRContext::context();
+	JRContextRef unmanaged = JRContext::context(unmanagedOptions);
+	std::vector<uint8_t> bitmap(data.size());
+	printf("\n%d x %d exposure render, ms\n", kSize, kSize);
+	printf("%22s %8.1f\n", "colour managed", JRBestMilliseconds(context, managed, bitmap));
+	printf("%22s %8.1f\n", "managesColor = false", JRBestMilliseconds(unmanaged, managed, bitmap));
+	printf("%22s %8.1f\n", "round trip (elided)", JRBestMilliseconds(context, roundTrip, bitmap));
+	printf("round trip identical: %s\n", bitmap == data ? "yes" : "no");
+	return 0;
+}
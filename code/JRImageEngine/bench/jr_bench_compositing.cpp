@@ -0,0 +1,154 @@
+//
+//  jr_bench_compositing.cpp
+//  JRImageEngine
+//
+//  Two parts. First, the spans of a few operators on translucent rows, where
+//  nothing can be skipped, with the scalar loops and with the best SIMD
+//  level. Second, a layout of 24 layers over a background: opaque photos
+//  and translucent panels with clear margins at random positions, the last
+//  few blended with a mode or a mask. It is rendered
+//  with JRCompositeKernel and with the same operators wrapped in a plain
+//  colour kernel, which renders every input of every layer everywhere. The
+//  two must match exactly.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_compositing.cpp -o jr_bench_compositing
+//
+
+#include "jr_Compositing.h"
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+static const int kWidth = 2048;
+static const int kHeight = 1536;
+static const int kLayers = 24;
+static const int kRenders = 5;
+
+/// 预乘的 float 像素; 'opaque' 为真时 alpha 全为 1, 否则边缘 16 像素透明
+static JRImageRef JRLayer(std::mt19937& random, int width, int height, bool opaque)
+{
+	std::uniform_real_distribution<float> unit(0, 1);
+	float alpha = opaque ? 1.0f : 0.3f + 0.6f * unit(random);
+	std::vector<float> pixels(size_t(width) * height * 4);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			float* p = &pixels[(size_t(y) * width + x) * 4];
+			bool margin = !opaque && (x < 16 || y < 16 || x >= width - 16 || y >= height - 16);
+			float a = margin ? 0.0f : alpha;
+			p[0] = unit(random) * a;
+			p[1] = unit(random) * a;
+			p[2] = unit(random) * a;
+			p[3] = a;
+		}
+	}
+	std::vector<uint8_t> data(pixels.size() * sizeof(float));
+	std::memcpy(data.data(), pixels.data(), data.size());
+	return JRImage::imageWithBitmapData(std::move(data), size_t(width) * 16, width, height, kJRFormatRGBAf);
+}
+
+/// 同样的运算, 但作为普通的颜色 kernel: 不统计覆盖, 也不跳过任何输入
+class JRPlainCompositeKernel : public JRColorKernel {
+public:
+	explicit JRPlainCompositeKernel(const std::shared_ptr<const JRCompositeKernel>& kernel)
+	: JRColorKernel(kernel->name(), nullptr), _kernel(kernel)
+	{
+	}
+
+	void apply(float* pixels, const float* const* inputs, size_t count, const float* args) const override
+	{
+		_kernel->apply(pixels, inputs, count, args);
+	}
+
+private:
+	std::shared_ptr<const JRCompositeKernel> _kernel;
+};
+
+static double JRTime(const JRContext& context, const JRImageRef& image)
+{
+	double best = INFINITY;
+	for (int i = 0; i < kRenders; i++) {
+		auto start = std::chrono::steady_clock::now();
+		context.createBitmap(image, JRRectMake(0, 0, kWidth, kHeight));
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+int main()
+{
+	std::mt19937 random(42);
+	JRContextRef context = JRContext::context(JRContextOptions());
+
+	/// 直接调用 kernel, 每行先复制图像: 量的是 span 本身而不是渲染
+	std::vector<std::vector<float>> rows;
+	for (int i = 0; i < 3; i++) {
+		rows.emplace_back(size_t(kWidth) * 4);
+		for (size_t k = 0; k < rows[i].size(); k += 4) {
+			float a = (k / 4 + i) % 7 == 0 ? 1.0f : 0.25f + 0.125f * float((k / 4 + i) % 5);
+			float* p = &rows[i][k];
+			p[0] = a * float((k * 7 + size_t(i)) % 11) / 10;
+			p[1] = a * float((k * 3 + size_t(i)) % 13) / 12;
+			p[2] = a * float((k * 5 + size_t(i)) % 17) / 16;
+			p[3] = a;
+		}
+	}
+	std::vector<float> pixels(rows[0].size());
+	const float* inputs[] = { rows[1].data(), rows[2].data() };
+	const JRCompositeOperation operations[] = { kJRCompositeSourceOver, kJRCompositeMultiplyBlend, kJRCompositeOverlayBlend,
+												kJRCompositeDifferenceBlend, kJRCompositeBlendWithMask };
+	JRSIMDLevel best = JRSIMDActiveLevel();
+	printf("spans of %d pixels, %d rows, best of %d\n", kWidth, kHeight, kRenders);
+	printf("%-24s %12s %12s\n", "operator", "scalar", JRSIMDLevelName(best));
+	for (JRCompositeOperation operation : operations) {
+		std::shared_ptr<const JRCompositeKernel> kernel = JRCompositeKernel::kernel(operation);
+		double rates[2];
+		for (int level = 0; level < 2; level++) {
+			JRSIMDSetMaximumLevel(level == 0 ? kJRSIMDLevelScalar : best);
+			double seconds = INFINITY;
+			for (int r = 0; r < kRenders; r++) {
+				auto start = std::chrono::steady_clock::now();
+				for (int y = 0; y < kHeight; y++) {
+					std::memcpy(pixels.data(), rows[0].data(), pixels.size() * sizeof(float));
+					kernel->apply(pixels.data(), inputs, size_t(kWidth), nullptr);
+				}
+				seconds = std::min(seconds, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+			}
+			rates[level] = double(kWidth) * kHeight / seconds / 1e6;
+		}
+		printf("%-24s %7.0f Mpx/s %7.0f Mpx/s\n", kernel->name().c_str(), rates[0], rates[1]);
+	}
+	JRSIMDSetMaximumLevel(best);
+
+	/// 一半是不透明的照片, 其余是带透明边缘的半透明面板; 最后几层用混合模式或蒙版
+	JRImageRef layout = JRLayer(random, kWidth, kHeight, true);
+	JRImageRef plain = layout;
+	for (int i = 0; i < kLayers; i++) {
+		int width = 200 + int(random() % 800);
+		int height = 150 + int(random() % 600);
+		JRImageRef layer = JRLayer(random, width, height, i % 2 == 0)->applying(
+			JRAffineTransformMakeTranslation(double(random() % (kWidth - 100)) - 100, double(random() % (kHeight - 100)) - 100));
+		JRCompositeOperation operation = i >= kLayers - 4 ? operations[1 + i % 4] : kJRCompositeSourceOver;
+		std::vector<JRImageRef> inputs = { layer, layout };
+		std::vector<JRImageRef> plainInputs = { layer, plain };
+		if (operation == kJRCompositeBlendWithMask) {
+			JRImageRef layerMask = JRLayer(random, width, height, false)->applying(JRAffineTransformMakeTranslation(layer->extent().x, layer->extent().y));
+			inputs.push_back(layerMask);
+			plainInputs.push_back(layerMask);
+		}
+		std::shared_ptr<const JRCompositeKernel> kernel = JRCompositeKernel::kernel(operation);
+		layout = JRImage::imageWithKernel(kernel, inputs, {});
+		plain = JRImage::imageWithKernel(std::make_shared<JRPlainCompositeKernel>(kernel), plainInputs, {});
+	}
+	JRRect rect = JRRectMake(0, 0, kWidth, kHeight);
+	bool identical = context->createBitmap(layout, rect, kJRFormatRGBAf)->data == context->createBitmap(plain, rect, kJRFormatRGBAf)->data;
+	double plainMs = JRTime(*context, plain);
+	double layoutMs = JRTime(*context, layout);
+	printf("\n%d layers, %s\n", kLayers, identical ? "identical" : "DIFFERENT");
+	printf("%-24s %7.1f ms\n", "every input rendered", plainMs);
+	printf("%-24s %7.1f ms\n", "coverage shortcuts", layoutMs);
+	return identical ? 0 : 1;
+}
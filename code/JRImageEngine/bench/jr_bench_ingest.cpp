@@ -0,0 +1,87 @@
+//
+//  jr_bench_ingest.cpp
+//  JRImageEngine
+//
+//  Cost of getting a file into the engine. Reading it into a vector for
+//  imageWithBitmapData copies every byte before the first tile runs;
+//  imageWithContentsOfFile maps it and tiles read only what they touch. A
+//  small crop should be almost free when mapped, and a full render should
+//  cost no more than with the copy.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_ingest.cpp -o jr_bench_ingest
+//
+
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static double JRMilliseconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Writes a width x height RGBA PAM file and returns the offset of its pixels. */
+static size_t JRWritePAM(const std::string& path, int width, int height)
+{
+	std::string header = "P7\nWIDTH " + std::to_string(width) + "\nHEIGHT " + std::to_string(height)
+		+ "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+	FILE* file = fopen(path.c_str(), "wb");
+	fwrite(header.data(), 1, header.size(), file);
+	std::vector<uint8_t> row(size_t(width) * 4);
+	for (int y = 0; y < height; y++) {
+		for (size_t i = 0; i < row.size(); i++) {
+			row[i] = (i & 3) == 3 ? 255 : uint8_t((i * 7 + size_t(y) * 3) & 0xff);
+		}
+		fwrite(row.data(), 1, row.size(), file);
+	}
+	fclose(file);
+	return header.size();
+}
+
+static JRImageRef JRLoadByCopy(const std::string& path, size_t offset, int width, int height)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	std::vector<uint8_t> data(size_t(width) * height * 4);
+	fseek(file, long(offset), SEEK_SET);
+	size_t read = fread(data.data(), 1, data.size(), file);
+	fclose(file);
+	if (read != data.size()) {
+		return nullptr;
+	}
+	return JRImage::imageWithBitmapData(std::move(data), size_t(width) * 4, width, height, kJRFormatRGBA8);
+}
+
+int main(int argc, char* argv[])
+{
+	int width = argc > 1 ? atoi(argv[1]) : 8000;
+	int height = argc > 2 ? atoi(argv[2]) : 6000;
+	std::string path = argc > 3 ? argv[3] : "/tmp/jr_bench_ingest.pam";
+	size_t offset = JRWritePAM(path, width, height);
+	JRContextRef context = JRContext::context();
+	JRRect crop = JRRectMake(width / 2, height / 2, 512, 512);
+	printf("%d x %d RGBA PAM (%.0f MB)\n", width, height, double(width) * height * 4 / (1 << 20));
+	printf("%8s %12s %14s %14s\n", "ingest", "load ms", "512 crop ms", "full sepia ms");
+
+	for (int mapped = 0; mapped < 2; mapped++) {
+		auto start = std::chrono::steady_clock::now();
+		JRImageRef image = mapped ? JRImage::imageWithContentsOfFile(path) : JRLoadByCopy(path, offset, width, height);
+		double load = JRMilliseconds(start);
+		if (!image) {
+			printf("failed to load %s\n", path.c_str());
+			return 1;
+		}
+		start = std::chrono::steady_clock::now();
+		context->createBitmap(image->cropping(crop), crop);
+		double cropped = JRMilliseconds(start);
+		start = std::chrono::steady_clock::now();
+		context->createBitmap(image->applyingFilter("CISepiaTone", {}), image->extent());
+		double full = JRMilliseconds(start);
+		printf("%8s %12.1f %14.1f %14.1f\n", mapped ? "mmap" : "copy", load, cropped, full);
+	}
+	remove(path.c_str());
+	return 0;
+}
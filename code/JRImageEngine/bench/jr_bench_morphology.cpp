@@ -0,0 +1,164 @@
+//
+//  jr_bench_morphology.cpp
+//  JRImageEngine
+//
+//  Renders CIMorphologyRectangleMinimum, CIMorphologyRectangleMaximum and
+//  CIMedianFilter over a 12 MP mask at radii from 1 to 60. The time should
+//  stay flat as the radius grows. For comparison, it also times a naive
+//  dilation that scans the whole square, on a 512 x 512 crop. The naive
+//  minimum, maximum and median are the reference: the bench fails unless
+//  all three filters match them exactly.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_morphology.cpp -o jr_bench_morphology
+//
+
+#include "jr_ImageEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static const int kWidth = 4000;
+static const int kHeight = 3000;
+
+/// 软边的圆形蒙版加噪点, 像抠像得到的遮罩
+static JRImageRef JRTestMask()
+{
+	std::vector<uint8_t> data(size_t(kWidth) * kHeight * 4);
+	uint32_t state = 12345;
+	for (int y = 0; y < kHeight; y++) {
+		uint8_t* p = data.data() + size_t(y) * kWidth * 4;
+		for (int x = 0; x < kWidth; x++, p += 4) {
+			state = state * 1664525u + 1013904223u;
+			double d = std::hypot(x - kWidth * 0.5, y - kHeight * 0.5) / (kHeight * 0.35);
+			int value = int(std::min(std::max((1.2 - d) * 5, 0.0), 1.0) * 255);
+			if ((state >> 24) < 8) {
+				value = 255 - value;
+			}
+			p[0] = p[1] = p[2] = p[3] = uint8_t(value);
+		}
+	}
+	return JRImage::imageWithBitmapData(std::move(data), size_t(kWidth) * 4, kWidth, kHeight, kJRFormatRGBA8);
+}
+
+static double JRTime(const JRContext& context, const JRImageRef& image, const JRIRect& bounds)
+{
+	double best = INFINITY;
+	for (int i = 0; i < 3; i++) {
+		auto start = std::chrono::steady_clock::now();
+		JRBuffer buffer = context.render(image, bounds);
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+static JRImageRef JRFiltered(const char* name, const JRImageRef& mask, int radius)
+{
+	JRFilterRef filter = JRFilter::filterWithName(name);
+	filter->setValue(mask, kJRInputImageKey);
+	if (std::string(name) == "CIMedianFilter") {
+		filter->setValue(double(radius), kJRInputRadiusKey);
+	} else {
+		filter->setValue(double(2 * radius + 1), kJRInputWidthKey);
+		filter->setValue(double(2 * radius + 1), "inputHeight");
+	}
+	return filter->outputImage();
+}
+
+enum JRNaiveOperation {
+	kJRNaiveMinimum,
+	kJRNaiveMaximum,
+	kJRNaiveMedian,
+};
+
+/// 逐个扫描整个方形. 中值与 JRMedianKernel 一样先量化到 256 级
+static JRBuffer JRNaive(const JRBuffer& input, const JRIRect& crop, int radius, JRNaiveOperation operation)
+{
+	JRBuffer output = JRBuffer::bufferWithRect(crop);
+	std::vector<int> bins;
+	for (int y = crop.y; y < crop.maxY(); y++) {
+		for (int x = crop.x; x < crop.maxX(); x++) {
+			float* o = output.pixelAt(x, y);
+			for (int c = 0; c < 4; c++) {
+				float m = input.pixelAt(x, y)[c];
+				bins.clear();
+				for (int j = -radius; j <= radius; j++) {
+					for (int i = -radius; i <= radius; i++) {
+						float v = input.pixelAt(x + i, y + j)[c];
+						if (operation == kJRNaiveMinimum) {
+							m = std::min(m, v);
+						} else if (operation == kJRNaiveMaximum) {
+							m = std::max(m, v);
+						} else {
+							float bin = v * 255.0f + 0.5f;
+							bins.push_back(bin <= 0 ? 0 : bin >= 255 ? 255 : int(bin));
+						}
+					}
+				}
+				if (operation == kJRNaiveMedian) {
+					std::nth_element(bins.begin(), bins.begin() + bins.size() / 2, bins.end());
+					m = float(bins[bins.size() / 2]) * (1.0f / 255.0f);
+				}
+				o[c] = m;
+			}
+		}
+	}
+	return output;
+}
+
+static size_t JRMismatches(const JRBuffer& expected, const JRBuffer& actual)
+{
+	const JRIRect& rect = expected.rect();
+	size_t mismatches = 0;
+	for (int y = rect.y; y < rect.maxY(); y++) {
+		for (int x = rect.x; x < rect.maxX(); x++) {
+			for (int c = 0; c < 4; c++) {
+				mismatches += expected.pixelAt(x, y)[c] == actual.pixelAt(x, y)[c] ? 0 : 1;
+			}
+		}
+	}
+	return mismatches;
+}
+
+int main()
+{
+	JRImageRef mask = JRTestMask();
+	JRContextRef context = JRContext::context();
+	const JRIRect bounds = { 0, 0, kWidth, kHeight };
+	printf("%d x %d (%.1f MP), ms per render\n", kWidth, kHeight, double(kWidth) * kHeight / 1e6);
+	printf("%8s %10s %10s %10s\n", "radius", "minimum", "maximum", "median");
+	for (int radius : { 1, 5, 15, 30, 60 }) {
+		printf("%8d %10.1f %10.1f %10.1f\n", radius,
+			   JRTime(*context, JRFiltered("CIMorphologyRectangleMinimum", mask, radius), bounds),
+			   JRTime(*context, JRFiltered("CIMorphologyRectangleMaximum", mask, radius), bounds),
+			   JRTime(*context, JRFiltered("CIMedianFilter", mask, radius), bounds));
+	}
+
+	/// 与逐个扫描的结果比较, 在软边和噪点上, 必须完全相同
+	const char* names[] = { "CIMorphologyRectangleMinimum", "CIMorphologyRectangleMaximum", "CIMedianFilter" };
+	const JRIRect check = { 1000, 1000, 128, 128 };
+	size_t mismatches = 0;
+	for (int radius : { 1, 5, 30 }) {
+		JRBuffer input = context->render(mask, JRIRectInset(check, -radius, -radius));
+		for (int operation = kJRNaiveMinimum; operation <= kJRNaiveMedian; operation++) {
+			JRBuffer expected = JRNaive(input, check, radius, JRNaiveOperation(operation));
+			mismatches += JRMismatches(expected, context->render(JRFiltered(names[operation], mask, radius), check));
+		}
+	}
+	printf("128 x 128 minimum, maximum and median at radii 1, 5 and 30 against naive: %zu mismatches\n", mismatches);
+
+	/// 逐个扫描整个方形的膨胀, 只算 512 x 512
+	const int radius = 30;
+	const JRIRect crop = { 1000, 1000, 512, 512 };
+	JRBuffer input = context->render(mask, JRIRectInset(crop, -radius, -radius));
+	auto start = std::chrono::steady_clock::now();
+	JRBuffer naive = JRNaive(input, crop, radius, kJRNaiveMaximum);
+	double naiveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	JRImageRef dilated = JRFiltered("CIMorphologyRectangleMaximum", mask, radius);
+	double fastMs = JRTime(*context, dilated, crop);
+	mismatches += JRMismatches(naive, context->render(dilated, crop));
+	printf("512 x 512 maximum at radius %d: naive %.1f ms, van Herk %.1f ms\n", radius, naiveMs, fastMs);
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+//
+//  jr_bench_pipeline.cpp
+//  JRImageEngine
+//
+//  Thumbnail throughput. The one-at-a-time path decodes an image, builds the
+//  filter chain by name, renders it and encodes the result, one image after
+//  another. The pipeline path compiles the chain once with JRPipeline and
+//  overlaps decoding, rendering and encoding with processBatch. Both
+//  produce the same bitmaps; the report is images per second.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_pipeline.cpp -o jr_bench_pipeline
+//
+
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static const int kWidth = 640;
+static const int kHeight = 480;
+
+/* Stands in for a JPEG decode: produces the pixels of image 'index'. */
+static JRImageRef JRDecode(size_t index)
+{
+	std::vector<uint8_t> data(size_t(kWidth) * kHeight * 4);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (i & 3) == 3 ? 255 : uint8_t((i * 5 + index * 11 + i / 2557) & 0xff);
+	}
+	return JRImage::imageWithBitmapData(std::move(data), size_t(kWidth) * 4, kWidth, kHeight, kJRFormatRGBA8);
+}
+
+/* Stands in for an encoder: a checksum over every byte. */
+static uint64_t JREncode(const std::shared_ptr<JRBitmap>& bitmap)
+{
+	uint64_t sum = 0;
+	for (uint8_t byte : bitmap->data) {
+		sum = sum * 31 + byte;
+	}
+	return sum;
+}
+
+static const std::vector<std::pair<std::string, JRFilterParameters>>& JRThumbnailFilters()
+{
+	static std::vector<std::pair<std::string, JRFilterParameters>> filters = {
+		{ "CIColorControls", { { kJRInputSaturationKey, 1.1 }, { kJRInputContrastKey, 1.05 } } },
+		{ "CISepiaTone", { { kJRInputIntensityKey, 0.3 } } },
+		{ "CIGaussianBlur", { { kJRInputRadiusKey, 1.5 } } },
+		{ "CIAffineTransform", { { kJRInputTransformKey, JRAffineTransformMakeScale(0.25, 0.25) } } },
+		{ "CICrop", { { "inputRectangle", JRRectMake(0, 0, kWidth / 4, kHeight / 4) } } },
+	};
+	return filters;
+}
+
+static double JRSeconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	size_t count = argc > 1 ? size_t(atoi(argv[1])) : 500;
+	printf("%zu images, %d x %d -> %d x %d\n", count, kWidth, kHeight, kWidth / 4, kHeight / 4);
+
+	JRContextRef context = JRContext::context();
+	uint64_t serialSum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < count; i++) {
+		JRImageRef image = JRDecode(i);
+		for (const std::pair<std::string, JRFilterParameters>& filter : JRThumbnailFilters()) {
+			image = image->applyingFilter(filter.first, filter.second);
+		}
+		serialSum += JREncode(context->createBitmap(image, image->extent()));
+	}
+	double serial = JRSeconds(start);
+
+	JRPipelineRef pipeline = JRPipeline::pipelineWithFilters(JRThumbnailFilters());
+	uint64_t pipelineSum = 0;
+	start = std::chrono::steady_clock::now();
+	pipeline->processBatch(count, JRDecode, [&](size_t, const std::shared_ptr<JRBitmap>& bitmap) {
+		pipelineSum += JREncode(bitmap);
+	});
+	double pipelined = JRSeconds(start);
+
+	printf("%14s %10.1f images/s\n", "one at a time", double(count) / serial);
+	printf("%14s %10.1f images/s\n", "pipeline", double(count) / pipelined);
+	printf("outputs %s\n", serialSum == pipelineSum ? "match" : "DIFFER");
+	return 0;
+}
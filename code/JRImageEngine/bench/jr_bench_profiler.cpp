@@ -0,0 +1,79 @@
+//
+//  jr_bench_profiler.cpp
+//  JRImageEngine
+//
+//  Renders a 12-stage chain on a 2048 x 1536 image with and without a
+//  JRProfiler. Without one the renders should take the same time as before
+//  the profiler existed. With one, the report shows which stage costs the
+//  most. Pass a path to also write the Chrome trace there.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_profiler.cpp -o jr_bench_profiler
+//
+
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+static const int kWidth = 2048;
+static const int kHeight = 1536;
+static const int kRenders = 5;
+
+static JRImageRef JRTestImage()
+{
+	std::vector<uint8_t> data(size_t(kWidth) * kHeight * 4);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (i & 3) == 3 ? 255 : uint8_t((i * 7 + i / 8191) & 0xff);
+	}
+	return JRImage::imageWithBitmapData(std::move(data), size_t(kWidth) * 4, kWidth, kHeight, kJRFormatRGBA8);
+}
+
+/// 12 个滤镜, 其中颜色滤镜会被融合
+static JRImageRef JRTwelveStages(const JRImageRef& image)
+{
+	return image->applyingFilter("CISepiaTone", { { kJRInputIntensityKey, 0.6 } })
+		->applyingFilter("CIExposureAdjust", { { kJRInputEVKey, 0.3 } })
+		->applyingFilter("CIGaussianBlur", { { kJRInputRadiusKey, 4.0 } })
+		->applyingFilter("CIColorControls", { { "inputSaturation", 1.2 } })
+		->applyingFilter("CIAffineTransform", { { kJRInputTransformKey, JRAffineTransformMakeRotation(0.05) } })
+		->applyingFilter("CICrop", { { "inputRectangle", JRRectMake(0, 0, kWidth, kHeight) } })
+		->applyingFilter("CIMorphologyRectangleMaximum", { { kJRInputWidthKey, 3.0 }, { "inputHeight", 3.0 } })
+		->applyingFilter("CIColorInvert", {})
+		->applyingFilter("CIMedianFilter", {})
+		->applyingFilter("CIColorInvert", {})
+		->applyingFilter("CIGaussianBlur", { { kJRInputRadiusKey, 12.0 } })
+		->applyingFilter("CIExposureAdjust", { { kJRInputEVKey, -0.3 } });
+}
+
+static double JRTime(const JRContext& context, const JRImageRef& image)
+{
+	double best = INFINITY;
+	for (int i = 0; i < kRenders; i++) {
+		auto start = std::chrono::steady_clock::now();
+		context.createBitmap(image, JRRectMake(0, 0, kWidth, kHeight));
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+int main(int argc, char* argv[])
+{
+	JRImageRef image = JRTwelveStages(JRTestImage());
+	JRContextOptions options;
+	JRContextRef plain = JRContext::context(options);
+	options.profiler = std::make_shared<JRProfiler>();
+	JRContextRef profiled = JRContext::context(options);
+
+	double plainMs = JRTime(*plain, image);
+	double profiledMs = JRTime(*profiled, image);
+	printf("%d x %d, 12 stages, best of %d\n", kWidth, kHeight, kRenders);
+	printf("%-20s %8.1f ms\n", "no profiler", plainMs);
+	printf("%-20s %8.1f ms\n", "profiler", profiledMs);
+	printf("\n%s", options.profiler->report().c_str());
+	if (argc > 1 && !options.profiler->writeChromeTrace(argv[1])) {
+		fprintf(stderr, "cannot write %s\n", argv[1]);
+		return 1;
+	}
+	return 0;
+}
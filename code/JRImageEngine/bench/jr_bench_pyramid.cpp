@@ -0,0 +1,92 @@
+//
+//  jr_bench_pyramid.cpp
+//  JRImageEngine
+//
+//  Renders previews of a 24 MP photo (exposure, then a Gaussian blur) at
+//  several sizes, from the full source and through JRContextOptions::
+//  pyramidBudget. Prints the time of each, the first pyramid render that
+//  builds the level, and the largest difference between the two results.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_pyramid.cpp -o jr_bench_pyramid
+//
+
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+static const int kWidth = 6000;
+static const int kHeight = 4000;
+static const double kSigma = 8;
+
+static JRImageRef JRTestImage()
+{
+	std::vector<uint8_t> data(size_t(kWidth) * kHeight * 4);
+	for (int y = 0; y < kHeight; y++) {
+		uint8_t* p = data.data() + size_t(y) * kWidth * 4;
+		for (int x = 0; x < kWidth; x++, p += 4) {
+			p[0] = uint8_t(x * 255 / kWidth);
+			p[1] = uint8_t(y * 255 / kHeight);
+			p[2] = uint8_t(((x / 64 + y / 64) & 1) * 200 + 20);
+			p[3] = 255;
+		}
+	}
+	return JRImage::imageWithBitmapData(std::move(data), size_t(kWidth) * 4, kWidth, kHeight, kJRFormatRGBA8);
+}
+
+static JRImageRef JRRecipe(const JRImageRef& source)
+{
+	JRFilterRef exposure = JRFilter::filterWithName("CIExposureAdjust");
+	exposure->setValue(source, kJRInputImageKey);
+	exposure->setValue(0.5, "inputEV");
+	return exposure->outputImage()->applyingGaussianBlur(kSigma);
+}
+
+static double JRMilliseconds(const std::function<void()>& block)
+{
+	auto start = std::chrono::steady_clock::now();
+	block();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+	JRImageRef source = JRTestImage();
+	JRRect extent = source->extent();
+	JRContextRef direct = JRContext::context();
+	JRContextOptions options;
+	options.pyramidBudget = 256 << 20;
+	JRContextRef pyramid = JRContext::context(options);
+
+	printf("%d x %d source, exposure + blur sigma %g\n", kWidth, kHeight, kSigma);
+	printf("%12s %12s %12s %12s %10s\n", "preview", "direct ms", "first ms", "pyramid ms", "max diff");
+	for (int width : { 1500, 750, 375 }) {
+		int height = width * kHeight / kWidth;
+		JRImageRef image = JRRecipe(source);
+		std::shared_ptr<JRBitmap> a, b;
+		double directMs = INFINITY, pyramidMs = INFINITY;
+		for (int i = 0; i < 3; i++) {
+			directMs = std::min(directMs, JRMilliseconds([&] { a = direct->createBitmap(image, extent, width, height); }));
+		}
+		double firstMs = JRMilliseconds([&] { b = pyramid->createBitmap(image, extent, width, height); });
+		for (int i = 0; i < 3; i++) {
+			pyramidMs = std::min(pyramidMs, JRMilliseconds([&] { b = pyramid->createBitmap(image, extent, width, height); }));
+		}
+		/// 四周 3 sigma 以内是模糊的边缘, 两种算法对边缘的处理不同
+		int margin = int(std::ceil(3 * kSigma * width / kWidth)) + 1;
+		int diff = 0;
+		for (int y = margin; y < height - margin; y++) {
+			for (int x = margin * 4; x < (width - margin) * 4; x++) {
+				size_t i = size_t(y) * a->bytesPerRow + size_t(x);
+				diff = std::max(diff, std::abs(int(a->data[i]) - int(b->data[i])));
+			}
+		}
+		printf("%5d x %-5d %12.1f %12.1f %12.1f %10d\n", width, height, directMs, firstMs, pyramidMs, diff);
+	}
+	JRPyramidCache::Statistics statistics = pyramid->pyramids()->statistics();
+	printf("pyramid: %zu levels, %.1f MB, %zu builds, %zu hits\n", statistics.levels, statistics.bytes / 1e6,
+		   statistics.builds, statistics.hits);
+	return 0;
+}
@@ -0,0 +1,104 @@
+//
+//  jr_bench_reduction.cpp
+//  JRImageEngine
+//
+//  Analyses a 50 MP photo-sized image with JRImageStatistics: every pixel,
+//  then sampled at a few error bounds. Prints the time of each, the largest
+//  percentile error of the sampled results against the exhaustive one, and
+//  checks that the SIMD and scalar histograms are identical.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_reduction.cpp -o jr_bench_reduction
+//
+
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+static const int kWidth = 8640;
+static const int kHeight = 5760;
+
+/// 渐变加噪声, 直方图不集中在少数几个 bin
+static JRImageRef JRTestImage()
+{
+	std::vector<uint8_t> data(size_t(kWidth) * kHeight * 4);
+	uint32_t state = 12345;
+	for (int y = 0; y < kHeight; y++) {
+		uint8_t* p = data.data() + size_t(y) * kWidth * 4;
+		for (int x = 0; x < kWidth; x++, p += 4) {
+			state = state * 1664525u + 1013904223u;
+			int noise = int(state >> 26) - 32;
+			int base = (x * 255 / kWidth + y * 255 / kHeight) / 2;
+			p[0] = uint8_t(std::min(std::max(base + noise, 0), 255));
+			p[1] = uint8_t(std::min(std::max(255 - base + noise / 2, 0), 255));
+			p[2] = uint8_t(std::min(std::max(base * base / 255 + noise, 0), 255));
+			p[3] = 255;
+		}
+	}
+	return JRImage::imageWithBitmapData(std::move(data), size_t(kWidth) * 4, kWidth, kHeight, kJRFormatRGBA8);
+}
+
+static JRImageStatisticsRef JRAnalyse(const JRImageRef& image, const JRContext& context, double maximumError, double* ms)
+{
+	JRReductionOptions options;
+	options.maximumError = maximumError;
+	*ms = INFINITY;
+	JRImageStatisticsRef statistics;
+	for (int i = 0; i < 3; i++) {
+		auto start = std::chrono::steady_clock::now();
+		statistics = JRImageStatistics::statisticsWithImage(image, { 0, 0, kWidth, kHeight }, context, options);
+		*ms = std::min(*ms, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return statistics;
+}
+
+/// 抽样结果的分布函数与精确结果的最大差距 (以像素比例计)
+static double JRRankError(const JRImageStatistics& exact, const JRImageStatistics& sampled)
+{
+	double error = 0;
+	for (int c = 0; c < kJRReductionChannelCount; c++) {
+		const std::vector<uint64_t>& a = exact.histogram(JRReductionChannel(c));
+		const std::vector<uint64_t>& b = sampled.histogram(JRReductionChannel(c));
+		double ca = 0, cb = 0;
+		for (size_t i = 0; i < a.size(); i++) {
+			ca += double(a[i]) / double(exact.pixelCount());
+			cb += double(b[i]) / double(sampled.pixelCount());
+			error = std::max(error, std::fabs(ca - cb));
+		}
+	}
+	return error;
+}
+
+int main()
+{
+	JRImageRef image = JRTestImage();
+	JRContextRef context = JRContext::context();
+	printf("%d x %d (%.1f MP)\n", kWidth, kHeight, double(kWidth) * kHeight / 1e6);
+
+	double exactMs;
+	JRImageStatisticsRef exact = JRAnalyse(image, *context, 0, &exactMs);
+	printf("%12s %8s %12s %10s %12s %12s %10s\n", "max error", "step", "pixels", "ms", "bound", "rank error", "median L");
+	printf("%12s %8d %12llu %10.1f %12s %12s %10.4f\n", "exhaustive", exact->sampleStep(), (unsigned long long)exact->pixelCount(),
+		   exactMs, "0", "0", exact->percentile(kJRReductionChannelLuminance, 0.5));
+	for (double maximumError : { 0.01, 0.005, 0.002 }) {
+		double ms;
+		JRImageStatisticsRef sampled = JRAnalyse(image, *context, maximumError, &ms);
+		printf("%12g %8d %12llu %10.1f %12.5f %12.5f %10.4f\n", maximumError, sampled->sampleStep(),
+			   (unsigned long long)sampled->pixelCount(), ms, sampled->errorBound(), JRRankError(*exact, *sampled),
+			   sampled->percentile(kJRReductionChannelLuminance, 0.5));
+	}
+
+	JRSIMDSetMaximumLevel(kJRSIMDLevelScalar);
+	double scalarMs;
+	JRImageStatisticsRef scalar = JRAnalyse(image, *context, 0, &scalarMs);
+	JRSIMDSetMaximumLevel(JRSIMDSupportedLevel());
+	bool identical = true;
+	for (int c = 0; c < kJRReductionChannelCount; c++) {
+		identical = identical && scalar->histogram(JRReductionChannel(c)) == exact->histogram(JRReductionChannel(c))
+			&& scalar->minimum(JRReductionChannel(c)) == exact->minimum(JRReductionChannel(c))
+			&& scalar->maximum(JRReductionChannel(c)) == exact->maximum(JRReductionChannel(c));
+	}
+	printf("scalar: %.1f ms, histograms %s\n", scalarMs, identical ? "identical" : "DIFFER");
+	return identical ? 0 : 1;
+}
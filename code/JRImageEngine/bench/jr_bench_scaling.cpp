@@ -0,0 +1,63 @@
+//
+//  jr_bench_scaling.cpp
+//  JRImageEngine
+//
+//  Thread scaling of one large render, like createCGImage(_:from:) in
+//  JRBaseController.demo(). The same context options are used at every
+//  thread count, only JRContextOptions::threadCount changes.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_scaling.cpp -o jr_bench_scaling
+//  ./jr_bench_scaling [maximum threads]
+//
+
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+static const int kSize = 4096;
+static const int kIterations = 3;
+
+int main(int argc, char* argv[])
+{
+	int maximum = argc > 1 ? atoi(argv[1]) : int(std::thread::hardware_concurrency());
+	maximum = maximum > 0 ? maximum : 1;
+
+	std::vector<uint8_t> data(size_t(kSize) * kSize * 4);
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = uint8_t((i * 7 + i / 4099) & 0xff);
+	}
+	JRImageRef image = JRImage::imageWithBitmapData(data, size_t(kSize) * 4, kSize, kSize, kJRFormatRGBA8);
+	image = image->applyingFilter("CIColorControls", { { kJRInputSaturationKey, 1.2 }, { kJRInputContrastKey, 1.1 } });
+	image = image->applyingGaussianBlur(6.0);
+	image = image->applyingFilter("CISepiaTone", { { kJRInputIntensityKey, 0.8 } });
+	JRRect rect = JRRectMake(0, 0, kSize, kSize);
+
+	std::vector<int> counts;
+	for (int n = 1; n < maximum; n *= 2) {
+		counts.push_back(n);
+	}
+	counts.push_back(maximum);
+
+	printf("%d x %d, colour controls -> blur(6) -> sepia -> RGBA8\n", kSize, kSize);
+	printf("%8s %10s %10s %10s\n", "threads", "ms", "speedup", "efficiency");
+	double base = 0;
+	for (int n : counts) {
+		JRContextOptions options;
+		options.threadCount = n;
+		JRContextRef context = JRContext::context(options);
+		context->createBitmap(image, rect);
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < kIterations; i++) {
+			context->createBitmap(image, rect);
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / kIterations;
+		base = base > 0 ? base : ms;
+		printf("%8d %10.1f %10.2f %9.0f%%\n", n, ms, base / ms, 100.0 * base / ms / n);
+	}
+	return 0;
+}
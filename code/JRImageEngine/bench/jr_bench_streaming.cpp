@@ -0,0 +1,186 @@
+//
+//  jr_bench_streaming.cpp
+//  JRImageEngine
+//
+//  Peak working memory of JRContext::renderBands() against a whole-image
+//  render. The source is a synthetic scanline decoder, so nothing of the
+//  image exists in memory except what the engine holds. Streaming should
+//  stay at a few bands of buffers however tall the image is, and decode
+//  every source row exactly once.
+//
+//  Each mode runs in a forked process, so it starts from an empty buffer
+//  pool and its peak RSS is its own. The report counts all of the memory:
+//  the pool's peak of float buffers, the output (the whole bitmap, or the
+//  rows of one band), and the growth of peak RSS during the render, which
+//  also covers the decoder's rows and anything else the pool does not see.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_streaming.cpp -o jr_bench_streaming
+//
+
+#include "jr_BufferPool.h"
+#include "jr_ImageEngine.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/* A gradient with some noise, produced row by row. */
+class JRSyntheticDecoder : public JRScanlineDecoder {
+public:
+	JRSyntheticDecoder(int width, int height) : _width(width), _height(height), _row(0), _decodedRows(0) {}
+
+	int width() const override { return _width; }
+	int height() const override { return _height; }
+	JRFormat format() const override { return kJRFormatRGBA8; }
+
+	bool readRows(void* rows, size_t rowBytes, int count) override
+	{
+		if (_row + count > _height) {
+			return false;
+		}
+		for (int i = 0; i < count; i++, _row++) {
+			uint8_t* p = static_cast<uint8_t*>(rows) + size_t(i) * rowBytes;
+			for (int x = 0; x < _width; x++, p += 4) {
+				p[0] = uint8_t(x * 255 / _width);
+				p[1] = uint8_t(_row * 255 / _height);
+				p[2] = uint8_t((x * 31 + _row * 17) & 0xff);
+				p[3] = 255;
+			}
+		}
+		_decodedRows += size_t(count);
+		return true;
+	}
+
+	bool rewind() override
+	{
+		_row = 0;
+		return true;
+	}
+
+	size_t decodedRows() const { return _decodedRows; }
+
+private:
+	int _width;
+	int _height;
+	int _row;
+	size_t _decodedRows;
+};
+
+static JRImageRef JRMakePipeline(const JRImageRef& source)
+{
+	JRImageRef image = source->applyingFilter("CIColorControls", { { kJRInputSaturationKey, 1.2 } });
+	image = image->applyingGaussianBlur(4.0);
+	image = image->cropping(source->extent());
+	return image->applying(JRAffineTransformMakeScale(0.5, 0.5));
+}
+
+struct JRStreamingReport {
+	double milliseconds;
+	size_t poolPeakBytes;
+	size_t outputBytes;
+	long peakRSSGrowthKilobytes;
+	size_t decodedRows;
+	size_t rewinds;
+};
+
+static long JRPeakRSSKilobytes()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return long(usage.ru_maxrss / 1024);
+#else
+	return long(usage.ru_maxrss);
+#endif
+}
+
+static JRStreamingReport JRRunMode(bool streaming, int width, int height, int bandHeight)
+{
+	std::shared_ptr<JRBufferPool> pool = JRBufferPool::sharedPool();
+	JRContextRef context = JRContext::context();
+	JRSyntheticDecoder* decoder = new JRSyntheticDecoder(width, height);
+	std::shared_ptr<JRScanlineImageProvider> provider =
+		std::make_shared<JRScanlineImageProvider>(std::unique_ptr<JRScanlineDecoder>(decoder));
+	JRImageRef image = JRMakePipeline(JRImage::imageWithImageProvider(provider));
+	JRIRect bounds = JRIRectFromRect(image->extent());
+	JRStreamingReport report = {};
+	uint64_t checksum = 0;
+
+	long startRSS = JRPeakRSSKilobytes();
+	auto start = std::chrono::steady_clock::now();
+	if (streaming) {
+		context->renderBands(image, bounds, kJRFormatRGBA8, bandHeight, [&](const void* rows, size_t rowBytes, const JRIRect& band) {
+			const uint8_t* p = static_cast<const uint8_t*>(rows);
+			for (int y = 0; y < band.height; y++) {
+				checksum += p[size_t(y) * rowBytes + size_t(y % band.width) * 4];
+			}
+			return true;
+		});
+		report.outputBytes = size_t(bounds.width) * 4 * size_t(std::min(bandHeight, bounds.height));
+	} else {
+		std::shared_ptr<JRBitmap> bitmap = context->createBitmap(image, image->extent());
+		report.outputBytes = bitmap->data.size();
+	}
+	report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	report.poolPeakBytes = pool->statistics().peakLiveBytes;
+	report.peakRSSGrowthKilobytes = JRPeakRSSKilobytes() - startRSS;
+	report.decodedRows = decoder->decodedRows();
+	report.rewinds = provider->rewinds();
+	(void)checksum;
+	return report;
+}
+
+/// 子进程中运行一种方式: 缓冲池从空开始, 峰值 RSS 只属于这一种
+static bool JRRunModeInChild(bool streaming, int width, int height, int bandHeight, JRStreamingReport* report)
+{
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return false;
+	}
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	if (pid == 0) {
+		close(fds[0]);
+		JRStreamingReport result = JRRunMode(streaming, width, height, bandHeight);
+		ssize_t written = write(fds[1], &result, sizeof(result));
+		_exit(written == ssize_t(sizeof(result)) ? 0 : 1);
+	}
+	close(fds[1]);
+	ssize_t length = read(fds[0], report, sizeof(*report));
+	close(fds[0]);
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return length == ssize_t(sizeof(*report)) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	int width = argc > 1 ? atoi(argv[1]) : 12000;
+	int height = argc > 2 ? atoi(argv[2]) : 8000;
+	int bandHeight = argc > 3 ? atoi(argv[3]) : 256;
+	printf("%d x %d source, saturation -> blur -> crop -> scale 0.5, %d-row bands\n", width, height, bandHeight);
+	printf("%8s %10s %12s %12s %12s %14s %10s\n", "mode", "ms", "pool MB", "output MB", "RSS growth", "decoded rows", "rewinds");
+
+	for (int streaming = 1; streaming >= 0; streaming--) {
+		JRStreamingReport report;
+		if (!JRRunModeInChild(streaming, width, height, bandHeight, &report)) {
+			printf("%8s failed\n", streaming ? "bands" : "whole");
+			return 1;
+		}
+		printf("%8s %10.1f %12.1f %12.1f %9.1f MB %14zu %10zu\n", streaming ? "bands" : "whole", report.milliseconds,
+			   double(report.poolPeakBytes) / (1 << 20), double(report.outputBytes) / (1 << 20),
+			   double(report.peakRSSGrowthKilobytes) / 1024, report.decodedRows, report.rewinds);
+	}
+	return 0;
+}
@@ -0,0 +1,604 @@
+//
+//  jr_bench_suite.cpp
+//  JRImageEngine
+//
+//  The regression suite. Each case renders one path of the public API over a
+//  matrix of image sizes, pixel formats (the source and the destination) and
+//  thread counts: an image from bitmap bytes; applying, cropping and
+//  clampingToExtent; applyingGaussianBlur; colour matching; compositing; and
+//  the recipes of SubclassingCIFilter_RecipesforCustomEffects.md. Every case
+//  runs in a process of its own, forked before the engine starts any thread,
+//  so the buffer pool and the peak RSS belong to that case alone. After a
+//  warm-up render, a case renders until it has at least kMinimumSamples
+//  samples and kCaseSeconds have passed. The report is MP/s at the median,
+//  p50 and p99 latency (with fewer than 100 samples, p99 is the slowest one)
+//  and peak RSS, which includes the case's inputs.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_suite.cpp -o jr_bench_suite
+//
+//  jr_bench_suite [--quick] [--filter text] [--output results.tsv]
+//                 [--baseline old.tsv] [--threshold 0.1]
+//  jr_bench_suite --compare old.tsv new.tsv [--threshold 0.1]
+//
+//  --output writes the results as a baseline: tab-separated, one case per
+//  line, after a header with the format version, the SIMD level and the
+//  hardware threads. --baseline compares the results with an earlier file,
+//  and --compare compares two files without running anything. A case whose
+//  p50 grew by more than the threshold (relative, 0.1 by default) is a
+//  regression, and so is a peak RSS that grew by more than the threshold;
+//  either makes the exit status 1. Differences within the threshold are
+//  reported as noise.
+//
+//  The recipes use the filters this engine has. There is no CILinearGradient,
+//  CIPixellate or CIDissolveTransition: tilt-shift masks with a radial band,
+//  pixellation scales down and back up, and the dissolve is a blend with a
+//  constant grey mask. Faces are fixed rectangles, since detection has its own
+//  bench (jr_bench_facedetector.cpp). Old Film is the grade of
+//  jr_bench_video.cpp at a fixed time.
+//
+
+#include "jr_ImageEngine.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/// 基线文件的格式版本; 列改变时加一
+static const int kBaselineVersion = 1;
+static const int kMinimumSamples = 7;
+static const int kMaximumSamples = 400;
+static const double kCaseSeconds = 0.5;
+
+// MARK: - Inputs
+
+/// 可复现的伪随机数: 同一位置在每次运行中都相同
+static float JRNoise(uint32_t x, uint32_t y, uint32_t seed)
+{
+	uint32_t h = x * 0x9E3779B1u ^ y * 0x85EBCA77u ^ seed * 0xC2B2AE3Du;
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+	return float(h & 0xffff) / 65535.0f;
+}
+
+/* A synthetic photo in premultiplied RGBAf: smooth gradients with grain, and
+ * a green screen over the middle third for the chroma key. 'alpha' below 1
+ * makes a translucent layer with clear margins instead. */
+static JRImageRef JRSourceImage(int width, int height, uint32_t seed, float alpha)
+{
+	std::vector<float> pixels(size_t(width) * height * 4);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			float* p = &pixels[(size_t(y) * width + x) * 4];
+			float grain = 0.1f * JRNoise(uint32_t(x), uint32_t(y), seed);
+			bool screen = x > width / 3 && x < 2 * width / 3 && y > height / 3 && y < 2 * height / 3;
+			float r = screen ? 0.1f : 0.85f * float(x) / float(width);
+			float g = screen ? 0.8f : 0.5f + 0.4f * std::sin(float(x + y) * 0.01f);
+			float b = screen ? 0.15f : 0.85f * float(y) / float(height);
+			bool margin = alpha < 1 && (x < width / 8 || y < height / 8 || x >= width - width / 8 || y >= height - height / 8);
+			float a = margin ? 0.0f : alpha;
+			p[0] = (r + grain) * a;
+			p[1] = (g + grain) * a;
+			p[2] = (b + grain) * a;
+			p[3] = a;
+		}
+	}
+	std::vector<uint8_t> data(pixels.size() * sizeof(float));
+	std::memcpy(data.data(), pixels.data(), data.size());
+	return JRImage::imageWithBitmapData(std::move(data), size_t(width) * 16, width, height, kJRFormatRGBAf);
+}
+
+/// 转成 'format' 的字节, 之后的 case 从这些字节读取
+static std::shared_ptr<const uint8_t> JRSourceBytes(const JRContext& context, const JRImageRef& image, JRFormat format)
+{
+	JRIRect bounds = JRIRectMake(0, 0, int(image->extent().width), int(image->extent().height));
+	size_t rowBytes = size_t(bounds.width) * JRFormatBytesPerPixel(format);
+	std::shared_ptr<uint8_t> bytes(new uint8_t[rowBytes * size_t(bounds.height)], std::default_delete<uint8_t[]>());
+	context.render(image, bytes.get(), rowBytes, bounds, format);
+	return bytes;
+}
+
+/// 与说明中的颜色立方体相同: 色相在 [0.3, 0.4] 之间的像素变为透明
+static std::string JRChromaKeyCube(int n)
+{
+	std::vector<float> cube(size_t(n) * n * n * 4);
+	for (int b = 0; b < n; b++) {
+		for (int g = 0; g < n; g++) {
+			for (int r = 0; r < n; r++) {
+				float rgb[3] = { float(r) / float(n - 1), float(g) / float(n - 1), float(b) / float(n - 1) };
+				float maximum = std::max({ rgb[0], rgb[1], rgb[2] });
+				float delta = maximum - std::min({ rgb[0], rgb[1], rgb[2] });
+				float hue = 0;
+				if (delta > 0) {
+					if (maximum == rgb[0]) {
+						hue = std::fmod((rgb[1] - rgb[2]) / delta + 6.0f, 6.0f);
+					} else if (maximum == rgb[1]) {
+						hue = (rgb[2] - rgb[0]) / delta + 2.0f;
+					} else {
+						hue = (rgb[0] - rgb[1]) / delta + 4.0f;
+					}
+					hue /= 6.0f;
+				}
+				float alpha = hue > 0.3f && hue < 0.4f ? 0.0f : 1.0f;
+				float* c = &cube[((size_t(b) * n + g) * n + r) * 4];
+				c[0] = rgb[0] * alpha;
+				c[1] = rgb[1] * alpha;
+				c[2] = rgb[2] * alpha;
+				c[3] = alpha;
+			}
+		}
+	}
+	return std::string(reinterpret_cast<const char*>(cube.data()), cube.size() * sizeof(float));
+}
+
+// MARK: - Cases
+
+/* What a case renders. 'source' and 'background' wrap the bytes of the
+ * case's format; 'bytes' are the source bytes themselves, for the case that
+ * times the wrapping. */
+struct JRCaseInputs {
+	std::shared_ptr<const uint8_t> bytes;
+	JRImageRef source;
+	JRImageRef background;
+	JRImageRef layer;
+	JRFormat format;
+	int width;
+	int height;
+};
+
+/* Builds the graph of one sample. Most cases build it once and render it
+ * repeatedly; 'rebuilds' makes each sample build it again. */
+struct JRBenchCase {
+	const char* name;
+	std::function<JRImageRef(const JRCaseInputs&)> build;
+	bool rebuilds;
+};
+
+static JRImageRef JRFaceMask(const JRCaseInputs& in, double scale)
+{
+	/// 两张固定的脸; 每张一个硬边的圆, 叠在透明上
+	JRImageRef mask = JRImage::imageWithColor(JRColor::colorWithRed(0, 0, 0, 0));
+	const double faces[2][3] = { { 0.3, 0.6, 0.12 }, { 0.7, 0.4, 0.1 } };
+	for (const auto& face : faces) {
+		double radius = face[2] * in.height * scale;
+		JRImageRef circle = JRFilter::filterWithName("CIRadialGradient", {
+			{ kJRInputCenterKey, JRVector::vectorWithXY(face[0] * in.width, face[1] * in.height) },
+			{ "inputRadius0", radius },
+			{ "inputRadius1", radius + 1.0 },
+			{ "inputColor0", JRColor::colorWithRed(0, 1, 0, 1) },
+			{ "inputColor1", JRColor::colorWithRed(0, 0, 0, 0) },
+		})->outputImage();
+		mask = circle->applyingFilter("CISourceOverCompositing", { { kJRInputBackgroundImageKey, mask } });
+	}
+	return mask;
+}
+
+/// CIPixellate 的近似: 缩小 'scale' 倍再放大回来
+static JRImageRef JRPixellated(const JRImageRef& image, double scale)
+{
+	return image->applying(JRAffineTransformMakeScale(1.0 / scale, 1.0 / scale))
+		->applying(JRAffineTransformMakeScale(scale, scale))
+		->cropping(image->extent());
+}
+
+static std::vector<JRBenchCase> JRBenchCases()
+{
+	return {
+		{ "bitmap", [](const JRCaseInputs& in) {
+			 return JRImage::imageWithBitmapBytes(in.bytes, size_t(in.width) * JRFormatBytesPerPixel(in.format), in.width, in.height, in.format);
+		 }, true },
+		{ "geometry", [](const JRCaseInputs& in) {
+			 JRRect extent = in.source->extent();
+			 JRAffineTransform rotation = JRAffineTransformConcat(
+				 JRAffineTransformConcat(JRAffineTransformMakeTranslation(-extent.width / 2, -extent.height / 2), JRAffineTransformMakeRotation(0.1)),
+				 JRAffineTransformMakeTranslation(extent.width / 2, extent.height / 2));
+			 return in.source->applying(rotation)
+				 ->cropping(JRRectMake(extent.width / 8, extent.height / 8, extent.width * 3 / 4, extent.height * 3 / 4))
+				 ->clampingToExtent()
+				 ->cropping(extent);
+		 }, false },
+		{ "blur", [](const JRCaseInputs& in) {
+			 return in.source->clampingToExtent()->applyingGaussianBlur(8.0)->cropping(in.source->extent());
+		 }, false },
+		{ "colour-match", [](const JRCaseInputs& in) {
+			 return in.source->matchedToWorkingSpace(kJRColorSpaceSRGB)
+				 ->applyingFilter("CIColorControls", { { "inputSaturation", 1.2 }, { "inputContrast", 1.1 } })
+				 ->matchedFromWorkingSpace(kJRColorSpaceSRGB);
+		 }, false },
+		{ "composite", [](const JRCaseInputs& in) {
+			 return in.layer->applyingFilter("CISourceOverCompositing", { { kJRInputBackgroundImageKey, in.source } })
+				 ->applyingFilter("CIMultiplyBlendMode", { { kJRInputBackgroundImageKey, in.background } });
+		 }, false },
+		{ "color-invert", [](const JRCaseInputs& in) {
+			 return in.source->applyingFilter("CIColorInvert", {});
+		 }, false },
+		{ "chroma-key", [](const JRCaseInputs& in) {
+			 return in.source->applyingFilter("CIColorCube", { { "inputCubeDimension", 64.0 }, { "inputCubeData", JRChromaKeyCube(64) } })
+				 ->applyingFilter("CISourceOverCompositing", { { kJRInputBackgroundImageKey, in.background } });
+		 }, false },
+		{ "white-vignette", [](const JRCaseInputs& in) {
+			 /// 白色在脸外逐渐变浓, 脸部保持原样
+			 double radius = 0.12 * in.height + 50;
+			 JRImageRef vignette = JRFilter::filterWithName("CIRadialGradient", {
+				 { kJRInputCenterKey, JRVector::vectorWithXY(0.3 * in.width, 0.6 * in.height) },
+				 { "inputRadius0", radius },
+				 { "inputRadius1", double(std::max(in.width, in.height)) },
+				 { "inputColor0", JRColor::colorWithRed(0, 0, 0, 0) },
+				 { "inputColor1", JRColor::colorWithRed(1, 1, 1, 1) },
+			 })->outputImage();
+			 return vignette->applyingFilter("CISourceOverCompositing", { { kJRInputBackgroundImageKey, in.source } })
+				 ->cropping(in.source->extent());
+		 }, false },
+		{ "tilt-shift", [](const JRCaseInputs& in) {
+			 JRImageRef blurred = in.source->clampingToExtent()->applyingGaussianBlur(10.0)->cropping(in.source->extent());
+			 /// 没有 CILinearGradient: 以中心为圆心的径向渐变代替两条线性渐变, 中间清晰
+			 JRImageRef mask = JRFilter::filterWithName("CIRadialGradient", {
+				 { kJRInputCenterKey, JRVector::vectorWithXY(in.width / 2, in.height / 2) },
+				 { "inputRadius0", 0.25 * in.height },
+				 { "inputRadius1", 0.5 * in.height },
+				 { "inputColor0", JRColor::colorWithRed(0, 0, 0, 1) },
+				 { "inputColor1", JRColor::colorWithRed(1, 1, 1, 1) },
+			 })->outputImage();
+			 return blurred->applyingFilter("CIBlendWithMask", { { kJRInputBackgroundImageKey, in.source }, { kJRInputMaskImageKey, mask } });
+		 }, false },
+		{ "anonymous-faces", [](const JRCaseInputs& in) {
+			 JRImageRef pixellated = JRPixellated(in.source, std::max(in.width, in.height) / 60.0);
+			 return pixellated->applyingFilter("CIBlendWithMask", { { kJRInputBackgroundImageKey, in.source }, { kJRInputMaskImageKey, JRFaceMask(in, 1.0) } });
+		 }, false },
+		{ "pixellate-transition", [](const JRCaseInputs& in) {
+			 /// time = 0.3 时的一帧: 溶解用常量灰色蒙版混合, 再像素化
+			 double time = 0.3;
+			 JRImageRef mask = JRImage::imageWithColor(JRColor::colorWithRed(float(time), float(time), float(time), 1));
+			 JRImageRef dissolved = in.background->applyingFilter("CIBlendWithMask", { { kJRInputBackgroundImageKey, in.source }, { kJRInputMaskImageKey, mask } });
+			 return JRPixellated(dissolved, std::max(2.0, 90.0 * (1 - 2 * std::fabs(time - 0.5))));
+		 }, false },
+		{ "old-film", [](const JRCaseInputs& in) {
+			 JRImageRef graded = in.source->applyingFilter("CISepiaTone", { { kJRInputIntensityKey, 0.8 } })
+				 ->applyingFilter("CIExposureAdjust", { { kJRInputEVKey, 0.1 } });
+			 JRImageRef vignette = JRFilter::filterWithName("CIRadialGradient", {
+				 { kJRInputCenterKey, JRVector::vectorWithXY(in.width / 2, in.height / 2) },
+				 { "inputRadius0", 0.4 * in.height },
+				 { "inputRadius1", 1.1 * in.height },
+				 { "inputColor0", JRColor::colorWithRed(0, 0, 0, 0) },
+				 { "inputColor1", JRColor::colorWithRed(0, 0, 0, 0.8f) },
+			 })->outputImage()->cropping(in.source->extent())->applyingGaussianBlur(20.0);
+			 return vignette->applyingFilter("CISourceOverCompositing", { { kJRInputBackgroundImageKey, graded } })->cropping(in.source->extent());
+		 }, false },
+	};
+}
+
+// MARK: - Running
+
+/* One line of a baseline. The first five fields are the key. */
+struct JRBenchResult {
+	std::string name;
+	int width = 0;
+	int height = 0;
+	std::string format;
+	int threads = 0;
+	double megapixelsPerSecond = 0;
+	double p50 = 0;
+	double p99 = 0;
+	long peakRSS = 0;
+	int samples = 0;
+
+	std::tuple<std::string, int, int, std::string, int> key() const { return std::make_tuple(name, width, height, format, threads); }
+};
+
+/// 子进程通过管道传回的结果
+struct JRCaseReport {
+	double p50;
+	double p99;
+	long peakRSS;
+	int samples;
+};
+
+static long JRPeakRSSKilobytes()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return long(usage.ru_maxrss / 1024);
+#else
+	return long(usage.ru_maxrss);
+#endif
+}
+
+/// 在子进程中运行: 生成输入, 预热一次, 然后计时
+static JRCaseReport JRRunCase(const JRBenchCase& benchCase, int width, int height, JRFormat format, int threads)
+{
+	JRContextOptions options;
+	options.threadCount = threads;
+	JRContextRef context = JRContext::context(options);
+	size_t rowBytes = size_t(width) * JRFormatBytesPerPixel(format);
+
+	JRCaseInputs in;
+	in.format = format;
+	in.width = width;
+	in.height = height;
+	in.bytes = JRSourceBytes(*context, JRSourceImage(width, height, 1, 1.0f), format);
+	in.source = JRImage::imageWithBitmapBytes(in.bytes, rowBytes, width, height, format);
+	in.background = JRImage::imageWithBitmapBytes(JRSourceBytes(*context, JRSourceImage(width, height, 2, 1.0f), format), rowBytes, width,
+												  height, format);
+	in.layer = JRImage::imageWithBitmapBytes(JRSourceBytes(*context, JRSourceImage(width, height, 3, 0.6f), format), rowBytes, width,
+											 height, format);
+
+	JRIRect bounds = JRIRectMake(0, 0, width, height);
+	std::vector<uint8_t> destination(rowBytes * size_t(height));
+	JRImageRef image = benchCase.build(in);
+	context->render(image, destination.data(), rowBytes, bounds, format);
+
+	std::vector<double> samples;
+	auto begin = std::chrono::steady_clock::now();
+	while (samples.size() < size_t(kMinimumSamples) ||
+		   (samples.size() < size_t(kMaximumSamples) && std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() < kCaseSeconds)) {
+		auto start = std::chrono::steady_clock::now();
+		if (benchCase.rebuilds) {
+			image = benchCase.build(in);
+		}
+		context->render(image, destination.data(), rowBytes, bounds, format);
+		samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	std::sort(samples.begin(), samples.end());
+	/// 最近秩: 第 ceil(p n) 个样本
+	auto percentile = [&](double p) { return samples[size_t(std::max(1.0, std::ceil(p * double(samples.size())))) - 1]; };
+	return { percentile(0.5), percentile(0.99), JRPeakRSSKilobytes(), int(samples.size()) };
+}
+
+/* Forks, runs the case in the child and reads its report. The parent never
+ * calls the engine, so it has no threads to lose in the fork. */
+static bool JRRunCaseInChild(const JRBenchCase& benchCase, int width, int height, JRFormat format, int threads, JRCaseReport* report)
+{
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return false;
+	}
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid < 0) {
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	if (pid == 0) {
+		close(fds[0]);
+		JRCaseReport result = JRRunCase(benchCase, width, height, format, threads);
+		ssize_t written = write(fds[1], &result, sizeof(result));
+		_exit(written == ssize_t(sizeof(result)) ? 0 : 1);
+	}
+	close(fds[1]);
+	ssize_t length = read(fds[0], report, sizeof(*report));
+	close(fds[0]);
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return length == ssize_t(sizeof(*report)) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// MARK: - Baselines
+
+static std::string JRBaselineHeader()
+{
+	std::ostringstream header;
+	header << "# jr_bench_suite " << kBaselineVersion << "\n";
+	header << "# simd " << JRSIMDLevelName(JRSIMDActiveLevel()) << " hardware-threads " << std::thread::hardware_concurrency() << "\n";
+	header << "case\twidth\theight\tformat\tthreads\tmpps\tp50_ms\tp99_ms\tpeak_rss_kb\tsamples\n";
+	return header.str();
+}
+
+static bool JRWriteBaseline(const std::string& path, const std::vector<JRBenchResult>& results)
+{
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+	file << JRBaselineHeader();
+	char line[256];
+	for (const JRBenchResult& r : results) {
+		snprintf(line, sizeof(line), "%s\t%d\t%d\t%s\t%d\t%.2f\t%.4f\t%.4f\t%ld\t%d\n", r.name.c_str(), r.width, r.height, r.format.c_str(),
+				 r.threads, r.megapixelsPerSecond, r.p50, r.p99, r.peakRSS, r.samples);
+		file << line;
+	}
+	return bool(file);
+}
+
+/* Reads a file written by JRWriteBaseline. Fails on another version, and
+ * puts the environment line (SIMD level, hardware threads) in 'environment'. */
+static bool JRReadBaseline(const std::string& path, std::vector<JRBenchResult>* results, std::string* environment)
+{
+	std::ifstream file(path);
+	std::string line;
+	if (!file || !std::getline(file, line) || line != "# jr_bench_suite " + std::to_string(kBaselineVersion)) {
+		return false;
+	}
+	while (std::getline(file, line)) {
+		if (line.empty() || line.compare(0, 5, "case\t") == 0) {
+			continue;
+		}
+		if (line[0] == '#') {
+			*environment = line.substr(2);
+			continue;
+		}
+		std::istringstream fields(line);
+		JRBenchResult r;
+		if (!(fields >> r.name >> r.width >> r.height >> r.format >> r.threads >> r.megapixelsPerSecond >> r.p50 >> r.p99 >> r.peakRSS >> r.samples)) {
+			return false;
+		}
+		results->push_back(r);
+	}
+	return true;
+}
+
+/* Prints each case present in both, and returns the number of regressions:
+ * a p50 or a peak RSS more than 'threshold' above the old one. */
+static int JRCompare(const std::vector<JRBenchResult>& old, const std::string& oldEnvironment, const std::vector<JRBenchResult>& current,
+					 const std::string& currentEnvironment, double threshold)
+{
+	if (oldEnvironment != currentEnvironment) {
+		printf("warning: baseline from '%s', results from '%s'\n", oldEnvironment.c_str(), currentEnvironment.c_str());
+	}
+	std::map<std::tuple<std::string, int, int, std::string, int>, const JRBenchResult*> byKey;
+	for (const JRBenchResult& r : old) {
+		byKey[r.key()] = &r;
+	}
+	int regressions = 0;
+	int improvements = 0;
+	int missing = 0;
+	printf("%-44s %10s %10s %8s %8s  %s\n", "case", "old p50", "new p50", "p50", "rss", "verdict");
+	for (const JRBenchResult& r : current) {
+		auto found = byKey.find(r.key());
+		if (found == byKey.end()) {
+			missing++;
+			continue;
+		}
+		const JRBenchResult& o = *found->second;
+		double time = r.p50 / o.p50 - 1;
+		double rss = double(r.peakRSS) / double(std::max(1L, o.peakRSS)) - 1;
+		const char* verdict = "noise";
+		if (time > threshold || rss > threshold) {
+			verdict = time > threshold ? "REGRESSION" : "RSS REGRESSION";
+			regressions++;
+		} else if (time < -threshold) {
+			verdict = "faster";
+			improvements++;
+		}
+		char label[128];
+		snprintf(label, sizeof(label), "%s %dx%d %s t%d", r.name.c_str(), r.width, r.height, r.format.c_str(), r.threads);
+		printf("%-44s %8.2fms %8.2fms %+7.1f%% %+7.1f%%  %s\n", label, o.p50, r.p50, time * 100, rss * 100, verdict);
+	}
+	printf("%d regressions, %d faster, %d cases not in the baseline (threshold %.0f%%)\n", regressions, improvements, missing,
+		   threshold * 100);
+	return regressions;
+}
+
+// MARK: - Main
+
+static std::string JRBaselineEnvironment()
+{
+	std::string header = JRBaselineHeader();
+	size_t start = header.find('\n') + 3;
+	return header.substr(start, header.find('\n', start) - start);
+}
+
+int main(int argc, char* argv[])
+{
+	bool quick = false;
+	std::string filter;
+	std::string output;
+	std::string baseline;
+	std::vector<std::string> compared;
+	double threshold = 0.1;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (argument == "--quick") {
+			quick = true;
+		} else if (argument == "--filter" && hasValue) {
+			filter = argv[++i];
+		} else if (argument == "--output" && hasValue) {
+			output = argv[++i];
+		} else if (argument == "--baseline" && hasValue) {
+			baseline = argv[++i];
+		} else if (argument == "--threshold" && hasValue) {
+			threshold = atof(argv[++i]);
+		} else if (argument == "--compare" && i + 2 < argc) {
+			compared = { argv[i + 1], argv[i + 2] };
+			i += 2;
+		} else {
+			fprintf(stderr, "usage: %s [--quick] [--filter text] [--output file] [--baseline file] [--threshold t]\n"
+							"       %s --compare old new [--threshold t]\n", argv[0], argv[0]);
+			return 2;
+		}
+	}
+
+	if (!compared.empty()) {
+		std::vector<JRBenchResult> old, current;
+		std::string oldEnvironment, currentEnvironment;
+		for (int k = 0; k < 2; k++) {
+			if (!JRReadBaseline(compared[k], k == 0 ? &old : &current, k == 0 ? &oldEnvironment : &currentEnvironment)) {
+				fprintf(stderr, "cannot read %s\n", compared[k].c_str());
+				return 2;
+			}
+		}
+		return JRCompare(old, oldEnvironment, current, currentEnvironment, threshold) > 0 ? 1 : 0;
+	}
+
+	std::vector<std::pair<int, int>> sizes = { { 640, 480 }, { 1920, 1080 }, { 4096, 3072 } };
+	std::vector<JRFormat> formats = { kJRFormatRGBA8, kJRFormatRGBAh, kJRFormatRGBAf };
+	std::vector<int> threads = { 1 };
+	int hardware = int(std::thread::hardware_concurrency());
+	if (hardware > 1) {
+		threads.push_back(hardware);
+	}
+	if (quick) {
+		sizes = { { 640, 480 } };
+		formats = { kJRFormatRGBA8 };
+	}
+
+	std::vector<JRBenchResult> results;
+	bool failed = false;
+	printf("%-44s %10s %10s %10s %10s\n", "case", "MP/s", "p50", "p99", "peak RSS");
+	for (const JRBenchCase& benchCase : JRBenchCases()) {
+		if (!filter.empty() && std::string(benchCase.name).find(filter) == std::string::npos) {
+			continue;
+		}
+		for (const auto& size : sizes) {
+			for (JRFormat format : formats) {
+				for (int threadCount : threads) {
+					JRCaseReport report;
+					char label[128];
+					snprintf(label, sizeof(label), "%s %dx%d %s t%d", benchCase.name, size.first, size.second, JRFormatName(format), threadCount);
+					if (!JRRunCaseInChild(benchCase, size.first, size.second, format, threadCount, &report)) {
+						printf("%-44s FAILED\n", label);
+						failed = true;
+						continue;
+					}
+					JRBenchResult r;
+					r.name = benchCase.name;
+					r.width = size.first;
+					r.height = size.second;
+					r.format = JRFormatName(format);
+					r.threads = threadCount;
+					r.megapixelsPerSecond = double(size.first) * size.second / (report.p50 * 1e3);
+					r.p50 = report.p50;
+					r.p99 = report.p99;
+					r.peakRSS = report.peakRSS;
+					r.samples = report.samples;
+					results.push_back(r);
+					printf("%-44s %10.1f %8.2fms %8.2fms %8.1fMB\n", label, r.megapixelsPerSecond, r.p50, r.p99, double(r.peakRSS) / 1024);
+				}
+			}
+		}
+	}
+
+	if (!output.empty() && !JRWriteBaseline(output, results)) {
+		fprintf(stderr, "cannot write %s\n", output.c_str());
+		return 2;
+	}
+	int regressions = 0;
+	if (!baseline.empty()) {
+		std::vector<JRBenchResult> old;
+		std::string oldEnvironment;
+		if (!JRReadBaseline(baseline, &old, &oldEnvironment)) {
+			fprintf(stderr, "cannot read %s\n", baseline.c_str());
+			return 2;
+		}
+		printf("\n");
+		regressions = JRCompare(old, oldEnvironment, results, JRBaselineEnvironment(), threshold);
+	}
+	return failed || regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+//
+//  jr_bench_yuv.cpp
+//  JRImageEngine
+//
+//  Blurs, sharpens and grades a 1920 x 1080 NV12 frame on its planes, and
+//  blurs the same frame the RGBA way (imageWithYUVFrame, CIGaussianBlur,
+//  createYUVFrame) for comparison. Prints the time and the size of the
+//  float intermediate each blur pass writes and reads back: 1.5 samples per
+//  pixel on the planes against 4 for RGBA.
+//
+//  c++ -std=c++17 -O2 -pthread -I.. ../*.cpp jr_bench_yuv.cpp -o jr_bench_yuv
+//
+
+#include "jr_ImageEngine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+static const int kWidth = 1920;
+static const int kHeight = 1080;
+static const int kRuns = 5;
+
+static double JRBestMilliseconds(const std::function<void()>& body)
+{
+	double best = 1e9;
+	for (int run = 0; run < kRuns; run++) {
+		auto start = std::chrono::steady_clock::now();
+		body();
+		best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
+
+int main()
+{
+	size_t lumaBytes = size_t(kWidth) * kHeight, chromaBytes = size_t(kWidth) * (kHeight / 2);
+	std::shared_ptr<uint8_t> luma(new uint8_t[lumaBytes], std::default_delete<uint8_t[]>());
+	std::shared_ptr<uint8_t> chroma(new uint8_t[chromaBytes], std::default_delete<uint8_t[]>());
+	for (size_t i = 0; i < lumaBytes; i++) {
+		luma.get()[i] = uint8_t(16 + (i * 7919 >> 4) % 220);
+	}
+	for (size_t i = 0; i < chromaBytes; i++) {
+		chroma.get()[i] = uint8_t(64 + (i * 104729 >> 5) % 128);
+	}
+	JRYUVFrameRef frame = JRYUVFrame::frameWithPlanes(kJRYUVLayoutNV12, kWidth, kHeight,
+													  { { luma, size_t(kWidth) }, { chroma, size_t(kWidth) } });
+	JRContextRef context = JRContext::context();
+	const double sigma = 4;
+
+	double planar = double(lumaBytes + chromaBytes) * sizeof(float);
+	double rgba = double(lumaBytes) * 4 * sizeof(float);
+	printf("%d x %d NV12, ms (MB of float intermediate per pass)\n", kWidth, kHeight);
+	printf("%26s %8.1f (%.1f)\n", "blur via RGBA", JRBestMilliseconds([&] {
+		JRImageRef blurred = JRImage::imageWithYUVFrame(frame)->applyingGaussianBlur(sigma);
+		context->createYUVFrame(blurred, { 0, 0, kWidth, kHeight });
+	}), rgba / 1e6);
+	printf("%26s %8.1f (%.1f)\n", "applyingGaussianBlur", JRBestMilliseconds([&] {
+		frame->applyingGaussianBlur(sigma);
+	}), planar / 1e6);
+	printf("%26s %8.1f\n", "sharpeningLuminance", JRBestMilliseconds([&] {
+		frame->sharpeningLuminance();
+	}));
+	printf("%26s %8.1f\n", "applyingLuminanceCurve", JRBestMilliseconds([&] {
+		frame->applyingLuminanceCurve({ JRVector::vectorWithXY(0, 0), JRVector::vectorWithXY(0.5, 0.6), JRVector::vectorWithXY(1, 1) });
+	}));
+	return 0;
+}
@@ -0,0 +1,91 @@
+//
+//  jr_Buffer.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Buffer.h"
+#include "jr_BufferPool.h"
+
+#include <cstring>
+
+/// 行宽按 64 字节对齐 (16 个 float)
+static size_t JRAlignedRowFloats(int width)
+{
+	return (size_t(width) * 4 + 15) & ~size_t(15);
+}
+
+JRBuffer::JRBuffer()
+: _rect({ 0, 0, 0, 0 }), _data(nullptr), _rowFloats(0)
+{
+}
+
+JRBuffer JRBuffer::bufferWithRect(const JRIRect& rect)
+{
+	JRBuffer buffer;
+	if (rect.isEmpty()) {
+		return buffer;
+	}
+	size_t rowFloats = JRAlignedRowFloats(rect.width);
+	buffer._rect = rect;
+	buffer._rowFloats = rowFloats;
+	buffer._storage = JRBufferPool::sharedPool()->allocate(rowFloats * sizeof(float) * size_t(rect.height));
+	buffer._data = buffer._storage.get();
+	return buffer;
+}
+
+JRBuffer JRBuffer::bufferWithPixels(float* pixels, size_t rowFloats, const JRIRect& rect)
+{
+	JRBuffer buffer;
+	buffer._rect = rect;
+	buffer._rowFloats = rowFloats;
+	buffer._data = pixels;
+	return buffer;
+}
+
+JRBuffer JRBuffer::view(const JRIRect& rect) const
+{
+	JRBuffer buffer = *this;
+	buffer._rect = rect;
+	buffer._data = rect.isEmpty() ? _data : pixelAt(rect.x, rect.y);
+	return buffer;
+}
+
+void JRBuffer::clear() const
+{
+	clear(_rect);
+}
+
+void JRBuffer::clear(const JRIRect& rect) const
+{
+	JRIRect r = JRIRectIntersection(rect, _rect);
+	for (int y = r.y; y < r.maxY(); y++) {
+		std::memset(pixelAt(r.x, y), 0, size_t(r.width) * 4 * sizeof(float));
+	}
+}
+
+void JRBuffer::fill(const JRColor& color) const
+{
+	for (int y = _rect.y; y < _rect.maxY(); y++) {
+		float* p = rowAt(y);
+		for (int x = 0; x < _rect.width; x++, p += 4) {
+			p[0] = color.red;
+			p[1] = color.green;
+			p[2] = color.blue;
+			p[3] = color.alpha;
+		}
+	}
+}
+
+void JRBuffer::copyFrom(const JRBuffer& source) const
+{
+	JRIRect r = JRIRectIntersection(source.rect(), _rect);
+	if (r.isEmpty() || source.pixelAt(r.x, r.y) == pixelAt(r.x, r.y)) {
+		return;
+	}
+	for (int y = r.y; y < r.maxY(); y++) {
+		std::memcpy(pixelAt(r.x, y), source.pixelAt(r.x, y), size_t(r.width) * 4 * sizeof(float));
+	}
+}
@@ -0,0 +1,58 @@
+//
+//  jr_Buffer.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Buffer_h
+#define jr_Buffer_h
+
+#include "jr_Color.h"
+#include "jr_Geometry.h"
+
+#include <cstddef>
+#include <memory>
+
+/* A rectangle of premultiplied float RGBA pixels in the working format.
+ * Buffers are cheap handles: copies and views share the same storage. Row 0
+ * holds the pixels at rect.y. */
+class JRBuffer {
+public:
+	JRBuffer();
+
+	/* Allocates an uninitialised, 64-byte aligned buffer covering 'rect'.
+	 * The memory comes from JRBufferPool::sharedPool() and goes back to it
+	 * when the last buffer sharing it is released. */
+	static JRBuffer bufferWithRect(const JRIRect& rect);
+	/* Wraps caller-owned pixels. The caller keeps them alive. */
+	static JRBuffer bufferWithPixels(float* pixels, size_t rowFloats, const JRIRect& rect);
+
+	const JRIRect& rect() const { return _rect; }
+	size_t rowFloats() const { return _rowFloats; }
+	bool isValid() const { return _data != nullptr || _rect.isEmpty(); }
+
+	float* data() const { return _data; }
+	/// 绝对坐标 y 所在的行
+	float* rowAt(int y) const { return _data + size_t(y - _rect.y) * _rowFloats; }
+	float* pixelAt(int x, int y) const { return rowAt(y) + size_t(x - _rect.x) * 4; }
+
+	/* Returns a buffer sharing this storage limited to 'rect', which must be
+	 * inside rect(). */
+	JRBuffer view(const JRIRect& rect) const;
+
+	void clear() const;
+	void clear(const JRIRect& rect) const;
+	void fill(const JRColor& premultipliedColor) const;
+	/* Copies the overlap of 'source' and this buffer. */
+	void copyFrom(const JRBuffer& source) const;
+
+private:
+	JRIRect _rect;
+	float* _data;
+	size_t _rowFloats;
+	std::shared_ptr<float> _storage;
+};
+
+#endif /* jr_Buffer_h */
@@ -0,0 +1,165 @@
+//
+//  jr_BufferPool.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_BufferPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+/// 最小的档位 4KB
+static const size_t kJRBufferPoolMinimumShift = 12;
+
+/// 档位: 2^k 之后按 2^k / 4 递增. 返回档位编号和档位大小
+static size_t JRSizeClass(size_t bytes, size_t* classBytes)
+{
+	if (bytes <= (size_t(1) << kJRBufferPoolMinimumShift)) {
+		*classBytes = size_t(1) << kJRBufferPoolMinimumShift;
+		return 0;
+	}
+	size_t shift = kJRBufferPoolMinimumShift;
+	while ((size_t(1) << (shift + 1)) < bytes) {
+		shift++;
+	}
+	size_t base = size_t(1) << shift;
+	size_t step = base / 4;
+	size_t steps = (bytes - base + step - 1) / step;
+	*classBytes = base + steps * step;
+	return (shift - kJRBufferPoolMinimumShift) * 4 + steps;
+}
+
+static size_t JRClassBytes(size_t sizeClass)
+{
+	if (sizeClass == 0) {
+		return size_t(1) << kJRBufferPoolMinimumShift;
+	}
+	size_t shift = kJRBufferPoolMinimumShift + (sizeClass - 1) / 4;
+	size_t steps = (sizeClass - 1) % 4 + 1;
+	return (size_t(1) << shift) + steps * ((size_t(1) << shift) / 4);
+}
+
+JRBufferPool::JRBufferPool(size_t idleLimit)
+: _idleLimit(idleLimit), _statistics()
+{
+}
+
+JRBufferPool::~JRBufferPool()
+{
+	trimToLimit(0);
+}
+
+std::shared_ptr<JRBufferPool> JRBufferPool::sharedPool()
+{
+	static std::shared_ptr<JRBufferPool> pool = std::make_shared<JRBufferPool>(size_t(512) << 20);
+	return pool;
+}
+
+size_t JRBufferPool::blockBytes(size_t bytes)
+{
+	size_t classBytes;
+	JRSizeClass(bytes, &classBytes);
+	return classBytes;
+}
+
+std::shared_ptr<float> JRBufferPool::allocate(size_t bytes)
+{
+	size_t classBytes;
+	size_t sizeClass = JRSizeClass(bytes, &classBytes);
+	float* block = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (sizeClass < _idle.size() && !_idle[sizeClass].empty()) {
+			block = _idle[sizeClass].back();
+			_idle[sizeClass].pop_back();
+			_statistics.idleBytes -= classBytes;
+			_statistics.reuses++;
+		} else {
+			_statistics.allocations++;
+			_statistics.allocatedBytes += classBytes;
+		}
+		_statistics.liveBytes += classBytes;
+		_statistics.peakLiveBytes = std::max(_statistics.peakLiveBytes, _statistics.liveBytes);
+	}
+	if (!block) {
+		block = static_cast<float*>(std::aligned_alloc(64, classBytes));
+		if (!block) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			_statistics.liveBytes -= classBytes;
+			throw std::bad_alloc();
+		}
+	}
+	/// 释放时回到池中; 持有池的引用, 池不会先于块销毁
+	std::shared_ptr<JRBufferPool> pool = shared_from_this();
+	return std::shared_ptr<float>(block, [pool, sizeClass](float* p) { pool->recycle(p, sizeClass); });
+}
+
+void JRBufferPool::recycle(float* block, size_t sizeClass)
+{
+	size_t classBytes = JRClassBytes(sizeClass);
+	std::lock_guard<std::mutex> lock(_mutex);
+	_statistics.liveBytes -= classBytes;
+	if (_statistics.idleBytes + classBytes > _idleLimit) {
+		std::free(block);
+		return;
+	}
+	if (_idle.size() <= sizeClass) {
+		_idle.resize(sizeClass + 1);
+	}
+	_idle[sizeClass].push_back(block);
+	_statistics.idleBytes += classBytes;
+}
+
+size_t JRBufferPool::idleLimit() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _idleLimit;
+}
+
+void JRBufferPool::setIdleLimit(size_t idleLimit)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_idleLimit = idleLimit;
+	trimToLimit(idleLimit);
+}
+
+void JRBufferPool::purge()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	trimToLimit(0);
+}
+
+void JRBufferPool::trim(size_t idleBytes)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	trimToLimit(idleBytes);
+}
+
+JRBufferPool::Statistics JRBufferPool::statistics() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _statistics;
+}
+
+void JRBufferPool::resetPeakLiveBytes()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_statistics.peakLiveBytes = _statistics.liveBytes;
+}
+
+void JRBufferPool::trimToLimit(size_t limit)
+{
+	/// 先释放最大的块
+	for (size_t sizeClass = _idle.size(); sizeClass > 0 && _statistics.idleBytes > limit; sizeClass--) {
+		std::vector<float*>& blocks = _idle[sizeClass - 1];
+		while (!blocks.empty() && _statistics.idleBytes > limit) {
+			std::free(blocks.back());
+			blocks.pop_back();
+			_statistics.idleBytes -= JRClassBytes(sizeClass - 1);
+		}
+	}
+}
@@ -0,0 +1,78 @@
+//
+//  jr_BufferPool.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_BufferPool_h
+#define jr_BufferPool_h
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* Recycles the 64-byte aligned blocks behind JRBuffer. Sizes are rounded up
+ * to size classes a quarter of a power of two apart, so at most 25% of a
+ * block is unused. A block goes back to its class when the last buffer
+ * sharing it is released, and the next request of that class reuses it,
+ * pages already faulted in. Once the renders of a context have seen every
+ * tile and intermediate size, they stop allocating buffer memory.
+ *
+ * Idle blocks beyond idleLimit() are freed. Thread-safe. */
+class JRBufferPool : public std::enable_shared_from_this<JRBufferPool> {
+public:
+	struct Statistics {
+		/* Blocks and bytes obtained from the system. */
+		size_t allocations;
+		size_t allocatedBytes;
+		/* Requests served from an idle block. */
+		size_t reuses;
+		/* Bytes in blocks handed out and not yet returned. */
+		size_t liveBytes;
+		/* The highest liveBytes since creation or resetPeakLiveBytes(). */
+		size_t peakLiveBytes;
+		/* Bytes in blocks waiting to be reused. */
+		size_t idleBytes;
+	};
+
+	explicit JRBufferPool(size_t idleLimit);
+	~JRBufferPool();
+
+	/* The pool JRBuffer::bufferWithRect draws from, keeping up to 512 MB
+	 * idle. */
+	static std::shared_ptr<JRBufferPool> sharedPool();
+
+	/* At least 'bytes' of 64-byte aligned memory, returned to the pool with
+	 * the last copy of the pointer. Throws std::bad_alloc on failure. */
+	std::shared_ptr<float> allocate(size_t bytes);
+	/* The size of the block allocate(bytes) hands out, 'bytes' rounded up to
+	 * its size class. */
+	static size_t blockBytes(size_t bytes);
+
+	size_t idleLimit() const;
+	/* Frees idle blocks until the new limit is met. */
+	void setIdleLimit(size_t idleLimit);
+	/* Frees every idle block. */
+	void purge();
+	/* Frees idle blocks, largest first, until at most 'idleBytes' remain.
+	 * idleLimit() does not change. */
+	void trim(size_t idleBytes);
+
+	Statistics statistics() const;
+	void resetPeakLiveBytes();
+
+private:
+	void recycle(float* block, size_t sizeClass);
+	void trimToLimit(size_t limit);
+
+	mutable std::mutex _mutex;
+	/// 每个大小档位的空闲块
+	std::vector<std::vector<float*>> _idle;
+	size_t _idleLimit;
+	Statistics _statistics;
+};
+
+#endif /* jr_BufferPool_h */
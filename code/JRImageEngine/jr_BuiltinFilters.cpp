@@ -0,0 +1,568 @@
+//
+//  jr_BuiltinFilters.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_ColorCube.h"
+#include "jr_ColorSpace.h"
+#include "jr_Compositing.h"
+#include "jr_Filter.h"
+#include "jr_GaussianBlur.h"
+#include "jr_Image.h"
+#include "jr_Morphology.h"
+
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+/// 内置滤镜: 由一组输入描述和一个输出函数组成
+class JRBuiltinFilter : public JRFilter {
+public:
+	typedef JRImageRef (*Output)(const JRBuiltinFilter& filter);
+
+	JRBuiltinFilter(const std::string& name, const JRFilterLayoutRef& layout, Output output)
+	: JRFilter(name, layout), _output(output)
+	{
+	}
+
+	JRImageRef outputImage() const override
+	{
+		return _output(*this);
+	}
+
+	using JRFilter::doubleForKey;
+	using JRFilter::vectorForKey;
+	using JRFilter::imageForKey;
+
+private:
+	Output _output;
+};
+
+// MARK: - Kernels
+
+/// CISepiaTone: args = [intensity]
+static void JRSepiaToneFunction(float* p, const float* const*, size_t count, const float* args)
+{
+	float k = args[0];
+	for (size_t i = 0; i < count; i++, p += 4) {
+		float r = p[0], g = p[1], b = p[2];
+		float sr = 0.393f * r + 0.769f * g + 0.189f * b;
+		float sg = 0.349f * r + 0.686f * g + 0.168f * b;
+		float sb = 0.272f * r + 0.534f * g + 0.131f * b;
+		p[0] = r + (sr - r) * k;
+		p[1] = g + (sg - g) * k;
+		p[2] = b + (sb - b) * k;
+	}
+}
+
+/// CIColorMatrix: args = [R(4), G(4), B(4), A(4), bias(4)]
+static void JRColorMatrixFunction(float* p, const float* const*, size_t count, const float* m)
+{
+	for (size_t i = 0; i < count; i++, p += 4) {
+		float r = p[0], g = p[1], b = p[2], a = p[3];
+		p[0] = m[0] * r + m[1] * g + m[2] * b + m[3] * a + m[16];
+		p[1] = m[4] * r + m[5] * g + m[6] * b + m[7] * a + m[17];
+		p[2] = m[8] * r + m[9] * g + m[10] * b + m[11] * a + m[18];
+		p[3] = m[12] * r + m[13] * g + m[14] * b + m[15] * a + m[19];
+	}
+}
+
+/// CIExposureAdjust: args = [2^EV], 直接作用于预乘数据
+static void JRExposureFunction(float* p, const float* const*, size_t count, const float* args)
+{
+	float scale = args[0];
+	for (size_t i = 0; i < count; i++, p += 4) {
+		p[0] *= scale;
+		p[1] *= scale;
+		p[2] *= scale;
+	}
+}
+
+/// CIColorControls: args = [saturation, brightness, contrast]
+static void JRColorControlsFunction(float* p, const float* const*, size_t count, const float* args)
+{
+	float s = args[0], brightness = args[1], contrast = args[2];
+	for (size_t i = 0; i < count; i++, p += 4) {
+		float luma = 0.2125f * p[0] + 0.7154f * p[1] + 0.0721f * p[2];
+		for (int c = 0; c < 3; c++) {
+			float v = luma + (p[c] - luma) * s + brightness;
+			p[c] = (v - 0.5f) * contrast + 0.5f;
+		}
+	}
+}
+
+/// CIColorInvert
+static void JRColorInvertFunction(float* p, const float* const*, size_t count, const float*)
+{
+	for (size_t i = 0; i < count; i++, p += 4) {
+		p[0] = 1.0f - p[0];
+		p[1] = 1.0f - p[1];
+		p[2] = 1.0f - p[2];
+	}
+}
+
+/// CIRadialGradient: args = [centerX, centerY, radius0, radius1, color0(4), color1(4)], 颜色已预乘
+class JRRadialGradientKernel : public JRGeneralKernel {
+public:
+	JRRadialGradientKernel()
+	: JRGeneralKernel("CIRadialGradient")
+	{
+	}
+
+	static JRKernelRef kernel()
+	{
+		static JRKernelRef kernel = std::make_shared<JRRadialGradientKernel>();
+		return kernel;
+	}
+
+	JRRect extent(const std::vector<JRRect>&, const JRKernelArguments&) const override
+	{
+		return JRRectInfinite;
+	}
+
+	JRRect regionOfInterest(size_t, const JRRect&, const JRKernelArguments&) const override
+	{
+		return JRRectNull;
+	}
+
+	/// 圆心随变换移动, 半径按比例缩放
+	bool transformArguments(const JRAffineTransform& t, const JRKernelArguments& args, JRKernelArguments* transformed) const override
+	{
+		double scale = JRAffineTransformUniformScale(t);
+		if (scale <= 0) {
+			return false;
+		}
+		double cx, cy;
+		JRAffineTransformApply(t, args[0], args[1], &cx, &cy);
+		*transformed = args;
+		(*transformed)[0] = float(cx);
+		(*transformed)[1] = float(cy);
+		(*transformed)[2] = float(args[2] * scale);
+		(*transformed)[3] = float(args[3] * scale);
+		return true;
+	}
+
+	void apply(const std::vector<JRBuffer>&, const JRBuffer& output, const JRKernelArguments& args) const override
+	{
+		const JRIRect& r = output.rect();
+		float r0 = args[2], r1 = args[3];
+		const float* c0 = &args[4];
+		const float* c1 = &args[8];
+		for (int y = r.y; y < r.maxY(); y++) {
+			float dy = float(y) + 0.5f - args[1];
+			float* p = output.rowAt(y);
+			for (int x = r.x; x < r.maxX(); x++, p += 4) {
+				float dx = float(x) + 0.5f - args[0];
+				float d = std::sqrt(dx * dx + dy * dy);
+				float t = r1 != r0 ? (d - r0) / (r1 - r0) : (d < r0 ? 0.0f : 1.0f);
+				t = t < 0 ? 0 : t > 1 ? 1 : t;
+				for (int c = 0; c < 4; c++) {
+					p[c] = c0[c] + (c1[c] - c0[c]) * t;
+				}
+			}
+		}
+	}
+};
+
+static JRKernelRef JRSepiaToneKernel()
+{
+	static JRKernelRef kernel = std::make_shared<JRColorKernel>("CISepiaTone", JRSepiaToneFunction, kJRColorKernelOptionUnpremultiplied);
+	return kernel;
+}
+
+static JRKernelRef JRColorMatrixKernel()
+{
+	static JRKernelRef kernel = std::make_shared<JRColorKernel>("CIColorMatrix", JRColorMatrixFunction, kJRColorKernelOptionUnpremultiplied);
+	return kernel;
+}
+
+static JRKernelRef JRExposureKernel()
+{
+	static JRKernelRef kernel = std::make_shared<JRColorKernel>("CIExposureAdjust", JRExposureFunction);
+	return kernel;
+}
+
+static JRKernelRef JRColorControlsKernel()
+{
+	static JRKernelRef kernel = std::make_shared<JRColorKernel>("CIColorControls", JRColorControlsFunction, kJRColorKernelOptionUnpremultiplied);
+	return kernel;
+}
+
+static JRKernelRef JRColorInvertKernel()
+{
+	static JRKernelRef kernel = std::make_shared<JRColorKernel>("CIColorInvert", JRColorInvertFunction, kJRColorKernelOptionUnpremultiplied);
+	return kernel;
+}
+
+// MARK: - Outputs
+
+static JRImageRef JRSepiaToneOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	return JRImage::imageWithKernel(JRSepiaToneKernel(), { image }, { float(f.doubleForKey(kJRInputIntensityKeyID)) });
+}
+
+static JRImageRef JRColorMatrixOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	JRKernelArguments args;
+	for (const char* key : { "inputRVector", "inputGVector", "inputBVector", "inputAVector", "inputBiasVector" }) {
+		JRVector v = f.vectorForKey(key);
+		for (int i = 0; i < 4; i++) {
+			args.push_back(float(v.valueAtIndex(i)));
+		}
+	}
+	return JRImage::imageWithKernel(JRColorMatrixKernel(), { image }, args);
+}
+
+static JRImageRef JRExposureAdjustOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	return JRImage::imageWithKernel(JRExposureKernel(), { image }, { float(std::exp2(f.doubleForKey(kJRInputEVKeyID))) });
+}
+
+static JRImageRef JRColorControlsOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	return JRImage::imageWithKernel(JRColorControlsKernel(), { image }, {
+		float(f.doubleForKey(kJRInputSaturationKeyID)),
+		float(f.doubleForKey(kJRInputBrightnessKeyID)),
+		float(f.doubleForKey(kJRInputContrastKeyID)),
+	});
+}
+
+static JRImageRef JRColorInvertOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	return JRImage::imageWithKernel(JRColorInvertKernel(), { image }, {});
+}
+
+static JRImageRef JRSRGBToneCurveToLinearOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	return JRImage::imageWithKernel(JRSRGBToLinearKernel(), { image }, {});
+}
+
+static JRImageRef JRLinearToSRGBToneCurveOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	return JRImage::imageWithKernel(JRLinearToSRGBKernel(), { image }, {});
+}
+
+static JRImageRef JRColorCubeOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	JRValue value = f.valueForKey("inputCubeData");
+	const std::string* data = std::get_if<std::string>(&value);
+	if (!image || !data) {
+		return nullptr;
+	}
+	/// inputCubeData 与 CIColorCube 相同: float RGBA, 按字节存放
+	std::vector<float> cells(data->size() / sizeof(float));
+	memcpy(cells.data(), data->data(), cells.size() * sizeof(float));
+	std::shared_ptr<const JRColorCube> cube = JRColorCube::cubeWithData(int(f.doubleForKey("inputCubeDimension")), std::move(cells));
+	if (!cube) {
+		return nullptr;
+	}
+	return JRImage::imageWithKernel(std::make_shared<JRColorCubeKernel>(cube), { image }, {});
+}
+
+static JRImageRef JRGaussianBlurOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	/// CIGaussianBlur 的 inputRadius 即标准差
+	double sigma = f.doubleForKey(kJRInputRadiusKeyID);
+	if (!(sigma > 0)) {
+		return image;
+	}
+	return JRImage::imageWithKernel(JRGaussianBlurKernel::kernel(), { image }, { float(sigma) });
+}
+
+static JRImageRef JRMorphologyOutput(const JRBuiltinFilter& f, JRMorphologyOperation operation)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	double width = f.doubleForKey(kJRInputWidthKeyID), height = f.doubleForKey("inputHeight");
+	if (JRMorphologyKernel::radius(width) == 0 && JRMorphologyKernel::radius(height) == 0) {
+		return image;
+	}
+	return JRImage::imageWithKernel(JRMorphologyKernel::kernel(operation), { image }, { float(width), float(height) });
+}
+
+static JRImageRef JRMorphologyRectangleMinimumOutput(const JRBuiltinFilter& f)
+{
+	return JRMorphologyOutput(f, kJRMorphologyMinimum);
+}
+
+static JRImageRef JRMorphologyRectangleMaximumOutput(const JRBuiltinFilter& f)
+{
+	return JRMorphologyOutput(f, kJRMorphologyMaximum);
+}
+
+static JRImageRef JRMedianFilterOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	if (!image) {
+		return nullptr;
+	}
+	/// inputRadius 是扩展的输入, 默认 1 即 Core Image 的 3 x 3
+	double radius = f.doubleForKey(kJRInputRadiusKeyID);
+	if (!(radius >= 0.5)) {
+		return image;
+	}
+	return JRImage::imageWithKernel(JRMedianKernel::kernel(), { image }, { float(radius) });
+}
+
+static JRImageRef JRAffineTransformOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	JRAffineTransform transform = JRAffineTransformIdentity;
+	if (!image) {
+		return nullptr;
+	}
+	JRValueGetTransform(f.valueForKey(kJRInputTransformKeyID), &transform);
+	return image->applying(transform);
+}
+
+static JRImageRef JRCropOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	JRRect rect = JRRectInfinite;
+	if (!image) {
+		return nullptr;
+	}
+	JRValueGetRect(f.valueForKey("inputRectangle"), &rect);
+	return image->cropping(rect);
+}
+
+static JRImageRef JRConstantColorGeneratorOutput(const JRBuiltinFilter& f)
+{
+	JRColor color = JRColor::colorWithRed(1, 1, 1, 1);
+	JRValueGetColor(f.valueForKey(kJRInputColorKeyID), &color);
+	return JRImage::imageWithColor(color);
+}
+
+/// 合成滤镜: inputImage 在 inputBackgroundImage 之上
+template <JRCompositeOperation operation>
+static JRImageRef JRCompositingOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	JRImageRef background = f.imageForKey(kJRInputBackgroundImageKeyID);
+	if (!image || !background) {
+		/// 缺少一方时 source-over 的结果就是另一方
+		return operation == kJRCompositeSourceOver ? (image ? image : background) : nullptr;
+	}
+	return JRImage::imageWithKernel(JRCompositeKernel::kernel(operation), { image, background }, {});
+}
+
+template <JRCompositeOperation operation>
+static JRImageRef JRBlendWithMaskOutput(const JRBuiltinFilter& f)
+{
+	JRImageRef image = f.imageForKey(kJRInputImageKeyID);
+	JRImageRef background = f.imageForKey(kJRInputBackgroundImageKeyID);
+	JRImageRef mask = f.imageForKey(kJRInputMaskImageKeyID);
+	if (!image || !background || !mask) {
+		return nullptr;
+	}
+	return JRImage::imageWithKernel(JRCompositeKernel::kernel(operation), { image, background, mask }, {});
+}
+
+static JRImageRef JRRadialGradientOutput(const JRBuiltinFilter& f)
+{
+	JRVector center = f.vectorForKey(kJRInputCenterKey);
+	JRKernelArguments args = { float(center.x), float(center.y), float(f.doubleForKey("inputRadius0")), float(f.doubleForKey("inputRadius1")) };
+	for (const char* key : { "inputColor0", "inputColor1" }) {
+		JRColor color = JRColor::clearColor();
+		JRValueGetColor(f.valueForKey(key), &color);
+		args.insert(args.end(), { color.red * color.alpha, color.green * color.alpha, color.blue * color.alpha, color.alpha });
+	}
+	return JRImage::imageWithKernel(JRRadialGradientKernel::kernel(), {}, args);
+}
+
+// MARK: - Registration
+
+static JRFilterAttribute JRImageAttribute(const std::string& name)
+{
+	return JRFilterAttributeWithType(name, kJRAttributeTypeImage, JRValue());
+}
+
+static void JRRegisterBuiltin(const JRFilterRegisterFunction& registerName, const std::string& name,
+							  const std::vector<std::string>& categories,
+							  const std::vector<JRFilterAttribute>& attributes, JRBuiltinFilter::Output output)
+{
+	std::vector<std::string> allCategories = categories;
+	allCategories.push_back(kJRCategoryBuiltIn);
+	/// 每个滤镜类只解析一次输入, 所有实例共用
+	JRFilterLayoutRef layout = JRFilterLayout::layoutWithAttributes(attributes);
+	registerName(name, [layout, output](const std::string& filterName) -> JRFilterRef {
+		return std::make_shared<JRBuiltinFilter>(filterName, layout, output);
+	}, { name.substr(2), allCategories });
+}
+
+void JRRegisterBuiltinFilters(const JRFilterRegisterFunction& registerName)
+{
+	JRRegisterBuiltin(registerName, "CISepiaTone",
+					  { kJRCategoryColorEffect, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey), JRFilterScalarAttribute(kJRInputIntensityKey, 1.0, 0.0, 1.0, 0.0, 1.0, 0.0) },
+					  JRSepiaToneOutput);
+
+	JRRegisterBuiltin(registerName, "CIColorMatrix",
+					  { kJRCategoryColorAdjustment, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey),
+						JRFilterAttributeWithType("inputRVector", kJRAttributeTypeOffset, JRVector::vectorWithXYZW(1, 0, 0, 0)),
+						JRFilterAttributeWithType("inputGVector", kJRAttributeTypeOffset, JRVector::vectorWithXYZW(0, 1, 0, 0)),
+						JRFilterAttributeWithType("inputBVector", kJRAttributeTypeOffset, JRVector::vectorWithXYZW(0, 0, 1, 0)),
+						JRFilterAttributeWithType("inputAVector", kJRAttributeTypeOffset, JRVector::vectorWithXYZW(0, 0, 0, 1)),
+						JRFilterAttributeWithType("inputBiasVector", kJRAttributeTypeOffset, JRVector::vectorWithXYZW(0, 0, 0, 0)) },
+					  JRColorMatrixOutput);
+
+	JRRegisterBuiltin(registerName, "CIExposureAdjust",
+					  { kJRCategoryColorAdjustment, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey), JRFilterScalarAttribute(kJRInputEVKey, 0.0, -10.0, 10.0, 0.0) },
+					  JRExposureAdjustOutput);
+
+	JRRegisterBuiltin(registerName, "CIColorControls",
+					  { kJRCategoryColorAdjustment, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey),
+						JRFilterScalarAttribute(kJRInputSaturationKey, 1.0, 0.0, INFINITY, 0.0, 2.0, 1.0),
+						JRFilterScalarAttribute(kJRInputBrightnessKey, 0.0, -1.0, INFINITY, -1.0, 1.0, 0.0),
+						JRFilterScalarAttribute(kJRInputContrastKey, 1.0, 0.0, INFINITY, 0.25, 4.0, 1.0) },
+					  JRColorControlsOutput);
+
+	JRRegisterBuiltin(registerName, "CIColorInvert",
+					  { kJRCategoryColorEffect, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey) },
+					  JRColorInvertOutput);
+
+	JRRegisterBuiltin(registerName, "CISRGBToneCurveToLinear",
+					  { kJRCategoryColorAdjustment, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey) },
+					  JRSRGBToneCurveToLinearOutput);
+
+	JRRegisterBuiltin(registerName, "CILinearToSRGBToneCurve",
+					  { kJRCategoryColorAdjustment, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey) },
+					  JRLinearToSRGBToneCurveOutput);
+
+	JRRegisterBuiltin(registerName, "CIColorCube",
+					  { kJRCategoryColorEffect, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey),
+						JRFilterScalarAttribute("inputCubeDimension", 2.0, 2.0, 128.0, 2.0, 128.0, 2.0),
+						JRFilterAttributeWithType("inputCubeData", "", std::string()) },
+					  JRColorCubeOutput);
+
+	JRRegisterBuiltin(registerName, "CIGaussianBlur",
+					  { kJRCategoryBlur, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey), JRFilterScalarAttribute(kJRInputRadiusKey, 10.0, 0.0, INFINITY, 0.0, 100.0, 0.0) },
+					  JRGaussianBlurOutput);
+
+	JRRegisterBuiltin(registerName, "CIMorphologyRectangleMinimum",
+					  { kJRCategoryBlur, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey),
+						JRFilterScalarAttribute(kJRInputWidthKey, 5.0, 1.0, INFINITY, 1.0, 201.0, 1.0),
+						JRFilterScalarAttribute("inputHeight", 5.0, 1.0, INFINITY, 1.0, 201.0, 1.0) },
+					  JRMorphologyRectangleMinimumOutput);
+
+	JRRegisterBuiltin(registerName, "CIMorphologyRectangleMaximum",
+					  { kJRCategoryBlur, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey),
+						JRFilterScalarAttribute(kJRInputWidthKey, 5.0, 1.0, INFINITY, 1.0, 201.0, 1.0),
+						JRFilterScalarAttribute("inputHeight", 5.0, 1.0, INFINITY, 1.0, 201.0, 1.0) },
+					  JRMorphologyRectangleMaximumOutput);
+
+	JRRegisterBuiltin(registerName, "CIMedianFilter",
+					  { kJRCategoryBlur, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey), JRFilterScalarAttribute(kJRInputRadiusKey, 1.0, 0.0, INFINITY, 0.0, 100.0, 0.0) },
+					  JRMedianFilterOutput);
+
+	JRRegisterBuiltin(registerName, "CIAffineTransform",
+					  { kJRCategoryGeometryAdjustment, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey),
+						JRFilterAttributeWithType(kJRInputTransformKey, kJRAttributeTypeTransform, JRAffineTransformIdentity) },
+					  JRAffineTransformOutput);
+
+	JRRegisterBuiltin(registerName, "CICrop",
+					  { kJRCategoryGeometryAdjustment, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey),
+						JRFilterAttributeWithType("inputRectangle", kJRAttributeTypeRectangle, JRRectInfinite) },
+					  JRCropOutput);
+
+	/// 合成滤镜的输入都是 inputImage 和 inputBackgroundImage
+	const std::pair<const char*, JRBuiltinFilter::Output> composites[] = {
+		{ "CISourceOverCompositing", JRCompositingOutput<kJRCompositeSourceOver> },
+		{ "CISourceInCompositing", JRCompositingOutput<kJRCompositeSourceIn> },
+		{ "CISourceOutCompositing", JRCompositingOutput<kJRCompositeSourceOut> },
+		{ "CISourceAtopCompositing", JRCompositingOutput<kJRCompositeSourceAtop> },
+		{ "CIAdditionCompositing", JRCompositingOutput<kJRCompositeAddition> },
+		{ "CIMultiplyCompositing", JRCompositingOutput<kJRCompositeMultiply> },
+		{ "CIMultiplyBlendMode", JRCompositingOutput<kJRCompositeMultiplyBlend> },
+		{ "CIScreenBlendMode", JRCompositingOutput<kJRCompositeScreenBlend> },
+		{ "CIOverlayBlendMode", JRCompositingOutput<kJRCompositeOverlayBlend> },
+		{ "CIDarkenBlendMode", JRCompositingOutput<kJRCompositeDarkenBlend> },
+		{ "CILightenBlendMode", JRCompositingOutput<kJRCompositeLightenBlend> },
+		{ "CIDifferenceBlendMode", JRCompositingOutput<kJRCompositeDifferenceBlend> },
+		{ "CIExclusionBlendMode", JRCompositingOutput<kJRCompositeExclusionBlend> },
+		{ "CIHardLightBlendMode", JRCompositingOutput<kJRCompositeHardLightBlend> },
+	};
+	for (const auto& composite : composites) {
+		JRRegisterBuiltin(registerName, composite.first,
+						  { kJRCategoryCompositeOperation, kJRCategoryVideo, kJRCategoryStillImage },
+						  { JRImageAttribute(kJRInputImageKey), JRImageAttribute(kJRInputBackgroundImageKey) },
+						  composite.second);
+	}
+
+	JRRegisterBuiltin(registerName, "CIBlendWithMask",
+					  { kJRCategoryStylize, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey), JRImageAttribute(kJRInputBackgroundImageKey),
+						JRImageAttribute(kJRInputMaskImageKey) },
+					  JRBlendWithMaskOutput<kJRCompositeBlendWithMask>);
+
+	JRRegisterBuiltin(registerName, "CIBlendWithAlphaMask",
+					  { kJRCategoryStylize, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRImageAttribute(kJRInputImageKey), JRImageAttribute(kJRInputBackgroundImageKey),
+						JRImageAttribute(kJRInputMaskImageKey) },
+					  JRBlendWithMaskOutput<kJRCompositeBlendWithAlphaMask>);
+
+	JRRegisterBuiltin(registerName, "CIRadialGradient",
+					  { kJRCategoryGenerator, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRFilterAttributeWithType(kJRInputCenterKey, kJRAttributeTypePosition, JRVector::vectorWithXY(150, 150)),
+						JRFilterAttributeWithType("inputRadius0", kJRAttributeTypeDistance, 5.0),
+						JRFilterAttributeWithType("inputRadius1", kJRAttributeTypeDistance, 100.0),
+						JRFilterAttributeWithType("inputColor0", kJRAttributeTypeColor, JRColor::colorWithRed(1, 1, 1, 1)),
+						JRFilterAttributeWithType("inputColor1", kJRAttributeTypeColor, JRColor::colorWithRed(0, 0, 0, 1)) },
+					  JRRadialGradientOutput);
+
+	JRRegisterBuiltin(registerName, "CIConstantColorGenerator",
+					  { kJRCategoryGenerator, kJRCategoryVideo, kJRCategoryStillImage },
+					  { JRFilterAttributeWithType(kJRInputColorKey, kJRAttributeTypeColor, JRColor::colorWithRed(1, 0, 0, 1)) },
+					  JRConstantColorGeneratorOutput);
+}
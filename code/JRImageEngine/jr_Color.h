@@ -0,0 +1,26 @@
+//
+//  jr_Color.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Color_h
+#define jr_Color_h
+
+/* An unpremultiplied RGBA color, the counterpart of CIColor. */
+struct JRColor {
+	float red;
+	float green;
+	float blue;
+	float alpha;
+
+	static JRColor colorWithRed(float r, float g, float b, float a = 1.0f) { return { r, g, b, a }; }
+	static JRColor clearColor() { return { 0, 0, 0, 0 }; }
+
+	bool operator==(const JRColor& c) const { return red == c.red && green == c.green && blue == c.blue && alpha == c.alpha; }
+	bool operator!=(const JRColor& c) const { return !(*this == c); }
+};
+
+#endif /* jr_Color_h */
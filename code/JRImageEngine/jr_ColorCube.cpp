@@ -0,0 +1,390 @@
+//
+//  jr_ColorCube.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_ColorCube.h"
+#include "jr_GraphOptimizer.h"
+#include "jr_SIMD.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <list>
+#include <mutex>
+
+#if defined(JR_SIMD_X86)
+#include <immintrin.h>
+#elif defined(JR_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/// 烘焙结果缓存的条目数
+static const size_t kJRColorCubeCacheEntries = 16;
+/// 越界检查和回退的粒度
+static const size_t kJRColorCubeChunkPixels = 256;
+/// 烘焙允许的最大插值误差, 8 位输出的 1/4 级
+static const float kJRColorCubeMaximumError = 1.0f / 1024.0f;
+
+JRColorCube::JRColorCube(int dimension, std::vector<float> cells)
+: _dimension(dimension), _cells(std::move(cells))
+{
+}
+
+std::shared_ptr<const JRColorCube> JRColorCube::cubeWithData(int dimension, std::vector<float> cells)
+{
+	if (dimension < 2 || dimension > 128 || cells.size() != size_t(dimension) * dimension * dimension * 4) {
+		return nullptr;
+	}
+	return std::shared_ptr<const JRColorCube>(new JRColorCube(dimension, std::move(cells)));
+}
+
+// MARK: - Lookup
+
+/* The four cells around a colour and their weights. Tetrahedral
+ * interpolation splits each lattice cell into six tetrahedra along the
+ * diagonal and blends the corners of the one containing the colour. */
+struct JRCubeCorners {
+	const float* v[4];
+	float w[4];
+};
+
+/// NaN 比较结果为假, 得到 0, 与向量的 max/min 相同; 否则 int(NaN) 会越界
+static inline float JRCubeClamp(float v)
+{
+	return !(v > 0.0f) ? 0.0f : v < 1.0f ? v : 1.0f;
+}
+
+static inline void JRCubeLocate(const float* cells, int dimension, const float* p, JRCubeCorners& corners)
+{
+	float a = p[3];
+	float inv = a > 0 ? 1.0f / a : 0.0f;
+	float scale = float(dimension - 1);
+	float r = JRCubeClamp(p[0] * inv) * scale;
+	float g = JRCubeClamp(p[1] * inv) * scale;
+	float b = JRCubeClamp(p[2] * inv) * scale;
+	int ir = std::min(int(r), dimension - 2);
+	int ig = std::min(int(g), dimension - 2);
+	int ib = std::min(int(b), dimension - 2);
+	float fr = r - float(ir), fg = g - float(ig), fb = b - float(ib);
+
+	size_t sr = 4, sg = size_t(dimension) * 4, sb = size_t(dimension) * dimension * 4;
+	const float* base = cells + size_t(ir) * sr + size_t(ig) * sg + size_t(ib) * sb;
+	/// 沿小数部分最大的轴走第一条边, 最小的轴走最后一条; 不用分支, 数据杂乱时也不会预测失败
+	float f1 = std::max(std::max(fr, fg), fb);
+	float f3 = std::min(std::min(fr, fg), fb);
+	float f2 = std::max(std::min(fr, fg), std::min(std::max(fr, fg), fb));
+	size_t first = fr >= fg && fr >= fb ? sr : fg >= fb ? sg : sb;
+	size_t last = fb <= fg && fb <= fr ? sb : fg <= fr ? sg : sr;
+	corners.v[0] = base;
+	corners.v[1] = base + first;
+	corners.v[2] = base + sr + sg + sb - last;
+	corners.v[3] = base + sr + sg + sb;
+	corners.w[0] = (1.0f - f1) * a;
+	corners.w[1] = (f1 - f2) * a;
+	corners.w[2] = (f2 - f3) * a;
+	corners.w[3] = f3 * a;
+}
+
+static void JRColorCubeApplyScalar(const float* cells, int dimension, float* p, size_t count)
+{
+	JRCubeCorners c;
+	for (size_t i = 0; i < count; i++, p += 4) {
+		JRCubeLocate(cells, dimension, p, c);
+		for (int k = 0; k < 4; k++) {
+			p[k] = (c.w[0] * c.v[0][k] + c.w[1] * c.v[1][k]) + (c.w[2] * c.v[2][k] + c.w[3] * c.v[3][k]);
+		}
+	}
+}
+
+#if defined(JR_SIMD_X86)
+
+#define JR_TARGET_AVX2 __attribute__((target("avx2")))
+
+/* Eight pixels at a time: the corners and weights are computed in vectors,
+ * with the same operations as JRCubeLocate, then each pixel blends its four
+ * cells with SSE. Results match the scalar kernel bit for bit. */
+JR_TARGET_AVX2 static void JRColorCubeApplyAVX2(const float* cells, int dimension, float* p, size_t count)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 scale = _mm256_set1_ps(float(dimension - 1));
+	const __m256i top = _mm256_set1_epi32(dimension - 2);
+	const int sr = 4, sg = dimension * 4, sb = dimension * dimension * 4;
+	const __m256i strideR = _mm256_set1_epi32(sr), strideG = _mm256_set1_epi32(sg), strideB = _mm256_set1_epi32(sb);
+	/// 转置后第 k 个通道对应的像素
+	static const int kLanePixel[8] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+	alignas(32) int32_t base[8], first[8], last[8];
+	alignas(32) float w0[8], w1[8], w2[8], w3[8];
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8, p += 32) {
+		__m256 m0 = _mm256_loadu_ps(p), m1 = _mm256_loadu_ps(p + 8), m2 = _mm256_loadu_ps(p + 16), m3 = _mm256_loadu_ps(p + 24);
+		__m256 t0 = _mm256_unpacklo_ps(m0, m1), t1 = _mm256_unpackhi_ps(m0, m1);
+		__m256 t2 = _mm256_unpacklo_ps(m2, m3), t3 = _mm256_unpackhi_ps(m2, m3);
+		__m256 a = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		__m256 inv = _mm256_and_ps(_mm256_div_ps(one, a), _mm256_cmp_ps(a, zero, _CMP_GT_OQ));
+		__m256 r = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), inv), zero), one), scale);
+		__m256 g = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)), inv), zero), one), scale);
+		__m256 b = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), inv), zero), one), scale);
+		__m256i ir = _mm256_min_epi32(_mm256_cvttps_epi32(r), top);
+		__m256i ig = _mm256_min_epi32(_mm256_cvttps_epi32(g), top);
+		__m256i ib = _mm256_min_epi32(_mm256_cvttps_epi32(b), top);
+		__m256 fr = _mm256_sub_ps(r, _mm256_cvtepi32_ps(ir));
+		__m256 fg = _mm256_sub_ps(g, _mm256_cvtepi32_ps(ig));
+		__m256 fb = _mm256_sub_ps(b, _mm256_cvtepi32_ps(ib));
+
+		__m256 f1 = _mm256_max_ps(_mm256_max_ps(fr, fg), fb);
+		__m256 f3 = _mm256_min_ps(_mm256_min_ps(fr, fg), fb);
+		__m256 f2 = _mm256_max_ps(_mm256_min_ps(fr, fg), _mm256_min_ps(_mm256_max_ps(fr, fg), fb));
+		__m256i rFirst = _mm256_castps_si256(_mm256_and_ps(_mm256_cmp_ps(fr, fg, _CMP_GE_OQ), _mm256_cmp_ps(fr, fb, _CMP_GE_OQ)));
+		__m256i gFirst = _mm256_castps_si256(_mm256_cmp_ps(fg, fb, _CMP_GE_OQ));
+		__m256i bLast = _mm256_castps_si256(_mm256_and_ps(_mm256_cmp_ps(fb, fg, _CMP_LE_OQ), _mm256_cmp_ps(fb, fr, _CMP_LE_OQ)));
+		__m256i gLast = _mm256_castps_si256(_mm256_cmp_ps(fg, fr, _CMP_LE_OQ));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(first), _mm256_blendv_epi8(_mm256_blendv_epi8(strideB, strideG, gFirst), strideR, rFirst));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(last), _mm256_blendv_epi8(_mm256_blendv_epi8(strideR, strideG, gLast), strideB, bLast));
+		__m256i offset = _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(ir, strideR), _mm256_mullo_epi32(ig, strideG)), _mm256_mullo_epi32(ib, strideB));
+		_mm256_store_si256(reinterpret_cast<__m256i*>(base), offset);
+		_mm256_store_ps(w0, _mm256_mul_ps(_mm256_sub_ps(one, f1), a));
+		_mm256_store_ps(w1, _mm256_mul_ps(_mm256_sub_ps(f1, f2), a));
+		_mm256_store_ps(w2, _mm256_mul_ps(_mm256_sub_ps(f2, f3), a));
+		_mm256_store_ps(w3, _mm256_mul_ps(f3, a));
+
+		for (int k = 0; k < 8; k++) {
+			const float* v = cells + base[k];
+			__m128 s0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(w0[k]), _mm_loadu_ps(v)), _mm_mul_ps(_mm_set1_ps(w1[k]), _mm_loadu_ps(v + first[k])));
+			__m128 s1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(w2[k]), _mm_loadu_ps(v + sr + sg + sb - last[k])),
+								   _mm_mul_ps(_mm_set1_ps(w3[k]), _mm_loadu_ps(v + sr + sg + sb)));
+			_mm_storeu_ps(p + kLanePixel[k] * 4, _mm_add_ps(s0, s1));
+		}
+	}
+	JRColorCubeApplyScalar(cells, dimension, p, count - i);
+}
+
+#elif defined(JR_SIMD_NEON)
+
+static void JRColorCubeApplyNEON(const float* cells, int dimension, float* p, size_t count)
+{
+	JRCubeCorners c;
+	for (size_t i = 0; i < count; i++, p += 4) {
+		JRCubeLocate(cells, dimension, p, c);
+		float32x4_t s0 = vaddq_f32(vmulq_n_f32(vld1q_f32(c.v[0]), c.w[0]), vmulq_n_f32(vld1q_f32(c.v[1]), c.w[1]));
+		float32x4_t s1 = vaddq_f32(vmulq_n_f32(vld1q_f32(c.v[2]), c.w[2]), vmulq_n_f32(vld1q_f32(c.v[3]), c.w[3]));
+		vst1q_f32(p, vaddq_f32(s0, s1));
+	}
+}
+
+#endif
+
+void JRColorCube::apply(float* pixels, size_t count) const
+{
+#if defined(JR_SIMD_X86)
+	if (JRSIMDActiveLevel() >= kJRSIMDLevelAVX2) {
+		JRColorCubeApplyAVX2(_cells.data(), _dimension, pixels, count);
+		return;
+	}
+#elif defined(JR_SIMD_NEON)
+	if (JRSIMDActiveLevel() == kJRSIMDLevelNEON) {
+		JRColorCubeApplyNEON(_cells.data(), _dimension, pixels, count);
+		return;
+	}
+#endif
+	JRColorCubeApplyScalar(_cells.data(), _dimension, pixels, count);
+}
+
+// MARK: - Kernels
+
+JRColorCubeKernel::JRColorCubeKernel(const std::shared_ptr<const JRColorCube>& cube)
+: JRColorKernel("CIColorCube", nullptr), _cube(cube)
+{
+}
+
+void JRColorCubeKernel::apply(float* pixels, const float* const*, size_t count, const float*) const
+{
+	_cube->apply(pixels, count);
+}
+
+static uint64_t JRChainHash(const JRColorKernel& chain, const JRKernelArguments& args)
+{
+	uint64_t hash = JRHashCombine(chain.hash(), args.size());
+	for (float value : args) {
+		uint32_t bits;
+		memcpy(&bits, &value, 4);
+		hash = JRHashCombine(hash, bits);
+	}
+	return hash;
+}
+
+/* A cube baked from a colour chain. Keeps the chain for pixels the cube
+ * cannot represent. */
+class JRBakedColorCubeKernel : public JRColorCubeKernel {
+public:
+	JRBakedColorCubeKernel(const std::shared_ptr<const JRColorCube>& cube, const std::shared_ptr<const JRColorKernel>& chain,
+						   const JRKernelArguments& arguments)
+	: JRColorCubeKernel(cube), _chain(chain), _arguments(arguments)
+	{
+	}
+
+	const std::shared_ptr<const JRColorKernel>& chain() const { return _chain; }
+	const JRKernelArguments& arguments() const { return _arguments; }
+
+	void apply(float* pixels, const float* const*, size_t count, const float*) const override
+	{
+		for (size_t start = 0; start < count; start += kJRColorCubeChunkPixels) {
+			size_t n = std::min(kJRColorCubeChunkPixels, count - start);
+			float* p = pixels + start * 4;
+			/// 预乘形式下 0 <= c <= a 即反预乘后在 [0, 1] 内
+			bool inside = true;
+			for (size_t i = 0; i < n * 4 && inside; i += 4) {
+				float a = p[i + 3];
+				inside = p[i] >= 0 && p[i] <= a && p[i + 1] >= 0 && p[i + 1] <= a && p[i + 2] >= 0 && p[i + 2] <= a;
+			}
+			if (inside) {
+				cube()->apply(p, n);
+			} else {
+				_chain->apply(p, nullptr, n, _arguments.data());
+			}
+		}
+	}
+
+	uint64_t hash() const override
+	{
+		return JRChainHash(*_chain, _arguments);
+	}
+
+	bool isEqual(const JRKernel& other) const override
+	{
+		const JRBakedColorCubeKernel* baked = dynamic_cast<const JRBakedColorCubeKernel*>(&other);
+		return baked && baked->_arguments == _arguments && baked->_chain->isEqual(*_chain);
+	}
+
+private:
+	std::shared_ptr<const JRColorKernel> _chain;
+	JRKernelArguments _arguments;
+};
+
+// MARK: - Baking
+
+/// 链在格点上的值; 不满足 "只依赖反预乘 RGB, alpha 不变" 时返回 nullptr
+static std::shared_ptr<const JRColorCube> JRSampleChain(const JRColorKernel& chain, const JRKernelArguments& args)
+{
+	const int n = kJRColorCubeBakeDimension;
+	const float step = 1.0f / float(n - 1);
+	std::vector<float> cells(size_t(n) * n * n * 4);
+	float* p = cells.data();
+	for (int b = 0; b < n; b++) {
+		for (int g = 0; g < n; g++) {
+			for (int r = 0; r < n; r++, p += 4) {
+				p[0] = float(r) * step;
+				p[1] = float(g) * step;
+				p[2] = float(b) * step;
+				p[3] = 1.0f;
+			}
+		}
+	}
+	chain.apply(cells.data(), nullptr, cells.size() / 4, args.data());
+
+	/// 抽样检查: 半透明像素的结果应该是不透明结果乘以 alpha
+	std::vector<float> probe;
+	std::vector<size_t> probed;
+	for (size_t i = 0; i < cells.size() / 4; i += 7) {
+		if (std::fabs(cells[i * 4 + 3] - 1.0f) > 1e-6f) {
+			return nullptr;
+		}
+		int r = int(i % size_t(n)), g = int(i / size_t(n) % size_t(n)), b = int(i / (size_t(n) * n));
+		for (float a : { 0.5f, 0.125f }) {
+			probe.insert(probe.end(), { float(r) * step * a, float(g) * step * a, float(b) * step * a, a });
+			probed.push_back(i);
+		}
+	}
+	chain.apply(probe.data(), nullptr, probed.size(), args.data());
+	for (size_t k = 0; k < probed.size(); k++) {
+		const float* expected = &cells[probed[k] * 4];
+		const float* actual = &probe[k * 4];
+		float a = actual[3];
+		for (int c = 0; c < 3; c++) {
+			if (std::fabs(actual[c] - expected[c] * a) > 1e-4f * std::max(1.0f, std::fabs(expected[c]))) {
+				return nullptr;
+			}
+		}
+	}
+	std::shared_ptr<const JRColorCube> cube = JRColorCube::cubeWithData(n, std::move(cells));
+
+	/// 格子中心离格点最远, 在这里比较插值误差. 陡峭的曲线 (例如 JRLinearToSRGB 靠近 0 的部分) 不烘焙
+	std::vector<float> exact;
+	for (size_t i = 0; i < size_t(n - 1) * (n - 1) * (n - 1); i += 5) {
+		size_t m = size_t(n - 1);
+		exact.insert(exact.end(), { (float(i % m) + 0.5f) * step, (float(i / m % m) + 0.5f) * step, (float(i / (m * m)) + 0.5f) * step, 1.0f });
+	}
+	std::vector<float> looked = exact;
+	chain.apply(exact.data(), nullptr, exact.size() / 4, args.data());
+	cube->apply(looked.data(), looked.size() / 4);
+	for (size_t i = 0; i < exact.size(); i++) {
+		if (std::fabs(exact[i] - looked[i]) > kJRColorCubeMaximumError) {
+			return nullptr;
+		}
+	}
+	return cube;
+}
+
+/* Baked kernels by chain, most recently used first. */
+class JRColorCubeCache {
+public:
+	static JRColorCubeCache& sharedCache()
+	{
+		static JRColorCubeCache cache;
+		return cache;
+	}
+
+	std::shared_ptr<const JRBakedColorCubeKernel> kernelForChain(const std::shared_ptr<const JRColorKernel>& chain, const JRKernelArguments& args)
+	{
+		uint64_t hash = JRChainHash(*chain, args);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+				if (it->hash == hash && it->arguments == args && it->chain->isEqual(*chain)) {
+					_entries.splice(_entries.begin(), _entries, it);
+					return it->kernel;
+				}
+			}
+		}
+		/// 烘焙时不持有锁; 两个线程同时烘焙同一条链只会多算一次
+		std::shared_ptr<const JRColorCube> cube = JRSampleChain(*chain, args);
+		std::shared_ptr<const JRBakedColorCubeKernel> kernel = cube ? std::make_shared<JRBakedColorCubeKernel>(cube, chain, args) : nullptr;
+		std::lock_guard<std::mutex> lock(_mutex);
+		_entries.push_front({ hash, chain, args, kernel });
+		if (_entries.size() > kJRColorCubeCacheEntries) {
+			_entries.pop_back();
+		}
+		return kernel;
+	}
+
+private:
+	struct Entry {
+		uint64_t hash;
+		std::shared_ptr<const JRColorKernel> chain;
+		JRKernelArguments arguments;
+		/// 不能烘焙的链也记下来 (kernel 为空), 避免重复检查
+		std::shared_ptr<const JRBakedColorCubeKernel> kernel;
+	};
+
+	std::mutex _mutex;
+	std::list<Entry> _entries;
+};
+
+JRImageRef JRBakeColorCube(const JRImageRef& image)
+{
+	if (!image || image->kind() != kJRImageKindKernel || image->kernel()->type() != kJRKernelTypeColor || image->inputs().size() != 1) {
+		return nullptr;
+	}
+	const JRFusedColorKernel* fused = dynamic_cast<const JRFusedColorKernel*>(image->kernel().get());
+	if (!fused || fused->stages().size() < kJRColorCubeMinimumStages) {
+		return nullptr;
+	}
+	std::shared_ptr<const JRColorKernel> chain = std::static_pointer_cast<const JRColorKernel>(image->kernel());
+	std::shared_ptr<const JRBakedColorCubeKernel> kernel = JRColorCubeCache::sharedCache().kernelForChain(chain, image->arguments());
+	return kernel ? JRImage::imageWithKernel(kernel, image->inputs(), {}) : nullptr;
+}
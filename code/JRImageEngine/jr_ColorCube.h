@@ -0,0 +1,77 @@
+//
+//  jr_ColorCube.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_ColorCube_h
+#define jr_ColorCube_h
+
+#include "jr_Image.h"
+#include "jr_Kernel.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/* Lattice points per axis of the cubes JRBakeColorCube builds. 33 puts the
+ * points on multiples of 1/32, and the table (575 KB) stays in L2. */
+inline constexpr int kJRColorCubeBakeDimension = 33;
+
+/* Fused chains of at least this many stages are baked. Shorter chains are
+ * cheaper to evaluate than the lookup. */
+inline constexpr size_t kJRColorCubeMinimumStages = 3;
+
+/* A 3D colour lookup table, laid out like the inputCubeData of CIColorCube:
+ * 'dimension'^3 premultiplied RGBA cells, red varying fastest, then green,
+ * then blue. */
+class JRColorCube {
+public:
+	/* Returns nullptr unless 2 <= dimension <= 128 and 'cells' holds
+	 * dimension^3 x 4 floats. */
+	static std::shared_ptr<const JRColorCube> cubeWithData(int dimension, std::vector<float> cells);
+
+	int dimension() const { return _dimension; }
+	const std::vector<float>& cells() const { return _cells; }
+
+	/* Replaces 'count' premultiplied pixels with the tetrahedral
+	 * interpolation of their unpremultiplied RGB, times their alpha. RGB is
+	 * clamped to [0, 1], and NaN is read as 0. */
+	void apply(float* pixels, size_t count) const;
+
+private:
+	JRColorCube(int dimension, std::vector<float> cells);
+
+	int _dimension;
+	std::vector<float> _cells;
+};
+
+/* The kernel of CIColorCube, and of chains JRBakeColorCube has baked. */
+class JRColorCubeKernel : public JRColorKernel {
+public:
+	explicit JRColorCubeKernel(const std::shared_ptr<const JRColorCube>& cube);
+
+	const std::shared_ptr<const JRColorCube>& cube() const { return _cube; }
+
+	void apply(float* pixels, const float* const* inputs, size_t count, const float* args) const override;
+
+private:
+	std::shared_ptr<const JRColorCube> _cube;
+};
+
+/* Replaces a point-wise colour chain with a single cube lookup. 'image' must
+ * be a single-input JRColorKernel node (normally a JRFusedColorKernel). The
+ * chain is sampled on a kJRColorCubeBakeDimension lattice, but only if it
+ * passes a check that its output is a function of unpremultiplied RGB with
+ * alpha unchanged, and the lookup stays within 1/1024 of the chain at the
+ * cell centres (curves as steep as JRLinearToSRGB near 0 do not); otherwise,
+ * or for short chains, this returns nullptr.
+ *
+ * Baked kernels are cached by the chain's hash and arguments, so building
+ * the same grade again reuses the cube. Pixels outside [0, 1], which the
+ * cube would clamp, still go through the original chain. */
+JRImageRef JRBakeColorCube(const JRImageRef& image);
+
+#endif /* jr_ColorCube_h */
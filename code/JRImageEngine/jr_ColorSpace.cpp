@@ -0,0 +1,384 @@
+//
+//  jr_ColorSpace.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_ColorSpace.h"
+#include "jr_Image.h"
+#include "jr_SIMD.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#if defined(JR_SIMD_X86)
+#include <immintrin.h>
+#elif defined(JR_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/* pow(x, y) is computed as exp2(y * log2(x)):
+ *  - log2 splits x into 2^e * m with m in [sqrt(1/2), sqrt(2)), and
+ *    log2(m) = t * P(t) with t = m - 1, P of degree 7 (error 9e-8);
+ *  - exp2 rounds y to an integer n, 2^(y - n) is a degree 5 polynomial
+ *    (relative error 8e-8), and 2^n goes into the exponent bits.
+ * The vector kernels run the same float operations in the same order, with
+ * no fused multiply-add, so they round exactly like the scalar code. */
+
+static const float kJRLog2Coefficients[8] = {
+	1.44269496f, -0.721352759f, 0.480924039f, -0.360241986f, 0.287075611f, -0.248821806f, 0.234209851f, -0.146203534f,
+};
+static const float kJRExp2Coefficients[6] = {
+	1.00000007f, 0.693146949f, 0.240221218f, 0.0555074262f, 0.00967545975f, 0.00132669704f,
+};
+/// sqrt(1/2) 的位模式
+static const uint32_t kJRSqrtHalfBits = 0x3f3504f3u;
+/// 加上再减去 1.5 * 2^23, 按最近偶数取整
+static const float kJRRoundMagic = 12582912.0f;
+
+static const float kJRToLinearThreshold = 0.04045f;
+static const float kJRToSRGBThreshold = 0.0031308f;
+
+static inline float JRBitsToFloat(uint32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, 4);
+	return value;
+}
+
+static inline uint32_t JRFloatToBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, 4);
+	return bits;
+}
+
+/// a 为正数
+static inline float JRFastLog2(float a)
+{
+	uint32_t bits = JRFloatToBits(a);
+	int32_t e = int32_t(bits - kJRSqrtHalfBits) >> 23;
+	float t = JRBitsToFloat(bits - (uint32_t(e) << 23)) - 1.0f;
+	float p = kJRLog2Coefficients[7];
+	for (int i = 6; i >= 0; i--) {
+		p = p * t + kJRLog2Coefficients[i];
+	}
+	return float(e) + p * t;
+}
+
+static inline float JRFastExp2(float y)
+{
+	/// 这样写 NaN 也落在范围内
+	y = y > -126.0f ? y : -126.0f;
+	y = y < 127.0f ? y : 127.0f;
+	float n = (y + kJRRoundMagic) - kJRRoundMagic;
+	float f = y - n;
+	float p = kJRExp2Coefficients[5];
+	for (int i = 4; i >= 0; i--) {
+		p = p * f + kJRExp2Coefficients[i];
+	}
+	return p * JRBitsToFloat(uint32_t(int32_t(n) + 127) << 23);
+}
+
+float JRSRGBToLinear(float value)
+{
+	float a = std::fabs(value);
+	float curve = JRFastExp2(2.4f * JRFastLog2((a + 0.055f) * (1.0f / 1.055f)));
+	return std::copysign(a <= kJRToLinearThreshold ? a * (1.0f / 12.92f) : curve, value);
+}
+
+float JRLinearToSRGB(float value)
+{
+	float a = std::fabs(value);
+	float curve = 1.055f * JRFastExp2(JRFastLog2(a) * (1.0f / 2.4f)) - 0.055f;
+	return std::copysign(a <= kJRToSRGBThreshold ? a * 12.92f : curve, value);
+}
+
+static void JRSRGBToLinearRowScalar(float* p, size_t count)
+{
+	for (size_t i = 0; i < count; i++, p += 4) {
+		p[0] = JRSRGBToLinear(p[0]);
+		p[1] = JRSRGBToLinear(p[1]);
+		p[2] = JRSRGBToLinear(p[2]);
+	}
+}
+
+static void JRLinearToSRGBRowScalar(float* p, size_t count)
+{
+	for (size_t i = 0; i < count; i++, p += 4) {
+		p[0] = JRLinearToSRGB(p[0]);
+		p[1] = JRLinearToSRGB(p[1]);
+		p[2] = JRLinearToSRGB(p[2]);
+	}
+}
+
+#if defined(JR_SIMD_X86)
+
+#define JR_TARGET_AVX2 __attribute__((target("avx2")))
+
+JR_TARGET_AVX2 static inline __m256 JRFastLog2AVX2(__m256 a)
+{
+	__m256i bits = _mm256_castps_si256(a);
+	__m256i e = _mm256_srai_epi32(_mm256_sub_epi32(bits, _mm256_set1_epi32(int32_t(kJRSqrtHalfBits))), 23);
+	__m256 t = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_sub_epi32(bits, _mm256_slli_epi32(e, 23))), _mm256_set1_ps(1.0f));
+	__m256 p = _mm256_set1_ps(kJRLog2Coefficients[7]);
+	for (int i = 6; i >= 0; i--) {
+		p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(kJRLog2Coefficients[i]));
+	}
+	return _mm256_add_ps(_mm256_cvtepi32_ps(e), _mm256_mul_ps(p, t));
+}
+
+JR_TARGET_AVX2 static inline __m256 JRFastExp2AVX2(__m256 y)
+{
+	/// max/min 遇到 NaN 返回第二个参数, 与标量版本一致
+	y = _mm256_max_ps(y, _mm256_set1_ps(-126.0f));
+	y = _mm256_min_ps(y, _mm256_set1_ps(127.0f));
+	const __m256 magic = _mm256_set1_ps(kJRRoundMagic);
+	__m256 n = _mm256_sub_ps(_mm256_add_ps(y, magic), magic);
+	__m256 f = _mm256_sub_ps(y, n);
+	__m256 p = _mm256_set1_ps(kJRExp2Coefficients[5]);
+	for (int i = 4; i >= 0; i--) {
+		p = _mm256_add_ps(_mm256_mul_ps(p, f), _mm256_set1_ps(kJRExp2Coefficients[i]));
+	}
+	__m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+	return _mm256_mul_ps(p, _mm256_castsi256_ps(scale));
+}
+
+/// 两个像素, 算完后把 alpha 换回去
+JR_TARGET_AVX2 static inline __m256 JRSRGBToLinearAVX2(__m256 v)
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	__m256 a = _mm256_andnot_ps(signMask, v);
+	__m256 x = _mm256_mul_ps(_mm256_add_ps(a, _mm256_set1_ps(0.055f)), _mm256_set1_ps(1.0f / 1.055f));
+	__m256 curve = JRFastExp2AVX2(_mm256_mul_ps(_mm256_set1_ps(2.4f), JRFastLog2AVX2(x)));
+	__m256 line = _mm256_mul_ps(a, _mm256_set1_ps(1.0f / 12.92f));
+	__m256 r = _mm256_blendv_ps(curve, line, _mm256_cmp_ps(a, _mm256_set1_ps(kJRToLinearThreshold), _CMP_LE_OQ));
+	r = _mm256_or_ps(r, _mm256_and_ps(v, signMask));
+	return _mm256_blend_ps(r, v, 0x88);
+}
+
+JR_TARGET_AVX2 static inline __m256 JRLinearToSRGBAVX2(__m256 v)
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	__m256 a = _mm256_andnot_ps(signMask, v);
+	__m256 curve = JRFastExp2AVX2(_mm256_mul_ps(JRFastLog2AVX2(a), _mm256_set1_ps(1.0f / 2.4f)));
+	curve = _mm256_sub_ps(_mm256_mul_ps(_mm256_set1_ps(1.055f), curve), _mm256_set1_ps(0.055f));
+	__m256 line = _mm256_mul_ps(a, _mm256_set1_ps(12.92f));
+	__m256 r = _mm256_blendv_ps(curve, line, _mm256_cmp_ps(a, _mm256_set1_ps(kJRToSRGBThreshold), _CMP_LE_OQ));
+	r = _mm256_or_ps(r, _mm256_and_ps(v, signMask));
+	return _mm256_blend_ps(r, v, 0x88);
+}
+
+/* Four vectors per iteration: the polynomials are long dependency chains,
+ * and the independent chains fill each other's latency. */
+JR_TARGET_AVX2 static void JRSRGBToLinearRowAVX2(float* p, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8, p += 32) {
+		__m256 v0 = _mm256_loadu_ps(p), v1 = _mm256_loadu_ps(p + 8), v2 = _mm256_loadu_ps(p + 16), v3 = _mm256_loadu_ps(p + 24);
+		_mm256_storeu_ps(p, JRSRGBToLinearAVX2(v0));
+		_mm256_storeu_ps(p + 8, JRSRGBToLinearAVX2(v1));
+		_mm256_storeu_ps(p + 16, JRSRGBToLinearAVX2(v2));
+		_mm256_storeu_ps(p + 24, JRSRGBToLinearAVX2(v3));
+	}
+	for (; i + 2 <= count; i += 2, p += 8) {
+		_mm256_storeu_ps(p, JRSRGBToLinearAVX2(_mm256_loadu_ps(p)));
+	}
+	JRSRGBToLinearRowScalar(p, count - i);
+}
+
+JR_TARGET_AVX2 static void JRLinearToSRGBRowAVX2(float* p, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8, p += 32) {
+		__m256 v0 = _mm256_loadu_ps(p), v1 = _mm256_loadu_ps(p + 8), v2 = _mm256_loadu_ps(p + 16), v3 = _mm256_loadu_ps(p + 24);
+		_mm256_storeu_ps(p, JRLinearToSRGBAVX2(v0));
+		_mm256_storeu_ps(p + 8, JRLinearToSRGBAVX2(v1));
+		_mm256_storeu_ps(p + 16, JRLinearToSRGBAVX2(v2));
+		_mm256_storeu_ps(p + 24, JRLinearToSRGBAVX2(v3));
+	}
+	for (; i + 2 <= count; i += 2, p += 8) {
+		_mm256_storeu_ps(p, JRLinearToSRGBAVX2(_mm256_loadu_ps(p)));
+	}
+	JRLinearToSRGBRowScalar(p, count - i);
+}
+
+#elif defined(JR_SIMD_NEON)
+
+static inline float32x4_t JRFastLog2NEON(float32x4_t a)
+{
+	uint32x4_t bits = vreinterpretq_u32_f32(a);
+	int32x4_t e = vshrq_n_s32(vreinterpretq_s32_u32(vsubq_u32(bits, vdupq_n_u32(kJRSqrtHalfBits))), 23);
+	float32x4_t t = vsubq_f32(vreinterpretq_f32_u32(vsubq_u32(bits, vshlq_n_u32(vreinterpretq_u32_s32(e), 23))), vdupq_n_f32(1.0f));
+	float32x4_t p = vdupq_n_f32(kJRLog2Coefficients[7]);
+	for (int i = 6; i >= 0; i--) {
+		p = vaddq_f32(vmulq_f32(p, t), vdupq_n_f32(kJRLog2Coefficients[i]));
+	}
+	return vaddq_f32(vcvtq_f32_s32(e), vmulq_f32(p, t));
+}
+
+static inline float32x4_t JRFastExp2NEON(float32x4_t y)
+{
+	/// 用比较和选择代替 vmaxq, NaN 的处理与标量版本一致
+	y = vbslq_f32(vcgtq_f32(y, vdupq_n_f32(-126.0f)), y, vdupq_n_f32(-126.0f));
+	y = vbslq_f32(vcltq_f32(y, vdupq_n_f32(127.0f)), y, vdupq_n_f32(127.0f));
+	const float32x4_t magic = vdupq_n_f32(kJRRoundMagic);
+	float32x4_t n = vsubq_f32(vaddq_f32(y, magic), magic);
+	float32x4_t f = vsubq_f32(y, n);
+	float32x4_t p = vdupq_n_f32(kJRExp2Coefficients[5]);
+	for (int i = 4; i >= 0; i--) {
+		p = vaddq_f32(vmulq_f32(p, f), vdupq_n_f32(kJRExp2Coefficients[i]));
+	}
+	int32x4_t scale = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127)), 23);
+	return vmulq_f32(p, vreinterpretq_f32_s32(scale));
+}
+
+/// 一次一个像素, alpha 用原值
+static void JRSRGBToLinearRowNEON(float* p, size_t count)
+{
+	const uint32x4_t signMask = vdupq_n_u32(0x80000000u);
+	for (size_t i = 0; i < count; i++, p += 4) {
+		float32x4_t v = vld1q_f32(p);
+		float32x4_t a = vabsq_f32(v);
+		float32x4_t x = vmulq_f32(vaddq_f32(a, vdupq_n_f32(0.055f)), vdupq_n_f32(1.0f / 1.055f));
+		float32x4_t curve = JRFastExp2NEON(vmulq_f32(vdupq_n_f32(2.4f), JRFastLog2NEON(x)));
+		float32x4_t line = vmulq_f32(a, vdupq_n_f32(1.0f / 12.92f));
+		float32x4_t r = vbslq_f32(vcleq_f32(a, vdupq_n_f32(kJRToLinearThreshold)), line, curve);
+		r = vbslq_f32(signMask, v, r);
+		vst1q_f32(p, vsetq_lane_f32(vgetq_lane_f32(v, 3), r, 3));
+	}
+}
+
+static void JRLinearToSRGBRowNEON(float* p, size_t count)
+{
+	const uint32x4_t signMask = vdupq_n_u32(0x80000000u);
+	for (size_t i = 0; i < count; i++, p += 4) {
+		float32x4_t v = vld1q_f32(p);
+		float32x4_t a = vabsq_f32(v);
+		float32x4_t curve = JRFastExp2NEON(vmulq_f32(JRFastLog2NEON(a), vdupq_n_f32(1.0f / 2.4f)));
+		curve = vsubq_f32(vmulq_f32(vdupq_n_f32(1.055f), curve), vdupq_n_f32(0.055f));
+		float32x4_t line = vmulq_f32(a, vdupq_n_f32(12.92f));
+		float32x4_t r = vbslq_f32(vcleq_f32(a, vdupq_n_f32(kJRToSRGBThreshold)), line, curve);
+		r = vbslq_f32(signMask, v, r);
+		vst1q_f32(p, vsetq_lane_f32(vgetq_lane_f32(v, 3), r, 3));
+	}
+}
+
+#endif
+
+void JRSRGBToLinearRow(float* pixels, size_t count)
+{
+#if defined(JR_SIMD_X86)
+	if (JRSIMDActiveLevel() >= kJRSIMDLevelAVX2) {
+		JRSRGBToLinearRowAVX2(pixels, count);
+		return;
+	}
+#elif defined(JR_SIMD_NEON)
+	if (JRSIMDActiveLevel() == kJRSIMDLevelNEON) {
+		JRSRGBToLinearRowNEON(pixels, count);
+		return;
+	}
+#endif
+	JRSRGBToLinearRowScalar(pixels, count);
+}
+
+void JRLinearToSRGBRow(float* pixels, size_t count)
+{
+#if defined(JR_SIMD_X86)
+	if (JRSIMDActiveLevel() >= kJRSIMDLevelAVX2) {
+		JRLinearToSRGBRowAVX2(pixels, count);
+		return;
+	}
+#elif defined(JR_SIMD_NEON)
+	if (JRSIMDActiveLevel() == kJRSIMDLevelNEON) {
+		JRLinearToSRGBRowNEON(pixels, count);
+		return;
+	}
+#endif
+	JRLinearToSRGBRowScalar(pixels, count);
+}
+
+// MARK: - Kernels
+
+static void JRSRGBToLinearFunction(float* pixels, const float* const*, size_t count, const float*)
+{
+	JRSRGBToLinearRow(pixels, count);
+}
+
+static void JRLinearToSRGBFunction(float* pixels, const float* const*, size_t count, const float*)
+{
+	JRLinearToSRGBRow(pixels, count);
+}
+
+std::shared_ptr<const JRColorKernel> JRSRGBToLinearKernel()
+{
+	static std::shared_ptr<const JRColorKernel> kernel = std::make_shared<JRColorKernel>(
+		"CISRGBToneCurveToLinear", JRSRGBToLinearFunction, kJRColorKernelOptionUnpremultiplied);
+	return kernel;
+}
+
+std::shared_ptr<const JRColorKernel> JRLinearToSRGBKernel()
+{
+	static std::shared_ptr<const JRColorKernel> kernel = std::make_shared<JRColorKernel>(
+		"CILinearToSRGBToneCurve", JRLinearToSRGBFunction, kJRColorKernelOptionUnpremultiplied);
+	return kernel;
+}
+
+std::shared_ptr<const JRColorKernel> JRColorSpaceToWorkingKernel(JRColorSpace space)
+{
+	static std::shared_ptr<const JRColorKernel> kernel = std::make_shared<JRColorKernel>(
+		"matchedToWorkingSpace(sRGB)", JRSRGBToLinearFunction, kJRColorKernelOptionUnpremultiplied);
+	return space == kJRColorSpaceSRGB ? kernel : nullptr;
+}
+
+std::shared_ptr<const JRColorKernel> JRColorSpaceFromWorkingKernel(JRColorSpace space)
+{
+	static std::shared_ptr<const JRColorKernel> kernel = std::make_shared<JRColorKernel>(
+		"matchedFromWorkingSpace(sRGB)", JRLinearToSRGBFunction, kJRColorKernelOptionUnpremultiplied);
+	return space == kJRColorSpaceSRGB ? kernel : nullptr;
+}
+
+bool JRColorKernelsCancel(const JRColorKernel& outer, const JRColorKernel& inner)
+{
+	/// 按函数比较, 滤镜和 matched 节点可以互相抵消
+	return (outer.function() == JRLinearToSRGBFunction && inner.function() == JRSRGBToLinearFunction)
+		|| (outer.function() == JRSRGBToLinearFunction && inner.function() == JRLinearToSRGBFunction);
+}
+
+// MARK: - Removing color matching
+
+static JRImageRef JRRemoveColorMatching(const JRImageRef& image, std::unordered_map<const JRImage*, JRImageRef>& removed)
+{
+	auto found = removed.find(image.get());
+	if (found != removed.end()) {
+		return found->second;
+	}
+	JRImageRef result;
+	if (image->kind() == kJRImageKindKernel
+		&& (image->kernel() == JRColorSpaceToWorkingKernel(kJRColorSpaceSRGB) || image->kernel() == JRColorSpaceFromWorkingKernel(kJRColorSpaceSRGB))) {
+		result = JRRemoveColorMatching(image->inputs()[0], removed);
+	} else {
+		std::vector<JRImageRef> inputs;
+		bool changed = false;
+		for (const JRImageRef& input : image->inputs()) {
+			inputs.push_back(JRRemoveColorMatching(input, removed));
+			changed = changed || inputs.back() != input;
+		}
+		result = changed ? image->imageByReplacingInputs(inputs) : image;
+	}
+	removed[image.get()] = result;
+	return result;
+}
+
+JRImageRef JRImageRemovingColorMatching(const JRImageRef& image)
+{
+	if (!image) {
+		return nullptr;
+	}
+	std::unordered_map<const JRImage*, JRImageRef> removed;
+	return JRRemoveColorMatching(image, removed);
+}
@@ -0,0 +1,65 @@
+//
+//  jr_ColorSpace.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_ColorSpace_h
+#define jr_ColorSpace_h
+
+#include "jr_Kernel.h"
+#include "jr_Value.h"
+
+#include <cstddef>
+#include <memory>
+
+/* Colour spaces an image can be matched to or from the working space, which
+ * is linear sRGB like the default working space of a CIContext. */
+enum JRColorSpace {
+	kJRColorSpaceLinearSRGB = 0,
+	kJRColorSpaceSRGB,
+};
+
+/* The largest error of JRSRGBToLinear and JRLinearToSRGB relative to the
+ * exact sRGB transfer functions, for |value| up to 64. It holds for every
+ * float in that range and for every SIMD level (bench/jr_bench_colorspace.cpp
+ * checks them all), well under half a 16-bit step. */
+inline constexpr float kJRSRGBTransferMaximumError = 2e-6f;
+
+/* The sRGB transfer functions, extended to the whole real line by mirroring
+ * negative values, like extended sRGB. Both are built from polynomial
+ * log2 / exp2 approximations instead of pow(), and each is the inverse of
+ * the other within kJRSRGBTransferMaximumError. */
+float JRSRGBToLinear(float value);
+float JRLinearToSRGB(float value);
+
+/* Converts the RGB of 'count' unpremultiplied RGBA pixels in place and keeps
+ * alpha. The row kernels use the best instruction set from
+ * JRSIMDActiveLevel() and match the scalar functions bit for bit. */
+void JRSRGBToLinearRow(float* pixels, size_t count);
+void JRLinearToSRGBRow(float* pixels, size_t count);
+
+/* The kernels of CISRGBToneCurveToLinear and CILinearToSRGBToneCurve. */
+std::shared_ptr<const JRColorKernel> JRSRGBToLinearKernel();
+std::shared_ptr<const JRColorKernel> JRLinearToSRGBKernel();
+
+/* The kernels of JRImage::matchedToWorkingSpace and matchedFromWorkingSpace:
+ * the same conversions as above, but kept apart so that a context that does
+ * not manage colour can remove them. Returns nullptr for the working space
+ * itself, which needs no conversion. */
+std::shared_ptr<const JRColorKernel> JRColorSpaceToWorkingKernel(JRColorSpace space);
+std::shared_ptr<const JRColorKernel> JRColorSpaceFromWorkingKernel(JRColorSpace space);
+
+/* Whether applying 'outer' to the output of 'inner' gives back the input of
+ * 'inner', so the optimizer can drop the pair. True for an sRGB conversion
+ * followed by its inverse, whichever kernels above carry them. */
+bool JRColorKernelsCancel(const JRColorKernel& outer, const JRColorKernel& inner);
+
+/* 'image' with every matchedToWorkingSpace / matchedFromWorkingSpace node
+ * removed, for JRContextOptions::managesColor. Explicit tone curve filters
+ * are kept. Shared sub-graphs stay shared. */
+JRImageRef JRImageRemovingColorMatching(const JRImageRef& image);
+
+#endif /* jr_ColorSpace_h */
@@ -0,0 +1,603 @@
+//
+//  jr_Compositing.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Compositing.h"
+#include "jr_SIMD.h"
+
+#if defined(JR_SIMD_X86)
+#include <immintrin.h>
+#define JR_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(JR_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/// 蒙版亮度的系数, 与 jr_Reduction.cpp 相同
+static const float kJRLumaRed = 0.2126f;
+static const float kJRLumaGreen = 0.7152f;
+static const float kJRLumaBlue = 0.0722f;
+
+typedef void (*JRCompositeSpanFunction)(float* p, const float* const* inputs, size_t count);
+
+/* Each operator gives one channel of the result from the channel and alpha of
+ * the image (s, as) and of the background (b, ab). The vector versions run
+ * the same float operations in the same order as the scalar one, and the
+ * scalar min and max pick the same operand as the SSE/AVX instructions, so
+ * the AVX2 results agree bit for bit. */
+
+static inline float JRMin(float a, float b) { return a < b ? a : b; }
+static inline float JRMax(float a, float b) { return a > b ? a : b; }
+
+// MARK: - Operators
+
+struct JRSourceOverOperator {
+	static const bool kBlendAlpha = false;
+	static float scalar(float s, float as, float b, float) { return s + b * (1.0f - as); }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256 as, __m256 b, __m256)
+	{
+		return _mm256_add_ps(s, _mm256_mul_ps(b, _mm256_sub_ps(_mm256_set1_ps(1.0f), as)));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t as, float32x4_t b, float32x4_t)
+	{
+		return vaddq_f32(s, vmulq_f32(b, vsubq_f32(vdupq_n_f32(1.0f), as)));
+	}
+#endif
+};
+
+struct JRSourceInOperator {
+	static const bool kBlendAlpha = false;
+	static float scalar(float s, float, float, float ab) { return s * ab; }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256, __m256, __m256 ab) { return _mm256_mul_ps(s, ab); }
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t, float32x4_t, float32x4_t ab) { return vmulq_f32(s, ab); }
+#endif
+};
+
+struct JRSourceOutOperator {
+	static const bool kBlendAlpha = false;
+	static float scalar(float s, float, float, float ab) { return s * (1.0f - ab); }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256, __m256, __m256 ab)
+	{
+		return _mm256_mul_ps(s, _mm256_sub_ps(_mm256_set1_ps(1.0f), ab));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t, float32x4_t, float32x4_t ab)
+	{
+		return vmulq_f32(s, vsubq_f32(vdupq_n_f32(1.0f), ab));
+	}
+#endif
+};
+
+struct JRSourceAtopOperator {
+	static const bool kBlendAlpha = false;
+	static float scalar(float s, float as, float b, float ab) { return s * ab + b * (1.0f - as); }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256 as, __m256 b, __m256 ab)
+	{
+		return _mm256_add_ps(_mm256_mul_ps(s, ab), _mm256_mul_ps(b, _mm256_sub_ps(_mm256_set1_ps(1.0f), as)));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t as, float32x4_t b, float32x4_t ab)
+	{
+		return vaddq_f32(vmulq_f32(s, ab), vmulq_f32(b, vsubq_f32(vdupq_n_f32(1.0f), as)));
+	}
+#endif
+};
+
+struct JRAdditionOperator {
+	static const bool kBlendAlpha = false;
+	static float scalar(float s, float, float b, float) { return s + b; }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256, __m256 b, __m256) { return _mm256_add_ps(s, b); }
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t, float32x4_t b, float32x4_t) { return vaddq_f32(s, b); }
+#endif
+};
+
+struct JRMultiplyOperator {
+	static const bool kBlendAlpha = false;
+	static float scalar(float s, float, float b, float) { return s * b; }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256, __m256 b, __m256) { return _mm256_mul_ps(s, b); }
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t, float32x4_t b, float32x4_t) { return vmulq_f32(s, b); }
+#endif
+};
+
+/// 混合模式: 结果 = s (1 - ab) + b (1 - as) + as ab B(s / as, b / ab), 最后一项都化成了不需要除法的形式
+struct JRMultiplyBlendOperator {
+	static const bool kBlendAlpha = true;
+	static float scalar(float s, float as, float b, float ab) { return s * (1.0f - ab) + b * (1.0f - as) + s * b; }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256 as, __m256 b, __m256 ab)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		__m256 base = _mm256_add_ps(_mm256_mul_ps(s, _mm256_sub_ps(one, ab)), _mm256_mul_ps(b, _mm256_sub_ps(one, as)));
+		return _mm256_add_ps(base, _mm256_mul_ps(s, b));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t as, float32x4_t b, float32x4_t ab)
+	{
+		const float32x4_t one = vdupq_n_f32(1.0f);
+		float32x4_t base = vaddq_f32(vmulq_f32(s, vsubq_f32(one, ab)), vmulq_f32(b, vsubq_f32(one, as)));
+		return vaddq_f32(base, vmulq_f32(s, b));
+	}
+#endif
+};
+
+struct JRScreenBlendOperator {
+	static const bool kBlendAlpha = true;
+	static float scalar(float s, float, float b, float) { return s + b - s * b; }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256, __m256 b, __m256)
+	{
+		return _mm256_sub_ps(_mm256_add_ps(s, b), _mm256_mul_ps(s, b));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t, float32x4_t b, float32x4_t)
+	{
+		return vsubq_f32(vaddq_f32(s, b), vmulq_f32(s, b));
+	}
+#endif
+};
+
+/// 强光: 2s <= as 时是 multiply(b, 2s), 否则是 screen(b, 2s - as). 叠加是交换 s 与 b 的强光
+template <bool kOverlay>
+struct JRHardLightBlendOperator {
+	static const bool kBlendAlpha = true;
+	static float scalar(float s, float as, float b, float ab)
+	{
+		float base = s * (1.0f - ab) + b * (1.0f - as);
+		bool low = kOverlay ? b + b <= ab : s + s <= as;
+		return low ? base + (s + s) * b : base + (as * ab - ((as - s) + (as - s)) * (ab - b));
+	}
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256 as, __m256 b, __m256 ab)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		__m256 base = _mm256_add_ps(_mm256_mul_ps(s, _mm256_sub_ps(one, ab)), _mm256_mul_ps(b, _mm256_sub_ps(one, as)));
+		__m256 low = kOverlay ? _mm256_cmp_ps(_mm256_add_ps(b, b), ab, _CMP_LE_OQ) : _mm256_cmp_ps(_mm256_add_ps(s, s), as, _CMP_LE_OQ);
+		__m256 multiply = _mm256_add_ps(base, _mm256_mul_ps(_mm256_add_ps(s, s), b));
+		__m256 d = _mm256_sub_ps(as, s);
+		__m256 screen = _mm256_add_ps(base, _mm256_sub_ps(_mm256_mul_ps(as, ab), _mm256_mul_ps(_mm256_add_ps(d, d), _mm256_sub_ps(ab, b))));
+		return _mm256_blendv_ps(screen, multiply, low);
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t as, float32x4_t b, float32x4_t ab)
+	{
+		const float32x4_t one = vdupq_n_f32(1.0f);
+		float32x4_t base = vaddq_f32(vmulq_f32(s, vsubq_f32(one, ab)), vmulq_f32(b, vsubq_f32(one, as)));
+		uint32x4_t low = kOverlay ? vcleq_f32(vaddq_f32(b, b), ab) : vcleq_f32(vaddq_f32(s, s), as);
+		float32x4_t multiply = vaddq_f32(base, vmulq_f32(vaddq_f32(s, s), b));
+		float32x4_t d = vsubq_f32(as, s);
+		float32x4_t screen = vaddq_f32(base, vsubq_f32(vmulq_f32(as, ab), vmulq_f32(vaddq_f32(d, d), vsubq_f32(ab, b))));
+		return vbslq_f32(low, multiply, screen);
+	}
+#endif
+};
+
+struct JRDarkenBlendOperator {
+	static const bool kBlendAlpha = true;
+	static float scalar(float s, float as, float b, float ab) { return s + b - JRMax(s * ab, b * as); }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256 as, __m256 b, __m256 ab)
+	{
+		return _mm256_sub_ps(_mm256_add_ps(s, b), _mm256_max_ps(_mm256_mul_ps(s, ab), _mm256_mul_ps(b, as)));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t as, float32x4_t b, float32x4_t ab)
+	{
+		return vsubq_f32(vaddq_f32(s, b), vmaxq_f32(vmulq_f32(s, ab), vmulq_f32(b, as)));
+	}
+#endif
+};
+
+struct JRLightenBlendOperator {
+	static const bool kBlendAlpha = true;
+	static float scalar(float s, float as, float b, float ab) { return s + b - JRMin(s * ab, b * as); }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256 as, __m256 b, __m256 ab)
+	{
+		return _mm256_sub_ps(_mm256_add_ps(s, b), _mm256_min_ps(_mm256_mul_ps(s, ab), _mm256_mul_ps(b, as)));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t as, float32x4_t b, float32x4_t ab)
+	{
+		return vsubq_f32(vaddq_f32(s, b), vminq_f32(vmulq_f32(s, ab), vmulq_f32(b, as)));
+	}
+#endif
+};
+
+struct JRDifferenceBlendOperator {
+	static const bool kBlendAlpha = true;
+	static float scalar(float s, float as, float b, float ab)
+	{
+		float m = JRMin(s * ab, b * as);
+		return s + b - (m + m);
+	}
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256 as, __m256 b, __m256 ab)
+	{
+		__m256 m = _mm256_min_ps(_mm256_mul_ps(s, ab), _mm256_mul_ps(b, as));
+		return _mm256_sub_ps(_mm256_add_ps(s, b), _mm256_add_ps(m, m));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t as, float32x4_t b, float32x4_t ab)
+	{
+		float32x4_t m = vminq_f32(vmulq_f32(s, ab), vmulq_f32(b, as));
+		return vsubq_f32(vaddq_f32(s, b), vaddq_f32(m, m));
+	}
+#endif
+};
+
+struct JRExclusionBlendOperator {
+	static const bool kBlendAlpha = true;
+	static float scalar(float s, float, float b, float) { return s + b - (s + s) * b; }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 s, __m256, __m256 b, __m256)
+	{
+		return _mm256_sub_ps(_mm256_add_ps(s, b), _mm256_mul_ps(_mm256_add_ps(s, s), b));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t s, float32x4_t, float32x4_t b, float32x4_t)
+	{
+		return vsubq_f32(vaddq_f32(s, b), vmulq_f32(vaddq_f32(s, s), b));
+	}
+#endif
+};
+
+/// 蒙版混合的 m: 亮度或 alpha
+struct JRLumaMask {
+	static float scalar(const float* m)
+	{
+		float luma = m[0] * kJRLumaRed + m[1] * kJRLumaGreen + m[2] * kJRLumaBlue;
+		return JRMin(JRMax(luma, 0.0f), 1.0f);
+	}
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 m)
+	{
+		/// dp_ps 的求和顺序是 (p0 + p1) + (p2 + 0), 与标量相同
+		const __m256 weights = _mm256_setr_ps(kJRLumaRed, kJRLumaGreen, kJRLumaBlue, 0, kJRLumaRed, kJRLumaGreen, kJRLumaBlue, 0);
+		__m256 luma = _mm256_dp_ps(m, weights, 0x7f);
+		return _mm256_min_ps(_mm256_max_ps(luma, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+	}
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t m)
+	{
+		float luma = vgetq_lane_f32(m, 0) * kJRLumaRed + vgetq_lane_f32(m, 1) * kJRLumaGreen + vgetq_lane_f32(m, 2) * kJRLumaBlue;
+		return vdupq_n_f32(JRMin(JRMax(luma, 0.0f), 1.0f));
+	}
+#endif
+};
+
+struct JRAlphaMask {
+	static float scalar(const float* m) { return m[3]; }
+#if defined(JR_SIMD_X86)
+	JR_TARGET_AVX2 static __m256 avx2(__m256 m) { return _mm256_permute_ps(m, _MM_SHUFFLE(3, 3, 3, 3)); }
+#elif defined(JR_SIMD_NEON)
+	static float32x4_t neon(float32x4_t m) { return vdupq_n_f32(vgetq_lane_f32(m, 3)); }
+#endif
+};
+
+// MARK: - Spans
+
+/// p 是图像, inputs[0] 是背景, 结果写回 p
+template <typename Op>
+static void JRCompositeSpanScalar(float* p, const float* const* inputs, size_t count)
+{
+	const float* b = inputs[0];
+	for (size_t i = 0; i < count; i++, p += 4, b += 4) {
+		float as = p[3], ab = b[3];
+		for (int c = 0; c < 4; c++) {
+			p[c] = Op::scalar(p[c], as, b[c], ab);
+		}
+		if (Op::kBlendAlpha) {
+			p[3] = as + ab - as * ab;
+		}
+	}
+}
+
+/// inputs[1] 是蒙版
+template <typename Mask>
+static void JRMaskSpanScalar(float* p, const float* const* inputs, size_t count)
+{
+	const float* b = inputs[0];
+	const float* mask = inputs[1];
+	for (size_t i = 0; i < count; i++, p += 4, b += 4, mask += 4) {
+		float m = Mask::scalar(mask);
+		for (int c = 0; c < 4; c++) {
+			p[c] = p[c] * m + b[c] * (1.0f - m);
+		}
+	}
+}
+
+#if defined(JR_SIMD_X86)
+
+/// 每次两个像素, as 与 ab 广播到各自像素的四个通道
+template <typename Op>
+JR_TARGET_AVX2 static void JRCompositeSpanAVX2(float* p, const float* const* inputs, size_t count)
+{
+	const float* b = inputs[0];
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m256 s = _mm256_loadu_ps(p + i * 4);
+		__m256 d = _mm256_loadu_ps(b + i * 4);
+		__m256 as = _mm256_permute_ps(s, _MM_SHUFFLE(3, 3, 3, 3));
+		__m256 ab = _mm256_permute_ps(d, _MM_SHUFFLE(3, 3, 3, 3));
+		__m256 r = Op::avx2(s, as, d, ab);
+		if (Op::kBlendAlpha) {
+			r = _mm256_blend_ps(r, _mm256_sub_ps(_mm256_add_ps(as, ab), _mm256_mul_ps(as, ab)), 0x88);
+		}
+		_mm256_storeu_ps(p + i * 4, r);
+	}
+	const float* rest[] = { b + i * 4 };
+	JRCompositeSpanScalar<Op>(p + i * 4, rest, count - i);
+}
+
+template <typename Mask>
+JR_TARGET_AVX2 static void JRMaskSpanAVX2(float* p, const float* const* inputs, size_t count)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const float* b = inputs[0];
+	const float* mask = inputs[1];
+	size_t i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m256 m = Mask::avx2(_mm256_loadu_ps(mask + i * 4));
+		__m256 s = _mm256_mul_ps(_mm256_loadu_ps(p + i * 4), m);
+		_mm256_storeu_ps(p + i * 4, _mm256_add_ps(s, _mm256_mul_ps(_mm256_loadu_ps(b + i * 4), _mm256_sub_ps(one, m))));
+	}
+	const float* rest[] = { b + i * 4, mask + i * 4 };
+	JRMaskSpanScalar<Mask>(p + i * 4, rest, count - i);
+}
+
+#elif defined(JR_SIMD_NEON)
+
+template <typename Op>
+static void JRCompositeSpanNEON(float* p, const float* const* inputs, size_t count)
+{
+	const float* b = inputs[0];
+	for (size_t i = 0; i < count; i++, p += 4, b += 4) {
+		float32x4_t s = vld1q_f32(p);
+		float32x4_t d = vld1q_f32(b);
+		float32x4_t as = vdupq_n_f32(vgetq_lane_f32(s, 3));
+		float32x4_t ab = vdupq_n_f32(vgetq_lane_f32(d, 3));
+		float32x4_t r = Op::neon(s, as, d, ab);
+		if (Op::kBlendAlpha) {
+			r = vsetq_lane_f32(p[3] + b[3] - p[3] * b[3], r, 3);
+		}
+		vst1q_f32(p, r);
+	}
+}
+
+template <typename Mask>
+static void JRMaskSpanNEON(float* p, const float* const* inputs, size_t count)
+{
+	const float32x4_t one = vdupq_n_f32(1.0f);
+	const float* b = inputs[0];
+	const float* mask = inputs[1];
+	for (size_t i = 0; i < count; i++, p += 4, b += 4, mask += 4) {
+		float32x4_t m = Mask::neon(vld1q_f32(mask));
+		vst1q_f32(p, vaddq_f32(vmulq_f32(vld1q_f32(p), m), vmulq_f32(vld1q_f32(b), vsubq_f32(one, m))));
+	}
+}
+
+#endif
+
+/// 按 JRCompositeOperation 排列
+static const JRCompositeSpanFunction kJRCompositeScalarSpans[kJRCompositeOperationCount] = {
+	JRCompositeSpanScalar<JRSourceOverOperator>, JRCompositeSpanScalar<JRSourceInOperator>,
+	JRCompositeSpanScalar<JRSourceOutOperator>, JRCompositeSpanScalar<JRSourceAtopOperator>,
+	JRCompositeSpanScalar<JRAdditionOperator>, JRCompositeSpanScalar<JRMultiplyOperator>,
+	JRCompositeSpanScalar<JRMultiplyBlendOperator>, JRCompositeSpanScalar<JRScreenBlendOperator>,
+	JRCompositeSpanScalar<JRHardLightBlendOperator<true>>, JRCompositeSpanScalar<JRDarkenBlendOperator>,
+	JRCompositeSpanScalar<JRLightenBlendOperator>, JRCompositeSpanScalar<JRDifferenceBlendOperator>,
+	JRCompositeSpanScalar<JRExclusionBlendOperator>, JRCompositeSpanScalar<JRHardLightBlendOperator<false>>,
+	JRMaskSpanScalar<JRLumaMask>, JRMaskSpanScalar<JRAlphaMask>,
+};
+
+#if defined(JR_SIMD_X86)
+static const JRCompositeSpanFunction kJRCompositeAVX2Spans[kJRCompositeOperationCount] = {
+	JRCompositeSpanAVX2<JRSourceOverOperator>, JRCompositeSpanAVX2<JRSourceInOperator>,
+	JRCompositeSpanAVX2<JRSourceOutOperator>, JRCompositeSpanAVX2<JRSourceAtopOperator>,
+	JRCompositeSpanAVX2<JRAdditionOperator>, JRCompositeSpanAVX2<JRMultiplyOperator>,
+	JRCompositeSpanAVX2<JRMultiplyBlendOperator>, JRCompositeSpanAVX2<JRScreenBlendOperator>,
+	JRCompositeSpanAVX2<JRHardLightBlendOperator<true>>, JRCompositeSpanAVX2<JRDarkenBlendOperator>,
+	JRCompositeSpanAVX2<JRLightenBlendOperator>, JRCompositeSpanAVX2<JRDifferenceBlendOperator>,
+	JRCompositeSpanAVX2<JRExclusionBlendOperator>, JRCompositeSpanAVX2<JRHardLightBlendOperator<false>>,
+	JRMaskSpanAVX2<JRLumaMask>, JRMaskSpanAVX2<JRAlphaMask>,
+};
+#elif defined(JR_SIMD_NEON)
+static const JRCompositeSpanFunction kJRCompositeNEONSpans[kJRCompositeOperationCount] = {
+	JRCompositeSpanNEON<JRSourceOverOperator>, JRCompositeSpanNEON<JRSourceInOperator>,
+	JRCompositeSpanNEON<JRSourceOutOperator>, JRCompositeSpanNEON<JRSourceAtopOperator>,
+	JRCompositeSpanNEON<JRAdditionOperator>, JRCompositeSpanNEON<JRMultiplyOperator>,
+	JRCompositeSpanNEON<JRMultiplyBlendOperator>, JRCompositeSpanNEON<JRScreenBlendOperator>,
+	JRCompositeSpanNEON<JRHardLightBlendOperator<true>>, JRCompositeSpanNEON<JRDarkenBlendOperator>,
+	JRCompositeSpanNEON<JRLightenBlendOperator>, JRCompositeSpanNEON<JRDifferenceBlendOperator>,
+	JRCompositeSpanNEON<JRExclusionBlendOperator>, JRCompositeSpanNEON<JRHardLightBlendOperator<false>>,
+	JRMaskSpanNEON<JRLumaMask>, JRMaskSpanNEON<JRAlphaMask>,
+};
+#endif
+
+// MARK: - Coverage
+
+static JRAlphaCoverage JRCoverage(bool clear, bool opaque)
+{
+	return clear ? kJRAlphaClear : opaque ? kJRAlphaOpaque : kJRAlphaPartial;
+}
+
+static JRAlphaCoverage JRBufferAlphaCoverageScalar(const JRBuffer& buffer, const JRIRect& rect)
+{
+	bool clear = true, opaque = true;
+	for (int y = rect.y; y < rect.maxY() && (clear || opaque); y++) {
+		const float* p = buffer.pixelAt(rect.x, y);
+		for (int x = 0; x < rect.width; x++, p += 4) {
+			clear = clear && p[0] == 0 && p[1] == 0 && p[2] == 0 && p[3] == 0;
+			opaque = opaque && p[3] == 1;
+		}
+	}
+	return JRCoverage(clear, opaque);
+}
+
+#if defined(JR_SIMD_X86)
+
+JR_TARGET_AVX2 static JRAlphaCoverage JRBufferAlphaCoverageAVX2(const JRBuffer& buffer, const JRIRect& rect)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 alpha = _mm256_castsi256_ps(_mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1));
+	/// 任一通道不为 0, 任一 alpha 不为 1 (NaN 两者都算)
+	__m256 nonzero = zero, translucent = zero;
+	for (int y = rect.y; y < rect.maxY(); y++) {
+		const float* p = buffer.pixelAt(rect.x, y);
+		int x = 0;
+		for (; x + 2 <= rect.width; x += 2, p += 8) {
+			__m256 v = _mm256_loadu_ps(p);
+			nonzero = _mm256_or_ps(nonzero, _mm256_cmp_ps(v, zero, _CMP_NEQ_UQ));
+			translucent = _mm256_or_ps(translucent, _mm256_and_ps(_mm256_cmp_ps(v, one, _CMP_NEQ_UQ), alpha));
+		}
+		if (x < rect.width) {
+			__m128 v = _mm_loadu_ps(p);
+			__m256 last = _mm256_castps128_ps256(v);
+			__m256 low = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, -1, 0, 0, 0, 0));
+			nonzero = _mm256_or_ps(nonzero, _mm256_and_ps(_mm256_cmp_ps(last, zero, _CMP_NEQ_UQ), low));
+			translucent = _mm256_or_ps(translucent, _mm256_and_ps(_mm256_cmp_ps(last, one, _CMP_NEQ_UQ), _mm256_and_ps(alpha, low)));
+		}
+		if (!_mm256_testz_ps(nonzero, nonzero) && !_mm256_testz_ps(translucent, translucent)) {
+			return kJRAlphaPartial;
+		}
+	}
+	return JRCoverage(_mm256_testz_ps(nonzero, nonzero), _mm256_testz_ps(translucent, translucent));
+}
+
+#endif
+
+JRAlphaCoverage JRBufferAlphaCoverage(const JRBuffer& buffer, const JRIRect& rect)
+{
+	if (rect.isEmpty()) {
+		return kJRAlphaClear;
+	}
+#if defined(JR_SIMD_X86)
+	if (JRSIMDActiveLevel() >= kJRSIMDLevelAVX2) {
+		return JRBufferAlphaCoverageAVX2(buffer, rect);
+	}
+#endif
+	return JRBufferAlphaCoverageScalar(buffer, rect);
+}
+
+// MARK: - JRCompositeKernel
+
+static const char* const kJRCompositeNames[kJRCompositeOperationCount] = {
+	"CISourceOverCompositing", "CISourceInCompositing", "CISourceOutCompositing", "CISourceAtopCompositing",
+	"CIAdditionCompositing", "CIMultiplyCompositing", "CIMultiplyBlendMode", "CIScreenBlendMode",
+	"CIOverlayBlendMode", "CIDarkenBlendMode", "CILightenBlendMode", "CIDifferenceBlendMode",
+	"CIExclusionBlendMode", "CIHardLightBlendMode", "CIBlendWithMask", "CIBlendWithAlphaMask",
+};
+
+JRCompositeKernel::JRCompositeKernel(JRCompositeOperation operation)
+: JRColorKernel(kJRCompositeNames[operation], nullptr), _operation(operation)
+{
+}
+
+std::shared_ptr<const JRCompositeKernel> JRCompositeKernel::kernel(JRCompositeOperation operation)
+{
+	static const std::vector<std::shared_ptr<const JRCompositeKernel>> kernels = [] {
+		std::vector<std::shared_ptr<const JRCompositeKernel>> kernels;
+		for (int i = 0; i < kJRCompositeOperationCount; i++) {
+			kernels.push_back(std::make_shared<JRCompositeKernel>(JRCompositeOperation(i)));
+		}
+		return kernels;
+	}();
+	return kernels[size_t(operation)];
+}
+
+JRRect JRCompositeKernel::extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments& args) const
+{
+	if (inputExtents.size() < 2) {
+		return JRColorKernel::extent(inputExtents, args);
+	}
+	switch (_operation) {
+		case kJRCompositeSourceIn:
+		case kJRCompositeMultiply:
+			return JRRectIntersection(inputExtents[0], inputExtents[1]);
+		case kJRCompositeSourceOut:
+			return inputExtents[0];
+		case kJRCompositeSourceAtop:
+			return inputExtents[1];
+		default:
+			/// 蒙版以外 m = 0, 结果是背景
+			return JRRectUnion(inputExtents[0], inputExtents[1]);
+	}
+}
+
+void JRCompositeKernel::apply(float* pixels, const float* const* inputs, size_t count, const float*) const
+{
+#if defined(JR_SIMD_X86)
+	if (JRSIMDActiveLevel() >= kJRSIMDLevelAVX2) {
+		kJRCompositeAVX2Spans[_operation](pixels, inputs, count);
+		return;
+	}
+#elif defined(JR_SIMD_NEON)
+	if (JRSIMDActiveLevel() == kJRSIMDLevelNEON) {
+		kJRCompositeNEONSpans[_operation](pixels, inputs, count);
+		return;
+	}
+#endif
+	kJRCompositeScalarSpans[_operation](pixels, inputs, count);
+}
+
+int JRCompositeKernel::shortcut(const JRAlphaCoverage* coverage) const
+{
+	JRAlphaCoverage s = coverage[0], b = coverage[1];
+	switch (_operation) {
+		case kJRCompositeSourceOver:
+			if (s == kJRAlphaOpaque || b == kJRAlphaClear) {
+				return 0;
+			}
+			return s == kJRAlphaClear ? 1 : kJRCompositeShortcutNone;
+		case kJRCompositeSourceIn:
+			if (s == kJRAlphaClear || b == kJRAlphaClear) {
+				return kJRCompositeShortcutClear;
+			}
+			return b == kJRAlphaOpaque ? 0 : kJRCompositeShortcutNone;
+		case kJRCompositeSourceOut:
+			if (s == kJRAlphaClear || b == kJRAlphaOpaque) {
+				return kJRCompositeShortcutClear;
+			}
+			return b == kJRAlphaClear ? 0 : kJRCompositeShortcutNone;
+		case kJRCompositeSourceAtop:
+			if (b == kJRAlphaClear) {
+				return kJRCompositeShortcutClear;
+			}
+			if (s == kJRAlphaClear) {
+				return 1;
+			}
+			return s == kJRAlphaOpaque && b == kJRAlphaOpaque ? 0 : kJRCompositeShortcutNone;
+		case kJRCompositeMultiply:
+			return s == kJRAlphaClear || b == kJRAlphaClear ? kJRCompositeShortcutClear : kJRCompositeShortcutNone;
+		case kJRCompositeBlendWithMask:
+		case kJRCompositeBlendWithAlphaMask:
+			/// 亮度蒙版不透明不代表 m = 1
+			if (coverage[2] == kJRAlphaClear) {
+				return 1;
+			}
+			if (_operation == kJRCompositeBlendWithAlphaMask && coverage[2] == kJRAlphaOpaque) {
+				return 0;
+			}
+			return s == kJRAlphaClear && b == kJRAlphaClear ? kJRCompositeShortcutClear : kJRCompositeShortcutNone;
+		default:
+			/// 加法与混合模式: 一方透明时结果就是另一方
+			if (s == kJRAlphaClear) {
+				return 1;
+			}
+			return b == kJRAlphaClear ? 0 : kJRCompositeShortcutNone;
+	}
+}
@@ -0,0 +1,122 @@
+//
+//  jr_Compositing.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Compositing_h
+#define jr_Compositing_h
+
+#include "jr_Buffer.h"
+#include "jr_Kernel.h"
+
+#include <memory>
+
+/* The operators of the compositing filters. Input 0 is the image (the
+ * source), input 1 the background (the destination), and for the mask blends
+ * input 2 is the mask. All of them work on premultiplied pixels. The
+ * destination operators of Porter and Duff are the source ones with the
+ * inputs swapped. */
+enum JRCompositeOperation {
+	/* Porter-Duff operators. Each channel, alpha included, follows the same
+	 * formula. */
+	/* CISourceOverCompositing: s + b (1 - as). */
+	kJRCompositeSourceOver = 0,
+	/* CISourceInCompositing: s ab. */
+	kJRCompositeSourceIn,
+	/* CISourceOutCompositing: s (1 - ab). */
+	kJRCompositeSourceOut,
+	/* CISourceAtopCompositing: s ab + b (1 - as). */
+	kJRCompositeSourceAtop,
+	/* CIAdditionCompositing: s + b. */
+	kJRCompositeAddition,
+	/* CIMultiplyCompositing: s b. */
+	kJRCompositeMultiply,
+
+	/* Separable blend modes of the W3C compositing specification, rewritten
+	 * on premultiplied values so they need no division. Alpha is
+	 * as + ab - as ab. */
+	/* CIMultiplyBlendMode. */
+	kJRCompositeMultiplyBlend,
+	/* CIScreenBlendMode. */
+	kJRCompositeScreenBlend,
+	/* CIOverlayBlendMode. */
+	kJRCompositeOverlayBlend,
+	/* CIDarkenBlendMode. */
+	kJRCompositeDarkenBlend,
+	/* CILightenBlendMode. */
+	kJRCompositeLightenBlend,
+	/* CIDifferenceBlendMode. */
+	kJRCompositeDifferenceBlend,
+	/* CIExclusionBlendMode. */
+	kJRCompositeExclusionBlend,
+	/* CIHardLightBlendMode. */
+	kJRCompositeHardLightBlend,
+
+	/* s m + b (1 - m), with m the luma of the mask clamped to [0, 1]
+	 * (CIBlendWithMask) or its alpha (CIBlendWithAlphaMask). */
+	kJRCompositeBlendWithMask,
+	kJRCompositeBlendWithAlphaMask,
+
+	kJRCompositeOperationCount
+};
+
+/* What is known about the alpha of a region. Clear means every channel of
+ * every pixel is 0, opaque that every alpha is exactly 1. */
+enum JRAlphaCoverage {
+	kJRAlphaPartial = 0,
+	kJRAlphaClear,
+	kJRAlphaOpaque,
+};
+
+/* Summarises 'rect' (inside buffer.rect()) of 'buffer'. Stops reading as soon
+ * as the region can be neither clear nor opaque. */
+JRAlphaCoverage JRBufferAlphaCoverage(const JRBuffer& buffer, const JRIRect& rect);
+
+/* Values of JRCompositeKernel::shortcut other than an input index. */
+enum {
+	/* The output is clear. */
+	kJRCompositeShortcutClear = -1,
+	/* The operator has to run. */
+	kJRCompositeShortcutNone = -2,
+};
+
+/* The kernel of the compositing filters. It is a colour kernel: 'pixels'
+ * holds the image and receives the result, inputs[0] is the background and
+ * inputs[1] the mask. Spans run with AVX2 or NEON when available; the AVX2
+ * results equal the scalar ones bit for bit.
+ *
+ * The renderer also asks the kernel where it can skip work. Given the
+ * coverage of each input over a block of pixels, shortcut() says whether the
+ * output there is one of the inputs unchanged, or clear. Where an opaque
+ * image covers the block, source-over never renders the background; where
+ * the image is clear, the background is copied without blending. In a stack
+ * of layers this prunes the layers that are hidden or absent, block by
+ * block. */
+class JRCompositeKernel : public JRColorKernel {
+public:
+	explicit JRCompositeKernel(JRCompositeOperation operation);
+
+	static std::shared_ptr<const JRCompositeKernel> kernel(JRCompositeOperation operation);
+
+	JRCompositeOperation operation() const { return _operation; }
+
+	/* Only where the inputs that contribute overlap: the image alone for
+	 * source-out, the background for source-atop, and the intersection for
+	 * source-in and multiply. */
+	JRRect extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments& args) const override;
+	void apply(float* pixels, const float* const* inputs, size_t count, const float* args) const override;
+
+	/* 'coverage' holds one entry per input; kJRAlphaPartial stands for
+	 * anything, so the answer holds whatever those inputs turn out to be.
+	 * Returns the index of the input the output equals, or one of the values
+	 * above. */
+	int shortcut(const JRAlphaCoverage* coverage) const;
+
+private:
+	JRCompositeOperation _operation;
+};
+
+#endif /* jr_Compositing_h */
@@ -0,0 +1,535 @@
+//
+//  jr_Context.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Context.h"
+#include "jr_BufferPool.h"
+#include "jr_GraphOptimizer.h"
+#include "jr_ImagePyramid.h"
+#include "jr_Parallel.h"
+#include "jr_Profiler.h"
+#include "jr_RenderCache.h"
+#include "jr_RenderPlan.h"
+#include "jr_Renderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+/// 预算不够时 tile 和条带最小缩到这个大小
+static const int kJRBudgetMinimumTileSize = 64;
+
+JRContext::JRContext(const JRContextOptions& options)
+: _options(options)
+{
+	_options.tileSize = std::max(_options.tileSize, 16);
+	_options.threadCount = std::max(_options.threadCount, 0);
+	_pool = _options.threadCount == 0 ? JRThreadPool::sharedPool() : std::make_shared<JRThreadPool>(size_t(_options.threadCount));
+	if (_options.cacheBudget > 0) {
+		_cache = std::make_shared<JRRenderCache>(_options.cacheBudget);
+	}
+	if (_options.pyramidBudget > 0) {
+		_pyramids = std::make_shared<JRPyramidCache>(_options.pyramidBudget);
+	}
+}
+
+std::shared_ptr<JRContext> JRContext::context()
+{
+	return context(JRContextOptions());
+}
+
+std::shared_ptr<JRContext> JRContext::context(const JRContextOptions& options)
+{
+	return std::shared_ptr<JRContext>(new JRContext(options));
+}
+
+/// profiler 不为空时才给节点编号
+static JRProfileLabelsRef JRProfileLabelsForImage(const JRProfilerRef& profiler, const JRImage* image)
+{
+	return profiler && image ? JRProfiler::labelsForGraph(*image) : nullptr;
+}
+
+JRImageRef JRContext::prepareImage(const JRImageRef& image, const JRIRect& bounds) const
+{
+	if (!image) {
+		return image;
+	}
+	JRProfileRecorder recorder(_options.profiler.get(), nullptr, "prepare");
+	JRImageRef result = _options.managesColor ? image : JRImageRemovingColorMatching(image);
+	/// 金字塔的每一层是固定的对象, 换用之后缓存仍能认出相同的子图
+	result = _pyramids ? JRImageUsingPyramids(result, *_pyramids) : result;
+	result = _cache ? applyCache(result, bounds) : result;
+	return _options.optimizesGraph ? JRGraphOptimizer(_options.bakesColorCubes).optimize(result) : result;
+}
+
+/// 是否为源节点, 源节点不缓存
+static bool JRIsSourceImage(const JRImage& image)
+{
+	return image.kind() == kJRImageKindEmpty || image.kind() == kJRImageKindProvider || image.kind() == kJRImageKindColor;
+}
+
+JRImageRef JRContext::applyCache(const JRImageRef& image, const JRIRect& bounds) const
+{
+	std::unordered_map<const JRImage*, JRRect> rois = JRRenderPlan::regionsOfInterest(*image, bounds);
+	JRProfileRecorder recorder(_options.profiler.get(), JRProfileLabelsForImage(_options.profiler, image.get()), "cache");
+	auto neededRect = [&](const JRImage& node) {
+		JRRect needed = JRRectIntersection(rois[&node], node.extent());
+		return needed.isNull() || needed.isInfinite() ? JRIRect() : JRIRectFromRect(needed);
+	};
+
+	/// 从输出往下找缓存中已有的子图, 换成它的像素
+	std::unordered_map<const JRImage*, JRImageRef> substituted;
+	std::function<JRImageRef(const JRImageRef&)> substitute = [&](const JRImageRef& node) -> JRImageRef {
+		auto found = substituted.find(node.get());
+		if (found != substituted.end()) {
+			return found->second;
+		}
+		JRImageRef result = node;
+		JRIRect needed = neededRect(*node);
+		JRBuffer cached = JRIsSourceImage(*node) || needed.isEmpty() ? JRBuffer() : _cache->lookup(*node, needed);
+		if (!JRIsSourceImage(*node) && !needed.isEmpty()) {
+			recorder.recordCacheLookup(*node, !cached.rect().isEmpty());
+		}
+		if (!cached.rect().isEmpty()) {
+			result = JRImage::imageWithImageProvider(std::make_shared<JRBufferImageProvider>(cached));
+		} else if (!node->inputs().empty()) {
+			std::vector<JRImageRef> inputs;
+			bool changed = false;
+			for (const JRImageRef& input : node->inputs()) {
+				inputs.push_back(substitute(input));
+				changed = changed || inputs.back() != input;
+			}
+			result = changed ? node->imageByReplacingInputs(inputs) : node;
+		}
+		substituted[node.get()] = result;
+		return result;
+	};
+	JRImageRef result = substitute(image);
+
+	/// 输出节点的输入最可能在下一次渲染中原样出现 (编辑器只改最后一个参数)
+	std::vector<JRImageRef> inputs = result->inputs();
+	bool changed = false;
+	for (size_t i = 0; i < inputs.size(); i++) {
+		const JRImageRef& original = image->inputs()[i];
+		JRIRect needed = neededRect(*original);
+		if (JRIsSourceImage(*inputs[i]) || needed.isEmpty() || size_t(needed.area()) * 4 * sizeof(float) > _options.cacheBudget) {
+			continue;
+		}
+		JRImageRef prepared = _options.optimizesGraph ? JRGraphOptimizer(_options.bakesColorCubes).optimize(inputs[i]) : inputs[i];
+		int tileSize;
+		JRRenderReservation reservation = admit(prepared.get(), needed, &tileSize, nullptr);
+		JRBuffer buffer = JRBuffer::bufferWithRect(needed);
+		auto start = std::chrono::steady_clock::now();
+		renderPrepared(*prepared, buffer, tileSize);
+		double cost = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		/// 以原始子图为键, 下一次的 recipe 与它结构相同
+		_cache->insert(original, buffer, cost);
+		inputs[i] = JRImage::imageWithImageProvider(std::make_shared<JRBufferImageProvider>(buffer));
+		changed = true;
+	}
+	return changed ? result->imageByReplacingInputs(inputs) : result;
+}
+
+/// 留下中间结果中下一条带还会用到的整行, 其余还给 JRBufferPool
+static void JRKeepBandWindow(std::unordered_map<const JRImage*, JRBuffer>& buffers, const std::unordered_map<const JRImage*, JRRect>& nextRegions,
+							 const JRImage* image, const JRBuffer* buffer)
+{
+	auto next = nextRegions.find(image);
+	if (!buffer || next == nextRegions.end()) {
+		return;
+	}
+	JRIRect rect = buffer->rect();
+	JRIRect needed = JRIRectIntersection(JRIRectFromRect(next->second), rect);
+	if (needed.isEmpty()) {
+		return;
+	}
+	JRBuffer window = JRBuffer::bufferWithRect({ rect.x, needed.y, rect.width, needed.height });
+	window.copyFrom(*buffer);
+	buffers[image] = window;
+}
+
+void JRContext::materialize(JRRenderPlan& plan, const JRProfileLabelsRef& labels, BandWindows* windows) const
+{
+	JRProfiler* profiler = _options.profiler.get();
+	std::unordered_map<const JRImage*, JRBuffer> nextWindows;
+	const std::vector<JRRenderPlan::Intermediate>& intermediates = plan.intermediates();
+	for (size_t i = 0; i < intermediates.size(); i++) {
+		const JRRenderPlan::Intermediate& intermediate = intermediates[i];
+		const JRIRect& rect = intermediate.rect;
+		JRProfileRecorder recorder(profiler, labels, "materialize", labels ? labels->at(intermediate.image) : std::string());
+		recorder.recordAllocation(*intermediate.image, rect);
+		JRBuffer buffer = JRBuffer::bufferWithRect(rect);
+		auto renderRect = [&](const JRIRect& r) {
+			if (r.isEmpty()) {
+				return;
+			}
+			/// 数据源整块读取一次, 逐行解码的 provider 才能按行序前进
+			if (intermediate.image->kind() == kJRImageKindProvider) {
+				JRProfileRecorder tileRecorder(profiler, labels, "tile");
+				JRRenderer(&plan, tileRecorder.enabled() ? &tileRecorder : nullptr).render(*intermediate.image, buffer.view(r));
+				return;
+			}
+			/// 分条带时逐行渲染 tile: 同一行的 tile 读取相同的源行, 逐行解码的源只需前进
+			int step = windows ? plan.tileSize() : r.height;
+			for (int y = r.y; y < r.maxY(); y += step) {
+				forEachTile({ r.x, y, r.width, std::min(step, r.maxY() - y) }, plan.tileSize(), [&](const JRIRect& tile) {
+					JRProfileRecorder tileRecorder(profiler, labels, "tile");
+					JRRenderer(&plan, tileRecorder.enabled() ? &tileRecorder : nullptr).render(*intermediate.image, buffer.view(tile));
+				});
+			}
+		};
+
+		/// 与上一条带重叠的整行直接拷贝, 只渲染其余的行
+		JRIRect reused = { 0, 0, 0, 0 };
+		auto previous = windows ? windows->buffers.find(intermediate.image) : std::unordered_map<const JRImage*, JRBuffer>::iterator();
+		if (windows && previous != windows->buffers.end()) {
+			JRIRect overlap = JRIRectIntersection(previous->second.rect(), rect);
+			if (!overlap.isEmpty() && overlap.x == rect.x && overlap.width == rect.width) {
+				buffer.view(overlap).copyFrom(previous->second);
+				reused = overlap;
+				recorder.recordCacheLookup(*intermediate.image, true);
+			}
+			windows->buffers.erase(previous);
+		}
+		if (reused.isEmpty()) {
+			renderRect(rect);
+		} else {
+			renderRect({ rect.x, rect.y, rect.width, reused.y - rect.y });
+			renderRect({ rect.x, reused.maxY(), rect.width, rect.maxY() - reused.maxY() });
+		}
+		plan.setBuffer(intermediate.image, buffer);
+
+		/// 不再被读取的中间结果还给 JRBufferPool, 供后面的节点使用
+		for (const JRRenderPlan::Intermediate& earlier : intermediates) {
+			if (earlier.lastUse == i) {
+				if (windows) {
+					JRKeepBandWindow(nextWindows, windows->nextRegions, earlier.image, plan.bufferForImage(earlier.image));
+				}
+				plan.setBuffer(earlier.image, JRBuffer());
+			}
+		}
+	}
+	if (windows) {
+		/// 输出 tile 读取的中间结果在渲染完这一条带后才留下
+		windows->buffers.swap(nextWindows);
+	}
+}
+
+/// 分条带渲染的峰值: 一条带的计划, 加上 windows 保留的与下一条带重叠的行
+static size_t JRBandedPeakBytes(const JRImage& prepared, const JRIRect& bounds, int bandHeight, int tileSize, size_t threads)
+{
+	JRIRect band = { bounds.x, bounds.y, bounds.width, std::min(bandHeight, bounds.height) };
+	JRRenderPlan plan(prepared, band, tileSize, true);
+	std::unordered_map<const JRImage*, JRRect> next = JRRenderPlan::regionsOfInterest(prepared, { band.x, band.maxY(), band.width, band.height });
+	size_t windowBytes = 0;
+	for (const JRRenderPlan::Intermediate& intermediate : plan.intermediates()) {
+		auto found = next.find(intermediate.image);
+		JRIRect rows = found != next.end() ? JRIRectIntersection(JRIRectFromRect(found->second), intermediate.rect) : JRIRect{ 0, 0, 0, 0 };
+		if (!rows.isEmpty()) {
+			windowBytes += JRBufferPool::blockBytes(size_t(intermediate.rect.width) * size_t(rows.height) * 4 * sizeof(float));
+		}
+	}
+	return plan.peakBytes(prepared, band, threads) + windowBytes;
+}
+
+JRRenderReservation JRContext::admit(const JRImage* prepared, const JRIRect& bounds, int* tileSize, int* bandHeight) const
+{
+	*tileSize = _options.tileSize;
+	if (bandHeight) {
+		*bandHeight = 0;
+	}
+	JRRenderBudget* budget = _options.renderBudget.get();
+	if (!budget || !prepared || bounds.isEmpty()) {
+		return JRRenderReservation();
+	}
+	size_t threads = _pool->threadCount();
+	size_t bytes = JRRenderPlan(*prepared, bounds, *tileSize).peakBytes(*prepared, bounds, threads);
+	JRRenderFit fit = kJRRenderFitAsAsked;
+	/// 依次尝试更小的 tile, 再尝试条带; 都放不下时用估计最小的一种, 由预算安排单独运行
+	auto consider = [&](size_t candidate, int size, int height, JRRenderFit candidateFit) {
+		if (candidate < bytes) {
+			bytes = candidate;
+			fit = candidateFit;
+			*tileSize = size;
+			if (bandHeight) {
+				*bandHeight = height;
+			}
+		}
+	};
+	for (int size = *tileSize / 2; bytes > budget->bytes() && size >= kJRBudgetMinimumTileSize; size /= 2) {
+		consider(JRRenderPlan(*prepared, bounds, size).peakBytes(*prepared, bounds, threads), size, 0, kJRRenderFitSmallerTiles);
+	}
+	for (int height = _options.tileSize; bandHeight && bytes > budget->bytes() && height >= kJRBudgetMinimumTileSize; height /= 2) {
+		if (height < bounds.height) {
+			consider(JRBandedPeakBytes(*prepared, bounds, height, height, threads), height, height, kJRRenderFitBands);
+		}
+	}
+	return budget->reserve(bytes, fit);
+}
+
+void JRContext::forEachTile(const JRIRect& bounds, int tileSize, const std::function<void(const JRIRect& tile)>& block) const
+{
+	if (bounds.isEmpty()) {
+		return;
+	}
+	int size = tileSize;
+	size_t columns = size_t((bounds.width + size - 1) / size);
+	size_t rows = size_t((bounds.height + size - 1) / size);
+	_pool->parallelFor(columns * rows, 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			int x = bounds.x + int(i % columns) * size;
+			int y = bounds.y + int(i / columns) * size;
+			block({ x, y, std::min(size, bounds.maxX() - x), std::min(size, bounds.maxY() - y) });
+		}
+	});
+}
+
+JRBuffer JRContext::render(const JRImageRef& image, const JRIRect& bounds) const
+{
+	JRBuffer buffer = JRBuffer::bufferWithRect(bounds);
+	render(image, buffer);
+	return buffer;
+}
+
+void JRContext::render(const JRImageRef& image, const JRBuffer& destination) const
+{
+	JRProfileRecorder recorder(_options.profiler.get(), nullptr, "render");
+	JRImageRef prepared = prepareImage(image, destination.rect());
+	if (!prepared) {
+		destination.clear();
+		return;
+	}
+	int tileSize;
+	JRRenderReservation reservation = admit(prepared.get(), destination.rect(), &tileSize, nullptr);
+	renderPrepared(*prepared, destination, tileSize);
+}
+
+void JRContext::renderPrepared(const JRImage& prepared, const JRBuffer& destination, int tileSize) const
+{
+	JRProfiler* profiler = _options.profiler.get();
+	JRProfileLabelsRef labels = JRProfileLabelsForImage(_options.profiler, &prepared);
+	JRRenderPlan plan(prepared, destination.rect(), tileSize);
+	materialize(plan, labels);
+	forEachTile(destination.rect(), tileSize, [&](const JRIRect& tile) {
+		JRProfileRecorder recorder(profiler, labels, "tile");
+		JRRenderer(&plan, recorder.enabled() ? &recorder : nullptr).render(prepared, destination.view(tile));
+	});
+}
+
+void JRContext::render(const JRImageRef& image, void* bitmap, size_t rowBytes, const JRIRect& bounds, JRFormat format) const
+{
+	JRProfileRecorder recorder(_options.profiler.get(), nullptr, "render");
+	JRImageRef prepared = prepareImage(image, bounds);
+	int tileSize, bandHeight;
+	JRRenderReservation reservation = admit(prepared.get(), bounds, &tileSize, &bandHeight);
+	if (bandHeight == 0) {
+		renderPrepared(prepared.get(), bitmap, rowBytes, bounds, format, tileSize, nullptr);
+		return;
+	}
+	/// 整幅的中间结果超出预算: 与 renderBands 相同地逐条带渲染, 直接写进 bitmap
+	BandWindows windows;
+	for (int y = bounds.y; y < bounds.maxY(); y += bandHeight) {
+		JRIRect band = { bounds.x, y, bounds.width, std::min(bandHeight, bounds.maxY() - y) };
+		renderPrepared(prepared.get(), static_cast<uint8_t*>(bitmap) + size_t(y - bounds.y) * rowBytes, rowBytes, band, format, tileSize,
+					   &windows);
+	}
+}
+
+void JRContext::renderPrepared(const JRImage* prepared, void* bitmap, size_t rowBytes, const JRIRect& bounds, JRFormat format, int tileSize,
+							   BandWindows* windows) const
+{
+	JRProfiler* profiler = _options.profiler.get();
+	JRProfileLabelsRef labels = JRProfileLabelsForImage(_options.profiler, prepared);
+	std::unique_ptr<JRRenderPlan> plan;
+	if (prepared) {
+		if (windows) {
+			/// 同样高的下一条带: 只关心它顶部与这一条带重叠的行
+			windows->nextRegions = JRRenderPlan::regionsOfInterest(*prepared, { bounds.x, bounds.maxY(), bounds.width, bounds.height });
+		}
+		plan.reset(new JRRenderPlan(*prepared, bounds, tileSize, windows != nullptr));
+		materialize(*plan, labels, windows);
+	}
+	uint8_t* base = static_cast<uint8_t*>(bitmap);
+	size_t bpp = JRFormatBytesPerPixel(format);
+	forEachTile(bounds, tileSize, [&](const JRIRect& tile) {
+		JRProfileRecorder recorder(profiler, labels, "tile");
+		JRBuffer buffer = JRBuffer::bufferWithRect(tile);
+		if (prepared) {
+			JRRenderer(plan.get(), recorder.enabled() ? &recorder : nullptr).render(*prepared, buffer);
+		} else {
+			buffer.clear();
+		}
+		for (int y = tile.y; y < tile.maxY(); y++) {
+			uint8_t* row = base + size_t(y - bounds.y) * rowBytes + size_t(tile.x - bounds.x) * bpp;
+			JRFormatPackRow(format, buffer.rowAt(y), row, size_t(tile.width));
+		}
+	});
+	if (windows && plan) {
+		for (const JRRenderPlan::Intermediate& intermediate : plan->intermediates()) {
+			if (intermediate.lastUse == kJRRenderPlanFinal) {
+				JRKeepBandWindow(windows->buffers, windows->nextRegions, intermediate.image, plan->bufferForImage(intermediate.image));
+			}
+		}
+	}
+}
+
+void JRContext::renderTiles(const JRImageRef& image, const JRIRect& bounds, const std::function<void(const JRBuffer& tile)>& body) const
+{
+	JRProfileRecorder recorder(_options.profiler.get(), nullptr, "render");
+	JRImageRef prepared = prepareImage(image, bounds);
+	JRProfiler* profiler = _options.profiler.get();
+	JRProfileLabelsRef labels = JRProfileLabelsForImage(_options.profiler, prepared.get());
+	int tileSize;
+	JRRenderReservation reservation = admit(prepared.get(), bounds, &tileSize, nullptr);
+	std::unique_ptr<JRRenderPlan> plan;
+	if (prepared) {
+		plan.reset(new JRRenderPlan(*prepared, bounds, tileSize));
+		materialize(*plan, labels);
+	}
+	forEachTile(bounds, tileSize, [&](const JRIRect& tile) {
+		JRProfileRecorder tileRecorder(profiler, labels, "tile");
+		JRBuffer buffer = JRBuffer::bufferWithRect(tile);
+		if (prepared) {
+			JRRenderer(plan.get(), tileRecorder.enabled() ? &tileRecorder : nullptr).render(*prepared, buffer);
+		} else {
+			buffer.clear();
+		}
+		body(buffer);
+	});
+}
+
+void JRContext::renderTiles(const JRImageRef& image, const std::vector<JRIRect>& rects, const std::function<void(const JRBuffer& tile)>& body) const
+{
+	JRProfileRecorder recorder(_options.profiler.get(), nullptr, "render");
+	/// 与 renderBands 相同, 不经过缓存: 零散的矩形不值得缓存整块的中间结果
+	JRImageRef prepared = _options.managesColor ? image : JRImageRemovingColorMatching(image);
+	prepared = prepared && _options.optimizesGraph ? JRGraphOptimizer(_options.bakesColorCubes).optimize(prepared) : prepared;
+	JRProfiler* profiler = _options.profiler.get();
+	JRProfileLabelsRef labels = JRProfileLabelsForImage(_options.profiler, prepared.get());
+	/// 每个线程同时渲染一个矩形, 按最大的一个预留
+	JRRenderReservation reservation;
+	if (_options.renderBudget && prepared) {
+		size_t largest = 0;
+		for (const JRIRect& rect : rects) {
+			largest = std::max(largest, JRRenderPlan::tileBytes(*prepared, rect, nullptr));
+		}
+		reservation = _options.renderBudget->reserve(largest * std::min(_pool->threadCount(), rects.size()));
+	}
+	_pool->parallelFor(rects.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (rects[i].isEmpty()) {
+				continue;
+			}
+			JRProfileRecorder tileRecorder(profiler, labels, "tile");
+			JRBuffer buffer = JRBuffer::bufferWithRect(rects[i]);
+			if (prepared) {
+				JRRenderer(nullptr, tileRecorder.enabled() ? &tileRecorder : nullptr).render(*prepared, buffer);
+			} else {
+				buffer.clear();
+			}
+			body(buffer);
+		}
+	});
+}
+
+std::shared_ptr<JRBitmap> JRContext::createBitmap(const JRImageRef& image, const JRRect& fromRect, JRFormat format) const
+{
+	if (fromRect.isEmpty() || fromRect.isInfinite()) {
+		return nullptr;
+	}
+	JRIRect bounds = JRIRectFromRect(fromRect);
+	std::shared_ptr<JRBitmap> bitmap = std::make_shared<JRBitmap>();
+	bitmap->width = bounds.width;
+	bitmap->height = bounds.height;
+	bitmap->format = format;
+	bitmap->bytesPerRow = size_t(bounds.width) * JRFormatBytesPerPixel(format);
+	bitmap->data.resize(bitmap->bytesPerRow * size_t(bounds.height));
+	render(image, bitmap->data.data(), bitmap->bytesPerRow, bounds, format);
+	return bitmap;
+}
+
+std::shared_ptr<JRBitmap> JRContext::createBitmap(const JRImageRef& image, const JRRect& fromRect, int width, int height,
+												 JRFormat format) const
+{
+	if (fromRect.isEmpty() || fromRect.isInfinite() || width <= 0 || height <= 0) {
+		return nullptr;
+	}
+	/// fromRect 映射到 (0, 0, width, height)
+	JRAffineTransform t = JRAffineTransformMake(width / fromRect.width, 0, 0, height / fromRect.height,
+												-fromRect.minX() * width / fromRect.width, -fromRect.minY() * height / fromRect.height);
+	JRImageRef scaled = image ? image->cropping(fromRect)->applying(t) : image;
+	return createBitmap(scaled, JRRectMake(0, 0, width, height), format);
+}
+
+JRYUVFrameRef JRContext::createYUVFrame(const JRImageRef& image, const JRIRect& bounds, JRYUVLayout layout,
+										JRYUVMatrix matrix, bool fullRange) const
+{
+	if (bounds.isEmpty()) {
+		return nullptr;
+	}
+	size_t chromaStep = layout == kJRYUVLayoutNV12 ? 2 : 1;
+	size_t lumaRowBytes = size_t(bounds.width), chromaRowBytes = size_t((bounds.width + 1) / 2) * chromaStep;
+	size_t chromaBytes = chromaRowBytes * size_t((bounds.height + 1) / 2);
+	std::shared_ptr<uint8_t> luma(new uint8_t[lumaRowBytes * size_t(bounds.height)], std::default_delete<uint8_t[]>());
+	std::shared_ptr<uint8_t> cb(new uint8_t[chromaBytes], std::default_delete<uint8_t[]>());
+	std::shared_ptr<uint8_t> cr;
+	if (layout == kJRYUVLayoutI420) {
+		cr.reset(new uint8_t[chromaBytes], std::default_delete<uint8_t[]>());
+	}
+	uint8_t* crBytes = cr ? cr.get() : cb.get() + 1;
+
+	/// 条带高度取偶数, 每条带都从色度行的开头开始
+	int bandHeight = (_options.tileSize + 1) & ~1;
+	renderBands(image, bounds, kJRFormatRGBAf, bandHeight, [&](const void* rows, size_t rowBytes, const JRIRect& band) {
+		size_t y = size_t(band.y - bounds.y);
+		JRYUVEncodeRows((const float*)rows, rowBytes, band.width, band.height, matrix, fullRange,
+						luma.get() + y * lumaRowBytes, lumaRowBytes,
+						cb.get() + y / 2 * chromaRowBytes, crBytes + y / 2 * chromaRowBytes, chromaRowBytes, chromaStep);
+		return true;
+	});
+	std::vector<JRYUVPlane> planes = { { luma, lumaRowBytes }, { cb, chromaRowBytes } };
+	if (cr) {
+		planes.push_back({ cr, chromaRowBytes });
+	}
+	return JRYUVFrame::frameWithPlanes(layout, bounds.width, bounds.height, std::move(planes), matrix, fullRange);
+}
+
+bool JRContext::renderBands(const JRImageRef& image, const JRIRect& bounds, JRFormat format, int bandHeight, const JRBandConsumer& consumer) const
+{
+	if (bounds.isEmpty()) {
+		return true;
+	}
+	JRProfileRecorder recorder(_options.profiler.get(), nullptr, "render");
+	/// 不经过缓存: 缓存会保留整幅图大小的中间结果
+	JRImageRef prepared = _options.managesColor ? image : JRImageRemovingColorMatching(image);
+	prepared = prepared && _options.optimizesGraph ? JRGraphOptimizer(_options.bakesColorCubes).optimize(prepared) : prepared;
+	bandHeight = bandHeight > 0 ? bandHeight : _options.tileSize;
+
+	size_t rowBytes = size_t(bounds.width) * JRFormatBytesPerPixel(format);
+	std::vector<uint8_t> rows(rowBytes * size_t(std::min(bandHeight, bounds.height)));
+	/// 条带高度由调用者决定, 只预留不降级
+	JRRenderReservation reservation;
+	if (_options.renderBudget && prepared) {
+		size_t bytes = JRBandedPeakBytes(*prepared, bounds, std::min(bandHeight, _options.tileSize), _options.tileSize, _pool->threadCount());
+		reservation = _options.renderBudget->reserve(bytes + rows.size());
+	}
+	/// 比 tile 高的条带按 tile 高度分行渲染: 同一行的 tile 读取相同的源行, 逐行解码的源只需前进
+	int step = std::min(bandHeight, _options.tileSize);
+	BandWindows windows;
+	for (int y = bounds.y; y < bounds.maxY(); y += bandHeight) {
+		JRIRect band = { bounds.x, y, bounds.width, std::min(bandHeight, bounds.maxY() - y) };
+		for (int top = band.y; top < band.maxY(); top += step) {
+			JRIRect part = { band.x, top, band.width, std::min(step, band.maxY() - top) };
+			renderPrepared(prepared.get(), rows.data() + size_t(top - band.y) * rowBytes, rowBytes, part, format, _options.tileSize, &windows);
+		}
+		if (!consumer(rows.data(), rowBytes, band)) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,197 @@
+//
+//  jr_Context.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Context_h
+#define jr_Context_h
+
+#include "jr_Buffer.h"
+#include "jr_Format.h"
+#include "jr_Image.h"
+#include "jr_RenderBudget.h"
+#include "jr_YUVFrame.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class JRProfiler;
+class JRPyramidCache;
+class JRRenderCache;
+class JRRenderPlan;
+class JRThreadPool;
+
+struct JRContextOptions {
+	/* Edge length of the square tiles a render is split into. */
+	int tileSize = 512;
+	/* Run JRGraphOptimizer (kernel fusion, transform folding) before each
+	 * render. Turn off to evaluate the graph exactly as it was built. */
+	bool optimizesGraph = true;
+	/* Let the optimizer bake chains of colour filters into one 3D lookup
+	 * (JRBakeColorCube). Output differs from the exact chain by the
+	 * interpolation error, well under one 8-bit step for smooth grades. */
+	bool bakesColorCubes = true;
+	/* Convert between colour spaces where the recipe asks for it
+	 * (matchedToWorkingSpace, matchedFromWorkingSpace). When false, those
+	 * nodes are removed before rendering and filters run on the encoded
+	 * values, like a CIContext whose working colour space is null: faster,
+	 * but exaggerated adjustments look different. */
+	bool managesColor = true;
+	/* Threads a render may use, counting the calling thread. 0 uses the
+	 * shared pool, one thread per hardware thread. */
+	int threadCount = 0;
+	/* Bytes of rendered intermediates kept between renders, the counterpart
+	 * of kCIContextCacheIntermediates. When it is not 0, each render stores
+	 * the inputs of its output node, and later renders of the same sub-graph
+	 * reuse them. 0 turns the cache off. */
+	size_t cacheBudget = 0;
+	/* Bytes of downscaled source levels kept between renders. When it is not
+	 * 0, a render through a downscaling applying(_:) reads the nearest
+	 * pyramid level of each source and runs the filters below the transform
+	 * at the smaller size, with blur radii scaled to match (see
+	 * JRImageUsingPyramids). A preview then costs about its own size rather
+	 * than the original's. 0 renders every downscale from the full source. */
+	size_t pyramidBudget = 0;
+	/* Records the time, pixels, bytes, cache use and allocations of every
+	 * node of every render (see JRProfiler). nullptr records nothing. */
+	std::shared_ptr<JRProfiler> profiler;
+	/* A memory budget shared with other contexts (see JRRenderBudget). Each
+	 * render reserves its estimated peak before it starts and waits while
+	 * the budget is full. A render too large for the budget runs with
+	 * smaller tiles, or in bands when it writes to a bitmap. nullptr does
+	 * not limit renders. */
+	std::shared_ptr<JRRenderBudget> renderBudget;
+};
+
+/* Rendered pixels, the counterpart of the CGImage returned by createCGImage. */
+struct JRBitmap {
+	std::vector<uint8_t> data;
+	size_t bytesPerRow;
+	int width;
+	int height;
+	JRFormat format;
+};
+
+/* Receives one band of a streamed render: band.height rows of the output
+ * format starting at row band.y. Return false to stop the render. */
+typedef std::function<bool(const void* rows, size_t rowBytes, const JRIRect& band)> JRBandConsumer;
+
+/* Evaluates JRImage recipes on the CPU, like a software CIContext. Contexts
+ * hold state worth keeping; create one and reuse it for every render.
+ *
+ * A render is split into tiles that run on a work-stealing thread pool.
+ * Intermediates that several tiles would otherwise recompute (see
+ * JRRenderPlan) are rendered once first, also in parallel tiles. A context
+ * may be used from several threads at once; with a renderBudget, renders
+ * from all of them share one memory limit. */
+class JRContext {
+public:
+	static std::shared_ptr<JRContext> context();
+	static std::shared_ptr<JRContext> context(const JRContextOptions& options);
+
+	const JRContextOptions& options() const { return _options; }
+	/* The intermediate cache, or nullptr when cacheBudget is 0. */
+	const std::shared_ptr<JRRenderCache>& cache() const { return _cache; }
+	/* The source pyramids, or nullptr when pyramidBudget is 0. */
+	const std::shared_ptr<JRPyramidCache>& pyramids() const { return _pyramids; }
+
+	/* Renders 'bounds' of 'image' into a new working-format buffer. */
+	JRBuffer render(const JRImageRef& image, const JRIRect& bounds) const;
+	/* Renders into 'destination', covering destination.rect(). */
+	void render(const JRImageRef& image, const JRBuffer& destination) const;
+	/* Renders 'bounds' of 'image' into caller memory in 'format'. */
+	void render(const JRImageRef& image, void* bitmap, size_t rowBytes, const JRIRect& bounds, JRFormat format) const;
+
+	/* Renders the 'fromRect' region of 'image', rounded out to whole pixels.
+	 * Returns nil for an empty or infinite rect. */
+	std::shared_ptr<JRBitmap> createBitmap(const JRImageRef& image, const JRRect& fromRect, JRFormat format = kJRFormatRGBA8) const;
+	/* Renders 'fromRect' of 'image' scaled to 'width' x 'height' pixels, the
+	 * small target of a thumbnail or preview. With pyramidBudget, this reads
+	 * the sources at the nearest pyramid level. Returns nil for an empty or
+	 * infinite rect or an empty size. */
+	std::shared_ptr<JRBitmap> createBitmap(const JRImageRef& image, const JRRect& fromRect, int width, int height,
+										   JRFormat format = kJRFormatRGBA8) const;
+	/* Renders 'bounds' of 'image' into a new 4:2:0 frame. The image is
+	 * streamed through renderBands two rows at a time per chroma row, so
+	 * only one band of RGBA exists at once. Alpha is dropped, which leaves
+	 * translucent pixels composited over black. Returns nil for an empty
+	 * rect. */
+	JRYUVFrameRef createYUVFrame(const JRImageRef& image, const JRIRect& bounds, JRYUVLayout layout = kJRYUVLayoutNV12,
+								 JRYUVMatrix matrix = kJRYUVMatrixBT709, bool fullRange = false) const;
+
+	/* Renders 'bounds' of 'image' in bands of 'bandHeight' rows (0 means
+	 * tileSize), from the smallest y down, and passes each band to
+	 * 'consumer'. For images larger than memory:
+	 *  - bands render one row of tiles at a time, top down, and tiles read
+	 *    their sources directly, so a JRScanlineImageProvider decodes as it
+	 *    goes and each source row once;
+	 *  - only nodes with several consumers are materialised, shared sources
+	 *    included, over the band plus its halo and also one row of tiles at
+	 *    a time. Inputs of general kernels are rendered with each tile's halo
+	 *    instead;
+	 *  - of each intermediate, only the rows the next band overlaps are kept
+	 *    after its last use, instead of being computed again.
+	 * Peak memory is a tile per thread plus band height x width x shared
+	 * nodes, not the image. The intermediate cache is not used. Returns false
+	 * if the consumer stopped the render. */
+	bool renderBands(const JRImageRef& image, const JRIRect& bounds, JRFormat format, int bandHeight, const JRBandConsumer& consumer) const;
+
+	/* Renders 'bounds' of 'image' tile by tile and passes each tile to 'body'
+	 * as a working-format buffer that is released afterwards, so memory stays
+	 * at a tile per thread. For reductions such as JRImageStatistics, which
+	 * look at each pixel once. 'body' runs on several threads at once. */
+	void renderTiles(const JRImageRef& image, const JRIRect& bounds, const std::function<void(const JRBuffer& tile)>& body) const;
+	/* The same for scattered 'rects', such as sampled rows. Each rect is
+	 * rendered on its own: shared intermediates are not planned over their
+	 * union, and the intermediate cache is not used. */
+	void renderTiles(const JRImageRef& image, const std::vector<JRIRect>& rects, const std::function<void(const JRBuffer& tile)>& body) const;
+
+private:
+	explicit JRContext(const JRContextOptions& options);
+
+	/// 渲染前换用金字塔, 替换缓存中已有的子图, 再做图优化
+	JRImageRef prepareImage(const JRImageRef& image, const JRIRect& bounds) const;
+	JRImageRef applyCache(const JRImageRef& image, const JRIRect& bounds) const;
+	void renderPrepared(const JRImage& prepared, const JRBuffer& destination, int tileSize) const;
+
+	/// 分条带渲染时在条带之间保留的行
+	struct BandWindows {
+		/// 上一条带的中间结果中, 这一条带还会用到的行
+		std::unordered_map<const JRImage*, JRBuffer> buffers;
+		/// 下一条带每个节点需要的区域
+		std::unordered_map<const JRImage*, JRRect> nextRegions;
+	};
+
+	/// windows 不为空时按条带渲染 (见 renderBands)
+	void renderPrepared(const JRImage* prepared, void* bitmap, size_t rowBytes, const JRIRect& bounds, JRFormat format, int tileSize,
+						BandWindows* windows) const;
+
+	/// 有 renderBudget 时估计峰值并预留. 放不下时把 tileSize 改小; bandHeight 不为空时还可以改为条带渲染,
+	/// 为 0 表示不分条带
+	JRRenderReservation admit(const JRImage* prepared, const JRIRect& bounds, int* tileSize, int* bandHeight) const;
+
+	/// 先渲染 plan 中需要共享的中间结果. windows 中与上一条带重叠的行直接复用,
+	/// 每个中间结果最后一次被读取后只把下一条带会用到的行留在 windows 中.
+	/// labels 是 profiler 用的节点名, 不记录时为空
+	void materialize(JRRenderPlan& plan, const std::shared_ptr<const std::unordered_map<const JRImage*, std::string>>& labels,
+					 BandWindows* windows = nullptr) const;
+
+	/// 按 tile 并行遍历, 每个 tile 只渲染它需要的区域
+	void forEachTile(const JRIRect& bounds, int tileSize, const std::function<void(const JRIRect& tile)>& block) const;
+
+	JRContextOptions _options;
+	std::shared_ptr<JRThreadPool> _pool;
+	std::shared_ptr<JRRenderCache> _cache;
+	std::shared_ptr<JRPyramidCache> _pyramids;
+};
+
+typedef std::shared_ptr<JRContext> JRContextRef;
+
+#endif /* jr_Context_h */
@@ -0,0 +1,770 @@
+//
+//  jr_FaceDetector.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_FaceDetector.h"
+#include "jr_Parallel.h"
+#include "jr_SIMD.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#if defined(JR_SIMD_X86)
+#include <immintrin.h>
+#elif defined(JR_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/// 每个任务扫描的窗口行数
+static const size_t kJRDetectorRowBlock = 8;
+/// groupRectangles 的 eps
+static const double kJRDetectorGroupEpsilon = 0.2;
+
+// MARK: - XML
+
+/// OpenCV 级联文件只用到元素和文本, 属性、注释和声明都跳过
+struct JRXMLNode {
+	std::string name;
+	std::string text;
+	std::vector<JRXMLNode> children;
+
+	const JRXMLNode* child(const std::string& childName) const
+	{
+		for (const JRXMLNode& node : children) {
+			if (node.name == childName) {
+				return &node;
+			}
+		}
+		return nullptr;
+	}
+
+	/// 深度优先找第一个名为 name 的节点
+	const JRXMLNode* find(const std::string& nodeName) const
+	{
+		if (name == nodeName) {
+			return this;
+		}
+		for (const JRXMLNode& node : children) {
+			const JRXMLNode* found = node.find(nodeName);
+			if (found) {
+				return found;
+			}
+		}
+		return nullptr;
+	}
+};
+
+static bool JRParseXMLChildren(const std::string& xml, size_t& i, JRXMLNode& parent)
+{
+	while (i < xml.size()) {
+		size_t open = xml.find('<', i);
+		if (open == std::string::npos) {
+			parent.text.append(xml, i, std::string::npos);
+			i = xml.size();
+			return parent.name.empty();
+		}
+		parent.text.append(xml, i, open - i);
+		if (xml.compare(open, 4, "<!--") == 0) {
+			size_t end = xml.find("-->", open);
+			if (end == std::string::npos) {
+				return false;
+			}
+			i = end + 3;
+		} else if (xml.compare(open, 2, "<?") == 0 || xml.compare(open, 2, "<!") == 0) {
+			size_t end = xml.find('>', open);
+			if (end == std::string::npos) {
+				return false;
+			}
+			i = end + 1;
+		} else if (xml.compare(open, 2, "</") == 0) {
+			size_t end = xml.find('>', open);
+			if (end == std::string::npos) {
+				return false;
+			}
+			i = end + 1;
+			return xml.compare(open + 2, parent.name.size(), parent.name) == 0;
+		} else {
+			size_t end = xml.find('>', open);
+			if (end == std::string::npos) {
+				return false;
+			}
+			size_t nameEnd = xml.find_first_of(" \t\r\n/>", open + 1);
+			JRXMLNode node;
+			node.name = xml.substr(open + 1, nameEnd - open - 1);
+			i = end + 1;
+			if (xml[end - 1] != '/' && !JRParseXMLChildren(xml, i, node)) {
+				return false;
+			}
+			parent.children.push_back(std::move(node));
+		}
+	}
+	return parent.name.empty();
+}
+
+static std::vector<double> JRParseNumbers(const std::string& text)
+{
+	std::vector<double> numbers;
+	const char* p = text.c_str();
+	char* end;
+	for (double value = std::strtod(p, &end); end != p; value = std::strtod(p, &end)) {
+		numbers.push_back(value);
+		p = end;
+	}
+	return numbers;
+}
+
+static double JRParseNumber(const JRXMLNode* node, double fallback)
+{
+	std::vector<double> numbers = node ? JRParseNumbers(node->text) : std::vector<double>();
+	return numbers.empty() ? fallback : numbers[0];
+}
+
+static std::string JRTrimmedText(const JRXMLNode* node)
+{
+	if (!node) {
+		return std::string();
+	}
+	size_t begin = node->text.find_first_not_of(" \t\r\n");
+	size_t end = node->text.find_last_not_of(" \t\r\n");
+	return begin == std::string::npos ? std::string() : node->text.substr(begin, end - begin + 1);
+}
+
+// MARK: - JRHaarCascade
+
+JRHaarCascade::JRHaarCascade(int width, int height, std::vector<Feature> features, std::vector<Stage> stages)
+: _width(width), _height(height), _features(std::move(features)), _stages(std::move(stages))
+{
+}
+
+JRHaarCascadeRef JRHaarCascade::cascadeWithStages(int width, int height, std::vector<Feature> features, std::vector<Stage> stages)
+{
+	if (width < 3 || height < 3 || stages.empty()) {
+		return nullptr;
+	}
+	for (const Feature& feature : features) {
+		if (feature.rects.size() < 2 || feature.rects.size() > 3) {
+			return nullptr;
+		}
+		for (const Rect& r : feature.rects) {
+			if (r.x < 0 || r.y < 0 || r.width < 0 || r.height < 0 || r.x + r.width > width || r.y + r.height > height) {
+				return nullptr;
+			}
+		}
+	}
+	for (const Stage& stage : stages) {
+		for (const Stump& stump : stage.stumps) {
+			if (stump.feature < 0 || size_t(stump.feature) >= features.size()) {
+				return nullptr;
+			}
+		}
+	}
+	return JRHaarCascadeRef(new JRHaarCascade(width, height, std::move(features), std::move(stages)));
+}
+
+JRHaarCascadeRef JRHaarCascade::cascadeWithXMLString(const std::string& xml)
+{
+	JRXMLNode root;
+	size_t i = 0;
+	if (!JRParseXMLChildren(xml, i, root)) {
+		return nullptr;
+	}
+	const JRXMLNode* cascade = root.find("cascade");
+	if (!cascade || JRTrimmedText(cascade->child("stageType")) != "BOOST" || JRTrimmedText(cascade->child("featureType")) != "HAAR") {
+		return nullptr;
+	}
+	const JRXMLNode* stageNodes = cascade->child("stages");
+	const JRXMLNode* featureNodes = cascade->child("features");
+	if (!stageNodes || !featureNodes) {
+		return nullptr;
+	}
+
+	std::vector<Feature> features;
+	for (const JRXMLNode& node : featureNodes->children) {
+		if (JRParseNumber(node.child("tilted"), 0) != 0 || !node.child("rects")) {
+			return nullptr;
+		}
+		Feature feature;
+		for (const JRXMLNode& rect : node.child("rects")->children) {
+			std::vector<double> v = JRParseNumbers(rect.text);
+			if (v.size() != 5) {
+				return nullptr;
+			}
+			feature.rects.push_back({ int(v[0]), int(v[1]), int(v[2]), int(v[3]), float(v[4]) });
+		}
+		features.push_back(std::move(feature));
+	}
+
+	std::vector<Stage> stages;
+	for (const JRXMLNode& node : stageNodes->children) {
+		Stage stage;
+		stage.threshold = float(JRParseNumber(node.child("stageThreshold"), 0));
+		const JRXMLNode* weak = node.child("weakClassifiers");
+		if (!weak) {
+			return nullptr;
+		}
+		for (const JRXMLNode& classifier : weak->children) {
+			/// 树桩: internalNodes = left right featureIdx threshold, 两个叶子
+			std::vector<double> internal = JRParseNumbers(JRTrimmedText(classifier.child("internalNodes")));
+			std::vector<double> leaves = JRParseNumbers(JRTrimmedText(classifier.child("leafValues")));
+			if (internal.size() != 4 || leaves.size() != 2) {
+				return nullptr;
+			}
+			stage.stumps.push_back({ int(internal[2]), float(internal[3]), float(leaves[0]), float(leaves[1]) });
+		}
+		stages.push_back(std::move(stage));
+	}
+	int width = int(JRParseNumber(cascade->child("width"), 0));
+	int height = int(JRParseNumber(cascade->child("height"), 0));
+	return cascadeWithStages(width, height, std::move(features), std::move(stages));
+}
+
+JRHaarCascadeRef JRHaarCascade::cascadeWithContentsOfFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return nullptr;
+	}
+	std::stringstream contents;
+	contents << file.rdbuf();
+	return cascadeWithXMLString(contents.str());
+}
+
+// MARK: - Search
+
+/// 8 位灰度图, 第 0 行是 bounds 的第一行
+struct JRGrayImage {
+	std::vector<uint8_t> pixels;
+	int width;
+	int height;
+};
+
+/// 一次搜索的参数
+struct JRSearchParameters {
+	double scaleFactor;
+	int step;
+	int minimumNeighbours;
+	double minimumSize;
+	double maximumSize;
+};
+
+struct JRDetection {
+	int x;
+	int y;
+	int width;
+	int height;
+	int neighbours;
+};
+
+/// 某一尺度下展开的矩形: 积分图中四个角的偏移
+struct JRCompiledRect {
+	int32_t corners[4];
+	float weight;
+};
+
+/// 某一尺度下的级联: 每个特征固定三个矩形, 缺少的权重为 0, 四个角都在原点
+struct JRCompiledCascade {
+	std::vector<JRCompiledRect> rects;
+	JRCompiledRect normal;
+	float area;
+
+	JRCompiledCascade(const JRHaarCascade& cascade, int stride)
+	{
+		auto compile = [stride](int x, int y, int w, int h, float weight) {
+			return JRCompiledRect{ { y * stride + x, y * stride + x + w, (y + h) * stride + x, (y + h) * stride + x + w }, weight };
+		};
+		for (const JRHaarCascade::Feature& feature : cascade.features()) {
+			for (size_t i = 0; i < 3; i++) {
+				if (i < feature.rects.size()) {
+					const JRHaarCascade::Rect& r = feature.rects[i];
+					rects.push_back(compile(r.x, r.y, r.width, r.height, r.weight));
+				} else {
+					rects.push_back({ { 0, 0, 0, 0 }, 0.0f });
+				}
+			}
+		}
+		/// 与 OpenCV 相同, 方差在去掉一圈边框的窗口上计算
+		normal = compile(1, 1, cascade.width() - 2, cascade.height() - 2, 1.0f);
+		area = float((cascade.width() - 2) * (cascade.height() - 2));
+	}
+};
+
+/// 积分图 (宽高各多一行一列), 以 2^32 为模: 矩形和小于 2^32 时差值准确
+struct JRIntegralImage {
+	std::vector<uint32_t> sum;
+	std::vector<uint32_t> squares;
+	int stride;
+};
+
+static inline uint32_t JRRectSum(const uint32_t* p, const int32_t* corners)
+{
+	return p[corners[0]] - p[corners[1]] - p[corners[2]] + p[corners[3]];
+}
+
+/// 窗口标准差乘以面积的倒数, 特征值要乘以它
+static inline float JRInverseNormal(const JRIntegralImage& integral, size_t offset, const JRCompiledCascade& compiled)
+{
+	int64_t s = int64_t(JRRectSum(integral.sum.data() + offset, compiled.normal.corners));
+	int64_t sq = int64_t(JRRectSum(integral.squares.data() + offset, compiled.normal.corners));
+	int64_t n = int64_t(compiled.area) * sq - s * s;
+	return n > 0 ? float(1.0 / std::sqrt(double(n))) : 1.0f;
+}
+
+static bool JREvaluateWindow(const JRHaarCascade& cascade, const JRCompiledCascade& compiled, const JRIntegralImage& integral, size_t offset)
+{
+	const uint32_t* p = integral.sum.data() + offset;
+	const float inverse = JRInverseNormal(integral, offset, compiled);
+	for (const JRHaarCascade::Stage& stage : cascade.stages()) {
+		float sum = 0;
+		for (const JRHaarCascade::Stump& stump : stage.stumps) {
+			const JRCompiledRect* r = &compiled.rects[size_t(stump.feature) * 3];
+			float v = r[0].weight * float(int32_t(JRRectSum(p, r[0].corners))) + r[1].weight * float(int32_t(JRRectSum(p, r[1].corners)));
+			v = (v + r[2].weight * float(int32_t(JRRectSum(p, r[2].corners)))) * inverse;
+			sum += v < stump.threshold ? stump.left : stump.right;
+		}
+		if (sum < stage.threshold) {
+			return false;
+		}
+	}
+	return true;
+}
+
+#if defined(JR_SIMD_X86)
+
+#define JR_TARGET_AVX2 __attribute__((target("avx2")))
+
+/// 相邻 8 个窗口同一个角的积分值. 间隔 2 时读两次再取偶数位, 比 gather 快
+JR_TARGET_AVX2 static inline __m256i JRLoadCorners(const uint32_t* p, int step, __m256i lanes)
+{
+	if (step == 1) {
+		return _mm256_loadu_si256((const __m256i*)p);
+	}
+	if (step == 2) {
+		const __m256i evens = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+		__m256i lo = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)p), evens);
+		__m256i hi = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)(p + 8)), evens);
+		return _mm256_permute2x128_si256(lo, hi, 0x20);
+	}
+	return _mm256_i32gather_epi32((const int*)p, lanes, 4);
+}
+
+JR_TARGET_AVX2 static inline __m256 JRRectSumsAVX2(const uint32_t* p, const int32_t* corners, int step, __m256i lanes)
+{
+	__m256i a = JRLoadCorners(p + corners[0], step, lanes);
+	__m256i b = JRLoadCorners(p + corners[1], step, lanes);
+	__m256i c = JRLoadCorners(p + corners[2], step, lanes);
+	__m256i d = JRLoadCorners(p + corners[3], step, lanes);
+	return _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_sub_epi32(_mm256_sub_epi32(a, b), c), d));
+}
+
+/// 从 offset 开始每隔 step 的 8 个窗口, 返回通过的掩码
+JR_TARGET_AVX2 static int JREvaluateWindowsAVX2(const JRHaarCascade& cascade, const JRCompiledCascade& compiled,
+											   const JRIntegralImage& integral, size_t offset, int step)
+{
+	const uint32_t* p = integral.sum.data() + offset;
+	const __m256i lanes = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(step));
+	alignas(32) float inverses[8];
+	for (int i = 0; i < 8; i++) {
+		inverses[i] = JRInverseNormal(integral, offset + size_t(i * step), compiled);
+	}
+	const __m256 inverse = _mm256_load_ps(inverses);
+	__m256 alive = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+	for (const JRHaarCascade::Stage& stage : cascade.stages()) {
+		__m256 sum = _mm256_setzero_ps();
+		for (const JRHaarCascade::Stump& stump : stage.stumps) {
+			const JRCompiledRect* r = &compiled.rects[size_t(stump.feature) * 3];
+			__m256 v = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(r[0].weight), JRRectSumsAVX2(p, r[0].corners, step, lanes)),
+									 _mm256_mul_ps(_mm256_set1_ps(r[1].weight), JRRectSumsAVX2(p, r[1].corners, step, lanes)));
+			v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_set1_ps(r[2].weight), JRRectSumsAVX2(p, r[2].corners, step, lanes)));
+			v = _mm256_mul_ps(v, inverse);
+			__m256 less = _mm256_cmp_ps(v, _mm256_set1_ps(stump.threshold), _CMP_LT_OQ);
+			sum = _mm256_add_ps(sum, _mm256_blendv_ps(_mm256_set1_ps(stump.right), _mm256_set1_ps(stump.left), less));
+		}
+		alive = _mm256_and_ps(alive, _mm256_cmp_ps(sum, _mm256_set1_ps(stage.threshold), _CMP_GE_OQ));
+		if (_mm256_movemask_ps(alive) == 0) {
+			return 0;
+		}
+	}
+	return _mm256_movemask_ps(alive);
+}
+
+#elif defined(JR_SIMD_NEON)
+
+static inline uint32x4_t JRLoadCorners(const uint32_t* p, int step)
+{
+	if (step == 1) {
+		return vld1q_u32(p);
+	}
+	const uint32_t values[4] = { p[0], p[step], p[2 * step], p[3 * step] };
+	return vld1q_u32(values);
+}
+
+static inline float32x4_t JRRectSumsNEON(const uint32_t* p, const int32_t* corners, int step)
+{
+	uint32x4_t a = JRLoadCorners(p + corners[0], step);
+	uint32x4_t b = JRLoadCorners(p + corners[1], step);
+	uint32x4_t c = JRLoadCorners(p + corners[2], step);
+	uint32x4_t d = JRLoadCorners(p + corners[3], step);
+	return vcvtq_f32_s32(vreinterpretq_s32_u32(vaddq_u32(vsubq_u32(vsubq_u32(a, b), c), d)));
+}
+
+static inline bool JRAnyLane(uint32x4_t mask)
+{
+	uint32x2_t m = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+	return (vget_lane_u32(m, 0) | vget_lane_u32(m, 1)) != 0;
+}
+
+/// 从 offset 开始每隔 step 的 4 个窗口, 返回通过的掩码
+static int JREvaluateWindowsNEON(const JRHaarCascade& cascade, const JRCompiledCascade& compiled,
+								 const JRIntegralImage& integral, size_t offset, int step)
+{
+	const uint32_t* p = integral.sum.data() + offset;
+	float inverses[4];
+	for (int i = 0; i < 4; i++) {
+		inverses[i] = JRInverseNormal(integral, offset + size_t(i * step), compiled);
+	}
+	const float32x4_t inverse = vld1q_f32(inverses);
+	uint32x4_t alive = vdupq_n_u32(~0u);
+	for (const JRHaarCascade::Stage& stage : cascade.stages()) {
+		float32x4_t sum = vdupq_n_f32(0);
+		for (const JRHaarCascade::Stump& stump : stage.stumps) {
+			const JRCompiledRect* r = &compiled.rects[size_t(stump.feature) * 3];
+			/// 乘和加分开写, 不让编译器合成 FMA
+			float32x4_t v = vaddq_f32(vmulq_n_f32(JRRectSumsNEON(p, r[0].corners, step), r[0].weight),
+									  vmulq_n_f32(JRRectSumsNEON(p, r[1].corners, step), r[1].weight));
+			v = vaddq_f32(v, vmulq_n_f32(JRRectSumsNEON(p, r[2].corners, step), r[2].weight));
+			v = vmulq_f32(v, inverse);
+			uint32x4_t less = vcltq_f32(v, vdupq_n_f32(stump.threshold));
+			sum = vaddq_f32(sum, vbslq_f32(less, vdupq_n_f32(stump.left), vdupq_n_f32(stump.right)));
+		}
+		alive = vandq_u32(alive, vcgeq_f32(sum, vdupq_n_f32(stage.threshold)));
+		if (!JRAnyLane(alive)) {
+			return 0;
+		}
+	}
+	uint32_t lanes[4];
+	vst1q_u32(lanes, alive);
+	return (lanes[0] & 1) | (lanes[1] & 2) | (lanes[2] & 4) | (lanes[3] & 8);
+}
+
+#endif
+
+/// 双线性缩小 region, 再建积分图
+static JRIntegralImage JRMakeIntegral(const JRGrayImage& gray, const JRIRect& region, double factor, int width, int height)
+{
+	JRIntegralImage integral;
+	integral.stride = width + 1;
+	integral.sum.assign(size_t(width + 1) * size_t(height + 1), 0);
+	integral.squares.assign(integral.sum.size(), 0);
+	const size_t columns = size_t(width);
+	std::vector<uint8_t> row(columns);
+	std::vector<int> x0(columns);
+	std::vector<float> wx(columns);
+	for (int x = 0; x < width; x++) {
+		double sx = std::min(std::max((x + 0.5) * factor - 0.5, 0.0), double(region.width - 1));
+		x0[size_t(x)] = std::min(int(sx), std::max(region.width - 2, 0));
+		wx[size_t(x)] = float(sx - x0[size_t(x)]);
+	}
+	for (int y = 0; y < height; y++) {
+		double sy = std::min(std::max((y + 0.5) * factor - 0.5, 0.0), double(region.height - 1));
+		int y0 = std::min(int(sy), std::max(region.height - 2, 0));
+		float wy = float(sy - y0);
+		const uint8_t* top = gray.pixels.data() + size_t(region.y + y0) * size_t(gray.width) + size_t(region.x);
+		const uint8_t* bottom = region.height > 1 ? top + gray.width : top;
+		for (int x = 0; x < width; x++) {
+			size_t i = size_t(x0[size_t(x)]);
+			size_t j = region.width > 1 ? i + 1 : i;
+			float t = top[i] + (float(top[j]) - float(top[i])) * wx[size_t(x)];
+			float b = bottom[i] + (float(bottom[j]) - float(bottom[i])) * wx[size_t(x)];
+			row[size_t(x)] = uint8_t(t + (b - t) * wy + 0.5f);
+		}
+		const uint32_t* above = integral.sum.data() + size_t(y) * size_t(integral.stride);
+		const uint32_t* aboveSquares = integral.squares.data() + size_t(y) * size_t(integral.stride);
+		uint32_t* sum = integral.sum.data() + size_t(y + 1) * size_t(integral.stride);
+		uint32_t* squares = integral.squares.data() + size_t(y + 1) * size_t(integral.stride);
+		uint32_t rowSum = 0, rowSquares = 0;
+		for (int x = 0; x < width; x++) {
+			uint32_t v = row[size_t(x)];
+			rowSum += v;
+			rowSquares += v * v;
+			sum[x + 1] = above[x + 1] + rowSum;
+			squares[x + 1] = aboveSquares[x + 1] + rowSquares;
+		}
+	}
+	return integral;
+}
+
+/// 扫描一个尺度的所有窗口, 结果为 region 内的坐标
+static void JRSearchScale(const JRHaarCascade& cascade, const JRGrayImage& gray, const JRIRect& region, double factor,
+						  int step, std::vector<JRDetection>& detections, std::mutex& mutex)
+{
+	int width = int(region.width / factor), height = int(region.height / factor);
+	int columns = (width - cascade.width()) / step + 1, rows = (height - cascade.height()) / step + 1;
+	if (columns <= 0 || rows <= 0) {
+		return;
+	}
+	JRIntegralImage integral = JRMakeIntegral(gray, region, factor, width, height);
+	JRCompiledCascade compiled(cascade, integral.stride);
+	int size = int(std::lround(cascade.width() * factor)), sizeY = int(std::lround(cascade.height() * factor));
+
+	JRParallelFor(size_t(rows), kJRDetectorRowBlock, [&](size_t begin, size_t end) {
+		std::vector<JRDetection> found;
+		auto add = [&](int column, int y) {
+			found.push_back({ int(std::lround(column * step * factor)), int(std::lround(y * factor)), size, sizeY, 1 });
+		};
+		for (size_t r = begin; r < end; r++) {
+			int y = int(r) * step;
+			size_t base = size_t(y) * size_t(integral.stride);
+			int column = 0;
+#if defined(JR_SIMD_X86)
+			if (JRSIMDActiveLevel() >= kJRSIMDLevelAVX2) {
+				for (; column + 8 <= columns; column += 8) {
+					int mask = JREvaluateWindowsAVX2(cascade, compiled, integral, base + size_t(column * step), step);
+					for (int i = 0; mask; i++, mask >>= 1) {
+						if (mask & 1) {
+							add(column + i, y);
+						}
+					}
+				}
+			}
+#elif defined(JR_SIMD_NEON)
+			if (JRSIMDActiveLevel() == kJRSIMDLevelNEON) {
+				for (; column + 4 <= columns; column += 4) {
+					int mask = JREvaluateWindowsNEON(cascade, compiled, integral, base + size_t(column * step), step);
+					for (int i = 0; mask; i++, mask >>= 1) {
+						if (mask & 1) {
+							add(column + i, y);
+						}
+					}
+				}
+			}
+#endif
+			for (; column < columns; column++) {
+				if (JREvaluateWindow(cascade, compiled, integral, base + size_t(column * step))) {
+					add(column, y);
+				}
+			}
+		}
+		if (!found.empty()) {
+			std::lock_guard<std::mutex> lock(mutex);
+			detections.insert(detections.end(), found.begin(), found.end());
+		}
+	});
+}
+
+/// OpenCV groupRectangles: 相似的窗口归为一组取平均, 票数不超过 minimumNeighbours 的组丢弃, 再去掉被大组包含的小组
+static std::vector<JRDetection> JRGroupDetections(const std::vector<JRDetection>& detections, int minimumNeighbours)
+{
+	std::vector<size_t> parent(detections.size());
+	for (size_t i = 0; i < parent.size(); i++) {
+		parent[i] = i;
+	}
+	auto root = [&parent](size_t i) {
+		while (parent[i] != i) {
+			i = parent[i] = parent[parent[i]];
+		}
+		return i;
+	};
+	/// 边长相差超过 2 * delta 的窗口不会相似, 所以按大小分类, 只比较大小相近的两类.
+	/// 另一类放进边长为 delta 的格子, 相似的窗口一定在相邻的 3 x 3 个格子里
+	std::map<std::pair<int, int>, std::vector<size_t>> sizes;
+	for (size_t i = 0; i < detections.size(); i++) {
+		sizes[{ detections[i].width, detections[i].height }].push_back(i);
+	}
+	for (auto first = sizes.begin(); first != sizes.end(); ++first) {
+		const int w = first->first.first, h = first->first.second;
+		for (auto second = first; second != sizes.end() && second->first.first - w <= 2 * kJRDetectorGroupEpsilon * std::max(w, h); ++second) {
+			const int w2 = second->first.first, h2 = second->first.second;
+			double delta = kJRDetectorGroupEpsilon * (std::min(w, w2) + std::min(h, h2)) * 0.5;
+			if (std::abs(w2 - w) > 2 * delta || std::abs(h2 - h) > 2 * delta) {
+				continue;
+			}
+			const int cell = std::max(1, int(std::ceil(delta)));
+			auto key = [cell](int x, int y) { return (int64_t(x / cell) << 32) ^ uint32_t(y / cell); };
+			std::unordered_map<int64_t, std::vector<size_t>> grid;
+			for (size_t j : second->second) {
+				grid[key(detections[j].x, detections[j].y)].push_back(j);
+			}
+			for (size_t i : first->second) {
+				const JRDetection& a = detections[i];
+				for (int dy = -1; dy <= 1; dy++) {
+					for (int dx = -1; dx <= 1; dx++) {
+						auto found = grid.find(key(a.x + dx * cell, a.y + dy * cell));
+						if (found == grid.end()) {
+							continue;
+						}
+						for (size_t j : found->second) {
+							const JRDetection& b = detections[j];
+							if (std::abs(a.x - b.x) <= delta && std::abs(a.y - b.y) <= delta
+								&& std::abs(a.x + a.width - b.x - b.width) <= delta && std::abs(a.y + a.height - b.y - b.height) <= delta) {
+								parent[root(i)] = root(j);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	std::vector<double> sums;
+	std::vector<JRDetection> groups;
+	std::vector<size_t> groupOf(detections.size(), SIZE_MAX);
+	for (size_t i = 0; i < detections.size(); i++) {
+		size_t r = root(i);
+		if (groupOf[r] == SIZE_MAX) {
+			groupOf[r] = groups.size();
+			groups.push_back({ 0, 0, 0, 0, 0 });
+			sums.insert(sums.end(), { 0, 0, 0, 0 });
+		}
+		size_t g = groupOf[r];
+		sums[g * 4 + 0] += detections[i].x;
+		sums[g * 4 + 1] += detections[i].y;
+		sums[g * 4 + 2] += detections[i].width;
+		sums[g * 4 + 3] += detections[i].height;
+		groups[g].neighbours++;
+	}
+	for (size_t g = 0; g < groups.size(); g++) {
+		double n = groups[g].neighbours;
+		groups[g] = { int(std::lround(sums[g * 4] / n)), int(std::lround(sums[g * 4 + 1] / n)), int(std::lround(sums[g * 4 + 2] / n)),
+					  int(std::lround(sums[g * 4 + 3] / n)), groups[g].neighbours };
+	}
+
+	groups.erase(std::remove_if(groups.begin(), groups.end(), [minimumNeighbours](const JRDetection& group) {
+		return group.neighbours <= minimumNeighbours;
+	}), groups.end());
+	std::vector<JRDetection> result;
+	for (const JRDetection& a : groups) {
+		bool inside = false;
+		for (const JRDetection& b : groups) {
+			if (&a == &b) {
+				continue;
+			}
+			int dx = int(std::lround(b.width * kJRDetectorGroupEpsilon)), dy = int(std::lround(b.height * kJRDetectorGroupEpsilon));
+			if (a.x >= b.x - dx && a.y >= b.y - dy && a.x + a.width <= b.x + b.width + dx && a.y + a.height <= b.y + b.height + dy
+				&& (b.neighbours > std::max(3, a.neighbours) || a.neighbours < 3)) {
+				inside = true;
+				break;
+			}
+		}
+		if (!inside) {
+			result.push_back(a);
+		}
+	}
+	return result;
+}
+
+/// 在 gray 的 region 内搜索, 尺度之间并行. 结果为 gray 中的坐标
+static std::vector<JRDetection> JRDetect(const JRHaarCascade& cascade, const JRGrayImage& gray, const JRIRect& region,
+										 const JRSearchParameters& parameters)
+{
+	std::vector<double> factors;
+	double factor = std::max(1.0, parameters.minimumSize / std::max(cascade.width(), cascade.height()));
+	for (; region.width / factor >= cascade.width() && region.height / factor >= cascade.height(); factor *= parameters.scaleFactor) {
+		if (cascade.width() * factor > parameters.maximumSize) {
+			break;
+		}
+		factors.push_back(factor);
+	}
+	std::vector<JRDetection> detections;
+	std::mutex mutex;
+	JRParallelFor(factors.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			JRSearchScale(cascade, gray, region, factors[i], parameters.step, detections, mutex);
+		}
+	});
+	std::vector<JRDetection> groups = JRGroupDetections(detections, parameters.minimumNeighbours);
+	for (JRDetection& group : groups) {
+		group.x += region.x;
+		group.y += region.y;
+	}
+	return groups;
+}
+
+// MARK: - JRFaceDetector
+
+JRFaceDetector::JRFaceDetector(const JRHaarCascadeRef& cascade, const JRContextRef& context, const JRFaceDetectorOptions& options)
+: _cascade(cascade), _context(context ? context : JRContext::context()), _options(options)
+{
+}
+
+std::shared_ptr<JRFaceDetector> JRFaceDetector::detectorWithCascade(const JRHaarCascadeRef& cascade, const JRContextRef& context,
+																	 const JRFaceDetectorOptions& options)
+{
+	if (!cascade) {
+		return nullptr;
+	}
+	return std::shared_ptr<JRFaceDetector>(new JRFaceDetector(cascade, context, options));
+}
+
+/// 在脸的一部分中找特征, 取票数最多的一组的中心
+static bool JRFindFeature(const JRHaarCascadeRef& cascade, const JRGrayImage& gray, const JRIRect& area, double faceSize,
+						  int step, const JRIRect& bounds, JRVector* position)
+{
+	JRIRect region = JRIRectIntersection(area, { 0, 0, gray.width, gray.height });
+	if (!cascade || region.width < cascade->width() || region.height < cascade->height()) {
+		return false;
+	}
+	std::vector<JRDetection> found = JRDetect(*cascade, gray, region, { 1.1, step, 0, faceSize * 0.1, faceSize * 0.6 });
+	if (found.empty()) {
+		return false;
+	}
+	const JRDetection& best = *std::max_element(found.begin(), found.end(), [](const JRDetection& a, const JRDetection& b) {
+		return a.neighbours < b.neighbours;
+	});
+	*position = JRVector::vectorWithXY(bounds.x + best.x + best.width * 0.5, bounds.y + best.y + best.height * 0.5);
+	return true;
+}
+
+std::vector<JRFaceFeature> JRFaceDetector::featuresInImage(const JRImageRef& image) const
+{
+	std::vector<JRFaceFeature> faces;
+	if (!image || image->extent().isEmpty() || image->extent().isInfinite()) {
+		return faces;
+	}
+	JRIRect bounds = JRIRectFromRect(image->extent());
+
+	/// 渲染为灰度, 与级联训练时一样按行从上往下排列
+	JRGrayImage gray;
+	gray.width = bounds.width;
+	gray.height = bounds.height;
+	gray.pixels.resize(size_t(bounds.width) * size_t(bounds.height));
+	_context->renderBands(image, bounds, kJRFormatRGBA8, 0, [&](const void* rows, size_t rowBytes, const JRIRect& band) {
+		for (int y = band.y; y < band.maxY(); y++) {
+			const uint8_t* p = (const uint8_t*)rows + size_t(y - band.y) * rowBytes;
+			uint8_t* g = gray.pixels.data() + size_t(y - bounds.y) * size_t(bounds.width);
+			for (int x = 0; x < band.width; x++, p += 4) {
+				g[x] = uint8_t((p[0] * 77 + p[1] * 150 + p[2] * 29 + 128) >> 8);
+			}
+		}
+		return true;
+	});
+
+	const bool high = _options.accuracy == kJRDetectorAccuracyHigh;
+	JRSearchParameters parameters = { high ? 1.1 : 1.25, high ? 1 : 2, high ? 3 : 2, _options.minimumFeatureSize, INFINITY };
+	for (const JRDetection& d : JRDetect(*_cascade, gray, { 0, 0, gray.width, gray.height }, parameters)) {
+		JRFaceFeature face = {};
+		face.bounds = JRRectMake(bounds.x + d.x, bounds.y + d.y, d.width, d.height);
+		face.neighbours = d.neighbours;
+		/// 眼睛在上半部分的左右两侧, 嘴在下部中间
+		int halfWidth = d.width / 2;
+		JRIRect eyes = { d.x, d.y + d.height / 5, halfWidth, d.height * 2 / 5 };
+		face.hasLeftEyePosition = JRFindFeature(_options.eyeCascade, gray, eyes, d.width, parameters.step, bounds, &face.leftEyePosition);
+		eyes.x += halfWidth;
+		face.hasRightEyePosition = JRFindFeature(_options.eyeCascade, gray, eyes, d.width, parameters.step, bounds, &face.rightEyePosition);
+		JRIRect mouth = { d.x + d.width / 6, d.y + d.height * 3 / 5, d.width * 2 / 3, d.height * 2 / 5 };
+		face.hasMouthPosition = JRFindFeature(_options.mouthCascade, gray, mouth, d.width, parameters.step, bounds, &face.mouthPosition);
+		faces.push_back(face);
+	}
+	std::sort(faces.begin(), faces.end(), [](const JRFaceFeature& a, const JRFaceFeature& b) {
+		return a.bounds.width * a.bounds.height > b.bounds.width * b.bounds.height;
+	});
+	return faces;
+}
@@ -0,0 +1,150 @@
+//
+//  jr_FaceDetector.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_FaceDetector_h
+#define jr_FaceDetector_h
+
+#include "jr_Context.h"
+#include "jr_Image.h"
+#include "jr_Value.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class JRHaarCascade;
+typedef std::shared_ptr<const JRHaarCascade> JRHaarCascadeRef;
+
+/* A boosted cascade of Haar-like features, the trained model a
+ * JRFaceDetector runs. A window passes a stage when the leaf values of its
+ * stumps add up to at least the stage threshold; a stump compares one
+ * feature, normalised by the standard deviation of the window, with its
+ * threshold. A window is a detection if it passes every stage, and most
+ * windows are rejected by the first few stages.
+ *
+ * The engine ships no trained cascades. Use the haarcascade_*.xml files that
+ * come with OpenCV (frontalface_default or frontalface_alt for faces,
+ * eye and mcs_mouth for features), or build one in code. */
+class JRHaarCascade {
+public:
+	/* Pixels relative to the window, 'weight' times their sum. */
+	struct Rect {
+		int x;
+		int y;
+		int width;
+		int height;
+		float weight;
+	};
+	/* Two or three weighted rects. */
+	struct Feature {
+		std::vector<Rect> rects;
+	};
+	/* Adds 'left' when feature < threshold, else 'right'. */
+	struct Stump {
+		int feature;
+		float threshold;
+		float left;
+		float right;
+	};
+	struct Stage {
+		float threshold;
+		std::vector<Stump> stumps;
+	};
+
+	/* Reads a cascade in the XML format of OpenCV's CascadeClassifier with
+	 * stageType BOOST, featureType HAAR and stump weak classifiers. Returns
+	 * nullptr for anything else, including tilted features. */
+	static JRHaarCascadeRef cascadeWithContentsOfFile(const std::string& path);
+	static JRHaarCascadeRef cascadeWithXMLString(const std::string& xml);
+	/* Returns nullptr if a stump names a missing feature, a feature does not
+	 * have two or three rects, or a rect leaves the window. */
+	static JRHaarCascadeRef cascadeWithStages(int width, int height, std::vector<Feature> features, std::vector<Stage> stages);
+
+	int width() const { return _width; }
+	int height() const { return _height; }
+	const std::vector<Feature>& features() const { return _features; }
+	const std::vector<Stage>& stages() const { return _stages; }
+
+private:
+	JRHaarCascade(int width, int height, std::vector<Feature> features, std::vector<Stage> stages);
+
+	int _width;
+	int _height;
+	std::vector<Feature> _features;
+	std::vector<Stage> _stages;
+};
+
+/* The counterpart of CIDetectorAccuracyLow and CIDetectorAccuracyHigh. */
+enum JRDetectorAccuracy {
+	/* Scales 1.25 apart, windows every second pixel, two neighbours. */
+	kJRDetectorAccuracyLow = 0,
+	/* Scales 1.1 apart, windows at every pixel, three neighbours. */
+	kJRDetectorAccuracyHigh,
+};
+
+struct JRFaceDetectorOptions {
+	JRDetectorAccuracy accuracy = kJRDetectorAccuracyHigh;
+	/* The side of the smallest face reported, in pixels, like
+	 * CIDetectorMinFeatureSize. Smaller than the cascade window means the
+	 * window. Larger values skip the finest scales, which cost the most. */
+	double minimumFeatureSize = 0;
+	/* Cascades searched inside each face for the eye and mouth positions.
+	 * Without them the positions are not reported. */
+	JRHaarCascadeRef eyeCascade;
+	JRHaarCascadeRef mouthCascade;
+};
+
+/* A face found by JRFaceDetector, the counterpart of CIFaceFeature. Bounds
+ * and positions are in image coordinates. The left eye is the one on the
+ * left of the image. */
+struct JRFaceFeature {
+	JRRect bounds;
+	/* How many overlapping windows voted for the face. */
+	int neighbours;
+	bool hasLeftEyePosition;
+	bool hasRightEyePosition;
+	bool hasMouthPosition;
+	JRVector leftEyePosition;
+	JRVector rightEyePosition;
+	JRVector mouthPosition;
+};
+
+/* Finds upright faces with a JRHaarCascade, the counterpart of a CIDetector
+ * of type CIDetectorTypeFace, on the CPU.
+ *
+ * The image is rendered once as 8-bit luminance. The search then runs
+ * over a pyramid of scales; each scale is resampled from it with its own
+ * integral image of sums and of squared sums, so any rect sum costs four
+ * reads. Scales run in parallel, and the windows of each scale run in
+ * parallel in bands of rows. Eight horizontally adjacent windows are
+ * evaluated at once with AVX2 or four with NEON, with the same arithmetic as
+ * the scalar code, until every one of them has been rejected. Overlapping detections are grouped like OpenCV's
+ * groupRectangles. */
+class JRFaceDetector {
+public:
+	/* Returns nullptr without a cascade. 'context' renders the images;
+	 * nullptr means a new default context. */
+	static std::shared_ptr<JRFaceDetector> detectorWithCascade(const JRHaarCascadeRef& cascade, const JRContextRef& context = nullptr,
+																const JRFaceDetectorOptions& options = JRFaceDetectorOptions());
+
+	const JRFaceDetectorOptions& options() const { return _options; }
+
+	/* The faces in 'image', largest first. Empty for an infinite image. */
+	std::vector<JRFaceFeature> featuresInImage(const JRImageRef& image) const;
+
+private:
+	JRFaceDetector(const JRHaarCascadeRef& cascade, const JRContextRef& context, const JRFaceDetectorOptions& options);
+
+	JRHaarCascadeRef _cascade;
+	JRContextRef _context;
+	JRFaceDetectorOptions _options;
+};
+
+typedef std::shared_ptr<JRFaceDetector> JRFaceDetectorRef;
+
+#endif /* jr_FaceDetector_h */
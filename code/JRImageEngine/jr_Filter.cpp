@@ -0,0 +1,542 @@
+//
+//  jr_Filter.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+// MARK: - Interned keys
+
+/// 键名到 ID 的全局表. 名字存在 deque 中, 返回的引用一直有效
+class JRFilterKeyTable {
+public:
+	static JRFilterKeyTable& shared()
+	{
+		static JRFilterKeyTable* table = new JRFilterKeyTable();
+		return *table;
+	}
+
+	JRFilterKey keyForName(const std::string& name)
+	{
+		{
+			std::shared_lock<std::shared_mutex> lock(_mutex);
+			auto found = _keys.find(name);
+			if (found != _keys.end()) {
+				return found->second;
+			}
+		}
+		std::unique_lock<std::shared_mutex> lock(_mutex);
+		return intern(name);
+	}
+
+	const std::string& name(JRFilterKey key)
+	{
+		static const std::string empty;
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		return key < _names.size() ? _names[key] : empty;
+	}
+
+private:
+	JRFilterKeyTable()
+	{
+		/// 顺序与 kJROutputImageKeyID... 相同
+		for (const char* name : { kJROutputImageKey, kJRInputBackgroundImageKey, kJRInputImageKey, kJRInputTimeKey,
+								  kJRInputTransformKey, kJRInputScaleKey, kJRInputCenterKey, kJRInputRadiusKey,
+								  kJRInputAngleKey, kJRInputWidthKey, kJRInputSharpnessKey, kJRInputIntensityKey,
+								  kJRInputEVKey, kJRInputSaturationKey, kJRInputColorKey, kJRInputBrightnessKey,
+								  kJRInputContrastKey, kJRInputMaskImageKey, kJRInputTargetImageKey, kJRInputExtentKey }) {
+			intern(name);
+		}
+	}
+
+	JRFilterKey intern(const std::string& name)
+	{
+		auto found = _keys.find(name);
+		if (found != _keys.end()) {
+			return found->second;
+		}
+		JRFilterKey key = JRFilterKey(_names.size());
+		_names.push_back(name);
+		_keys.emplace(name, key);
+		return key;
+	}
+
+	std::shared_mutex _mutex;
+	std::unordered_map<std::string, JRFilterKey> _keys;
+	std::deque<std::string> _names;
+};
+
+JRFilterKey JRFilterKeyForName(const std::string& name)
+{
+	return JRFilterKeyTable::shared().keyForName(name);
+}
+
+const std::string& JRFilterKeyName(JRFilterKey key)
+{
+	return JRFilterKeyTable::shared().name(key);
+}
+
+// MARK: - JRFilterLayout
+
+static JRFilterSlotType JRSlotTypeForAttributeType(const std::string& type)
+{
+	if (type == kJRAttributeTypeScalar || type == kJRAttributeTypeDistance || type == kJRAttributeTypeAngle ||
+		type == kJRAttributeTypeTime || type == kJRAttributeTypeBoolean || type == kJRAttributeTypeInteger ||
+		type == kJRAttributeTypeCount) {
+		return kJRFilterSlotTypeDouble;
+	}
+	if (type == kJRAttributeTypePosition || type == kJRAttributeTypeOffset) {
+		return kJRFilterSlotTypeVector;
+	}
+	if (type == kJRAttributeTypeColor) {
+		return kJRFilterSlotTypeColor;
+	}
+	if (type == kJRAttributeTypeTransform) {
+		return kJRFilterSlotTypeTransform;
+	}
+	if (type == kJRAttributeTypeRectangle) {
+		return kJRFilterSlotTypeRect;
+	}
+	if (type == kJRAttributeTypeImage) {
+		return kJRFilterSlotTypeImage;
+	}
+	return kJRFilterSlotTypeAny;
+}
+
+std::shared_ptr<const JRFilterLayout> JRFilterLayout::layoutWithAttributes(const std::vector<JRFilterAttribute>& attributes)
+{
+	std::shared_ptr<JRFilterLayout> layout = std::make_shared<JRFilterLayout>();
+	layout->_attributes = attributes;
+	layout->_defaults.resize(attributes.size());
+	for (size_t i = 0; i < attributes.size(); i++) {
+		JRFilterKey key = JRFilterKeyForName(attributes[i].name);
+		if (key >= layout->_slots.size()) {
+			layout->_slots.resize(size_t(key) + 1, -1);
+		}
+		layout->_slots[key] = int(i);
+		layout->_types.push_back(JRSlotTypeForAttributeType(attributes[i].type));
+		/// 默认值也按槽位的类型存放; 类型不对的默认值原样保留
+		if (!layout->validate(int(i), attributes[i].defaultValue, &layout->_defaults[i])) {
+			layout->_defaults[i] = attributes[i].defaultValue;
+		}
+	}
+	return layout;
+}
+
+bool JRFilterLayout::validate(int slot, const JRValue& value, JRValue* out) const
+{
+	if (std::holds_alternative<std::monostate>(value)) {
+		*out = value;
+		return true;
+	}
+	switch (_types[size_t(slot)]) {
+		case kJRFilterSlotTypeAny:
+			*out = value;
+			return true;
+		case kJRFilterSlotTypeDouble: {
+			double d;
+			if (!JRValueGetDouble(value, &d)) {
+				return false;
+			}
+			const JRFilterAttribute& attribute = _attributes[size_t(slot)];
+			/// 只按硬边界截断; 滑块范围之外的值原样保留
+			d = d < attribute.minimum ? attribute.minimum : d > attribute.maximum ? attribute.maximum : d;
+			*out = d;
+			return true;
+		}
+		case kJRFilterSlotTypeVector: {
+			JRVector v;
+			if (!JRValueGetVector(value, &v)) {
+				return false;
+			}
+			*out = v;
+			return true;
+		}
+		case kJRFilterSlotTypeColor: {
+			JRColor c;
+			if (!JRValueGetColor(value, &c)) {
+				return false;
+			}
+			*out = c;
+			return true;
+		}
+		case kJRFilterSlotTypeTransform: {
+			JRAffineTransform t;
+			if (!JRValueGetTransform(value, &t)) {
+				return false;
+			}
+			*out = t;
+			return true;
+		}
+		case kJRFilterSlotTypeRect: {
+			JRRect r;
+			if (!JRValueGetRect(value, &r)) {
+				return false;
+			}
+			*out = r;
+			return true;
+		}
+		case kJRFilterSlotTypeImage:
+			if (!std::holds_alternative<JRImageRef>(value)) {
+				return false;
+			}
+			*out = value;
+			return true;
+	}
+	return false;
+}
+
+// MARK: - Registry
+
+/// 全局滤镜注册表. 滤镜按 ID 存放, 名字和类别各有一个索引
+class JRFilterRegistry {
+public:
+	static JRFilterRegistry& shared()
+	{
+		static JRFilterRegistry* registry = new JRFilterRegistry();
+		return *registry;
+	}
+
+	void registerName(const std::string& name, const JRFilterConstructor& constructor, const JRFilterClassAttributes& classAttributes)
+	{
+		std::unique_lock<std::shared_mutex> lock(_mutex);
+		registerLocked(name, constructor, classAttributes);
+	}
+
+	JRFilterID filterID(const std::string& name)
+	{
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		auto found = _ids.find(name);
+		return found == _ids.end() ? kJRFilterIDNotFound : found->second;
+	}
+
+	JRFilterRef makeFilter(const std::string& name)
+	{
+		std::shared_ptr<const Entry> entry;
+		{
+			std::shared_lock<std::shared_mutex> lock(_mutex);
+			auto found = _ids.find(name);
+			if (found == _ids.end()) {
+				return nullptr;
+			}
+			entry = _entries[found->second];
+		}
+		return makeFilter(*entry);
+	}
+
+	JRFilterRef makeFilter(JRFilterID filterID)
+	{
+		std::shared_ptr<const Entry> entry;
+		{
+			std::shared_lock<std::shared_mutex> lock(_mutex);
+			if (filterID >= _entries.size()) {
+				return nullptr;
+			}
+			entry = _entries[filterID];
+		}
+		return makeFilter(*entry);
+	}
+
+	std::vector<std::string> namesInCategories(const std::vector<std::string>& categories)
+	{
+		std::shared_lock<std::shared_mutex> lock(_mutex);
+		/// 从最短的类别列表开始, 再用每个滤镜排好序的类别检查其余的
+		const std::vector<JRFilterID>* candidates = &_sortedIDs;
+		std::vector<const std::string*> required;
+		for (const std::string& category : categories) {
+			if (category.empty()) {
+				continue;
+			}
+			auto found = _categories.find(category);
+			if (found == _categories.end()) {
+				return {};
+			}
+			required.push_back(&category);
+			if (found->second.size() < candidates->size() || candidates == &_sortedIDs) {
+				candidates = &found->second;
+			}
+		}
+		std::vector<std::string> names;
+		names.reserve(candidates->size());
+		for (JRFilterID filterID : *candidates) {
+			const Entry& entry = *_entries[filterID];
+			bool matches = std::all_of(required.begin(), required.end(), [&](const std::string* category) {
+				return std::binary_search(entry.sortedCategories.begin(), entry.sortedCategories.end(), *category);
+			});
+			if (matches) {
+				names.push_back(entry.name);
+			}
+		}
+		return names;
+	}
+
+private:
+	struct Entry {
+		std::string name;
+		JRFilterConstructor constructor;
+		std::shared_ptr<const JRFilterClassAttributes> classAttributes;
+		std::vector<std::string> sortedCategories;
+	};
+
+	JRFilterRegistry()
+	{
+		JRRegisterBuiltinFilters([this](const std::string& name, const JRFilterConstructor& constructor, const JRFilterClassAttributes& classAttributes) {
+			registerLocked(name, constructor, classAttributes);
+		});
+	}
+
+	JRFilterRef makeFilter(const Entry& entry)
+	{
+		JRFilterRef filter = entry.constructor(entry.name);
+		if (filter) {
+			filter->_classAttributes = entry.classAttributes;
+			filter->setDefaults();
+		}
+		return filter;
+	}
+
+	void registerLocked(const std::string& name, const JRFilterConstructor& constructor, const JRFilterClassAttributes& classAttributes)
+	{
+		std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+		entry->name = name;
+		entry->constructor = constructor;
+		entry->classAttributes = std::make_shared<const JRFilterClassAttributes>(classAttributes);
+		entry->sortedCategories = classAttributes.categories;
+		std::sort(entry->sortedCategories.begin(), entry->sortedCategories.end());
+		entry->sortedCategories.erase(std::unique(entry->sortedCategories.begin(), entry->sortedCategories.end()),
+									  entry->sortedCategories.end());
+
+		auto found = _ids.find(name);
+		JRFilterID filterID = found == _ids.end() ? JRFilterID(_entries.size()) : found->second;
+		if (found == _ids.end()) {
+			_ids.emplace(name, filterID);
+			_entries.push_back(entry);
+		} else {
+			_entries[filterID] = entry;
+		}
+
+		/// 注册很少发生, 直接重建类别索引
+		_categories.clear();
+		_sortedIDs.clear();
+		for (JRFilterID i = 0; i < _entries.size(); i++) {
+			_sortedIDs.push_back(i);
+		}
+		std::sort(_sortedIDs.begin(), _sortedIDs.end(), [&](JRFilterID a, JRFilterID b) {
+			return _entries[a]->name < _entries[b]->name;
+		});
+		for (JRFilterID i : _sortedIDs) {
+			for (const std::string& category : _entries[i]->sortedCategories) {
+				_categories[category].push_back(i);
+			}
+		}
+	}
+
+	std::shared_mutex _mutex;
+	std::vector<std::shared_ptr<const Entry>> _entries;
+	std::unordered_map<std::string, JRFilterID> _ids;
+	/// 按名字排序的全部 ID, 以及每个类别中的 ID (同样按名字排序)
+	std::vector<JRFilterID> _sortedIDs;
+	std::unordered_map<std::string, std::vector<JRFilterID>> _categories;
+};
+
+// MARK: - JRFilter
+
+JRFilterRef JRFilter::filterWithName(const std::string& name)
+{
+	return JRFilterRegistry::shared().makeFilter(name);
+}
+
+JRFilterRef JRFilter::filterWithName(const std::string& name, const JRFilterParameters& params)
+{
+	JRFilterRef filter = filterWithName(name);
+	if (filter) {
+		for (const auto& item : params) {
+			filter->setValue(item.second, item.first);
+		}
+	}
+	return filter;
+}
+
+JRFilterID JRFilter::filterIDForName(const std::string& name)
+{
+	return JRFilterRegistry::shared().filterID(name);
+}
+
+JRFilterRef JRFilter::filterWithID(JRFilterID filterID)
+{
+	return JRFilterRegistry::shared().makeFilter(filterID);
+}
+
+std::vector<std::string> JRFilter::filterNamesInCategory(const std::string& category)
+{
+	return JRFilterRegistry::shared().namesInCategories({ category });
+}
+
+std::vector<std::string> JRFilter::filterNamesInCategories(const std::vector<std::string>& categories)
+{
+	return JRFilterRegistry::shared().namesInCategories(categories);
+}
+
+void JRFilter::registerName(const std::string& name, const JRFilterConstructor& constructor, const JRFilterClassAttributes& classAttributes)
+{
+	JRFilterRegistry::shared().registerName(name, constructor, classAttributes);
+}
+
+JRFilter::JRFilter(const std::string& name, const std::vector<JRFilterAttribute>& attributes)
+: JRFilter(name, JRFilterLayout::layoutWithAttributes(attributes))
+{
+}
+
+JRFilter::JRFilter(const std::string& name, const JRFilterLayoutRef& layout)
+: _name(name), _layout(layout), _slots(layout->slotCount())
+{
+}
+
+JRFilter::~JRFilter()
+{
+}
+
+const JRFilterClassAttributes& JRFilter::classAttributes() const
+{
+	static const JRFilterClassAttributes empty;
+	return _classAttributes ? *_classAttributes : empty;
+}
+
+std::vector<std::string> JRFilter::inputKeys() const
+{
+	std::vector<std::string> keys;
+	for (const JRFilterAttribute& attribute : _layout->attributes()) {
+		keys.push_back(attribute.name);
+	}
+	return keys;
+}
+
+std::vector<std::string> JRFilter::outputKeys() const
+{
+	return { kJROutputImageKey };
+}
+
+void JRFilter::setDefaults()
+{
+	const std::vector<JRValue>& defaults = _layout->defaults();
+	for (size_t i = 0; i < defaults.size(); i++) {
+		if (!std::holds_alternative<std::monostate>(defaults[i])) {
+			_slots[i] = defaults[i];
+		}
+	}
+}
+
+bool JRFilter::setValue(const JRValue& value, const std::string& key)
+{
+	return setValue(value, JRFilterKeyForName(key));
+}
+
+bool JRFilter::setValue(const JRValue& value, JRFilterKey key)
+{
+	int slot = _layout->slotForKey(key);
+	if (slot >= 0) {
+		return _layout->validate(slot, value, &_slots[size_t(slot)]);
+	}
+	for (auto& extra : _extras) {
+		if (extra.first == key) {
+			extra.second = value;
+			return true;
+		}
+	}
+	_extras.emplace_back(key, value);
+	return true;
+}
+
+JRValue JRFilter::valueForKey(const std::string& key) const
+{
+	return valueForKey(JRFilterKeyForName(key));
+}
+
+JRValue JRFilter::valueForKey(JRFilterKey key) const
+{
+	const JRValue* value = slotForKey(key);
+	if (value) {
+		return *value;
+	}
+	for (const auto& extra : _extras) {
+		if (extra.first == key) {
+			return extra.second;
+		}
+	}
+	return JRValue();
+}
+
+const JRValue* JRFilter::slotForKey(JRFilterKey key) const
+{
+	int slot = _layout->slotForKey(key);
+	return slot >= 0 ? &_slots[size_t(slot)] : nullptr;
+}
+
+double JRFilter::doubleForKey(const std::string& key) const
+{
+	return doubleForKey(JRFilterKeyForName(key));
+}
+
+JRVector JRFilter::vectorForKey(const std::string& key) const
+{
+	return vectorForKey(JRFilterKeyForName(key));
+}
+
+JRImageRef JRFilter::imageForKey(const std::string& key) const
+{
+	return imageForKey(JRFilterKeyForName(key));
+}
+
+double JRFilter::doubleForKey(JRFilterKey key) const
+{
+	/// 声明过的标量已经是 double, 不必再转换
+	const JRValue* slot = slotForKey(key);
+	if (slot) {
+		if (const double* d = std::get_if<double>(slot)) {
+			return *d;
+		}
+	}
+	double value = 0;
+	JRValueGetDouble(slot ? *slot : valueForKey(key), &value);
+	return value;
+}
+
+JRVector JRFilter::vectorForKey(JRFilterKey key) const
+{
+	JRVector value = { 0, 0, 0, 0, 0 };
+	const JRValue* slot = slotForKey(key);
+	JRValueGetVector(slot ? *slot : valueForKey(key), &value);
+	return value;
+}
+
+JRImageRef JRFilter::imageForKey(JRFilterKey key) const
+{
+	const JRValue* slot = slotForKey(key);
+	return JRValueGetImage(slot ? *slot : valueForKey(key));
+}
+
+JRFilterAttribute JRFilterScalarAttribute(const std::string& name, double defaultValue, double sliderMinimum, double sliderMaximum, double identity)
+{
+	return JRFilterScalarAttribute(name, defaultValue, -INFINITY, INFINITY, sliderMinimum, sliderMaximum, identity);
+}
+
+JRFilterAttribute JRFilterScalarAttribute(const std::string& name, double defaultValue, double minimum, double maximum,
+										  double sliderMinimum, double sliderMaximum, double identity)
+{
+	return { name, kJRAttributeTypeScalar, defaultValue, identity, minimum, maximum, sliderMinimum, sliderMaximum };
+}
+
+JRFilterAttribute JRFilterAttributeWithType(const std::string& name, const std::string& type, const JRValue& defaultValue)
+{
+	return { name, type, defaultValue, JRValue(), -INFINITY, INFINITY, 0, 0 };
+}
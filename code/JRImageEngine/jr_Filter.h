@@ -0,0 +1,280 @@
+//
+//  jr_Filter.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Filter_h
+#define jr_Filter_h
+
+#include "jr_Value.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* Filter attribute types, same strings as Core Image. */
+inline constexpr char kJRAttributeTypeTime[]			= "CIAttributeTypeTime";
+inline constexpr char kJRAttributeTypeScalar[]			= "CIAttributeTypeScalar";
+inline constexpr char kJRAttributeTypeDistance[]		= "CIAttributeTypeDistance";
+inline constexpr char kJRAttributeTypeAngle[]			= "CIAttributeTypeAngle";
+inline constexpr char kJRAttributeTypeBoolean[]			= "CIAttributeTypeBoolean";
+inline constexpr char kJRAttributeTypeInteger[]			= "CIAttributeTypeInteger";
+inline constexpr char kJRAttributeTypeCount[]			= "CIAttributeTypeCount";
+inline constexpr char kJRAttributeTypePosition[]		= "CIAttributeTypePosition";
+inline constexpr char kJRAttributeTypeOffset[]			= "CIAttributeTypeOffset";
+inline constexpr char kJRAttributeTypeRectangle[]		= "CIAttributeTypeRectangle";
+inline constexpr char kJRAttributeTypeColor[]			= "CIAttributeTypeColor";
+inline constexpr char kJRAttributeTypeImage[]			= "CIAttributeTypeImage";
+inline constexpr char kJRAttributeTypeTransform[]		= "CIAttributeTypeTransform";
+
+/* Categories */
+inline constexpr char kJRCategoryDistortionEffect[]		= "CICategoryDistortionEffect";
+inline constexpr char kJRCategoryGeometryAdjustment[]	= "CICategoryGeometryAdjustment";
+inline constexpr char kJRCategoryCompositeOperation[]	= "CICategoryCompositeOperation";
+inline constexpr char kJRCategoryColorAdjustment[]		= "CICategoryColorAdjustment";
+inline constexpr char kJRCategoryColorEffect[]			= "CICategoryColorEffect";
+inline constexpr char kJRCategoryGenerator[]			= "CICategoryGenerator";
+inline constexpr char kJRCategoryReduction[]			= "CICategoryReduction";
+inline constexpr char kJRCategoryStylize[]				= "CICategoryStylize";
+inline constexpr char kJRCategorySharpen[]				= "CICategorySharpen";
+inline constexpr char kJRCategoryBlur[]					= "CICategoryBlur";
+inline constexpr char kJRCategoryVideo[]				= "CICategoryVideo";
+inline constexpr char kJRCategoryStillImage[]			= "CICategoryStillImage";
+inline constexpr char kJRCategoryBuiltIn[]				= "CICategoryBuiltIn";
+
+/* Keys */
+inline constexpr char kJROutputImageKey[]				= "outputImage";
+inline constexpr char kJRInputBackgroundImageKey[]		= "inputBackgroundImage";
+inline constexpr char kJRInputImageKey[]				= "inputImage";
+inline constexpr char kJRInputTimeKey[]					= "inputTime";
+inline constexpr char kJRInputTransformKey[]			= "inputTransform";
+inline constexpr char kJRInputScaleKey[]				= "inputScale";
+inline constexpr char kJRInputCenterKey[]				= "inputCenter";
+inline constexpr char kJRInputRadiusKey[]				= "inputRadius";
+inline constexpr char kJRInputAngleKey[]				= "inputAngle";
+inline constexpr char kJRInputWidthKey[]				= "inputWidth";
+inline constexpr char kJRInputSharpnessKey[]			= "inputSharpness";
+inline constexpr char kJRInputIntensityKey[]			= "inputIntensity";
+inline constexpr char kJRInputEVKey[]					= "inputEV";
+inline constexpr char kJRInputSaturationKey[]			= "inputSaturation";
+inline constexpr char kJRInputColorKey[]				= "inputColor";
+inline constexpr char kJRInputBrightnessKey[]			= "inputBrightness";
+inline constexpr char kJRInputContrastKey[]				= "inputContrast";
+inline constexpr char kJRInputMaskImageKey[]			= "inputMaskImage";
+inline constexpr char kJRInputTargetImageKey[]			= "inputTargetImage";
+inline constexpr char kJRInputExtentKey[]				= "inputExtent";
+
+/* An input key interned to a small integer. Each name gets its ID the first
+ * time it is seen, and keeps it for the life of the process, so a caller
+ * that binds the same keys over and over can look each one up once.
+ * Filters store their inputs in slots indexed through these IDs rather than
+ * in a dictionary. */
+typedef uint32_t JRFilterKey;
+
+/* The IDs of the keys above, in the same order. JRFilterKeyForName returns
+ * these for those names. */
+enum : JRFilterKey {
+	kJROutputImageKeyID = 0,
+	kJRInputBackgroundImageKeyID,
+	kJRInputImageKeyID,
+	kJRInputTimeKeyID,
+	kJRInputTransformKeyID,
+	kJRInputScaleKeyID,
+	kJRInputCenterKeyID,
+	kJRInputRadiusKeyID,
+	kJRInputAngleKeyID,
+	kJRInputWidthKeyID,
+	kJRInputSharpnessKeyID,
+	kJRInputIntensityKeyID,
+	kJRInputEVKeyID,
+	kJRInputSaturationKeyID,
+	kJRInputColorKeyID,
+	kJRInputBrightnessKeyID,
+	kJRInputContrastKeyID,
+	kJRInputMaskImageKeyID,
+	kJRInputTargetImageKeyID,
+	kJRInputExtentKeyID,
+	kJRPredefinedKeyCount
+};
+
+/* Interns 'name'. Thread-safe. */
+JRFilterKey JRFilterKeyForName(const std::string& name);
+/* The name 'key' was interned from, or an empty string. */
+const std::string& JRFilterKeyName(JRFilterKey key);
+
+/* Describes one input of a filter, the typed form of the per-key dictionaries
+ * in CIFilter.attributes. */
+struct JRFilterAttribute {
+	std::string name;
+	std::string type;
+	JRValue defaultValue;
+	JRValue identity;
+	/* Hard bounds, like kCIAttributeMin and kCIAttributeMax: setValue
+	 * clamps numbers to them. -INFINITY and INFINITY where Core Image has
+	 * none. */
+	double minimum;
+	double maximum;
+	/* The range a user interface offers, which values may exceed. */
+	double sliderMinimum;
+	double sliderMaximum;
+};
+
+struct JRFilterClassAttributes {
+	std::string displayName;
+	std::vector<std::string> categories;
+};
+
+/* What a filter input slot holds, decided by the attribute type. */
+enum JRFilterSlotType {
+	/* Any JRValue, for inputs without a recognised type. */
+	kJRFilterSlotTypeAny = 0,
+	/* Scalar, distance, angle, time, boolean, integer and count. */
+	kJRFilterSlotTypeDouble,
+	/* Position and offset. */
+	kJRFilterSlotTypeVector,
+	kJRFilterSlotTypeColor,
+	kJRFilterSlotTypeTransform,
+	kJRFilterSlotTypeRect,
+	kJRFilterSlotTypeImage,
+};
+
+/* The inputs of one filter class, resolved once and shared by every instance:
+ * the attributes, the slot of each interned key, the type of each slot and
+ * the default values. A filter built from a layout stores its inputs in a
+ * fixed array of slots, in attribute order. */
+class JRFilterLayout {
+public:
+	static std::shared_ptr<const JRFilterLayout> layoutWithAttributes(const std::vector<JRFilterAttribute>& attributes);
+
+	const std::vector<JRFilterAttribute>& attributes() const { return _attributes; }
+	size_t slotCount() const { return _attributes.size(); }
+	/* The slot of 'key', or -1 if the filter has no such input. */
+	int slotForKey(JRFilterKey key) const { return key < _slots.size() ? _slots[key] : -1; }
+	JRFilterSlotType typeAtSlot(int slot) const { return _types[size_t(slot)]; }
+	/* The value of every slot after setDefaults(). */
+	const std::vector<JRValue>& defaults() const { return _defaults; }
+
+	/* Converts 'value' to what 'slot' holds, clamping numbers to the
+	 * attribute's hard minimum and maximum, never to the slider range. An
+	 * empty value is accepted by every slot. Returns false if 'value' has
+	 * the wrong type. */
+	bool validate(int slot, const JRValue& value, JRValue* out) const;
+
+private:
+	std::vector<JRFilterAttribute> _attributes;
+	/// 以键 ID 为下标的槽位, -1 表示没有
+	std::vector<int> _slots;
+	std::vector<JRFilterSlotType> _types;
+	std::vector<JRValue> _defaults;
+};
+
+typedef std::shared_ptr<const JRFilterLayout> JRFilterLayoutRef;
+
+class JRFilter;
+typedef std::shared_ptr<JRFilter> JRFilterRef;
+typedef std::function<JRFilterRef(const std::string& name)> JRFilterConstructor;
+
+/* A registered filter name interned to a small integer, stable for the life
+ * of the process. Registering a name again keeps its ID. */
+typedef uint32_t JRFilterID;
+inline constexpr JRFilterID kJRFilterIDNotFound = JRFilterID(-1);
+
+/* A mutable set of input values that produces an output image, the
+ * counterpart of CIFilter.
+ *
+ * Names and keys can be given as strings, as in Core Image, or as interned
+ * IDs. Code that builds many filters, such as a server assembling a graph
+ * per request, should look up the filter ID and the keys once and then use
+ * filterWithID and setValue(value, JRFilterKey). Those avoid hashing
+ * strings, and a set value is stored straight into its typed slot. */
+class JRFilter {
+public:
+	/* Returns nil if the filter is not known. */
+	static JRFilterRef filterWithName(const std::string& name);
+	static JRFilterRef filterWithName(const std::string& name, const JRFilterParameters& params);
+
+	/* The ID of a registered filter, or kJRFilterIDNotFound. */
+	static JRFilterID filterIDForName(const std::string& name);
+	/* Returns nil if no filter has the ID. */
+	static JRFilterRef filterWithID(JRFilterID filterID);
+
+	/* Names are sorted. Lookups use an index from category to filters, kept
+	 * up to date by registerName. An empty category returns every
+	 * registered filter. */
+	static std::vector<std::string> filterNamesInCategory(const std::string& category);
+	static std::vector<std::string> filterNamesInCategories(const std::vector<std::string>& categories);
+
+	/* Publishes a new filter, replacing any filter with the same name. */
+	static void registerName(const std::string& name, const JRFilterConstructor& constructor, const JRFilterClassAttributes& classAttributes);
+
+	virtual ~JRFilter();
+
+	const std::string& name() const { return _name; }
+	std::vector<std::string> inputKeys() const;
+	std::vector<std::string> outputKeys() const;
+	const std::vector<JRFilterAttribute>& inputAttributes() const { return _layout->attributes(); }
+	const JRFilterLayoutRef& layout() const { return _layout; }
+	const JRFilterClassAttributes& classAttributes() const;
+
+	/* Sets all inputs to their default values (where default values are
+	 * defined, other inputs are left as-is). */
+	void setDefaults();
+	/* Stores 'value' for a declared input after JRFilterLayout::validate, or
+	 * as-is for a key the filter does not declare. Returns false, leaving
+	 * the input unchanged, if the value has the wrong type for the input. */
+	bool setValue(const JRValue& value, const std::string& key);
+	bool setValue(const JRValue& value, JRFilterKey key);
+	JRValue valueForKey(const std::string& key) const;
+	JRValue valueForKey(JRFilterKey key) const;
+
+	virtual JRImageRef outputImage() const = 0;
+
+protected:
+	/* Resolves 'attributes' into a layout of its own. Filters built in
+	 * large numbers should share one layout through the other constructor. */
+	JRFilter(const std::string& name, const std::vector<JRFilterAttribute>& attributes);
+	JRFilter(const std::string& name, const JRFilterLayoutRef& layout);
+
+	double doubleForKey(const std::string& key) const;
+	JRVector vectorForKey(const std::string& key) const;
+	JRImageRef imageForKey(const std::string& key) const;
+	double doubleForKey(JRFilterKey key) const;
+	JRVector vectorForKey(JRFilterKey key) const;
+	JRImageRef imageForKey(JRFilterKey key) const;
+	/* The value of a declared input without a key lookup, or nullptr when
+	 * 'key' has no slot. */
+	const JRValue* slotForKey(JRFilterKey key) const;
+
+private:
+	friend class JRFilterRegistry;
+	friend class JRRecipe;
+
+	std::string _name;
+	JRFilterLayoutRef _layout;
+	std::shared_ptr<const JRFilterClassAttributes> _classAttributes;
+	/// 与 layout 的输入一一对应
+	std::vector<JRValue> _slots;
+	/// 没有声明的键, 很少见, 线性查找
+	std::vector<std::pair<JRFilterKey, JRValue>> _extras;
+};
+
+/* Scalar input attribute helpers for filter definitions. The first has a
+ * slider range and no hard bounds; the second also has hard bounds, either of
+ * which may be infinite. */
+JRFilterAttribute JRFilterScalarAttribute(const std::string& name, double defaultValue, double sliderMinimum, double sliderMaximum, double identity);
+JRFilterAttribute JRFilterScalarAttribute(const std::string& name, double defaultValue, double minimum, double maximum,
+										  double sliderMinimum, double sliderMaximum, double identity);
+JRFilterAttribute JRFilterAttributeWithType(const std::string& name, const std::string& type, const JRValue& defaultValue);
+
+typedef std::function<void(const std::string& name, const JRFilterConstructor& constructor, const JRFilterClassAttributes& classAttributes)> JRFilterRegisterFunction;
+
+/* Registers the filters that ship with the engine; called once when the
+ * registry is first used. */
+void JRRegisterBuiltinFilters(const JRFilterRegisterFunction& registerName);
+
+#endif /* jr_Filter_h */
@@ -0,0 +1,220 @@
+//
+//  jr_Format.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Format.h"
+#include "jr_FormatSIMD.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+size_t JRFormatBytesPerPixel(JRFormat format)
+{
+	switch (format) {
+		case kJRFormatRGBA8:
+		case kJRFormatBGRA8:
+			return 4;
+		case kJRFormatRGBAh:
+			return 8;
+		case kJRFormatRGBAf:
+			return 16;
+	}
+	return 0;
+}
+
+const char* JRFormatName(JRFormat format)
+{
+	switch (format) {
+		case kJRFormatRGBA8: return "RGBA8";
+		case kJRFormatBGRA8: return "BGRA8";
+		case kJRFormatRGBAh: return "RGBAh";
+		case kJRFormatRGBAf: return "RGBAf";
+	}
+	return "unknown";
+}
+
+uint16_t JRFloatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, 4);
+	uint32_t sign = (bits >> 16) & 0x8000;
+	int32_t exponent = int32_t((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	if (((bits >> 23) & 0xff) == 0xff) {
+		/// Inf / NaN
+		return uint16_t(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+	}
+	if (exponent >= 31) {
+		return uint16_t(sign | 0x7c00);
+	}
+	if (exponent <= 0) {
+		if (exponent < -10) {
+			return uint16_t(sign);
+		}
+		/// 非规格化数
+		mantissa |= 0x800000;
+		uint32_t shift = uint32_t(14 - exponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t rest = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1))) {
+			half++;
+		}
+		return uint16_t(sign | half);
+	}
+	uint32_t half = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+	uint32_t rest = mantissa & 0x1fff;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+		half++;
+	}
+	return uint16_t(half);
+}
+
+float JRHalfToFloat(uint16_t value)
+{
+	uint32_t sign = uint32_t(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+	uint32_t bits;
+
+	if (exponent == 0) {
+		if (mantissa == 0) {
+			bits = sign;
+		} else {
+			/// 非规格化数
+			exponent = 127 - 15 + 1;
+			while ((mantissa & 0x400) == 0) {
+				mantissa <<= 1;
+				exponent--;
+			}
+			mantissa &= 0x3ff;
+			bits = sign | (exponent << 23) | (mantissa << 13);
+		}
+	} else if (exponent == 31) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	} else {
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	}
+	float result;
+	std::memcpy(&result, &bits, 4);
+	return result;
+}
+
+static inline uint8_t JRFloatToByte(float value)
+{
+	/// NaN 比较结果为假, 得到 0, 与向量的 max/min 相同
+	float v = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+	return uint8_t(v * 255.0f + 0.5f);
+}
+
+void JRFormatUnpackRowScalar(JRFormat format, const void* src, float* dst, size_t count)
+{
+	const float scale = 1.0f / 255.0f;
+	switch (format) {
+		case kJRFormatRGBA8: {
+			const uint8_t* s = static_cast<const uint8_t*>(src);
+			for (size_t i = 0; i < count * 4; i++) {
+				dst[i] = s[i] * scale;
+			}
+			break;
+		}
+		case kJRFormatBGRA8: {
+			const uint8_t* s = static_cast<const uint8_t*>(src);
+			for (size_t i = 0; i < count; i++, s += 4, dst += 4) {
+				dst[0] = s[2] * scale;
+				dst[1] = s[1] * scale;
+				dst[2] = s[0] * scale;
+				dst[3] = s[3] * scale;
+			}
+			break;
+		}
+		case kJRFormatRGBAh: {
+			const uint16_t* s = static_cast<const uint16_t*>(src);
+			for (size_t i = 0; i < count * 4; i++) {
+				dst[i] = JRHalfToFloat(s[i]);
+			}
+			break;
+		}
+		case kJRFormatRGBAf:
+			std::memcpy(dst, src, count * 16);
+			break;
+	}
+}
+
+void JRFormatPackRowScalar(JRFormat format, const float* src, void* dst, size_t count)
+{
+	switch (format) {
+		case kJRFormatRGBA8: {
+			uint8_t* d = static_cast<uint8_t*>(dst);
+			for (size_t i = 0; i < count * 4; i++) {
+				d[i] = JRFloatToByte(src[i]);
+			}
+			break;
+		}
+		case kJRFormatBGRA8: {
+			uint8_t* d = static_cast<uint8_t*>(dst);
+			for (size_t i = 0; i < count; i++, src += 4, d += 4) {
+				d[0] = JRFloatToByte(src[2]);
+				d[1] = JRFloatToByte(src[1]);
+				d[2] = JRFloatToByte(src[0]);
+				d[3] = JRFloatToByte(src[3]);
+			}
+			break;
+		}
+		case kJRFormatRGBAh: {
+			uint16_t* d = static_cast<uint16_t*>(dst);
+			for (size_t i = 0; i < count * 4; i++) {
+				d[i] = JRFloatToHalf(src[i]);
+			}
+			break;
+		}
+		case kJRFormatRGBAf:
+			std::memcpy(dst, src, count * 16);
+			break;
+	}
+}
+
+void JRFormatUnpackRow(JRFormat format, const void* src, float* dst, size_t count)
+{
+	JRFormatActiveKernels().unpack[format](src, dst, count);
+}
+
+void JRFormatPackRow(JRFormat format, const float* src, void* dst, size_t count)
+{
+	JRFormatActiveKernels().pack[format](src, dst, count);
+}
+
+void JRFormatConvert(const void* src, size_t srcRowBytes, JRFormat srcFormat,
+					 void* dst, size_t dstRowBytes, JRFormat dstFormat, int width, int height)
+{
+	/// 中间行缓存, 分段处理以留在 L1/L2 中
+	const size_t kChunk = 1024;
+	const JRFormatKernels& kernels = JRFormatActiveKernels();
+	size_t srcBpp = JRFormatBytesPerPixel(srcFormat);
+	size_t dstBpp = JRFormatBytesPerPixel(dstFormat);
+	alignas(64) float row[kChunk * 4];
+
+	for (int y = 0; y < height; y++) {
+		const uint8_t* s = static_cast<const uint8_t*>(src) + size_t(y) * srcRowBytes;
+		uint8_t* d = static_cast<uint8_t*>(dst) + size_t(y) * dstRowBytes;
+		if (srcFormat == kJRFormatRGBAf) {
+			kernels.pack[dstFormat](reinterpret_cast<const float*>(s), d, size_t(width));
+			continue;
+		}
+		if (dstFormat == kJRFormatRGBAf) {
+			kernels.unpack[srcFormat](s, reinterpret_cast<float*>(d), size_t(width));
+			continue;
+		}
+		for (size_t x = 0; x < size_t(width); x += kChunk) {
+			size_t n = std::min(kChunk, size_t(width) - x);
+			kernels.unpack[srcFormat](s + x * srcBpp, row, n);
+			kernels.pack[dstFormat](row, d + x * dstBpp, n);
+		}
+	}
+}
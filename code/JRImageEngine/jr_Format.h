@@ -0,0 +1,44 @@
+//
+//  jr_Format.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Format_h
+#define jr_Format_h
+
+#include <cstddef>
+#include <cstdint>
+
+/* Pixel formats for bitmap input and output, the counterpart of CIFormat.
+ * All formats carry premultiplied alpha, like kCIFormatRGBA8. */
+enum JRFormat {
+	kJRFormatRGBA8 = 0,
+	kJRFormatBGRA8,
+	kJRFormatRGBAh,
+	kJRFormatRGBAf,
+};
+
+size_t JRFormatBytesPerPixel(JRFormat format);
+const char* JRFormatName(JRFormat format);
+
+/* Converts 'count' pixels of 'format' into the float RGBA working format.
+ * The row kernels use the best instruction set from JRSIMDActiveLevel(). */
+void JRFormatUnpackRow(JRFormat format, const void* src, float* dst, size_t count);
+
+/* Converts 'count' float RGBA pixels into 'format'. Values are clamped to
+ * [0, 1] for the 8-bit formats. */
+void JRFormatPackRow(JRFormat format, const float* src, void* dst, size_t count);
+
+/* Converts a 'width' x 'height' bitmap between formats. Rows may be padded
+ * ('rowBytes' larger than width times the pixel size). Conversions to or from
+ * RGBAf run in a single pass; other pairs go through a cached float row. */
+void JRFormatConvert(const void* src, size_t srcRowBytes, JRFormat srcFormat,
+					 void* dst, size_t dstRowBytes, JRFormat dstFormat, int width, int height);
+
+uint16_t JRFloatToHalf(float value);
+float JRHalfToFloat(uint16_t value);
+
+#endif /* jr_Format_h */
@@ -0,0 +1,435 @@
+//
+//  jr_FormatSIMD.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_FormatSIMD.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(JR_SIMD_X86)
+#include <immintrin.h>
+#define JR_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#define JR_TARGET_AVX512 __attribute__((target("avx2,fma,f16c,avx512f,avx512bw")))
+#elif defined(JR_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/* Every kernel runs the vector loop over whole vectors and finishes the
+ * remaining pixels with the scalar kernel, so any width works. Results match
+ * the scalar kernels bit for bit: the same float operations run in the same
+ * order, and rounding is to nearest even in both paths. */
+
+static const float kJRByteScale = 1.0f / 255.0f;
+
+// MARK: - Scalar
+
+static void JRUnpackRGBA8Scalar(const void* s, float* d, size_t n) { JRFormatUnpackRowScalar(kJRFormatRGBA8, s, d, n); }
+static void JRUnpackBGRA8Scalar(const void* s, float* d, size_t n) { JRFormatUnpackRowScalar(kJRFormatBGRA8, s, d, n); }
+static void JRUnpackRGBAhScalar(const void* s, float* d, size_t n) { JRFormatUnpackRowScalar(kJRFormatRGBAh, s, d, n); }
+static void JRUnpackRGBAfScalar(const void* s, float* d, size_t n) { JRFormatUnpackRowScalar(kJRFormatRGBAf, s, d, n); }
+static void JRPackRGBA8Scalar(const float* s, void* d, size_t n) { JRFormatPackRowScalar(kJRFormatRGBA8, s, d, n); }
+static void JRPackBGRA8Scalar(const float* s, void* d, size_t n) { JRFormatPackRowScalar(kJRFormatBGRA8, s, d, n); }
+static void JRPackRGBAhScalar(const float* s, void* d, size_t n) { JRFormatPackRowScalar(kJRFormatRGBAh, s, d, n); }
+static void JRPackRGBAfScalar(const float* s, void* d, size_t n) { JRFormatPackRowScalar(kJRFormatRGBAf, s, d, n); }
+
+static const JRFormatKernels kJRScalarKernels = {
+	{ JRUnpackRGBA8Scalar, JRUnpackBGRA8Scalar, JRUnpackRGBAhScalar, JRUnpackRGBAfScalar },
+	{ JRPackRGBA8Scalar, JRPackBGRA8Scalar, JRPackRGBAhScalar, JRPackRGBAfScalar },
+	JRPremultiplyScalar,
+	JRUnpremultiplyScalar,
+};
+
+#if defined(JR_SIMD_X86)
+
+// MARK: - AVX2
+
+/// 交换每个像素的 R 和 B
+JR_TARGET_AVX2 static inline __m128i JRSwapRB(__m128i v)
+{
+	const __m128i mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	return _mm_shuffle_epi8(v, mask);
+}
+
+JR_TARGET_AVX2 static inline void JRUnpack8AVX2(__m128i bytes, float* d)
+{
+	const __m256 scale = _mm256_set1_ps(kJRByteScale);
+	__m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+	__m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+	_mm256_storeu_ps(d, _mm256_mul_ps(lo, scale));
+	_mm256_storeu_ps(d + 8, _mm256_mul_ps(hi, scale));
+}
+
+JR_TARGET_AVX2 static void JRUnpackRGBA8AVX2(const void* src, float* d, size_t n)
+{
+	const uint8_t* s = static_cast<const uint8_t*>(src);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		JRUnpack8AVX2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * 4)), d + i * 4);
+	}
+	JRUnpackRGBA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX2 static void JRUnpackBGRA8AVX2(const void* src, float* d, size_t n)
+{
+	const uint8_t* s = static_cast<const uint8_t*>(src);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		JRUnpack8AVX2(JRSwapRB(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * 4))), d + i * 4);
+	}
+	JRUnpackBGRA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX2 static void JRUnpackRGBAhAVX2(const void* src, float* d, size_t n)
+{
+	const uint16_t* s = static_cast<const uint16_t*>(src);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		_mm256_storeu_ps(d + i * 4, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * 4))));
+	}
+	JRUnpackRGBAhScalar(s + i * 4, d + i * 4, n - i);
+}
+
+/// 16 个 float -> 16 个字节, 与标量版本一样: clamp, *255, +0.5, 截断
+JR_TARGET_AVX2 static inline __m128i JRPack16AVX2(const float* s)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 scale = _mm256_set1_ps(255.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	__m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(s), zero), one);
+	__m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(s + 8), zero), one);
+	__m256i ia = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(a, scale), half));
+	__m256i ib = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(b, scale), half));
+	__m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(ia, ib), 0xD8);
+	return _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+}
+
+JR_TARGET_AVX2 static void JRPackRGBA8AVX2(const float* s, void* dst, size_t n)
+{
+	uint8_t* d = static_cast<uint8_t*>(dst);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(d + i * 4), JRPack16AVX2(s + i * 4));
+	}
+	JRPackRGBA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX2 static void JRPackBGRA8AVX2(const float* s, void* dst, size_t n)
+{
+	uint8_t* d = static_cast<uint8_t*>(dst);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(d + i * 4), JRSwapRB(JRPack16AVX2(s + i * 4)));
+	}
+	JRPackBGRA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX2 static void JRPackRGBAhAVX2(const float* s, void* dst, size_t n)
+{
+	uint16_t* d = static_cast<uint16_t*>(dst);
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(s + i * 4), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(d + i * 4), h);
+	}
+	JRPackRGBAhScalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX2 static void JRPremultiplyAVX2(float* p, size_t n)
+{
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m256 v = _mm256_loadu_ps(p + i * 4);
+		__m256 a = _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3));
+		_mm256_storeu_ps(p + i * 4, _mm256_blend_ps(_mm256_mul_ps(v, a), v, 0x88));
+	}
+	JRPremultiplyScalar(p + i * 4, n - i);
+}
+
+JR_TARGET_AVX2 static void JRUnpremultiplyAVX2(float* p, size_t n)
+{
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m256 v = _mm256_loadu_ps(p + i * 4);
+		__m256 a = _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3));
+		__m256 inv = _mm256_and_ps(_mm256_div_ps(one, a), _mm256_cmp_ps(a, zero, _CMP_GT_OQ));
+		_mm256_storeu_ps(p + i * 4, _mm256_blend_ps(_mm256_mul_ps(v, inv), v, 0x88));
+	}
+	JRUnpremultiplyScalar(p + i * 4, n - i);
+}
+
+static const JRFormatKernels kJRAVX2Kernels = {
+	{ JRUnpackRGBA8AVX2, JRUnpackBGRA8AVX2, JRUnpackRGBAhAVX2, JRUnpackRGBAfScalar },
+	{ JRPackRGBA8AVX2, JRPackBGRA8AVX2, JRPackRGBAhAVX2, JRPackRGBAfScalar },
+	JRPremultiplyAVX2,
+	JRUnpremultiplyAVX2,
+};
+
+// MARK: - AVX-512
+
+/* GCC's avx512fintrin.h starts most intrinsics from _mm512_undefined_*(),
+ * which it writes as a self-initialised variable. Inlined here, each one
+ * warns under -Wmaybe-uninitialized, though every lane is written. */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+JR_TARGET_AVX512 static void JRUnpackRGBA8AVX512(const void* src, float* d, size_t n)
+{
+	const uint8_t* s = static_cast<const uint8_t*>(src);
+	const __m512 scale = _mm512_set1_ps(kJRByteScale);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * 4));
+		_mm512_storeu_ps(d + i * 4, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(bytes)), scale));
+	}
+	JRUnpackRGBA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX512 static void JRUnpackBGRA8AVX512(const void* src, float* d, size_t n)
+{
+	const uint8_t* s = static_cast<const uint8_t*>(src);
+	const __m512 scale = _mm512_set1_ps(kJRByteScale);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128i bytes = JRSwapRB(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * 4)));
+		_mm512_storeu_ps(d + i * 4, _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(bytes)), scale));
+	}
+	JRUnpackBGRA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX512 static void JRUnpackRGBAhAVX512(const void* src, float* d, size_t n)
+{
+	const uint16_t* s = static_cast<const uint16_t*>(src);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm512_storeu_ps(d + i * 4, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i * 4))));
+	}
+	JRUnpackRGBAhScalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX512 static inline __m128i JRPack16AVX512(const float* s)
+{
+	__m512 v = _mm512_min_ps(_mm512_max_ps(_mm512_loadu_ps(s), _mm512_setzero_ps()), _mm512_set1_ps(1.0f));
+	v = _mm512_add_ps(_mm512_mul_ps(v, _mm512_set1_ps(255.0f)), _mm512_set1_ps(0.5f));
+	return _mm512_cvtepi32_epi8(_mm512_cvttps_epi32(v));
+}
+
+JR_TARGET_AVX512 static void JRPackRGBA8AVX512(const float* s, void* dst, size_t n)
+{
+	uint8_t* d = static_cast<uint8_t*>(dst);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(d + i * 4), JRPack16AVX512(s + i * 4));
+	}
+	JRPackRGBA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX512 static void JRPackBGRA8AVX512(const float* s, void* dst, size_t n)
+{
+	uint8_t* d = static_cast<uint8_t*>(dst);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(d + i * 4), JRSwapRB(JRPack16AVX512(s + i * 4)));
+	}
+	JRPackBGRA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX512 static void JRPackRGBAhAVX512(const float* s, void* dst, size_t n)
+{
+	uint16_t* d = static_cast<uint16_t*>(dst);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(s + i * 4), _MM_FROUND_TO_NEAREST_INT);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i * 4), h);
+	}
+	JRPackRGBAhScalar(s + i * 4, d + i * 4, n - i);
+}
+
+JR_TARGET_AVX512 static void JRPremultiplyAVX512(float* p, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m512 v = _mm512_loadu_ps(p + i * 4);
+		__m512 a = _mm512_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3));
+		_mm512_storeu_ps(p + i * 4, _mm512_mask_blend_ps(0x8888, _mm512_mul_ps(v, a), v));
+	}
+	JRPremultiplyScalar(p + i * 4, n - i);
+}
+
+JR_TARGET_AVX512 static void JRUnpremultiplyAVX512(float* p, size_t n)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m512 v = _mm512_loadu_ps(p + i * 4);
+		__m512 a = _mm512_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3));
+		__mmask16 positive = _mm512_cmp_ps_mask(a, _mm512_setzero_ps(), _CMP_GT_OQ);
+		__m512 inv = _mm512_maskz_div_ps(positive, _mm512_set1_ps(1.0f), a);
+		_mm512_storeu_ps(p + i * 4, _mm512_mask_blend_ps(0x8888, _mm512_mul_ps(v, inv), v));
+	}
+	JRUnpremultiplyScalar(p + i * 4, n - i);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+static const JRFormatKernels kJRAVX512Kernels = {
+	{ JRUnpackRGBA8AVX512, JRUnpackBGRA8AVX512, JRUnpackRGBAhAVX512, JRUnpackRGBAfScalar },
+	{ JRPackRGBA8AVX512, JRPackBGRA8AVX512, JRPackRGBAhAVX512, JRPackRGBAfScalar },
+	JRPremultiplyAVX512,
+	JRUnpremultiplyAVX512,
+};
+
+#endif /* JR_SIMD_X86 */
+
+#if defined(JR_SIMD_NEON) && defined(__aarch64__)
+
+// MARK: - NEON
+
+static inline void JRUnpack16NEON(uint8x16_t bytes, float* d)
+{
+	const float32x4_t scale = vdupq_n_f32(kJRByteScale);
+	uint16x8_t lo = vmovl_u8(vget_low_u8(bytes));
+	uint16x8_t hi = vmovl_high_u8(bytes);
+	vst1q_f32(d, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), scale));
+	vst1q_f32(d + 4, vmulq_f32(vcvtq_f32_u32(vmovl_high_u16(lo)), scale));
+	vst1q_f32(d + 8, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), scale));
+	vst1q_f32(d + 12, vmulq_f32(vcvtq_f32_u32(vmovl_high_u16(hi)), scale));
+}
+
+static inline uint8x16_t JRSwapRBNEON(uint8x16_t v)
+{
+	static const uint8_t indices[16] = { 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 };
+	return vqtbl1q_u8(v, vld1q_u8(indices));
+}
+
+static void JRUnpackRGBA8NEON(const void* src, float* d, size_t n)
+{
+	const uint8_t* s = static_cast<const uint8_t*>(src);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		JRUnpack16NEON(vld1q_u8(s + i * 4), d + i * 4);
+	}
+	JRUnpackRGBA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+static void JRUnpackBGRA8NEON(const void* src, float* d, size_t n)
+{
+	const uint8_t* s = static_cast<const uint8_t*>(src);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		JRUnpack16NEON(JRSwapRBNEON(vld1q_u8(s + i * 4)), d + i * 4);
+	}
+	JRUnpackBGRA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+static void JRUnpackRGBAhNEON(const void* src, float* d, size_t n)
+{
+	const uint16_t* s = static_cast<const uint16_t*>(src);
+	size_t i = 0;
+	for (; i < n; i++) {
+		vst1q_f32(d + i * 4, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(s + i * 4))));
+	}
+}
+
+static inline uint32x4_t JRPack4NEON(const float* s)
+{
+	float32x4_t v = vminq_f32(vmaxq_f32(vld1q_f32(s), vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+	v = vaddq_f32(vmulq_f32(v, vdupq_n_f32(255.0f)), vdupq_n_f32(0.5f));
+	return vcvtq_u32_f32(v);
+}
+
+static inline uint8x16_t JRPack16NEON(const float* s)
+{
+	uint16x8_t lo = vcombine_u16(vmovn_u32(JRPack4NEON(s)), vmovn_u32(JRPack4NEON(s + 4)));
+	uint16x8_t hi = vcombine_u16(vmovn_u32(JRPack4NEON(s + 8)), vmovn_u32(JRPack4NEON(s + 12)));
+	return vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+}
+
+static void JRPackRGBA8NEON(const float* s, void* dst, size_t n)
+{
+	uint8_t* d = static_cast<uint8_t*>(dst);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		vst1q_u8(d + i * 4, JRPack16NEON(s + i * 4));
+	}
+	JRPackRGBA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+static void JRPackBGRA8NEON(const float* s, void* dst, size_t n)
+{
+	uint8_t* d = static_cast<uint8_t*>(dst);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		vst1q_u8(d + i * 4, JRSwapRBNEON(JRPack16NEON(s + i * 4)));
+	}
+	JRPackBGRA8Scalar(s + i * 4, d + i * 4, n - i);
+}
+
+static void JRPackRGBAhNEON(const float* s, void* dst, size_t n)
+{
+	uint16_t* d = static_cast<uint16_t*>(dst);
+	for (size_t i = 0; i < n; i++) {
+		vst1_u16(d + i * 4, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(s + i * 4))));
+	}
+}
+
+static void JRPremultiplyNEON(float* p, size_t n)
+{
+	for (size_t i = 0; i < n; i++, p += 4) {
+		float32x4_t v = vld1q_f32(p);
+		float32x4_t r = vmulq_f32(v, vdupq_laneq_f32(v, 3));
+		vst1q_f32(p, vsetq_lane_f32(vgetq_lane_f32(v, 3), r, 3));
+	}
+}
+
+static void JRUnpremultiplyNEON(float* p, size_t n)
+{
+	for (size_t i = 0; i < n; i++, p += 4) {
+		float32x4_t v = vld1q_f32(p);
+		float a = vgetq_lane_f32(v, 3);
+		float inv = a > 0 ? 1.0f / a : 0.0f;
+		vst1q_f32(p, vsetq_lane_f32(a, vmulq_n_f32(v, inv), 3));
+	}
+}
+
+static const JRFormatKernels kJRNEONKernels = {
+	{ JRUnpackRGBA8NEON, JRUnpackBGRA8NEON, JRUnpackRGBAhNEON, JRUnpackRGBAfScalar },
+	{ JRPackRGBA8NEON, JRPackBGRA8NEON, JRPackRGBAhNEON, JRPackRGBAfScalar },
+	JRPremultiplyNEON,
+	JRUnpremultiplyNEON,
+};
+
+#endif /* JR_SIMD_NEON */
+
+const JRFormatKernels& JRFormatKernelsForLevel(JRSIMDLevel level)
+{
+	switch (level) {
+#if defined(JR_SIMD_X86)
+		case kJRSIMDLevelAVX512:
+			return kJRAVX512Kernels;
+		case kJRSIMDLevelAVX2:
+			return kJRAVX2Kernels;
+#endif
+#if defined(JR_SIMD_NEON) && defined(__aarch64__)
+		case kJRSIMDLevelNEON:
+			return kJRNEONKernels;
+#endif
+		default:
+			return kJRScalarKernels;
+	}
+}
+
+const JRFormatKernels& JRFormatActiveKernels()
+{
+	return JRFormatKernelsForLevel(JRSIMDActiveLevel());
+}
@@ -0,0 +1,41 @@
+//
+//  jr_FormatSIMD.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_FormatSIMD_h
+#define jr_FormatSIMD_h
+
+#include "jr_Format.h"
+#include "jr_SIMD.h"
+
+#include <cstddef>
+
+typedef void (*JRUnpackRowFunction)(const void* src, float* dst, size_t count);
+typedef void (*JRPackRowFunction)(const float* src, void* dst, size_t count);
+typedef void (*JRPixelSpanFunction)(float* pixels, size_t count);
+
+/* The row kernels of one instruction set, indexed by JRFormat. Internal to
+ * jr_Format.cpp and jr_Kernel.cpp. */
+struct JRFormatKernels {
+	JRUnpackRowFunction unpack[4];
+	JRPackRowFunction pack[4];
+	JRPixelSpanFunction premultiply;
+	JRPixelSpanFunction unpremultiply;
+};
+
+/* The table for JRSIMDActiveLevel(). Entries an instruction set does not
+ * provide fall back to the scalar ones. */
+const JRFormatKernels& JRFormatActiveKernels();
+const JRFormatKernels& JRFormatKernelsForLevel(JRSIMDLevel level);
+
+/* Scalar kernels, defined in jr_Format.cpp and jr_Kernel.cpp. */
+void JRFormatUnpackRowScalar(JRFormat format, const void* src, float* dst, size_t count);
+void JRFormatPackRowScalar(JRFormat format, const float* src, void* dst, size_t count);
+void JRPremultiplyScalar(float* pixels, size_t count);
+void JRUnpremultiplyScalar(float* pixels, size_t count);
+
+#endif /* jr_FormatSIMD_h */
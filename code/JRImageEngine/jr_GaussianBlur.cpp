@@ -0,0 +1,319 @@
+//
+//  jr_GaussianBlur.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_GaussianBlur.h"
+#include "jr_BufferPool.h"
+#include "jr_Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/// 每个任务处理的行数 (列数), 同时也是转置的分块大小
+static const size_t kJRBlurBlock = 16;
+
+/// 一次模糊的参数, 由 sigma 决定
+struct JRBlurPlan {
+	bool box;
+	/// 总的采样半径
+	int radius;
+	/// 精确卷积: weights[k] 对应距离 k
+	std::vector<float> weights;
+	/// 扩展盒滤波: 2r+1 个内部像素权重 inner, 两端各一个像素权重 edge
+	int boxRadius;
+	float inner;
+	float edge;
+};
+
+static JRBlurPlan JRMakeBlurPlan(double sigma)
+{
+	JRBlurPlan plan = { false, 0, { 1.0f }, 0, 1.0f, 0.0f };
+	if (!(sigma > 0)) {
+		return plan;
+	}
+	if (sigma < kJRGaussianBlurBoxSigma) {
+		int r = int(std::ceil(3.0 * sigma));
+		double sum = 0;
+		std::vector<double> w(size_t(r) + 1);
+		for (int k = 0; k <= r; k++) {
+			w[size_t(k)] = std::exp(-double(k) * k / (2.0 * sigma * sigma));
+			sum += k == 0 ? w[0] : 2.0 * w[size_t(k)];
+		}
+		plan.radius = r;
+		plan.weights.resize(w.size());
+		for (size_t k = 0; k < w.size(); k++) {
+			plan.weights[k] = float(w[k] / sum);
+		}
+		return plan;
+	}
+
+	/// 三次扩展盒滤波 (Gwosdek et al.): 每次的方差为 sigma^2 / 3, 两端像素取小数权重补足
+	double v = sigma * sigma / 3.0;
+	int r = int(std::floor(0.5 * std::sqrt(12.0 * v + 1.0) - 0.5));
+	double a = (2 * r + 1) * (r * (r + 1) - 3.0 * v) / (6.0 * (v - (r + 1.0) * (r + 1.0)));
+	plan.box = true;
+	plan.boxRadius = r;
+	plan.radius = 3 * (r + 1);
+	plan.inner = float(1.0 / (2.0 * a + 2 * r + 1));
+	plan.edge = float(a / (2.0 * a + 2 * r + 1));
+	return plan;
+}
+
+/// 精确卷积: src 有 count + 2r 个像素, 每个像素 C 个通道
+template <int C>
+static void JRBlurLineExact(const std::vector<float>& weights, const float* src, float* dst, size_t count)
+{
+	const int r = int(weights.size()) - 1;
+	const float* w = weights.data();
+	for (size_t i = 0; i < count; i++, dst += C) {
+		const float* c = src + (i + size_t(r)) * C;
+		float s[C];
+		for (int j = 0; j < C; j++) {
+			s[j] = c[j] * w[0];
+		}
+		for (int k = 1; k <= r; k++) {
+			const float* lo = c - k * C;
+			const float* hi = c + k * C;
+			for (int j = 0; j < C; j++) {
+				s[j] += (lo[j] + hi[j]) * w[k];
+			}
+		}
+		for (int j = 0; j < C; j++) {
+			dst[j] = s[j];
+		}
+	}
+}
+
+/// 一次扩展盒滤波: src 有 count + 2(r + 1) 个像素. 滑动求和, 与半径无关
+template <int C>
+static void JRBlurLineBox(int r, float inner, float edge, const float* src, float* dst, size_t count)
+{
+	float s[C] = {};
+	for (int k = 1; k <= 2 * r + 1; k++) {
+		const float* p = src + k * C;
+		for (int j = 0; j < C; j++) {
+			s[j] += p[j];
+		}
+	}
+	const float* far = src + size_t(2 * r + 2) * C;
+	for (size_t i = 0; i < count; i++, src += C, far += C, dst += C) {
+		float d[C];
+		for (int j = 0; j < C; j++) {
+			d[j] = s[j] * inner + (src[j] + far[j]) * edge;
+		}
+		for (int j = 0; j < C; j++) {
+			s[j] += far[j] - src[C + j];
+		}
+		for (int j = 0; j < C; j++) {
+			dst[j] = d[j];
+		}
+	}
+}
+
+/// 对一行 (或转置后的一列) 做一维模糊. src 有 count + 2 * radius 个像素, 每个像素 C 个通道
+template <int C>
+static void JRBlurLine(const JRBlurPlan& plan, const float* src, float* dst, size_t count, float* temp)
+{
+	if (!plan.box) {
+		JRBlurLineExact<C>(plan.weights, src, dst, count);
+		return;
+	}
+	size_t step = size_t(plan.boxRadius + 1);
+	float* a = temp;
+	float* b = temp + (count + 2 * size_t(plan.radius)) * C;
+	JRBlurLineBox<C>(plan.boxRadius, plan.inner, plan.edge, src, a, count + 4 * step);
+	JRBlurLineBox<C>(plan.boxRadius, plan.inner, plan.edge, a, b, count + 2 * step);
+	JRBlurLineBox<C>(plan.boxRadius, plan.inner, plan.edge, b, dst, count);
+}
+
+/// 转置 rows x cols 个像素, 按 16 x 16 分块以留在 L1 中
+static void JRTransposePixels(const float* src, size_t srcRowFloats, float* dst, size_t dstRowFloats, size_t rows, size_t cols)
+{
+	for (size_t x0 = 0; x0 < cols; x0 += kJRBlurBlock) {
+		size_t x1 = std::min(x0 + kJRBlurBlock, cols);
+		for (size_t y = 0; y < rows; y++) {
+			const float* s = src + y * srcRowFloats + x0 * 4;
+			for (size_t x = x0; x < x1; x++, s += 4) {
+				std::memcpy(dst + x * dstRowFloats + y * 4, s, 4 * sizeof(float));
+			}
+		}
+	}
+}
+
+JRGaussianBlurKernel::JRGaussianBlurKernel()
+: JRGeneralKernel("CIGaussianBlur")
+{
+}
+
+std::shared_ptr<const JRGaussianBlurKernel> JRGaussianBlurKernel::kernel()
+{
+	static std::shared_ptr<const JRGaussianBlurKernel> kernel = std::make_shared<JRGaussianBlurKernel>();
+	return kernel;
+}
+
+int JRGaussianBlurKernel::radius(double sigma)
+{
+	return JRMakeBlurPlan(sigma).radius;
+}
+
+JRRect JRGaussianBlurKernel::extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments& args) const
+{
+	if (inputExtents.empty()) {
+		return JRRectNull;
+	}
+	int r = radius(args.empty() ? 0 : args[0]);
+	return JRRectInset(inputExtents[0], -r, -r);
+}
+
+JRRect JRGaussianBlurKernel::regionOfInterest(size_t, const JRRect& rect, const JRKernelArguments& args) const
+{
+	int r = radius(args.empty() ? 0 : args[0]);
+	return JRRectInset(rect, -r, -r);
+}
+
+bool JRGaussianBlurKernel::transformArguments(const JRAffineTransform& t, const JRKernelArguments& args, JRKernelArguments* transformed) const
+{
+	/// 各向同性, 只有均匀缩放能移到模糊之前
+	double scale = JRAffineTransformUniformScale(t);
+	if (scale <= 0 || args.empty()) {
+		return false;
+	}
+	*transformed = { float(args[0] * scale) };
+	return true;
+}
+
+void JRGaussianBlurKernel::apply(const std::vector<JRBuffer>& inputs, const JRBuffer& output, const JRKernelArguments& args) const
+{
+	const JRBlurPlan plan = JRMakeBlurPlan(args.empty() ? 0 : args[0]);
+	const JRBuffer& input = inputs[0];
+	const JRIRect& out = output.rect();
+	const int r = plan.radius;
+	const JRIRect span = { out.x - r, out.y - r, out.width + 2 * r, out.height + 2 * r };
+	const size_t width = size_t(out.width);
+	const size_t height = size_t(out.height);
+
+	/// 行方向的结果转置存放: 第 x 行是输出的第 x 列, 列方向也就能连续读取
+	JRBuffer columns = JRBuffer::bufferWithRect({ span.y, out.x, span.height, out.width });
+
+	JRParallelFor(size_t(span.height), kJRBlurBlock, [&](size_t begin, size_t end) {
+		/// 临时行也来自 JRBufferPool, 稳定后不再分配内存
+		JRBuffer rows = JRBuffer::bufferWithRect({ 0, 0, out.width, int(end - begin) });
+		JRBuffer temp = JRBuffer::bufferWithRect({ 0, 0, 2 * span.width, 1 });
+		for (size_t j = begin; j < end; j++) {
+			JRBlurLine<4>(plan, input.pixelAt(span.x, span.y + int(j)), rows.rowAt(int(j - begin)), width, temp.data());
+		}
+		JRTransposePixels(rows.data(), rows.rowFloats(), columns.pixelAt(span.y + int(begin), out.x), columns.rowFloats(),
+						  end - begin, width);
+	});
+
+	JRParallelFor(width, kJRBlurBlock, [&](size_t begin, size_t end) {
+		JRBuffer lines = JRBuffer::bufferWithRect({ 0, 0, out.height, int(end - begin) });
+		JRBuffer temp = JRBuffer::bufferWithRect({ 0, 0, 2 * span.height, 1 });
+		for (size_t x = begin; x < end; x++) {
+			JRBlurLine<4>(plan, columns.rowAt(out.x + int(x)), lines.rowAt(int(x - begin)), height, temp.data());
+		}
+		JRTransposePixels(lines.data(), lines.rowFloats(), output.pixelAt(out.x + int(begin), out.y), output.rowFloats(),
+						  end - begin, height);
+	});
+}
+
+// MARK: - Planes
+
+/// 平面按 16 个 float 一组模糊: 组内的值互不相关, 当作一个 16 通道的像素, 滑动求和也就能向量化
+static const int kJRPlaneGroup = 16;
+
+template <int C>
+static void JRBlurPlane(const JRBlurPlan& plan, const uint8_t* src, size_t srcRowBytes, uint8_t* dst, size_t dstRowBytes,
+						size_t width, size_t height)
+{
+	const int G = kJRPlaneGroup;
+	const int r = plan.radius;
+	const size_t rowFloats = width * C;
+	const std::shared_ptr<JRBufferPool> pool = JRBufferPool::sharedPool();
+	std::shared_ptr<float> rows = pool->allocate(rowFloats * height * sizeof(float));
+
+	/// 行方向: 每组 16 / C 行, 同一列上这些行的 C 个通道交错成一个像素. 边缘重复
+	const size_t rowGroup = size_t(G / C);
+	JRParallelFor((height + rowGroup - 1) / rowGroup, 1, [&](size_t begin, size_t end) {
+		size_t padded = width + 2 * size_t(r);
+		std::shared_ptr<float> scratch = pool->allocate((3 * padded + width) * G * sizeof(float));
+		float* line = scratch.get();
+		float* temp = line + padded * G;
+		float* out = temp + 2 * padded * G;
+		for (size_t group = begin; group < end; group++) {
+			size_t y0 = group * rowGroup;
+			for (int i = -r; i < int(width) + r; i++) {
+				size_t x = size_t(std::min(std::max(i, 0), int(width) - 1)) * C;
+				float* p = line + size_t(i + r) * G;
+				for (size_t k = 0; k < rowGroup; k++) {
+					const uint8_t* v = src + std::min(y0 + k, height - 1) * srcRowBytes + x;
+					for (int j = 0; j < C; j++) {
+						*p++ = float(v[j]);
+					}
+				}
+			}
+			JRBlurLine<G>(plan, line, out, width, temp);
+			for (size_t k = 0; k < rowGroup && y0 + k < height; k++) {
+				float* d = rows.get() + (y0 + k) * rowFloats;
+				for (size_t x = 0; x < width; x++) {
+					for (int j = 0; j < C; j++) {
+						*d++ = out[x * G + k * C + size_t(j)];
+					}
+				}
+			}
+		}
+	});
+
+	/// 列方向: 每组是一行中连续的 16 个 float, 不用转置
+	JRParallelFor((rowFloats + G - 1) / G, 1, [&](size_t begin, size_t end) {
+		size_t padded = height + 2 * size_t(r);
+		std::shared_ptr<float> scratch = pool->allocate((3 * padded + height) * G * sizeof(float));
+		float* line = scratch.get();
+		float* temp = line + padded * G;
+		float* out = temp + 2 * padded * G;
+		for (size_t group = begin; group < end; group++) {
+			size_t x0 = group * G;
+			size_t n = std::min(size_t(G), rowFloats - x0);
+			for (int i = -r; i < int(height) + r; i++) {
+				float* p = line + size_t(i + r) * G;
+				std::memcpy(p, rows.get() + size_t(std::min(std::max(i, 0), int(height) - 1)) * rowFloats + x0, n * sizeof(float));
+				std::fill(p + n, p + G, 0.0f);
+			}
+			JRBlurLine<G>(plan, line, out, height, temp);
+			/// 四舍五入到 8 位
+			for (size_t y = 0; y < height; y++) {
+				uint8_t* d = dst + y * dstRowBytes + x0;
+				const float* v = out + y * G;
+				for (size_t k = 0; k < n; k++) {
+					float value = v[k] + 0.5f;
+					d[k] = uint8_t(value <= 0 ? 0 : value >= 255 ? 255 : value);
+				}
+			}
+		}
+	});
+}
+
+bool JRGaussianBlurPlane(const uint8_t* src, size_t srcRowBytes, uint8_t* dst, size_t dstRowBytes,
+						 int width, int height, int channels, double sigma)
+{
+	if (width <= 0 || height <= 0) {
+		return true;
+	}
+	const JRBlurPlan plan = JRMakeBlurPlan(sigma);
+	switch (channels) {
+		case 1:
+			JRBlurPlane<1>(plan, src, srcRowBytes, dst, dstRowBytes, size_t(width), size_t(height));
+			return true;
+		case 2:
+			JRBlurPlane<2>(plan, src, srcRowBytes, dst, dstRowBytes, size_t(width), size_t(height));
+			return true;
+		default:
+			return false;
+	}
+}
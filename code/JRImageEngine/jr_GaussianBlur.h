@@ -0,0 +1,56 @@
+//
+//  jr_GaussianBlur.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_GaussianBlur_h
+#define jr_GaussianBlur_h
+
+#include "jr_Kernel.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/* Below this sigma the blur is an exact separable convolution with a kernel
+ * of radius ceil(3 * sigma), whose cost grows with sigma.
+ *
+ * From this sigma up it is three extended box filters per axis. Each pass
+ * costs the same per pixel whatever the sigma. The effective sigma is exact,
+ * but the shape of the kernel is not. Over any input in [0, 1], the result
+ * differs from the exact Gaussian by at most 0.04. That is half the 2D L1
+ * distance between the kernels, measured at 0.034-0.039 for sigma 3-100.
+ * On smooth content the error is far smaller. */
+inline constexpr double kJRGaussianBlurBoxSigma = 3.0;
+
+/* The CIGaussianBlur kernel. args = [sigma]. It reads 'radius' pixels beyond
+ * every output pixel and treats pixels outside the input as clear, so the
+ * output extent grows by that radius. The row and column passes are split
+ * across threads with JRParallelFor. */
+class JRGaussianBlurKernel : public JRGeneralKernel {
+public:
+	JRGaussianBlurKernel();
+
+	static std::shared_ptr<const JRGaussianBlurKernel> kernel();
+
+	/* How far the blur reaches for 'sigma', in pixels. */
+	static int radius(double sigma);
+
+	JRRect extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments& args) const override;
+	JRRect regionOfInterest(size_t index, const JRRect& rect, const JRKernelArguments& args) const override;
+	void apply(const std::vector<JRBuffer>& inputs, const JRBuffer& output, const JRKernelArguments& args) const override;
+	/* Scales sigma, for rotations and uniform scales. */
+	bool transformArguments(const JRAffineTransform& t, const JRKernelArguments& args, JRKernelArguments* transformed) const override;
+};
+
+/* Blurs an 8-bit plane of 'channels' (1 or 2) interleaved samples per
+ * pixel, such as the Y or CbCr plane of a video frame, with the same passes
+ * as JRGaussianBlurKernel. Unlike the kernel, pixels outside the plane repeat
+ * the edge, so the plane keeps its size and its edges do not fade. 'src' and
+ * 'dst' may not overlap. Returns false for other channel counts. */
+bool JRGaussianBlurPlane(const uint8_t* src, size_t srcRowBytes, uint8_t* dst, size_t dstRowBytes,
+						 int width, int height, int channels, double sigma);
+
+#endif /* jr_GaussianBlur_h */
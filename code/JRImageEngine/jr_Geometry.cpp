@@ -0,0 +1,289 @@
+//
+//  jr_Geometry.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Geometry.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+/// 像素坐标的安全范围, 无限大的矩形会被截到这里. 宽度最大 2^30, x + width 仍在 int 范围内
+static const double kJRPixelLimit = double(1 << 29);
+
+const JRRect JRRectNull			= { INFINITY, INFINITY, 0, 0 };
+const JRRect JRRectInfinite		= { -DBL_MAX / 2, -DBL_MAX / 2, DBL_MAX, DBL_MAX };
+const JRRect JRRectZero			= { 0, 0, 0, 0 };
+const JRAffineTransform JRAffineTransformIdentity = { 1, 0, 0, 1, 0, 0 };
+
+bool JRRect::isNull() const
+{
+	return std::isinf(x) && x > 0;
+}
+
+bool JRRect::isEmpty() const
+{
+	return isNull() || width <= 0 || height <= 0;
+}
+
+bool JRRect::isInfinite() const
+{
+	return width >= DBL_MAX / 2 || height >= DBL_MAX / 2;
+}
+
+bool JRIRect::contains(const JRIRect& r) const
+{
+	if (r.isEmpty()) {
+		return true;
+	}
+	return r.x >= x && r.y >= y && r.maxX() <= maxX() && r.maxY() <= maxY();
+}
+
+bool JRAffineTransform::isIdentity() const
+{
+	return a == 1 && b == 0 && c == 0 && d == 1 && tx == 0 && ty == 0;
+}
+
+bool JRAffineTransform::isIntegerTranslation() const
+{
+	return a == 1 && b == 0 && c == 0 && d == 1 && tx == std::floor(tx) && ty == std::floor(ty);
+}
+
+JRRect JRRectMake(double x, double y, double width, double height)
+{
+	return { x, y, width, height };
+}
+
+JRRect JRRectIntersection(const JRRect& r1, const JRRect& r2)
+{
+	if (r1.isNull() || r2.isNull()) {
+		return JRRectNull;
+	}
+	double x0 = std::max(r1.minX(), r2.minX());
+	double y0 = std::max(r1.minY(), r2.minY());
+	double x1 = std::min(r1.maxX(), r2.maxX());
+	double y1 = std::min(r1.maxY(), r2.maxY());
+	if (x1 <= x0 || y1 <= y0) {
+		return JRRectNull;
+	}
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+JRRect JRRectUnion(const JRRect& r1, const JRRect& r2)
+{
+	if (r1.isNull()) {
+		return r2;
+	}
+	if (r2.isNull()) {
+		return r1;
+	}
+	if (r1.isInfinite() || r2.isInfinite()) {
+		return JRRectInfinite;
+	}
+	double x0 = std::min(r1.minX(), r2.minX());
+	double y0 = std::min(r1.minY(), r2.minY());
+	double x1 = std::max(r1.maxX(), r2.maxX());
+	double y1 = std::max(r1.maxY(), r2.maxY());
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+JRRect JRRectInset(const JRRect& rect, double dx, double dy)
+{
+	if (rect.isNull() || rect.isInfinite()) {
+		return rect;
+	}
+	JRRect r = { rect.x + dx, rect.y + dy, rect.width - 2 * dx, rect.height - 2 * dy };
+	if (r.width <= 0 || r.height <= 0) {
+		return JRRectNull;
+	}
+	return r;
+}
+
+JRRect JRRectIntegral(const JRRect& rect)
+{
+	if (rect.isNull() || rect.isInfinite()) {
+		return rect;
+	}
+	double x0 = std::floor(rect.minX());
+	double y0 = std::floor(rect.minY());
+	double x1 = std::ceil(rect.maxX());
+	double y1 = std::ceil(rect.maxY());
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+JRRect JRRectApplyAffineTransform(const JRRect& rect, const JRAffineTransform& t)
+{
+	if (rect.isNull() || rect.isInfinite()) {
+		return rect;
+	}
+	double xs[4], ys[4];
+	JRAffineTransformApply(t, rect.minX(), rect.minY(), &xs[0], &ys[0]);
+	JRAffineTransformApply(t, rect.maxX(), rect.minY(), &xs[1], &ys[1]);
+	JRAffineTransformApply(t, rect.minX(), rect.maxY(), &xs[2], &ys[2]);
+	JRAffineTransformApply(t, rect.maxX(), rect.maxY(), &xs[3], &ys[3]);
+	double x0 = *std::min_element(xs, xs + 4);
+	double x1 = *std::max_element(xs, xs + 4);
+	double y0 = *std::min_element(ys, ys + 4);
+	double y1 = *std::max_element(ys, ys + 4);
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+bool JRRectEqualToRect(const JRRect& r1, const JRRect& r2)
+{
+	if (r1.isNull() || r2.isNull()) {
+		return r1.isNull() && r2.isNull();
+	}
+	return r1.x == r2.x && r1.y == r2.y && r1.width == r2.width && r1.height == r2.height;
+}
+
+bool JRRectContainsRect(const JRRect& r1, const JRRect& r2)
+{
+	if (r2.isNull()) {
+		return true;
+	}
+	if (r1.isNull()) {
+		return false;
+	}
+	return r2.minX() >= r1.minX() && r2.minY() >= r1.minY() && r2.maxX() <= r1.maxX() && r2.maxY() <= r1.maxY();
+}
+
+JRIRect JRIRectFromRect(const JRRect& rect)
+{
+	if (rect.isEmpty()) {
+		return { 0, 0, 0, 0 };
+	}
+	double x0 = std::max(std::floor(rect.minX()), -kJRPixelLimit);
+	double y0 = std::max(std::floor(rect.minY()), -kJRPixelLimit);
+	double x1 = std::min(std::ceil(rect.maxX()), kJRPixelLimit);
+	double y1 = std::min(std::ceil(rect.maxY()), kJRPixelLimit);
+	if (x1 <= x0 || y1 <= y0) {
+		return { 0, 0, 0, 0 };
+	}
+	return { int(x0), int(y0), int(x1 - x0), int(y1 - y0) };
+}
+
+JRRect JRRectFromIRect(const JRIRect& rect)
+{
+	if (rect.isEmpty()) {
+		return JRRectNull;
+	}
+	return { double(rect.x), double(rect.y), double(rect.width), double(rect.height) };
+}
+
+JRIRect JRIRectMake(int x, int y, int width, int height)
+{
+	return { x, y, width, height };
+}
+
+JRIRect JRIRectIntersection(const JRIRect& r1, const JRIRect& r2)
+{
+	int x0 = std::max(r1.x, r2.x);
+	int y0 = std::max(r1.y, r2.y);
+	int x1 = std::min(r1.maxX(), r2.maxX());
+	int y1 = std::min(r1.maxY(), r2.maxY());
+	if (x1 <= x0 || y1 <= y0) {
+		return { 0, 0, 0, 0 };
+	}
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+JRIRect JRIRectUnion(const JRIRect& r1, const JRIRect& r2)
+{
+	if (r1.isEmpty()) {
+		return r2;
+	}
+	if (r2.isEmpty()) {
+		return r1;
+	}
+	int x0 = std::min(r1.x, r2.x);
+	int y0 = std::min(r1.y, r2.y);
+	int x1 = std::max(r1.maxX(), r2.maxX());
+	int y1 = std::max(r1.maxY(), r2.maxY());
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+JRIRect JRIRectInset(const JRIRect& rect, int dx, int dy)
+{
+	JRIRect r = { rect.x + dx, rect.y + dy, rect.width - 2 * dx, rect.height - 2 * dy };
+	if (r.isEmpty()) {
+		return { 0, 0, 0, 0 };
+	}
+	return r;
+}
+
+JRAffineTransform JRAffineTransformMake(double a, double b, double c, double d, double tx, double ty)
+{
+	return { a, b, c, d, tx, ty };
+}
+
+JRAffineTransform JRAffineTransformMakeTranslation(double tx, double ty)
+{
+	return { 1, 0, 0, 1, tx, ty };
+}
+
+JRAffineTransform JRAffineTransformMakeScale(double sx, double sy)
+{
+	return { sx, 0, 0, sy, 0, 0 };
+}
+
+JRAffineTransform JRAffineTransformMakeRotation(double angle)
+{
+	double s = std::sin(angle);
+	double c = std::cos(angle);
+	return { c, s, -s, c, 0, 0 };
+}
+
+JRAffineTransform JRAffineTransformConcat(const JRAffineTransform& t1, const JRAffineTransform& t2)
+{
+	return {
+		t1.a * t2.a + t1.b * t2.c,
+		t1.a * t2.b + t1.b * t2.d,
+		t1.c * t2.a + t1.d * t2.c,
+		t1.c * t2.b + t1.d * t2.d,
+		t1.tx * t2.a + t1.ty * t2.c + t2.tx,
+		t1.tx * t2.b + t1.ty * t2.d + t2.ty,
+	};
+}
+
+bool JRAffineTransformIsInvertible(const JRAffineTransform& t)
+{
+	double det = t.a * t.d - t.b * t.c;
+	return std::fabs(det) > 1e-12;
+}
+
+JRAffineTransform JRAffineTransformInvert(const JRAffineTransform& t)
+{
+	double det = t.a * t.d - t.b * t.c;
+	if (std::fabs(det) <= 1e-12) {
+		return t;
+	}
+	double inv = 1.0 / det;
+	return {
+		t.d * inv,
+		-t.b * inv,
+		-t.c * inv,
+		t.a * inv,
+		(t.c * t.ty - t.d * t.tx) * inv,
+		(t.b * t.tx - t.a * t.ty) * inv,
+	};
+}
+
+void JRAffineTransformApply(const JRAffineTransform& t, double x, double y, double* outX, double* outY)
+{
+	*outX = t.a * x + t.c * y + t.tx;
+	*outY = t.b * x + t.d * y + t.ty;
+}
+
+double JRAffineTransformUniformScale(const JRAffineTransform& t)
+{
+	double scale = std::sqrt(t.a * t.a + t.b * t.b);
+	double tolerance = 1e-9 * scale;
+	if (std::fabs(t.a - t.d) > tolerance || std::fabs(t.b + t.c) > tolerance) {
+		return 0;
+	}
+	return scale;
+}
@@ -0,0 +1,104 @@
+//
+//  jr_Geometry.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Geometry_h
+#define jr_Geometry_h
+
+#include <cstdint>
+
+/* Rectangles in image space. Like CGRect, a null rect has an infinite origin
+ * and the infinite rect covers the whole plane. The y axis points up, so row 0
+ * of a buffer is the row with the smallest y. */
+struct JRRect {
+	double x;
+	double y;
+	double width;
+	double height;
+
+	double minX() const { return x; }
+	double minY() const { return y; }
+	double maxX() const { return x + width; }
+	double maxY() const { return y + height; }
+
+	bool isNull() const;
+	bool isEmpty() const;
+	bool isInfinite() const;
+};
+
+/* Integer pixel rectangle. Pixel (i, j) covers [i, i+1) x [j, j+1). */
+struct JRIRect {
+	int x;
+	int y;
+	int width;
+	int height;
+
+	int maxX() const { return x + width; }
+	int maxY() const { return y + height; }
+	bool isEmpty() const { return width <= 0 || height <= 0; }
+	int64_t area() const { return isEmpty() ? 0 : int64_t(width) * height; }
+	bool contains(const JRIRect& r) const;
+
+	bool operator==(const JRIRect& r) const { return x == r.x && y == r.y && width == r.width && height == r.height; }
+	bool operator!=(const JRIRect& r) const { return !(*this == r); }
+};
+
+/* [ a  b  0 ]
+ * [ c  d  0 ]
+ * [ tx ty 1 ]  — same layout as CGAffineTransform. */
+struct JRAffineTransform {
+	double a;
+	double b;
+	double c;
+	double d;
+	double tx;
+	double ty;
+
+	bool isIdentity() const;
+	/// 是否只有整数平移
+	bool isIntegerTranslation() const;
+};
+
+extern const JRRect JRRectNull;
+extern const JRRect JRRectInfinite;
+extern const JRRect JRRectZero;
+extern const JRAffineTransform JRAffineTransformIdentity;
+
+JRRect JRRectMake(double x, double y, double width, double height);
+JRRect JRRectIntersection(const JRRect& r1, const JRRect& r2);
+JRRect JRRectUnion(const JRRect& r1, const JRRect& r2);
+JRRect JRRectInset(const JRRect& rect, double dx, double dy);
+JRRect JRRectIntegral(const JRRect& rect);
+JRRect JRRectApplyAffineTransform(const JRRect& rect, const JRAffineTransform& t);
+bool JRRectEqualToRect(const JRRect& r1, const JRRect& r2);
+bool JRRectContainsRect(const JRRect& r1, const JRRect& r2);
+
+/* Rounds outwards to whole pixels and clamps to [-2^29, 2^29], so the
+ * infinite rect maps to a very large but finite JRIRect whose maxX() and
+ * maxY() still fit in an int. */
+JRIRect JRIRectFromRect(const JRRect& rect);
+JRRect JRRectFromIRect(const JRIRect& rect);
+JRIRect JRIRectMake(int x, int y, int width, int height);
+JRIRect JRIRectIntersection(const JRIRect& r1, const JRIRect& r2);
+JRIRect JRIRectUnion(const JRIRect& r1, const JRIRect& r2);
+JRIRect JRIRectInset(const JRIRect& rect, int dx, int dy);
+
+JRAffineTransform JRAffineTransformMake(double a, double b, double c, double d, double tx, double ty);
+JRAffineTransform JRAffineTransformMakeTranslation(double tx, double ty);
+JRAffineTransform JRAffineTransformMakeScale(double sx, double sy);
+JRAffineTransform JRAffineTransformMakeRotation(double angle);
+/* Returns t1 followed by t2, like CGAffineTransformConcat. */
+JRAffineTransform JRAffineTransformConcat(const JRAffineTransform& t1, const JRAffineTransform& t2);
+/* Returns 't' unchanged if it is not invertible, like CGAffineTransformInvert. */
+JRAffineTransform JRAffineTransformInvert(const JRAffineTransform& t);
+bool JRAffineTransformIsInvertible(const JRAffineTransform& t);
+void JRAffineTransformApply(const JRAffineTransform& t, double x, double y, double* outX, double* outY);
+/* The scale factor of a transform made only of rotation, uniform scaling and
+ * translation, or 0 for any other transform. */
+double JRAffineTransformUniformScale(const JRAffineTransform& t);
+
+#endif /* jr_Geometry_h */
@@ -0,0 +1,234 @@
+//
+//  jr_GraphOptimizer.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_GraphOptimizer.h"
+#include "jr_ColorCube.h"
+#include "jr_ColorSpace.h"
+
+#include <algorithm>
+
+/// 每次处理的像素数, 256 个 RGBA float 正好 4KB, 留在 L1 里
+static const size_t kJRFusedChunkPixels = 256;
+
+static std::string JRFusedKernelName(const std::vector<JRFusedColorKernel::Stage>& stages)
+{
+	std::string name = "fused(";
+	for (size_t i = 0; i < stages.size(); i++) {
+		name += (i ? "+" : "") + stages[i].kernel->name();
+	}
+	return name + ")";
+}
+
+JRFusedColorKernel::JRFusedColorKernel(const std::vector<Stage>& stages)
+: JRColorKernel(JRFusedKernelName(stages), nullptr), _stages(stages)
+{
+}
+
+void JRFusedColorKernel::apply(float* pixels, const float* const*, size_t count, const float* args) const
+{
+	for (size_t start = 0; start < count; start += kJRFusedChunkPixels) {
+		size_t n = std::min(kJRFusedChunkPixels, count - start);
+		float* p = pixels + start * 4;
+		bool premultiplied = true;
+
+		for (const Stage& stage : _stages) {
+			const JRColorKernel& kernel = *stage.kernel;
+			bool wantsUnpremultiplied = kernel.operatesOnUnpremultiplied() && kernel.function();
+			if (wantsUnpremultiplied && premultiplied) {
+				JRUnpremultiply(p, n);
+				premultiplied = false;
+			} else if (!wantsUnpremultiplied && !premultiplied) {
+				JRPremultiply(p, n);
+				premultiplied = true;
+			}
+			if (kernel.function()) {
+				kernel.function()(p, nullptr, n, args + stage.argumentOffset);
+			} else {
+				/// 自定义 apply 的 kernel, 按普通方式调用
+				kernel.apply(p, nullptr, n, args + stage.argumentOffset);
+			}
+		}
+		if (!premultiplied) {
+			JRPremultiply(p, n);
+		}
+	}
+}
+
+uint64_t JRFusedColorKernel::hash() const
+{
+	uint64_t hash = JRHashCombine(0, _stages.size());
+	for (const Stage& stage : _stages) {
+		hash = JRHashCombine(JRHashCombine(hash, stage.kernel->hash()), stage.argumentOffset);
+	}
+	return hash;
+}
+
+bool JRFusedColorKernel::isEqual(const JRKernel& other) const
+{
+	const JRFusedColorKernel* fused = dynamic_cast<const JRFusedColorKernel*>(&other);
+	if (!fused || fused->_stages.size() != _stages.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < _stages.size(); i++) {
+		if (!_stages[i].kernel->isEqual(*fused->_stages[i].kernel) || _stages[i].argumentOffset != fused->_stages[i].argumentOffset) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/// 单输入且不改变 extent 的 color kernel 才能合并
+static bool JRIsFusableColorNode(const JRImage& image)
+{
+	return image.kind() == kJRImageKindKernel
+		&& image.kernel()->type() == kJRKernelTypeColor
+		&& image.inputs().size() == 1
+		&& JRRectEqualToRect(image.extent(), image.inputs()[0]->extent());
+}
+
+/// image 与它的输入互逆
+static bool JRIsCancellingPair(const JRImage& image)
+{
+	if (image.kind() != kJRImageKindKernel || image.kernel()->type() != kJRKernelTypeColor || image.inputs().size() != 1) {
+		return false;
+	}
+	const JRImage& input = *image.inputs()[0];
+	if (input.kind() != kJRImageKindKernel || input.kernel()->type() != kJRKernelTypeColor || input.inputs().size() != 1) {
+		return false;
+	}
+	if (image.kernel() == JRColorKernel::premultiplyKernel()) {
+		return input.kernel() == JRColorKernel::unpremultiplyKernel();
+	}
+	return JRColorKernelsCancel(static_cast<const JRColorKernel&>(*image.kernel()), static_cast<const JRColorKernel&>(*input.kernel()));
+}
+
+JRGraphOptimizer::JRGraphOptimizer(bool bakesColorCubes)
+: _bakesColorCubes(bakesColorCubes)
+{
+}
+
+JRImageRef JRGraphOptimizer::optimize(const JRImageRef& image)
+{
+	if (!image) {
+		return nullptr;
+	}
+	_consumers.clear();
+	_rewritten.clear();
+	_baked.clear();
+	countConsumers(image.get());
+	JRImageRef result = rewrite(image);
+	return _bakesColorCubes ? bakeColorCubes(result) : result;
+}
+
+void JRGraphOptimizer::countConsumers(const JRImage* image)
+{
+	for (const JRImageRef& input : image->inputs()) {
+		if (_consumers[input.get()]++ == 0) {
+			countConsumers(input.get());
+		}
+	}
+}
+
+JRImageRef JRGraphOptimizer::rewrite(const JRImageRef& image)
+{
+	auto found = _rewritten.find(image.get());
+	if (found != _rewritten.end()) {
+		return found->second;
+	}
+
+	/// premultiply(unpremultiply(x)) == x, 互逆的 sRGB 转换也一样, 在合并之前去掉
+	if (JRIsCancellingPair(*image)) {
+		JRImageRef result = rewrite(image->inputs()[0]->inputs()[0]);
+		_rewritten[image.get()] = result;
+		return result;
+	}
+
+	std::vector<JRImageRef> inputs;
+	bool changed = false;
+	for (const JRImageRef& input : image->inputs()) {
+		inputs.push_back(rewrite(input));
+		changed = changed || inputs.back() != input;
+	}
+
+	JRImageRef result = changed ? image->imageByReplacingInputs(inputs) : image;
+	switch (image->kind()) {
+		case kJRImageKindTransform: {
+			const JRImage& input = *inputs[0];
+			if (input.kind() == kJRImageKindTransform) {
+				result = input.inputs()[0]->applying(JRAffineTransformConcat(input.transform(), image->transform()));
+			} else if (image->transform().isIdentity()) {
+				result = inputs[0];
+			}
+			break;
+		}
+		case kJRImageKindCrop: {
+			const JRImage& input = *inputs[0];
+			if (input.kind() == kJRImageKindCrop) {
+				result = input.inputs()[0]->cropping(JRRectIntersection(input.rect(), image->rect()));
+			}
+			break;
+		}
+		case kJRImageKindKernel:
+			if (JRIsFusableColorNode(*result)) {
+				result = fuseColorKernels(result, *image);
+			}
+			break;
+		default:
+			break;
+	}
+	_rewritten[image.get()] = result;
+	return result;
+}
+
+JRImageRef JRGraphOptimizer::fuseColorKernels(const JRImageRef& image, const JRImage& original)
+{
+	const JRImageRef& input = image->inputs()[0];
+	/// input 被多处使用时不合并, 否则会重复计算
+	bool shared = _consumers[original.inputs()[0].get()] > 1;
+	if (!JRIsFusableColorNode(*input) || shared) {
+		return image;
+	}
+
+	std::vector<JRFusedColorKernel::Stage> stages;
+	JRKernelArguments args;
+	auto appendStages = [&](const JRImage& node) {
+		const JRFusedColorKernel* fused = dynamic_cast<const JRFusedColorKernel*>(node.kernel().get());
+		size_t base = args.size();
+		if (fused) {
+			for (const JRFusedColorKernel::Stage& stage : fused->stages()) {
+				stages.push_back({ stage.kernel, base + stage.argumentOffset });
+			}
+		} else {
+			stages.push_back({ std::static_pointer_cast<const JRColorKernel>(node.kernel()), base });
+		}
+		args.insert(args.end(), node.arguments().begin(), node.arguments().end());
+	};
+	appendStages(*input);
+	appendStages(*image);
+
+	return JRImage::imageWithKernel(std::make_shared<JRFusedColorKernel>(stages), { input->inputs()[0] }, args);
+}
+
+JRImageRef JRGraphOptimizer::bakeColorCubes(const JRImageRef& image)
+{
+	auto found = _baked.find(image.get());
+	if (found != _baked.end()) {
+		return found->second;
+	}
+	std::vector<JRImageRef> inputs;
+	bool changed = false;
+	for (const JRImageRef& input : image->inputs()) {
+		inputs.push_back(bakeColorCubes(input));
+		changed = changed || inputs.back() != input;
+	}
+	JRImageRef result = changed ? image->imageByReplacingInputs(inputs) : image;
+	JRImageRef baked = JRBakeColorCube(result);
+	result = baked ? baked : result;
+	_baked[image.get()] = result;
+	return result;
+}
@@ -0,0 +1,75 @@
+//
+//  jr_GraphOptimizer.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_GraphOptimizer_h
+#define jr_GraphOptimizer_h
+
+#include "jr_Image.h"
+#include "jr_Kernel.h"
+
+#include <unordered_map>
+#include <vector>
+
+/* Several point-wise kernels run as one. Each chunk of pixels goes through
+ * every stage while it is still in cache, and the premultiply / unpremultiply
+ * steps between consecutive unpremultiplied stages are skipped. */
+class JRFusedColorKernel : public JRColorKernel {
+public:
+	struct Stage {
+		std::shared_ptr<const JRColorKernel> kernel;
+		/// 该阶段参数在合并参数中的位置
+		size_t argumentOffset;
+	};
+
+	/* 'stages' run in order; the fused arguments are the stage arguments
+	 * concatenated in the same order. */
+	explicit JRFusedColorKernel(const std::vector<Stage>& stages);
+
+	const std::vector<Stage>& stages() const { return _stages; }
+
+	void apply(float* pixels, const float* const* inputs, size_t count, const float* args) const override;
+
+	/// 每次优化都会新建, 按各阶段判断是否相同
+	uint64_t hash() const override;
+	bool isEqual(const JRKernel& other) const override;
+
+private:
+	std::vector<Stage> _stages;
+};
+
+/* Rewrites an image graph into a cheaper equivalent before rendering:
+ *  - runs of single-consumer, single-input color kernels become one
+ *    JRFusedColorKernel;
+ *  - adjacent applying(_:) transforms are concatenated, identities removed;
+ *  - nested crops collapse into one;
+ *  - premultiplyingAlpha() of unpremultiplyingAlpha() is removed, and so is
+ *    an sRGB conversion followed by its inverse (JRColorKernelsCancel);
+ *  - with 'bakesColorCubes', fused chains of kJRColorCubeMinimumStages or
+ *    more are baked into a colour cube (see JRBakeColorCube).
+ * Shared sub-graphs stay shared. */
+class JRGraphOptimizer {
+public:
+	explicit JRGraphOptimizer(bool bakesColorCubes = true);
+
+	JRImageRef optimize(const JRImageRef& image);
+
+private:
+	void countConsumers(const JRImage* image);
+	JRImageRef rewrite(const JRImageRef& image);
+	JRImageRef fuseColorKernels(const JRImageRef& image, const JRImage& original);
+	/// 合并完成后再烘焙, 否则链还会继续变长
+	JRImageRef bakeColorCubes(const JRImageRef& image);
+
+	bool _bakesColorCubes;
+
+	std::unordered_map<const JRImage*, int> _consumers;
+	std::unordered_map<const JRImage*, JRImageRef> _rewritten;
+	std::unordered_map<const JRImage*, JRImageRef> _baked;
+};
+
+#endif /* jr_GraphOptimizer_h */
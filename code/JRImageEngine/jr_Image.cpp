@@ -0,0 +1,427 @@
+//
+//  jr_Image.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Image.h"
+#include "jr_Filter.h"
+#include "jr_MappedImageProvider.h"
+#include "jr_YUVFrame.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+JRImageProvider::~JRImageProvider()
+{
+}
+
+const JRBuffer* JRImageProvider::pixels() const
+{
+	return nullptr;
+}
+
+JRBitmapImageProvider::JRBitmapImageProvider(std::vector<uint8_t> data, size_t bytesPerRow, int width, int height, JRFormat format)
+: _data(std::move(data)), _bytesPerRow(bytesPerRow), _width(width), _height(height), _format(format)
+{
+}
+
+JRIRect JRBitmapImageProvider::extent() const
+{
+	return { 0, 0, _width, _height };
+}
+
+void JRBitmapImageProvider::read(const JRIRect& rect, const JRBuffer& output) const
+{
+	size_t bpp = JRFormatBytesPerPixel(_format);
+	for (int y = rect.y; y < rect.maxY(); y++) {
+		const uint8_t* row = _data.data() + size_t(y) * _bytesPerRow + size_t(rect.x) * bpp;
+		JRFormatUnpackRow(_format, row, output.rowAt(y), size_t(rect.width));
+	}
+}
+
+JRBufferImageProvider::JRBufferImageProvider(const JRBuffer& buffer)
+: _buffer(buffer)
+{
+}
+
+JRIRect JRBufferImageProvider::extent() const
+{
+	return _buffer.rect();
+}
+
+void JRBufferImageProvider::read(const JRIRect& rect, const JRBuffer& output) const
+{
+	output.view(rect).copyFrom(_buffer);
+}
+
+const JRBuffer* JRBufferImageProvider::pixels() const
+{
+	return &_buffer;
+}
+
+static uint64_t JRHashDouble(uint64_t seed, double value)
+{
+	uint64_t bits;
+	/// +0 与 -0 视为相同
+	value = value == 0 ? 0 : value;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return JRHashCombine(seed, bits);
+}
+
+static uint64_t JRHashRect(uint64_t seed, const JRRect& rect)
+{
+	return JRHashDouble(JRHashDouble(JRHashDouble(JRHashDouble(seed, rect.x), rect.y), rect.width), rect.height);
+}
+
+JRImage::JRImage(JRImageKind kind)
+: _kind(kind), _extent(JRRectNull), _hash(0), _color(JRColor::clearColor()), _transform(JRAffineTransformIdentity), _rect(JRRectNull)
+{
+}
+
+JRImageRef JRImage::makeImage(JRImage* image)
+{
+	switch (image->_kind) {
+		case kJRImageKindEmpty:
+			image->_extent = JRRectNull;
+			break;
+		case kJRImageKindProvider:
+			image->_extent = JRRectFromIRect(image->_provider->extent());
+			break;
+		case kJRImageKindColor:
+			image->_extent = JRRectInfinite;
+			break;
+		case kJRImageKindTransform:
+			image->_extent = JRRectApplyAffineTransform(image->_inputs[0]->extent(), image->_transform);
+			break;
+		case kJRImageKindCrop:
+			image->_extent = JRRectIntersection(image->_inputs[0]->extent(), image->_rect);
+			break;
+		case kJRImageKindClamp:
+			image->_extent = image->_rect.isEmpty() ? JRRectNull : JRRectInfinite;
+			break;
+		case kJRImageKindKernel: {
+			std::vector<JRRect> extents;
+			for (const JRImageRef& input : image->_inputs) {
+				extents.push_back(input->extent());
+			}
+			image->_extent = image->_kernel->extent(extents, image->_arguments);
+			break;
+		}
+	}
+
+	uint64_t hash = JRHashCombine(0, uint64_t(image->_kind));
+	switch (image->_kind) {
+		case kJRImageKindEmpty:
+			break;
+		case kJRImageKindProvider:
+			hash = JRHashCombine(hash, uint64_t(reinterpret_cast<uintptr_t>(image->_provider.get())));
+			break;
+		case kJRImageKindColor: {
+			const JRColor& c = image->_color;
+			hash = JRHashDouble(JRHashDouble(JRHashDouble(JRHashDouble(hash, c.red), c.green), c.blue), c.alpha);
+			break;
+		}
+		case kJRImageKindTransform: {
+			const JRAffineTransform& t = image->_transform;
+			for (double v : { t.a, t.b, t.c, t.d, t.tx, t.ty }) {
+				hash = JRHashDouble(hash, v);
+			}
+			break;
+		}
+		case kJRImageKindCrop:
+		case kJRImageKindClamp:
+			hash = JRHashRect(hash, image->_rect);
+			break;
+		case kJRImageKindKernel:
+			hash = JRHashCombine(hash, image->_kernel->hash());
+			for (float v : image->_arguments) {
+				hash = JRHashDouble(hash, v);
+			}
+			break;
+	}
+	for (const JRImageRef& input : image->_inputs) {
+		hash = JRHashCombine(hash, input->_hash);
+	}
+	image->_hash = hash;
+	return JRImageRef(image);
+}
+
+JRImageRef JRImage::emptyImage()
+{
+	static JRImageRef image = makeImage(new JRImage(kJRImageKindEmpty));
+	return image;
+}
+
+JRImageRef JRImage::imageWithColor(const JRColor& color)
+{
+	JRImage* image = new JRImage(kJRImageKindColor);
+	image->_color = color;
+	return makeImage(image);
+}
+
+JRImageRef JRImage::imageWithBitmapData(std::vector<uint8_t> data, size_t bytesPerRow, int width, int height, JRFormat format)
+{
+	if (width <= 0 || height <= 0 || bytesPerRow < size_t(width) * JRFormatBytesPerPixel(format)
+		|| data.size() < bytesPerRow * size_t(height - 1) + size_t(width) * JRFormatBytesPerPixel(format)) {
+		return nullptr;
+	}
+	return imageWithImageProvider(std::make_shared<JRBitmapImageProvider>(std::move(data), bytesPerRow, width, height, format));
+}
+
+JRImageRef JRImage::imageWithBitmapBytes(std::shared_ptr<const uint8_t> bytes, size_t bytesPerRow, int width, int height, JRFormat format)
+{
+	if (!bytes || width <= 0 || height <= 0 || bytesPerRow < size_t(width) * JRFormatBytesPerPixel(format)) {
+		return nullptr;
+	}
+	return imageWithImageProvider(std::make_shared<JRMappedImageProvider>(std::move(bytes), std::vector<size_t>{ 0 }, height,
+																		  bytesPerRow, width, height, kJRSampleLayoutFormat, format));
+}
+
+JRImageRef JRImage::imageWithContentsOfFile(const std::string& path)
+{
+	return imageWithImageProvider(JRMappedImageProvider::providerWithContentsOfFile(path));
+}
+
+JRImageRef JRImage::imageWithRawFile(const std::string& path, size_t offset, size_t bytesPerRow, int width, int height, JRFormat format)
+{
+	size_t length = 0;
+	std::shared_ptr<const uint8_t> bytes = JRMapFile(path, &length);
+	if (!bytes || width <= 0 || height <= 0 || bytesPerRow < size_t(width) * JRFormatBytesPerPixel(format)
+		|| offset > length || length - offset < bytesPerRow * size_t(height - 1) + size_t(width) * JRFormatBytesPerPixel(format)) {
+		return nullptr;
+	}
+	return imageWithImageProvider(std::make_shared<JRMappedImageProvider>(std::move(bytes), std::vector<size_t>{ offset }, height,
+																		  bytesPerRow, width, height, kJRSampleLayoutFormat, format));
+}
+
+JRImageRef JRImage::imageWithYUVFrame(const std::shared_ptr<const JRYUVFrame>& frame)
+{
+	if (!frame) {
+		return nullptr;
+	}
+	return imageWithImageProvider(std::make_shared<JRYUVImageProvider>(frame));
+}
+
+JRImageRef JRImage::imageWithImageProvider(const JRImageProviderRef& provider)
+{
+	if (!provider) {
+		return nullptr;
+	}
+	JRImage* image = new JRImage(kJRImageKindProvider);
+	image->_provider = provider;
+	return makeImage(image);
+}
+
+JRImageRef JRImage::imageWithKernel(const JRKernelRef& kernel, const std::vector<JRImageRef>& inputs, const JRKernelArguments& args)
+{
+	if (!kernel) {
+		return nullptr;
+	}
+	for (const JRImageRef& input : inputs) {
+		if (!input) {
+			return nullptr;
+		}
+	}
+	JRImage* image = new JRImage(kJRImageKindKernel);
+	image->_kernel = kernel;
+	image->_inputs = inputs;
+	image->_arguments = args;
+	return makeImage(image);
+}
+
+JRImageRef JRImage::applying(const JRAffineTransform& matrix) const
+{
+	if (matrix.isIdentity()) {
+		return shared_from_this();
+	}
+	JRImage* image = new JRImage(kJRImageKindTransform);
+	image->_inputs.push_back(shared_from_this());
+	image->_transform = matrix;
+	return makeImage(image);
+}
+
+JRImageRef JRImage::cropping(const JRRect& rect) const
+{
+	JRImage* image = new JRImage(kJRImageKindCrop);
+	image->_inputs.push_back(shared_from_this());
+	image->_rect = rect;
+	return makeImage(image);
+}
+
+JRImageRef JRImage::clampingToExtent() const
+{
+	return clamping(_extent);
+}
+
+JRImageRef JRImage::clamping(const JRRect& rect) const
+{
+	JRImage* image = new JRImage(kJRImageKindClamp);
+	image->_inputs.push_back(shared_from_this());
+	/// 按整像素复制边缘
+	image->_rect = JRRectIntegral(rect);
+	return makeImage(image);
+}
+
+JRImageRef JRImage::applyingFilter(const std::string& filterName, const JRFilterParameters& params) const
+{
+	JRFilterRef filter = JRFilter::filterWithName(filterName, params);
+	if (!filter) {
+		return nullptr;
+	}
+	filter->setValue(shared_from_this(), kJRInputImageKeyID);
+	return filter->outputImage();
+}
+
+JRImageRef JRImage::applyingGaussianBlur(double sigma) const
+{
+	return applyingFilter("CIGaussianBlur", { { kJRInputRadiusKey, sigma } });
+}
+
+JRImageRef JRImage::premultiplyingAlpha() const
+{
+	return imageWithKernel(JRColorKernel::premultiplyKernel(), { shared_from_this() }, {});
+}
+
+JRImageRef JRImage::unpremultiplyingAlpha() const
+{
+	return imageWithKernel(JRColorKernel::unpremultiplyKernel(), { shared_from_this() }, {});
+}
+
+JRImageRef JRImage::matchedToWorkingSpace(JRColorSpace colorSpace) const
+{
+	std::shared_ptr<const JRColorKernel> kernel = JRColorSpaceToWorkingKernel(colorSpace);
+	return kernel ? imageWithKernel(kernel, { shared_from_this() }, {}) : shared_from_this();
+}
+
+JRImageRef JRImage::matchedFromWorkingSpace(JRColorSpace colorSpace) const
+{
+	std::shared_ptr<const JRColorKernel> kernel = JRColorSpaceFromWorkingKernel(colorSpace);
+	return kernel ? imageWithKernel(kernel, { shared_from_this() }, {}) : shared_from_this();
+}
+
+JRImageRef JRImage::imageByReplacingInputs(const std::vector<JRImageRef>& inputs) const
+{
+	if (inputs.size() != _inputs.size()) {
+		return nullptr;
+	}
+	JRImage* image = new JRImage(*this);
+	image->_inputs = inputs;
+	return makeImage(image);
+}
+
+/// 已比较过的节点对. 共享子图在两个图中会沿多条路径到达, 每对只需比较一次
+typedef std::set<std::pair<const JRImage*, const JRImage*>> JRImagePairSet;
+
+static bool JRImagesStructurallyEqual(const JRImage& image, const JRImage& other, JRImagePairSet& compared)
+{
+	if (&image == &other) {
+		return true;
+	}
+	if (image.structuralHash() != other.structuralHash() || image.kind() != other.kind() || image.inputs().size() != other.inputs().size()) {
+		return false;
+	}
+	/// 不相等会立即一路返回, 所以见过的节点对都是相等的
+	if (!compared.insert({ &image, &other }).second) {
+		return true;
+	}
+	switch (image.kind()) {
+		case kJRImageKindEmpty:
+			break;
+		case kJRImageKindProvider:
+			if (image.provider() != other.provider()) {
+				return false;
+			}
+			break;
+		case kJRImageKindColor:
+			if (!(image.color() == other.color())) {
+				return false;
+			}
+			break;
+		case kJRImageKindTransform: {
+			const JRAffineTransform& t = image.transform();
+			const JRAffineTransform& u = other.transform();
+			if (t.a != u.a || t.b != u.b || t.c != u.c || t.d != u.d || t.tx != u.tx || t.ty != u.ty) {
+				return false;
+			}
+			break;
+		}
+		case kJRImageKindCrop:
+		case kJRImageKindClamp:
+			if (!JRRectEqualToRect(image.rect(), other.rect())) {
+				return false;
+			}
+			break;
+		case kJRImageKindKernel:
+			if (!image.kernel()->isEqual(*other.kernel()) || image.arguments() != other.arguments()) {
+				return false;
+			}
+			break;
+	}
+	for (size_t i = 0; i < image.inputs().size(); i++) {
+		if (!JRImagesStructurallyEqual(*image.inputs()[i], *other.inputs()[i], compared)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool JRImage::isStructurallyEqual(const JRImage& other) const
+{
+	JRImagePairSet compared;
+	return JRImagesStructurallyEqual(*this, other, compared);
+}
+
+JRRect JRImage::inputRegionOfInterest(size_t index, const JRRect& rect) const
+{
+	if (rect.isNull() || index >= _inputs.size()) {
+		return JRRectNull;
+	}
+	switch (_kind) {
+		case kJRImageKindEmpty:
+		case kJRImageKindProvider:
+		case kJRImageKindColor:
+			return JRRectNull;
+		case kJRImageKindTransform: {
+			if (!JRAffineTransformIsInvertible(_transform)) {
+				return JRRectNull;
+			}
+			JRRect roi = JRRectApplyAffineTransform(rect, JRAffineTransformInvert(_transform));
+			/// 双线性采样需要多一个像素
+			return _transform.isIntegerTranslation() ? roi : JRRectInset(roi, -1, -1);
+		}
+		case kJRImageKindCrop:
+			return JRRectIntersection(rect, _rect);
+		case kJRImageKindClamp: {
+			if (_rect.isEmpty() || rect.isInfinite()) {
+				return _rect;
+			}
+			double x0 = std::min(std::max(rect.minX(), _rect.minX()), _rect.maxX() - 1);
+			double y0 = std::min(std::max(rect.minY(), _rect.minY()), _rect.maxY() - 1);
+			double x1 = std::max(std::min(rect.maxX(), _rect.maxX()), _rect.minX() + 1);
+			double y1 = std::max(std::min(rect.maxY(), _rect.maxY()), _rect.minY() + 1);
+			return JRRectMake(x0, y0, x1 - x0, y1 - y0);
+		}
+		case kJRImageKindKernel:
+			if (_kernel->type() == kJRKernelTypeGeneral) {
+				return static_cast<const JRGeneralKernel&>(*_kernel).regionOfInterest(index, rect, _arguments);
+			}
+			return rect;
+	}
+	return JRRectNull;
+}
+
+JRRect JRImage::regionOfInterest(const JRImageRef& image, const JRRect& rect) const
+{
+	if (image.get() == this) {
+		return rect;
+	}
+	JRRect roi = JRRectNull;
+	for (size_t i = 0; i < _inputs.size(); i++) {
+		roi = JRRectUnion(roi, _inputs[i]->regionOfInterest(image, inputRegionOfInterest(i, rect)));
+	}
+	return roi;
+}
@@ -0,0 +1,187 @@
+//
+//  jr_Image.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Image_h
+#define jr_Image_h
+
+#include "jr_Buffer.h"
+#include "jr_ColorSpace.h"
+#include "jr_Format.h"
+#include "jr_Kernel.h"
+#include "jr_Value.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class JRYUVFrame;
+
+/* Supplies source pixels on demand. The engine only ever asks for the rects a
+ * render actually touches, so a provider can decode lazily. */
+class JRImageProvider {
+public:
+	virtual ~JRImageProvider();
+
+	virtual JRIRect extent() const = 0;
+	/* Writes 'rect', which lies inside extent(), into 'output' (which covers
+	 * exactly 'rect') as premultiplied float RGBA. */
+	virtual void read(const JRIRect& rect, const JRBuffer& output) const = 0;
+
+	/* Providers that already hold working-format pixels return them, and the
+	 * renderer reads them in place instead of calling read(). The default
+	 * returns nullptr. */
+	virtual const JRBuffer* pixels() const;
+};
+
+typedef std::shared_ptr<const JRImageProvider> JRImageProviderRef;
+
+/* Pixels held in memory in one of the JRFormat layouts. Row 0 is y = 0. */
+class JRBitmapImageProvider : public JRImageProvider {
+public:
+	JRBitmapImageProvider(std::vector<uint8_t> data, size_t bytesPerRow, int width, int height, JRFormat format);
+
+	JRIRect extent() const override;
+	void read(const JRIRect& rect, const JRBuffer& output) const override;
+
+private:
+	std::vector<uint8_t> _data;
+	size_t _bytesPerRow;
+	int _width;
+	int _height;
+	JRFormat _format;
+};
+
+/* Pixels already in the working format, shared with a JRBuffer. JRContext
+ * uses it to stand in for cached intermediates. */
+class JRBufferImageProvider : public JRImageProvider {
+public:
+	explicit JRBufferImageProvider(const JRBuffer& buffer);
+
+	JRIRect extent() const override;
+	void read(const JRIRect& rect, const JRBuffer& output) const override;
+	const JRBuffer* pixels() const override;
+
+private:
+	JRBuffer _buffer;
+};
+
+enum JRImageKind {
+	kJRImageKindEmpty = 0,
+	kJRImageKindProvider,
+	kJRImageKindColor,
+	kJRImageKindTransform,
+	kJRImageKindCrop,
+	kJRImageKindClamp,
+	kJRImageKindKernel,
+};
+
+/* An immutable recipe for an image, the counterpart of CIImage. Nothing is
+ * evaluated until a JRContext renders a rect of it. */
+class JRImage : public std::enable_shared_from_this<JRImage> {
+public:
+	/* Initializers. */
+	static JRImageRef emptyImage();
+	/// 使用 JRColor, 无限大小
+	static JRImageRef imageWithColor(const JRColor& color);
+	/// 使用像素数据
+	static JRImageRef imageWithBitmapData(std::vector<uint8_t> data, size_t bytesPerRow, int width, int height, JRFormat format);
+	/* Wraps pixels without copying them. 'bytes' owns the memory, which must
+	 * hold 'height' rows of 'bytesPerRow'; its deleter runs once no image or
+	 * render uses it any more. */
+	static JRImageRef imageWithBitmapBytes(std::shared_ptr<const uint8_t> bytes, size_t bytesPerRow, int width, int height, JRFormat format);
+	/* Maps an uncompressed PGM, PPM, PAM or TIFF file and reads tiles straight
+	 * from the mapping. See JRMappedImageProvider for the exact subset.
+	 * Returns nullptr for other files. */
+	static JRImageRef imageWithContentsOfFile(const std::string& path);
+	/* Maps a headerless file of 'format' rows starting at 'offset'. */
+	static JRImageRef imageWithRawFile(const std::string& path, size_t offset, size_t bytesPerRow, int width, int height, JRFormat format);
+	/* Reads tiles straight from the planes of a 4:2:0 frame, converting to
+	 * RGB on the way in. See JRYUVImageProvider. */
+	static JRImageRef imageWithYUVFrame(const std::shared_ptr<const JRYUVFrame>& frame);
+	/// 使用 provider, 按需读取
+	static JRImageRef imageWithImageProvider(const JRImageProviderRef& provider);
+	/// 使用 kernel
+	static JRImageRef imageWithKernel(const JRKernelRef& kernel, const std::vector<JRImageRef>& inputs, const JRKernelArguments& args);
+
+	/* Returns a new image representing the original image with the transform
+	 * 'matrix' appended to it. */
+	JRImageRef applying(const JRAffineTransform& matrix) const;
+	/// 裁剪一个新的矩形图片
+	JRImageRef cropping(const JRRect& rect) const;
+	/* Return a new infinite image by replicating the edge pixels of the receiver image. */
+	JRImageRef clampingToExtent() const;
+	/* Return a new infinite image by replicating the edge pixels of a rectangle. */
+	JRImageRef clamping(const JRRect& rect) const;
+	/// 添加过滤器, 过滤器不存在时返回 nullptr
+	JRImageRef applyingFilter(const std::string& filterName, const JRFilterParameters& params) const;
+	/* Return a new image by applying a Gaussian blur with standard deviation
+	 * 'sigma', the same as CIGaussianBlur with inputRadius 'sigma'. */
+	JRImageRef applyingGaussianBlur(double sigma) const;
+	/* Return a new image by multiplying the receiver's RGB values by its alpha. */
+	JRImageRef premultiplyingAlpha() const;
+	/* Return a new image by dividing the receiver's RGB values by its alpha. */
+	JRImageRef unpremultiplyingAlpha() const;
+	/* Return a new image by converting the receiver from 'colorSpace' to the
+	 * linear working space. Returns the receiver for kJRColorSpaceLinearSRGB. */
+	JRImageRef matchedToWorkingSpace(JRColorSpace colorSpace) const;
+	/* Return a new image by converting the receiver from the working space to
+	 * 'colorSpace'. Returns the receiver for kJRColorSpaceLinearSRGB. */
+	JRImageRef matchedFromWorkingSpace(JRColorSpace colorSpace) const;
+
+	/* Return a rect the defines the bounds of non-(0,0,0,0) pixels */
+	const JRRect& extent() const { return _extent; }
+
+	/* Returns the rectangle of 'image' that is required to render the
+	 * rectangle 'rect' of the receiver. This may return a null rect. */
+	JRRect regionOfInterest(const JRImageRef& image, const JRRect& rect) const;
+
+	/* Graph introspection, used by the renderer. */
+	JRImageKind kind() const { return _kind; }
+	const std::vector<JRImageRef>& inputs() const { return _inputs; }
+	const JRImageProviderRef& provider() const { return _provider; }
+	const JRColor& color() const { return _color; }
+	const JRAffineTransform& transform() const { return _transform; }
+	/// crop / clamp 的矩形
+	const JRRect& rect() const { return _rect; }
+	const JRKernelRef& kernel() const { return _kernel; }
+	const JRKernelArguments& arguments() const { return _arguments; }
+
+	/* A hash of the whole recipe below and including this node: kinds,
+	 * parameters, kernels and sources. Images built the same way from the
+	 * same sources hash alike, even if they are different objects. */
+	uint64_t structuralHash() const { return _hash; }
+	/* Whether 'other' is the same recipe, which is what structuralHash()
+	 * approximates. Sources compare by identity. Each pair of nodes is
+	 * compared once, so shared sub-graphs are not walked once per path. */
+	bool isStructurallyEqual(const JRImage& other) const;
+
+	/* A copy of this node reading from 'inputs' instead, which must match
+	 * inputs() in count. */
+	JRImageRef imageByReplacingInputs(const std::vector<JRImageRef>& inputs) const;
+
+	/* The rect of input 'index' needed to produce 'rect' of this node. */
+	JRRect inputRegionOfInterest(size_t index, const JRRect& rect) const;
+
+private:
+	explicit JRImage(JRImageKind kind);
+	static JRImageRef makeImage(JRImage* image);
+
+	JRImageKind _kind;
+	JRRect _extent;
+	uint64_t _hash;
+	std::vector<JRImageRef> _inputs;
+	JRImageProviderRef _provider;
+	JRColor _color;
+	JRAffineTransform _transform;
+	JRRect _rect;
+	JRKernelRef _kernel;
+	JRKernelArguments _arguments;
+};
+
+#endif /* jr_Image_h */
@@ -0,0 +1,254 @@
+//
+//  jr_ImageAccumulator.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_ImageAccumulator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+/// image() 的内容: 某一时刻的 tile 表. tile 不会被修改, 只会被替换, 所以共享即可
+class JRAccumulatorImageProvider : public JRImageProvider {
+public:
+	JRAccumulatorImageProvider(const JRIRect& extent, JRFormat format, int columns, std::vector<JRImageAccumulator::Tile> tiles)
+	: _extent(extent), _format(format), _columns(columns), _tiles(std::move(tiles))
+	{
+	}
+
+	JRIRect extent() const override
+	{
+		return _extent;
+	}
+
+	void read(const JRIRect& rect, const JRBuffer& output) const override
+	{
+		const int size = kJRImageAccumulatorTileSize;
+		const size_t bpp = JRFormatBytesPerPixel(_format);
+		int tx0 = (rect.x - _extent.x) / size, tx1 = (rect.maxX() - 1 - _extent.x) / size;
+		int ty0 = (rect.y - _extent.y) / size, ty1 = (rect.maxY() - 1 - _extent.y) / size;
+		for (int ty = ty0; ty <= ty1; ty++) {
+			for (int tx = tx0; tx <= tx1; tx++) {
+				JRIRect tile = JRIRectIntersection({ _extent.x + tx * size, _extent.y + ty * size, size, size }, _extent);
+				JRIRect part = JRIRectIntersection(tile, rect);
+				const uint8_t* bytes = _tiles[size_t(ty) * size_t(_columns) + size_t(tx)].get();
+				size_t rowBytes = size_t(tile.width) * bpp;
+				for (int y = part.y; y < part.maxY(); y++) {
+					float* dst = output.pixelAt(part.x, y);
+					if (!bytes) {
+						std::memset(dst, 0, size_t(part.width) * 4 * sizeof(float));
+						continue;
+					}
+					const uint8_t* src = bytes + size_t(y - tile.y) * rowBytes + size_t(part.x - tile.x) * bpp;
+					JRFormatUnpackRow(_format, src, dst, size_t(part.width));
+				}
+			}
+		}
+	}
+
+private:
+	JRIRect _extent;
+	JRFormat _format;
+	int _columns;
+	std::vector<JRImageAccumulator::Tile> _tiles;
+};
+
+JRImageAccumulator::JRImageAccumulator(const JRIRect& extent, JRFormat format, const JRContextRef& context)
+: _extent(extent), _format(format), _context(context ? context : JRContext::context()), _groupDepth(0), _undoLimit(64)
+{
+	const int size = kJRImageAccumulatorTileSize;
+	_columns = (extent.width + size - 1) / size;
+	_rows = (extent.height + size - 1) / size;
+	_tiles.resize(size_t(_columns) * size_t(_rows));
+	_recorded.resize(_tiles.size());
+}
+
+std::shared_ptr<JRImageAccumulator> JRImageAccumulator::accumulatorWithExtent(const JRIRect& extent, JRFormat format,
+																			  const JRContextRef& context)
+{
+	if (extent.isEmpty()) {
+		return nullptr;
+	}
+	return std::shared_ptr<JRImageAccumulator>(new JRImageAccumulator(extent, format, context));
+}
+
+JRIRect JRImageAccumulator::tileRect(size_t index) const
+{
+	const int size = kJRImageAccumulatorTileSize;
+	int tx = int(index % size_t(_columns)), ty = int(index / size_t(_columns));
+	return JRIRectIntersection({ _extent.x + tx * size, _extent.y + ty * size, size, size }, _extent);
+}
+
+JRImageRef JRImageAccumulator::image() const
+{
+	if (!_image) {
+		_image = JRImage::imageWithImageProvider(std::make_shared<JRAccumulatorImageProvider>(_extent, _format, _columns, _tiles));
+	}
+	return _image;
+}
+
+void JRImageAccumulator::setImage(const JRImageRef& image)
+{
+	setImage(image, JRRectFromIRect(_extent));
+}
+
+void JRImageAccumulator::setImage(const JRImageRef& image, const JRRect& dirtyRect)
+{
+	JRIRect bounds = JRIRectIntersection(JRIRectFromRect(dirtyRect), _extent);
+	if (bounds.isEmpty()) {
+		return;
+	}
+	/// 只渲染脏矩形, 再拷进它覆盖的 tile
+	const size_t bpp = JRFormatBytesPerPixel(_format);
+	const size_t renderedRowBytes = size_t(bounds.width) * bpp;
+	std::vector<uint8_t> rendered(renderedRowBytes * size_t(bounds.height));
+	_context->render(image ? image : JRImage::emptyImage(), rendered.data(), renderedRowBytes, bounds, _format);
+
+	const int size = kJRImageAccumulatorTileSize;
+	int tx0 = (bounds.x - _extent.x) / size, tx1 = (bounds.maxX() - 1 - _extent.x) / size;
+	int ty0 = (bounds.y - _extent.y) / size, ty1 = (bounds.maxY() - 1 - _extent.y) / size;
+	for (int ty = ty0; ty <= ty1; ty++) {
+		for (int tx = tx0; tx <= tx1; tx++) {
+			size_t index = size_t(ty) * size_t(_columns) + size_t(tx);
+			JRIRect tile = tileRect(index);
+			JRIRect part = JRIRectIntersection(tile, bounds);
+			size_t rowBytes = size_t(tile.width) * bpp;
+			size_t bytes = rowBytes * size_t(tile.height);
+			/// 写时复制: 新 tile 从旧内容开始 (没有旧内容就是透明), 旧 tile 留给快照和撤销
+			std::shared_ptr<uint8_t> copy(new uint8_t[bytes], std::default_delete<uint8_t[]>());
+			if (part != tile) {
+				if (_tiles[index]) {
+					std::memcpy(copy.get(), _tiles[index].get(), bytes);
+				} else {
+					std::memset(copy.get(), 0, bytes);
+				}
+			}
+			for (int y = part.y; y < part.maxY(); y++) {
+				std::memcpy(copy.get() + size_t(y - tile.y) * rowBytes + size_t(part.x - tile.x) * bpp,
+							rendered.data() + size_t(y - bounds.y) * renderedRowBytes + size_t(part.x - bounds.x) * bpp,
+							size_t(part.width) * bpp);
+			}
+			replaceTile(index, std::move(copy));
+		}
+	}
+	_image.reset();
+	commitStep();
+}
+
+void JRImageAccumulator::clear()
+{
+	for (size_t i = 0; i < _tiles.size(); i++) {
+		if (_tiles[i]) {
+			replaceTile(i, nullptr);
+		}
+	}
+	_image.reset();
+	commitStep();
+}
+
+void JRImageAccumulator::replaceTile(size_t index, Tile tile)
+{
+	if (_undoLimit > 0 && !_recorded[index]) {
+		_recorded[index] = true;
+		_step.tiles.emplace_back(index, _tiles[index]);
+	}
+	_tiles[index] = std::move(tile);
+}
+
+void JRImageAccumulator::beginUndoGroup()
+{
+	_groupDepth++;
+}
+
+void JRImageAccumulator::endUndoGroup()
+{
+	if (_groupDepth > 0) {
+		_groupDepth--;
+		commitStep();
+	}
+}
+
+void JRImageAccumulator::commitStep()
+{
+	if (_groupDepth > 0 || _step.tiles.empty()) {
+		return;
+	}
+	for (const auto& entry : _step.tiles) {
+		_recorded[entry.first] = false;
+	}
+	_undo.push_back(std::move(_step));
+	_step = Step();
+	if (_undo.size() > _undoLimit) {
+		_undo.erase(_undo.begin());
+	}
+	_redo.clear();
+}
+
+void JRImageAccumulator::swapStep(std::vector<Step>& from, std::vector<Step>& to)
+{
+	Step step = std::move(from.back());
+	from.pop_back();
+	for (auto& entry : step.tiles) {
+		std::swap(_tiles[entry.first], entry.second);
+	}
+	to.push_back(std::move(step));
+	_image.reset();
+}
+
+bool JRImageAccumulator::undo()
+{
+	/// 组内的改动还没有成为一个步骤
+	if (_undo.empty() || _groupDepth > 0) {
+		return false;
+	}
+	swapStep(_undo, _redo);
+	return true;
+}
+
+bool JRImageAccumulator::redo()
+{
+	if (_redo.empty() || _groupDepth > 0) {
+		return false;
+	}
+	swapStep(_redo, _undo);
+	return true;
+}
+
+void JRImageAccumulator::setUndoLimit(size_t limit)
+{
+	_undoLimit = limit;
+	if (_undo.size() > limit) {
+		_undo.erase(_undo.begin(), _undo.end() - std::ptrdiff_t(limit));
+	}
+	if (limit == 0) {
+		for (const auto& entry : _step.tiles) {
+			_recorded[entry.first] = false;
+		}
+		_step = Step();
+		_redo.clear();
+	}
+}
+
+size_t JRImageAccumulator::historyBytes() const
+{
+	std::unordered_set<const uint8_t*> counted;
+	for (const Tile& tile : _tiles) {
+		counted.insert(tile.get());
+	}
+	size_t bytes = 0;
+	for (const std::vector<Step>* steps : { &_undo, &_redo }) {
+		for (const Step& step : *steps) {
+			for (const auto& entry : step.tiles) {
+				if (entry.second && counted.insert(entry.second.get()).second) {
+					JRIRect rect = tileRect(entry.first);
+					bytes += size_t(rect.width) * size_t(rect.height) * JRFormatBytesPerPixel(_format);
+				}
+			}
+		}
+	}
+	return bytes;
+}
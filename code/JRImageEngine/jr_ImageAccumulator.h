@@ -0,0 +1,121 @@
+//
+//  jr_ImageAccumulator.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_ImageAccumulator_h
+#define jr_ImageAccumulator_h
+
+#include "jr_Context.h"
+#include "jr_Format.h"
+#include "jr_Image.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/* Tiles of an accumulator are this many pixels square. */
+inline constexpr int kJRImageAccumulatorTileSize = 128;
+
+/* Feedback-based processing, the counterpart of CIImageAccumulator: the
+ * pixels of image() are rendered once and kept, so a recipe built on top of
+ * them (a brush composited over the canvas) does not grow with every
+ * stroke.
+ *
+ * The extent is stored as tiles of kJRImageAccumulatorTileSize pixels in
+ * 'format'. setImage(image, dirtyRect) renders only the dirty rect and
+ * replaces only the tiles it touches, so a brush dab costs its own area on
+ * any canvas size. Tiles are copy-on-write: image() returns a snapshot that
+ * shares them and stays valid after later changes, and the undo history
+ * keeps the replaced tiles of each step rather than whole frames. Tiles
+ * nothing was ever drawn into are not allocated.
+ *
+ * An accumulator is not thread-safe, but the images it returns are. */
+class JRImageAccumulator {
+public:
+	/* Returns nullptr for an empty extent. 'context' renders every update;
+	 * nullptr means a new default context. */
+	static std::shared_ptr<JRImageAccumulator> accumulatorWithExtent(const JRIRect& extent, JRFormat format = kJRFormatRGBAh,
+																	 const JRContextRef& context = nullptr);
+
+	const JRIRect& extent() const { return _extent; }
+	JRFormat format() const { return _format; }
+
+	/* The current contents, transparent where nothing was drawn. The image
+	 * is a snapshot and does not change when the accumulator does. */
+	JRImageRef image() const;
+
+	/* Replaces the whole extent with 'image'. */
+	void setImage(const JRImageRef& image);
+	/* Replaces the pixels under 'dirtyRect' (rounded out to whole pixels)
+	 * with those of 'image'. The rest of the extent keeps its pixels, whatever
+	 * 'image' holds there. */
+	void setImage(const JRImageRef& image, const JRRect& dirtyRect);
+	/* Makes the whole extent transparent. */
+	void clear();
+
+	/* Changes between beginUndoGroup() and the matching endUndoGroup() form
+	 * one undo step, such as all the dabs of a stroke. Groups nest. Outside a
+	 * group each setImage or clear is a step of its own. */
+	void beginUndoGroup();
+	void endUndoGroup();
+
+	bool canUndo() const { return !_undo.empty(); }
+	bool canRedo() const { return !_redo.empty(); }
+	/* Brings back the tiles of the last step. Returns false if there is
+	 * nothing to undo. A new change discards the steps that could be redone. */
+	bool undo();
+	bool redo();
+
+	/* The number of steps kept; older ones are dropped. 0 turns undo off.
+	 * The default is 64. */
+	size_t undoLimit() const { return _undoLimit; }
+	void setUndoLimit(size_t limit);
+
+	/* The bytes of tiles held only by the undo and redo history, for
+	 * showing the cost of a long session. */
+	size_t historyBytes() const;
+
+	typedef std::shared_ptr<const uint8_t> Tile;
+
+private:
+	/// 一个撤销步骤: 每个被替换的 tile 的下标和替换前的内容
+	struct Step {
+		std::vector<std::pair<size_t, Tile>> tiles;
+	};
+
+	JRImageAccumulator(const JRIRect& extent, JRFormat format, const JRContextRef& context);
+
+	JRIRect tileRect(size_t index) const;
+	/// 替换一个 tile, 并在当前步骤中记下旧的内容
+	void replaceTile(size_t index, Tile tile);
+	/// 结束当前步骤 (不在组内时)
+	void commitStep();
+	/// 把 from 中记录的 tile 换回去, 并在 to 中记下被换掉的内容
+	void swapStep(std::vector<Step>& from, std::vector<Step>& to);
+
+	JRIRect _extent;
+	JRFormat _format;
+	JRContextRef _context;
+	int _columns;
+	int _rows;
+	std::vector<Tile> _tiles;
+	/// image() 的快照, 内容改变时清空
+	mutable JRImageRef _image;
+
+	std::vector<Step> _undo;
+	std::vector<Step> _redo;
+	Step _step;
+	/// 当前步骤中已经记下的 tile
+	std::vector<bool> _recorded;
+	int _groupDepth;
+	size_t _undoLimit;
+};
+
+typedef std::shared_ptr<JRImageAccumulator> JRImageAccumulatorRef;
+
+#endif /* jr_ImageAccumulator_h */
@@ -0,0 +1,39 @@
+//
+//  jr_ImageEngine.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_ImageEngine_h
+#define jr_ImageEngine_h
+
+#include "jr_Buffer.h"
+#include "jr_Color.h"
+#include "jr_ColorCube.h"
+#include "jr_ColorSpace.h"
+#include "jr_Compositing.h"
+#include "jr_Context.h"
+#include "jr_FaceDetector.h"
+#include "jr_Filter.h"
+#include "jr_Format.h"
+#include "jr_GaussianBlur.h"
+#include "jr_Geometry.h"
+#include "jr_Image.h"
+#include "jr_ImageAccumulator.h"
+#include "jr_ImagePyramid.h"
+#include "jr_Kernel.h"
+#include "jr_MappedImageProvider.h"
+#include "jr_Morphology.h"
+#include "jr_Pipeline.h"
+#include "jr_Profiler.h"
+#include "jr_Recipe.h"
+#include "jr_Reduction.h"
+#include "jr_RenderBudget.h"
+#include "jr_SIMD.h"
+#include "jr_ScanlineImageProvider.h"
+#include "jr_Value.h"
+#include "jr_YUVFrame.h"
+
+#endif /* jr_ImageEngine_h */
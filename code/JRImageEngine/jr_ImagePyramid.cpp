@@ -0,0 +1,329 @@
+//
+//  jr_ImagePyramid.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_ImagePyramid.h"
+#include "jr_Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/// 每个任务大约读取的源行数
+static const int kJRPyramidRowBlock = 64;
+
+/// 第 level 层的大小, 不足一个块的边缘也算一个像素
+static JRIRect JRLevelRect(const JRIRect& sourceExtent, int level)
+{
+	int factor = 1 << level;
+	return { 0, 0, (sourceExtent.width + factor - 1) / factor, (sourceExtent.height + factor - 1) / factor };
+}
+
+/// 把 finer (第 from 层, 或 from == 0 时的源) 按 factor x factor 的块平均, 得到 coarse
+static JRBuffer JRReduceLevel(const JRImageProvider& source, const JRBuffer& finer, const JRIRect& finerRect, int factor)
+{
+	JRIRect coarse = { 0, 0, (finerRect.width + factor - 1) / factor, (finerRect.height + factor - 1) / factor };
+	JRBuffer output = JRBuffer::bufferWithRect(coarse);
+	const JRBuffer* pixels = finer.rect().isEmpty() ? source.pixels() : &finer;
+	size_t grain = size_t(std::max(1, kJRPyramidRowBlock / factor));
+	JRParallelFor(size_t(coarse.height), grain, [&](size_t begin, size_t end) {
+		int y0 = finerRect.y + int(begin) * factor;
+		int y1 = std::min(finerRect.y + int(end) * factor, finerRect.maxY());
+		JRIRect rows = { finerRect.x, y0, finerRect.width, y1 - y0 };
+		JRBuffer input;
+		if (pixels && pixels->rect().contains(rows)) {
+			input = pixels->view(rows);
+		} else {
+			input = JRBuffer::bufferWithRect(rows);
+			source.read(rows, input);
+		}
+		std::vector<float> sums(size_t(coarse.width) * 4);
+		for (size_t cy = begin; cy < end; cy++) {
+			int top = finerRect.y + int(cy) * factor;
+			int bottom = std::min(top + factor, y1);
+			std::fill(sums.begin(), sums.end(), 0.0f);
+			for (int y = top; y < bottom; y++) {
+				const float* p = input.rowAt(y);
+				for (int x = 0; x < finerRect.width; x++, p += 4) {
+					float* s = &sums[size_t(x / factor) * 4];
+					s[0] += p[0];
+					s[1] += p[1];
+					s[2] += p[2];
+					s[3] += p[3];
+				}
+			}
+			float* out = output.rowAt(int(cy));
+			for (int cx = 0; cx < coarse.width; cx++) {
+				int columns = std::min(factor, finerRect.width - cx * factor);
+				float inv = 1.0f / float(columns * (bottom - top));
+				for (int c = 0; c < 4; c++) {
+					out[cx * 4 + c] = sums[size_t(cx) * 4 + size_t(c)] * inv;
+				}
+			}
+		}
+	});
+	return output;
+}
+
+// MARK: - JRPyramidCache
+
+JRPyramidCache::JRPyramidCache(size_t budget)
+: _budget(budget), _bytes(0), _clock(0), _statistics()
+{
+}
+
+size_t JRPyramidCache::budget() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _budget;
+}
+
+void JRPyramidCache::setBudget(size_t budget)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_budget = budget;
+	evictToFit(budget);
+}
+
+JRImageRef JRPyramidCache::levelImage(const JRImage& source, int level)
+{
+	if (source.kind() != kJRImageKindProvider || level < 1 || level > kJRImagePyramidMaximumLevel) {
+		return nullptr;
+	}
+	const JRImageProviderRef& provider = source.provider();
+	const JRIRect extent = provider->extent();
+	const JRIRect rect = JRLevelRect(extent, level);
+	const size_t bytes = size_t(rect.area()) * 4 * sizeof(float);
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (extent.isEmpty() || bytes > _budget) {
+		return nullptr;
+	}
+	Pyramid& pyramid = _pyramids[provider.get()];
+	if (pyramid.source.lock() != provider) {
+		/// 新的 provider, 或者旧的已释放而地址被复用
+		for (const auto& entry : pyramid.levels) {
+			_bytes -= entry.second.bytes;
+		}
+		pyramid.levels.clear();
+		pyramid.source = provider;
+	}
+	auto found = pyramid.levels.find(level);
+	if (found != pyramid.levels.end()) {
+		found->second.lastUse = ++_clock;
+		_statistics.hits++;
+		return found->second.image;
+	}
+
+	/// 从已有的最细一层开始缩小, 没有就从源开始
+	int from = 0;
+	JRBuffer finer;
+	JRIRect finerRect = extent;
+	auto below = pyramid.levels.lower_bound(level);
+	if (below != pyramid.levels.begin()) {
+		--below;
+		from = below->first;
+		finer = *below->second.image->provider()->pixels();
+		finerRect = finer.rect();
+	}
+	JRBuffer buffer = JRReduceLevel(*provider, finer, finerRect, 1 << (level - from));
+
+	evictToFit(_budget - bytes);
+	/// 淘汰可能删除了其他 provider 的条目, pyramid 的引用仍然有效
+	Level& entry = pyramid.levels[level];
+	entry.image = JRImage::imageWithImageProvider(std::make_shared<JRBufferImageProvider>(buffer));
+	entry.bytes = bytes;
+	entry.lastUse = ++_clock;
+	_bytes += bytes;
+	_statistics.builds++;
+	return entry.image;
+}
+
+void JRPyramidCache::evictToFit(size_t budget)
+{
+	/// 先去掉 provider 已释放的条目
+	for (auto it = _pyramids.begin(); it != _pyramids.end();) {
+		if (it->second.source.expired()) {
+			for (const auto& entry : it->second.levels) {
+				_bytes -= entry.second.bytes;
+				_statistics.evictions++;
+			}
+			it = _pyramids.erase(it);
+		} else {
+			++it;
+		}
+	}
+	while (_bytes > budget) {
+		Pyramid* oldestPyramid = nullptr;
+		std::map<int, Level>::iterator oldest;
+		for (auto& pyramid : _pyramids) {
+			for (auto it = pyramid.second.levels.begin(); it != pyramid.second.levels.end(); ++it) {
+				if (!oldestPyramid || it->second.lastUse < oldest->second.lastUse) {
+					oldestPyramid = &pyramid.second;
+					oldest = it;
+				}
+			}
+		}
+		_bytes -= oldest->second.bytes;
+		oldestPyramid->levels.erase(oldest);
+		_statistics.evictions++;
+	}
+}
+
+void JRPyramidCache::removeAllEntries()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_pyramids.clear();
+	_bytes = 0;
+}
+
+JRPyramidCache::Statistics JRPyramidCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	Statistics statistics = _statistics;
+	statistics.levels = 0;
+	for (const auto& pyramid : _pyramids) {
+		statistics.levels += pyramid.second.levels.size();
+	}
+	statistics.bytes = _bytes;
+	return statistics;
+}
+
+// MARK: - Rewriting
+
+int JRImagePyramidLevel(const JRAffineTransform& t, const JRIRect& sourceExtent)
+{
+	if (!JRAffineTransformIsInvertible(t)) {
+		return 0;
+	}
+	/// 源的 x, y 方向各自缩放的倍数, 取缩小得少的那个
+	double scale = std::max(std::hypot(t.a, t.b), std::hypot(t.c, t.d));
+	int level = 0;
+	while (level < kJRImagePyramidMaximumLevel && double(2 << level) * scale <= 1 + 1e-9
+		   && (sourceExtent.width >> (level + 1)) > 0 && (sourceExtent.height >> (level + 1)) > 0) {
+		level++;
+	}
+	return level;
+}
+
+/// 缩小的变换: x, y 两个方向都缩小
+static bool JRIsDownscale(const JRAffineTransform& t)
+{
+	return JRAffineTransformIsInvertible(t) && std::max(std::hypot(t.a, t.b), std::hypot(t.c, t.d)) < 1;
+}
+
+class JRPyramidRewriter {
+public:
+	explicit JRPyramidRewriter(JRPyramidCache& cache)
+	: _cache(cache)
+	{
+	}
+
+	/// 整个图: 遇到缩小的变换就往下推
+	JRImageRef rewrite(const JRImageRef& image)
+	{
+		auto found = _rewritten.find(image.get());
+		if (found != _rewritten.end()) {
+			return found->second;
+		}
+		JRImageRef result;
+		if (image->kind() == kJRImageKindTransform && JRIsDownscale(image->transform())) {
+			result = pushDown(image->inputs()[0], image->transform());
+		} else {
+			result = rewriteInputs(image);
+		}
+		_rewritten[image.get()] = result;
+		return result;
+	}
+
+private:
+	JRImageRef rewriteInputs(const JRImageRef& image)
+	{
+		std::vector<JRImageRef> inputs;
+		bool changed = false;
+		for (const JRImageRef& input : image->inputs()) {
+			inputs.push_back(rewrite(input));
+			changed = changed || inputs.back() != input;
+		}
+		return changed ? image->imageByReplacingInputs(inputs) : image;
+	}
+
+	/// 与 image->applying(t) 等价的图, t 尽量靠近数据源
+	JRImageRef pushDown(const JRImageRef& image, const JRAffineTransform& t)
+	{
+		for (const auto& entry : _pushed[image.get()]) {
+			if (std::memcmp(&entry.first, &t, sizeof(t)) == 0) {
+				return entry.second;
+			}
+		}
+		/// 递归会插入新的条目, 之前取得的引用可能失效
+		JRImageRef result = pushDownUncached(image, t);
+		_pushed[image.get()].emplace_back(t, result);
+		return result;
+	}
+
+	JRImageRef pushDownUncached(const JRImageRef& image, const JRAffineTransform& t)
+	{
+		const bool axisAligned = t.b == 0 && t.c == 0;
+		switch (image->kind()) {
+			case kJRImageKindTransform:
+				return pushDown(image->inputs()[0], JRAffineTransformConcat(image->transform(), t));
+			case kJRImageKindProvider:
+				return readLevel(image, t);
+			case kJRImageKindCrop:
+				if (axisAligned) {
+					return pushDown(image->inputs()[0], t)->cropping(JRRectApplyAffineTransform(image->rect(), t));
+				}
+				break;
+			case kJRImageKindClamp:
+				if (axisAligned) {
+					return pushDown(image->inputs()[0], t)->clamping(JRRectApplyAffineTransform(image->rect(), t));
+				}
+				break;
+			case kJRImageKindKernel: {
+				/// 逐点的 kernel 与变换可交换; 其他 kernel 要能换算参数
+				JRKernelArguments args = image->arguments();
+				if (image->kernel()->type() == kJRKernelTypeGeneral
+					&& !static_cast<const JRGeneralKernel&>(*image->kernel()).transformArguments(t, image->arguments(), &args)) {
+					break;
+				}
+				std::vector<JRImageRef> inputs;
+				for (const JRImageRef& input : image->inputs()) {
+					inputs.push_back(pushDown(input, t));
+				}
+				return JRImage::imageWithKernel(image->kernel(), inputs, args);
+			}
+			default:
+				break;
+		}
+		return rewrite(image)->applying(t);
+	}
+
+	/// 数据源: 改为读取金字塔的一层, 再裁剪回原来的范围
+	JRImageRef readLevel(const JRImageRef& source, const JRAffineTransform& t)
+	{
+		JRIRect extent = source->provider()->extent();
+		int level = JRImagePyramidLevel(t, extent);
+		JRImageRef levelImage = level > 0 ? _cache.levelImage(*source, level) : nullptr;
+		if (!levelImage) {
+			return source->applying(t);
+		}
+		double factor = double(1 << level);
+		JRAffineTransform toSource = JRAffineTransformMake(factor, 0, 0, factor, extent.x, extent.y);
+		JRImageRef result = levelImage->applying(JRAffineTransformConcat(toSource, t));
+		return result->cropping(source->applying(t)->extent());
+	}
+
+	JRPyramidCache& _cache;
+	std::unordered_map<const JRImage*, JRImageRef> _rewritten;
+	std::unordered_map<const JRImage*, std::vector<std::pair<JRAffineTransform, JRImageRef>>> _pushed;
+};
+
+JRImageRef JRImageUsingPyramids(const JRImageRef& image, JRPyramidCache& cache)
+{
+	return image ? JRPyramidRewriter(cache).rewrite(image) : image;
+}
@@ -0,0 +1,102 @@
+//
+//  jr_ImagePyramid.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_ImagePyramid_h
+#define jr_ImagePyramid_h
+
+#include "jr_Buffer.h"
+#include "jr_Image.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/* The deepest pyramid level, 1 / 65536 of the source size. */
+inline constexpr int kJRImagePyramidMaximumLevel = 16;
+
+/* Downscaled copies of source images (provider nodes), kept between renders
+ * so that a preview of a large original costs about as much as the preview.
+ *
+ * Level k of a source averages blocks of 2^k x 2^k source pixels; blocks cut
+ * off by the edge average the pixels they have. Level pixel (i, j) covers the
+ * block whose corner is the source extent's origin plus 2^k * (i, j). A
+ * level is built on first use from the finest level already built, or from
+ * the source, so a 1/8 preview never creates the 1/2 level.
+ *
+ * Levels are evicted least recently used first. Entries follow the lifetime
+ * of their provider and are dropped once it is released. Levels are built
+ * under the cache lock, so concurrent renders of one source build it once.
+ * Thread-safe. */
+class JRPyramidCache {
+public:
+	struct Statistics {
+		size_t hits;
+		size_t builds;
+		size_t evictions;
+		size_t levels;
+		size_t bytes;
+	};
+
+	explicit JRPyramidCache(size_t budget);
+
+	size_t budget() const;
+	/* Evicts as needed to fit the new budget. */
+	void setBudget(size_t budget);
+
+	/* Level 'level' (1 to kJRImagePyramidMaximumLevel) of the provider image
+	 * 'source', in level coordinates: its extent starts at (0, 0). Returns
+	 * nullptr if 'source' is not a provider or the level does not fit the
+	 * budget. */
+	JRImageRef levelImage(const JRImage& source, int level);
+
+	void removeAllEntries();
+	Statistics statistics() const;
+
+private:
+	struct Level {
+		JRImageRef image;
+		size_t bytes;
+		uint64_t lastUse;
+	};
+	struct Pyramid {
+		/// 只用来判断 provider 是否还在, 地址可能被复用
+		std::weak_ptr<const JRImageProvider> source;
+		std::map<int, Level> levels;
+	};
+
+	void evictToFit(size_t budget);
+
+	mutable std::mutex _mutex;
+	std::unordered_map<const JRImageProvider*, Pyramid> _pyramids;
+	size_t _budget;
+	size_t _bytes;
+	uint64_t _clock;
+	Statistics _statistics;
+};
+
+/* The level of a pyramid that rendering a source through 't' should read:
+ * the coarsest level that still has at least one pixel per output pixel
+ * along both axes, or 0 when 't' does not shrink by half or more. */
+int JRImagePyramidLevel(const JRAffineTransform& t, const JRIRect& sourceExtent);
+
+/* 'image' with each downscaling applying(_:) moved as far down the graph as
+ * it goes, so the filters between it and the sources run at the smaller
+ * size, and each source below a downscale read from the pyramid level
+ * JRImagePyramidLevel picks. A transform moves below point-wise kernels,
+ * below general kernels that can transform their arguments (a Gaussian blur
+ * scales its sigma, see JRGeneralKernel::transformArguments), and, when it
+ * only scales and translates, below crops and clamps. Everything else stays
+ * where it was. The result differs from the exact render as much as a
+ * box-filtered downscale differs from a bilinear one, plus the change in
+ * where point-wise filters sample; it aliases less. Shared sub-graphs stay
+ * shared. */
+JRImageRef JRImageUsingPyramids(const JRImageRef& image, JRPyramidCache& cache);
+
+#endif /* jr_ImagePyramid_h */
@@ -0,0 +1,117 @@
+//
+//  jr_Kernel.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Kernel.h"
+#include "jr_FormatSIMD.h"
+
+JRKernel::JRKernel(const std::string& name)
+: _name(name)
+{
+}
+
+JRKernel::~JRKernel()
+{
+}
+
+JRRect JRKernel::extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments&) const
+{
+	JRRect extent = JRRectNull;
+	for (const JRRect& r : inputExtents) {
+		extent = JRRectUnion(extent, r);
+	}
+	return extent;
+}
+
+uint64_t JRKernel::hash() const
+{
+	return JRHashCombine(0, uint64_t(reinterpret_cast<uintptr_t>(this)));
+}
+
+bool JRKernel::isEqual(const JRKernel& other) const
+{
+	return this == &other;
+}
+
+JRColorKernel::JRColorKernel(const std::string& name, JRColorKernelFunction function, unsigned options)
+: JRKernel(name), _function(function), _options(options)
+{
+}
+
+void JRColorKernel::apply(float* pixels, const float* const* inputs, size_t count, const float* args) const
+{
+	if (operatesOnUnpremultiplied()) {
+		JRUnpremultiply(pixels, count);
+		_function(pixels, inputs, count, args);
+		JRPremultiply(pixels, count);
+	} else {
+		_function(pixels, inputs, count, args);
+	}
+}
+
+static void JRPremultiplyFunction(float* pixels, const float* const*, size_t count, const float*)
+{
+	JRPremultiply(pixels, count);
+}
+
+static void JRUnpremultiplyFunction(float* pixels, const float* const*, size_t count, const float*)
+{
+	JRUnpremultiply(pixels, count);
+}
+
+std::shared_ptr<const JRColorKernel> JRColorKernel::premultiplyKernel()
+{
+	static std::shared_ptr<const JRColorKernel> kernel = std::make_shared<JRColorKernel>("premultiply", JRPremultiplyFunction);
+	return kernel;
+}
+
+std::shared_ptr<const JRColorKernel> JRColorKernel::unpremultiplyKernel()
+{
+	static std::shared_ptr<const JRColorKernel> kernel = std::make_shared<JRColorKernel>("unpremultiply", JRUnpremultiplyFunction);
+	return kernel;
+}
+
+JRGeneralKernel::JRGeneralKernel(const std::string& name)
+: JRKernel(name)
+{
+}
+
+bool JRGeneralKernel::transformArguments(const JRAffineTransform&, const JRKernelArguments&, JRKernelArguments*) const
+{
+	return false;
+}
+
+void JRPremultiplyScalar(float* pixels, size_t count)
+{
+	for (size_t i = 0; i < count; i++, pixels += 4) {
+		float a = pixels[3];
+		pixels[0] *= a;
+		pixels[1] *= a;
+		pixels[2] *= a;
+	}
+}
+
+void JRUnpremultiplyScalar(float* pixels, size_t count)
+{
+	for (size_t i = 0; i < count; i++, pixels += 4) {
+		float a = pixels[3];
+		float inv = a > 0 ? 1.0f / a : 0.0f;
+		pixels[0] *= inv;
+		pixels[1] *= inv;
+		pixels[2] *= inv;
+	}
+}
+
+void JRPremultiply(float* pixels, size_t count)
+{
+	JRFormatActiveKernels().premultiply(pixels, count);
+}
+
+void JRUnpremultiply(float* pixels, size_t count)
+{
+	JRFormatActiveKernels().unpremultiply(pixels, count);
+}
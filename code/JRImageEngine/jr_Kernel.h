@@ -0,0 +1,122 @@
+//
+//  jr_Kernel.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Kernel_h
+#define jr_Kernel_h
+
+#include "jr_Buffer.h"
+#include "jr_Geometry.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef std::vector<float> JRKernelArguments;
+
+/* Mixes 'value' into 'seed', for the structural hashes of kernels and
+ * images. */
+inline uint64_t JRHashCombine(uint64_t seed, uint64_t value)
+{
+	/// splitmix64 的终结函数
+	uint64_t x = seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	return x ^ (x >> 31);
+}
+
+enum JRKernelType {
+	kJRKernelTypeColor = 0,
+	kJRKernelTypeGeneral,
+};
+
+/* A kernel is the per-pixel program behind a filter, like CIKernel. Kernels
+ * are immutable and shared between images. */
+class JRKernel {
+public:
+	explicit JRKernel(const std::string& name);
+	virtual ~JRKernel();
+
+	const std::string& name() const { return _name; }
+	virtual JRKernelType type() const = 0;
+
+	/* The extent of the output given the extents of the inputs. The default
+	 * is the union of the input extents. */
+	virtual JRRect extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments& args) const;
+
+	/* Identity for JRImage::structuralHash(). Kernels are normally shared
+	 * singletons, so the default is the address; kernels built on the fly
+	 * (like fused ones) describe what they compute instead. */
+	virtual uint64_t hash() const;
+	virtual bool isEqual(const JRKernel& other) const;
+
+private:
+	std::string _name;
+};
+
+typedef std::shared_ptr<const JRKernel> JRKernelRef;
+
+/* 'pixels' holds 'count' RGBA pixels of input 0 and receives the result in
+ * place. 'inputs' points at the pixels of inputs 1..n at the same positions. */
+typedef void (*JRColorKernelFunction)(float* pixels, const float* const* inputs, size_t count, const float* args);
+
+enum JRColorKernelOptions {
+	kJRColorKernelOptionNone = 0,
+	/* The function expects unpremultiplied pixels; the engine divides by alpha
+	 * before the call and multiplies after it. */
+	kJRColorKernelOptionUnpremultiplied = 1 << 0,
+};
+
+/* A point-wise kernel: each output pixel depends only on the input pixels at
+ * the same position, like CIColorKernel. */
+class JRColorKernel : public JRKernel {
+public:
+	JRColorKernel(const std::string& name, JRColorKernelFunction function, unsigned options = kJRColorKernelOptionNone);
+
+	JRKernelType type() const override { return kJRKernelTypeColor; }
+	JRColorKernelFunction function() const { return _function; }
+	unsigned options() const { return _options; }
+	bool operatesOnUnpremultiplied() const { return (_options & kJRColorKernelOptionUnpremultiplied) != 0; }
+
+	/* Runs the function over one span, handling premultiplication. */
+	virtual void apply(float* pixels, const float* const* inputs, size_t count, const float* args) const;
+
+	static std::shared_ptr<const JRColorKernel> premultiplyKernel();
+	static std::shared_ptr<const JRColorKernel> unpremultiplyKernel();
+
+private:
+	JRColorKernelFunction _function;
+	unsigned _options;
+};
+
+/* A kernel that samples a neighbourhood, like CIKernel with a ROI callback. */
+class JRGeneralKernel : public JRKernel {
+public:
+	explicit JRGeneralKernel(const std::string& name);
+
+	JRKernelType type() const override { return kJRKernelTypeGeneral; }
+
+	/* The rect of input 'index' needed to produce 'rect' of the output. */
+	virtual JRRect regionOfInterest(size_t index, const JRRect& rect, const JRKernelArguments& args) const = 0;
+
+	/* Produces 'output'. Each input buffer covers the integral ROI returned
+	 * for output.rect(). */
+	virtual void apply(const std::vector<JRBuffer>& inputs, const JRBuffer& output, const JRKernelArguments& args) const = 0;
+
+	/* The arguments with which this kernel, run on its inputs transformed by
+	 * 't', gives its own output transformed by 't'. A blur scales its radius.
+	 * This lets JRImageUsingPyramids move a downscale below the kernel, so the
+	 * kernel runs at the smaller size. The default returns false: the kernel
+	 * has no such arguments. */
+	virtual bool transformArguments(const JRAffineTransform& t, const JRKernelArguments& args, JRKernelArguments* transformed) const;
+};
+
+void JRPremultiply(float* pixels, size_t count);
+void JRUnpremultiply(float* pixels, size_t count);
+
+#endif /* jr_Kernel_h */
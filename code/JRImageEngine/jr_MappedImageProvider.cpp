@@ -0,0 +1,355 @@
+//
+//  jr_MappedImageProvider.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_MappedImageProvider.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+std::shared_ptr<const uint8_t> JRMapFile(const std::string& path, size_t* length)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return nullptr;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+		close(fd);
+		return nullptr;
+	}
+	size_t size = size_t(info.st_size);
+	void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	/// 映射建立后文件描述符就不再需要
+	close(fd);
+	if (address == MAP_FAILED) {
+		return nullptr;
+	}
+	if (length) {
+		*length = size;
+	}
+	return std::shared_ptr<const uint8_t>(static_cast<const uint8_t*>(address), [size](const uint8_t* p) {
+		munmap(const_cast<uint8_t*>(p), size);
+	});
+}
+
+static size_t JRSampleLayoutBytesPerPixel(JRSampleLayout layout, JRFormat format)
+{
+	switch (layout) {
+		case kJRSampleLayoutFormat: return JRFormatBytesPerPixel(format);
+		case kJRSampleLayoutRGB8: return 3;
+		case kJRSampleLayoutGray8: return 1;
+		case kJRSampleLayoutGrayAlpha8: return 2;
+	}
+	return 0;
+}
+
+JRMappedImageProvider::JRMappedImageProvider(std::shared_ptr<const uint8_t> bytes, std::vector<size_t> stripOffsets, int rowsPerStrip,
+											 size_t bytesPerRow, int width, int height, JRSampleLayout layout,
+											 JRFormat format, bool premultiplied)
+: _bytes(std::move(bytes)), _stripOffsets(std::move(stripOffsets)), _rowsPerStrip(rowsPerStrip > 0 ? rowsPerStrip : height),
+  _bytesPerRow(bytesPerRow), _width(width), _height(height), _layout(layout), _format(format), _premultiplied(premultiplied)
+{
+	/// 对齐的 premultiplied RGBAf 就是工作格式, 不用解包
+	const uint8_t* base = _stripOffsets.empty() ? nullptr : rowAt(0);
+	if (layout == kJRSampleLayoutFormat && format == kJRFormatRGBAf && premultiplied && _rowsPerStrip >= height
+		&& bytesPerRow % 16 == 0 && reinterpret_cast<uintptr_t>(base) % 16 == 0) {
+		float* pixels = reinterpret_cast<float*>(const_cast<uint8_t*>(base));
+		_pixels = JRBuffer::bufferWithPixels(pixels, bytesPerRow / sizeof(float), extent());
+	}
+}
+
+const uint8_t* JRMappedImageProvider::rowAt(int y) const
+{
+	return _bytes.get() + _stripOffsets[size_t(y / _rowsPerStrip)] + size_t(y % _rowsPerStrip) * _bytesPerRow;
+}
+
+JRIRect JRMappedImageProvider::extent() const
+{
+	return { 0, 0, _width, _height };
+}
+
+const JRBuffer* JRMappedImageProvider::pixels() const
+{
+	return _pixels.data() ? &_pixels : nullptr;
+}
+
+void JRMappedImageProvider::read(const JRIRect& rect, const JRBuffer& output) const
+{
+	const float scale = 1.0f / 255.0f;
+	size_t bpp = JRSampleLayoutBytesPerPixel(_layout, _format);
+	for (int y = rect.y; y < rect.maxY(); y++) {
+		const uint8_t* s = rowAt(y) + size_t(rect.x) * bpp;
+		float* d = output.rowAt(y);
+		switch (_layout) {
+			case kJRSampleLayoutFormat:
+				JRFormatUnpackRow(_format, s, d, size_t(rect.width));
+				break;
+			case kJRSampleLayoutRGB8:
+				for (int x = 0; x < rect.width; x++, s += 3, d += 4) {
+					d[0] = s[0] * scale;
+					d[1] = s[1] * scale;
+					d[2] = s[2] * scale;
+					d[3] = 1.0f;
+				}
+				break;
+			case kJRSampleLayoutGray8:
+				for (int x = 0; x < rect.width; x++, s++, d += 4) {
+					d[0] = d[1] = d[2] = s[0] * scale;
+					d[3] = 1.0f;
+				}
+				break;
+			case kJRSampleLayoutGrayAlpha8:
+				for (int x = 0; x < rect.width; x++, s += 2, d += 4) {
+					d[0] = d[1] = d[2] = s[0] * scale;
+					d[3] = s[1] * scale;
+				}
+				break;
+		}
+		if (!_premultiplied) {
+			JRPremultiply(output.rowAt(y), size_t(rect.width));
+		}
+	}
+}
+
+// MARK: - File formats
+
+/* The parts of a file header the provider needs. */
+struct JRMappedLayout {
+	std::vector<size_t> stripOffsets;
+	int rowsPerStrip;
+	int width;
+	int height;
+	JRSampleLayout layout;
+	JRFormat format;
+	bool premultiplied;
+};
+
+/// PNM 头部的下一个整数, 跳过空白和注释
+static bool JRReadHeaderInteger(const uint8_t* bytes, size_t length, size_t& offset, int& value)
+{
+	while (offset < length && (isspace(bytes[offset]) || bytes[offset] == '#')) {
+		if (bytes[offset] == '#') {
+			while (offset < length && bytes[offset] != '\n') {
+				offset++;
+			}
+		} else {
+			offset++;
+		}
+	}
+	if (offset >= length || !isdigit(bytes[offset])) {
+		return false;
+	}
+	long long v = 0;
+	while (offset < length && isdigit(bytes[offset]) && v <= 0x7fffffff) {
+		v = v * 10 + (bytes[offset++] - '0');
+	}
+	value = int(v);
+	return v <= 0x7fffffff;
+}
+
+static bool JRParsePNM(const uint8_t* bytes, size_t length, JRMappedLayout& layout)
+{
+	if (length < 3 || bytes[0] != 'P' || (bytes[1] != '5' && bytes[1] != '6')) {
+		return false;
+	}
+	size_t offset = 2;
+	int maxval = 0;
+	if (!JRReadHeaderInteger(bytes, length, offset, layout.width) || !JRReadHeaderInteger(bytes, length, offset, layout.height)
+		|| !JRReadHeaderInteger(bytes, length, offset, maxval) || maxval != 255 || offset >= length || !isspace(bytes[offset])) {
+		return false;
+	}
+	/// maxval 之后恰好一个空白字符
+	layout.stripOffsets = { offset + 1 };
+	layout.rowsPerStrip = layout.height;
+	layout.layout = bytes[1] == '5' ? kJRSampleLayoutGray8 : kJRSampleLayoutRGB8;
+	layout.format = kJRFormatRGBA8;
+	layout.premultiplied = true;
+	return true;
+}
+
+static bool JRParsePAM(const uint8_t* bytes, size_t length, JRMappedLayout& layout)
+{
+	if (length < 3 || memcmp(bytes, "P7\n", 3) != 0) {
+		return false;
+	}
+	int depth = 0;
+	int maxval = 0;
+	std::string tupleType;
+	layout.width = layout.height = 0;
+	size_t offset = 3;
+	while (offset < length) {
+		size_t end = offset;
+		while (end < length && bytes[end] != '\n') {
+			end++;
+		}
+		std::string line(reinterpret_cast<const char*>(bytes) + offset, end - offset);
+		offset = end + 1;
+		if (line == "ENDHDR") {
+			break;
+		}
+		size_t space = line.find(' ');
+		std::string key = line.substr(0, space);
+		std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+		if (key == "WIDTH") {
+			layout.width = atoi(value.c_str());
+		} else if (key == "HEIGHT") {
+			layout.height = atoi(value.c_str());
+		} else if (key == "DEPTH") {
+			depth = atoi(value.c_str());
+		} else if (key == "MAXVAL") {
+			maxval = atoi(value.c_str());
+		} else if (key == "TUPLTYPE") {
+			tupleType = value;
+		}
+	}
+	if (offset > length || maxval != 255) {
+		return false;
+	}
+	/// PAM 的 alpha 不是预乘的
+	layout.stripOffsets = { offset };
+	layout.rowsPerStrip = layout.height;
+	layout.format = kJRFormatRGBA8;
+	layout.premultiplied = depth != 2 && depth != 4;
+	switch (depth) {
+		case 1: layout.layout = kJRSampleLayoutGray8; break;
+		case 2: layout.layout = kJRSampleLayoutGrayAlpha8; break;
+		case 3: layout.layout = kJRSampleLayoutRGB8; break;
+		case 4: layout.layout = kJRSampleLayoutFormat; break;
+		default: return false;
+	}
+	return true;
+}
+
+static bool JRParseTIFF(const uint8_t* bytes, size_t length, JRMappedLayout& layout)
+{
+	if (length < 8 || !((bytes[0] == 'I' && bytes[1] == 'I') || (bytes[0] == 'M' && bytes[1] == 'M'))) {
+		return false;
+	}
+	bool little = bytes[0] == 'I';
+	auto u16 = [&](size_t at) -> uint32_t {
+		return little ? uint32_t(bytes[at] | bytes[at + 1] << 8) : uint32_t(bytes[at] << 8 | bytes[at + 1]);
+	};
+	auto u32 = [&](size_t at) -> uint32_t {
+		return little ? u16(at) | u16(at + 2) << 16 : u16(at) << 16 | u16(at + 2);
+	};
+	if (u16(2) != 42) {
+		return false;
+	}
+	size_t ifd = u32(4);
+	if (ifd + 2 > length) {
+		return false;
+	}
+	size_t count = u16(ifd);
+	if (ifd + 2 + count * 12 > length) {
+		return false;
+	}
+
+	/// 只接受 SHORT 和 LONG; 超过 4 字节的值存在 offset 处
+	auto values = [&](size_t entry, std::vector<uint32_t>& out) -> bool {
+		uint32_t type = u16(entry + 2);
+		uint32_t n = u32(entry + 4);
+		size_t size = type == 3 ? 2 : type == 4 ? 4 : 0;
+		if (size == 0 || n == 0 || n > length / size) {
+			return false;
+		}
+		size_t at = n * size <= 4 ? entry + 8 : u32(entry + 8);
+		if (at + n * size > length) {
+			return false;
+		}
+		out.resize(n);
+		for (uint32_t i = 0; i < n; i++) {
+			out[i] = size == 2 ? u16(at + i * 2) : u32(at + i * 4);
+		}
+		return true;
+	};
+
+	std::vector<uint32_t> width, height, bits, compression, photometric, offsets, samples, rows, planar, extra;
+	for (size_t i = 0; i < count; i++) {
+		size_t entry = ifd + 2 + i * 12;
+		std::vector<uint32_t>* target = nullptr;
+		switch (u16(entry)) {
+			case 256: target = &width; break;
+			case 257: target = &height; break;
+			case 258: target = &bits; break;
+			case 259: target = &compression; break;
+			case 262: target = &photometric; break;
+			case 273: target = &offsets; break;
+			case 277: target = &samples; break;
+			case 278: target = &rows; break;
+			case 284: target = &planar; break;
+			case 338: target = &extra; break;
+		}
+		if (target && !values(entry, *target)) {
+			return false;
+		}
+	}
+
+	uint32_t spp = samples.empty() ? 1 : samples[0];
+	if (width.empty() || height.empty() || offsets.empty() || width[0] > 0x7fffffff || height[0] > 0x7fffffff
+		|| (!compression.empty() && compression[0] != 1) || (!planar.empty() && planar[0] != 1) || photometric.empty()) {
+		return false;
+	}
+	for (uint32_t b : bits) {
+		if (b != 8) {
+			return false;
+		}
+	}
+	bool gray = photometric[0] == 1;
+	if (!(gray ? spp == 1 || spp == 2 : photometric[0] == 2 && (spp == 3 || spp == 4))) {
+		return false;
+	}
+	layout.width = int(width[0]);
+	layout.height = int(height[0]);
+	layout.rowsPerStrip = rows.empty() || rows[0] > height[0] ? layout.height : int(rows[0]);
+	layout.stripOffsets.assign(offsets.begin(), offsets.end());
+	layout.layout = spp == 1 ? kJRSampleLayoutGray8 : spp == 2 ? kJRSampleLayoutGrayAlpha8 : spp == 3 ? kJRSampleLayoutRGB8 : kJRSampleLayoutFormat;
+	layout.format = kJRFormatRGBA8;
+	/// ExtraSamples 1 表示预乘 (associated) alpha
+	layout.premultiplied = (spp != 2 && spp != 4) || (!extra.empty() && extra[0] == 1);
+	return true;
+}
+
+std::shared_ptr<JRMappedImageProvider> JRMappedImageProvider::providerWithContentsOfFile(const std::string& path)
+{
+	size_t length = 0;
+	std::shared_ptr<const uint8_t> bytes = JRMapFile(path, &length);
+	if (!bytes) {
+		return nullptr;
+	}
+	JRMappedLayout layout;
+	if (!JRParsePNM(bytes.get(), length, layout) && !JRParsePAM(bytes.get(), length, layout)
+		&& !JRParseTIFF(bytes.get(), length, layout)) {
+		return nullptr;
+	}
+	if (layout.width <= 0 || layout.height <= 0 || layout.rowsPerStrip <= 0) {
+		return nullptr;
+	}
+
+	/// 每个 strip 都必须完整地落在文件里
+	size_t bytesPerRow = size_t(layout.width) * JRSampleLayoutBytesPerPixel(layout.layout, layout.format);
+	size_t strips = (size_t(layout.height) + size_t(layout.rowsPerStrip) - 1) / size_t(layout.rowsPerStrip);
+	if (layout.stripOffsets.size() < strips) {
+		return nullptr;
+	}
+	for (size_t i = 0; i < strips; i++) {
+		size_t rowCount = std::min(size_t(layout.rowsPerStrip), size_t(layout.height) - i * size_t(layout.rowsPerStrip));
+		if (layout.stripOffsets[i] > length || rowCount * bytesPerRow > length - layout.stripOffsets[i]) {
+			return nullptr;
+		}
+	}
+	return std::make_shared<JRMappedImageProvider>(std::move(bytes), std::move(layout.stripOffsets), layout.rowsPerStrip,
+												   bytesPerRow, layout.width, layout.height, layout.layout, layout.format,
+												   layout.premultiplied);
+}
@@ -0,0 +1,74 @@
+//
+//  jr_MappedImageProvider.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_MappedImageProvider_h
+#define jr_MappedImageProvider_h
+
+#include "jr_Image.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/* How the samples of a JRMappedImageProvider are laid out. */
+enum JRSampleLayout {
+	/// JRFormat 中的格式, 见 JRMappedImageProvider 的构造函数
+	kJRSampleLayoutFormat = 0,
+	kJRSampleLayoutRGB8,
+	kJRSampleLayoutGray8,
+	kJRSampleLayoutGrayAlpha8,
+};
+
+/* Maps 'path' read-only. The memory is unmapped when the last copy of the
+ * pointer is released. Returns nullptr if the file cannot be mapped. */
+std::shared_ptr<const uint8_t> JRMapFile(const std::string& path, size_t* length);
+
+/* Reads pixels in place from memory it does not copy: a mapped file or a
+ * caller-owned buffer. 'bytes' owns that memory; the provider, and every
+ * image and render using it, keep it alive, and its deleter runs after the
+ * last of them.
+ *
+ * Rows may be split into strips, as in TIFF: row y starts at
+ * bytes + stripOffsets[y / rowsPerStrip] + (y % rowsPerStrip) * bytesPerRow.
+ * Tiles unpack only the rows and columns they touch, straight from there.
+ * Premultiplied kJRFormatRGBAf rows that are 16-byte aligned are not even
+ * unpacked: pixels() exposes them and kernels read them in place. */
+class JRMappedImageProvider : public JRImageProvider {
+public:
+	JRMappedImageProvider(std::shared_ptr<const uint8_t> bytes, std::vector<size_t> stripOffsets, int rowsPerStrip,
+						  size_t bytesPerRow, int width, int height, JRSampleLayout layout,
+						  JRFormat format = kJRFormatRGBA8, bool premultiplied = true);
+
+	/* A provider for an uncompressed image file, mapped rather than read:
+	 *  - binary PGM and PPM (P5, P6) and PAM (P7) with a maxval of 255;
+	 *  - baseline TIFF, uncompressed, 8-bit gray or RGB(A), chunky.
+	 * Returns nullptr for anything else. */
+	static std::shared_ptr<JRMappedImageProvider> providerWithContentsOfFile(const std::string& path);
+
+	JRIRect extent() const override;
+	void read(const JRIRect& rect, const JRBuffer& output) const override;
+	const JRBuffer* pixels() const override;
+
+private:
+	const uint8_t* rowAt(int y) const;
+
+	std::shared_ptr<const uint8_t> _bytes;
+	std::vector<size_t> _stripOffsets;
+	int _rowsPerStrip;
+	size_t _bytesPerRow;
+	int _width;
+	int _height;
+	JRSampleLayout _layout;
+	JRFormat _format;
+	bool _premultiplied;
+	JRBuffer _pixels;
+};
+
+#endif /* jr_MappedImageProvider_h */
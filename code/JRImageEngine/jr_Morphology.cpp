@@ -0,0 +1,318 @@
+//
+//  jr_Morphology.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Morphology.h"
+#include "jr_BufferPool.h"
+#include "jr_Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+/// 每个任务处理的行数 (列数), 同时也是转置的分块大小
+static const size_t kJRMorphologyBlock = 16;
+/// 中值滤波每个任务至少处理的列数
+static const int kJRMedianStrip = 64;
+/// 中值的直方图: 256 个细分 bin, 每 16 个合成一个粗 bin
+static const int kJRMedianBins = 256;
+static const int kJRMedianCoarseBins = 16;
+
+/// 转置 rows x cols 个像素, 按 16 x 16 分块以留在 L1 中
+static void JRTransposePixels(const float* src, size_t srcRowFloats, float* dst, size_t dstRowFloats, size_t rows, size_t cols)
+{
+	for (size_t x0 = 0; x0 < cols; x0 += kJRMorphologyBlock) {
+		size_t x1 = std::min(x0 + kJRMorphologyBlock, cols);
+		for (size_t y = 0; y < rows; y++) {
+			const float* s = src + y * srcRowFloats + x0 * 4;
+			for (size_t x = x0; x < x1; x++, s += 4) {
+				std::memcpy(dst + x * dstRowFloats + y * 4, s, 4 * sizeof(float));
+			}
+		}
+	}
+}
+
+// MARK: - van Herk/Gil-Werman
+
+struct JRMinimumOperation {
+	static float apply(float a, float b) { return a < b ? a : b; }
+};
+
+struct JRMaximumOperation {
+	static float apply(float a, float b) { return a > b ? a : b; }
+};
+
+/// 一行 (或转置后的一列) 的最小/最大值: src 有 count + 2r 个像素.
+/// 按 2r + 1 分块, g 是块内的前缀, h 是块内的后缀, 窗口 [i, i + 2r] 最多跨两块, 结果为 op(h[i], g[i + 2r])
+template <typename Op>
+static void JRMorphologyLine(int r, const float* src, float* dst, size_t count, float* g, float* h)
+{
+	const size_t window = size_t(2 * r + 1);
+	const size_t n = count + 2 * size_t(r);
+	for (size_t i = 0; i < n; i++) {
+		for (int c = 0; c < 4; c++) {
+			g[i * 4 + size_t(c)] = i % window == 0 ? src[i * 4 + size_t(c)] : Op::apply(g[(i - 1) * 4 + size_t(c)], src[i * 4 + size_t(c)]);
+		}
+	}
+	for (size_t i = n; i-- > 0;) {
+		bool last = i % window == window - 1 || i == n - 1;
+		for (int c = 0; c < 4; c++) {
+			h[i * 4 + size_t(c)] = last ? src[i * 4 + size_t(c)] : Op::apply(h[(i + 1) * 4 + size_t(c)], src[i * 4 + size_t(c)]);
+		}
+	}
+	const float* e = g + 2 * size_t(r) * 4;
+	for (size_t i = 0; i < count * 4; i++) {
+		dst[i] = Op::apply(h[i], e[i]);
+	}
+}
+
+template <typename Op>
+static void JRMorphology(const JRBuffer& input, const JRBuffer& output, int rx, int ry)
+{
+	const JRIRect& out = output.rect();
+	const JRIRect span = { out.x - rx, out.y - ry, out.width + 2 * rx, out.height + 2 * ry };
+	const size_t width = size_t(out.width);
+	const size_t height = size_t(out.height);
+
+	/// 行方向的结果转置存放: 第 x 行是输出的第 x 列, 列方向也就能连续读取
+	JRBuffer columns = JRBuffer::bufferWithRect({ span.y, out.x, span.height, out.width });
+
+	JRParallelFor(size_t(span.height), kJRMorphologyBlock, [&](size_t begin, size_t end) {
+		JRBuffer rows = JRBuffer::bufferWithRect({ 0, 0, out.width, int(end - begin) });
+		JRBuffer temp = JRBuffer::bufferWithRect({ 0, 0, 2 * span.width, 1 });
+		for (size_t j = begin; j < end; j++) {
+			JRMorphologyLine<Op>(rx, input.pixelAt(span.x, span.y + int(j)), rows.rowAt(int(j - begin)), width,
+								 temp.data(), temp.data() + size_t(span.width) * 4);
+		}
+		JRTransposePixels(rows.data(), rows.rowFloats(), columns.pixelAt(span.y + int(begin), out.x), columns.rowFloats(),
+						  end - begin, width);
+	});
+
+	JRParallelFor(width, kJRMorphologyBlock, [&](size_t begin, size_t end) {
+		JRBuffer lines = JRBuffer::bufferWithRect({ 0, 0, out.height, int(end - begin) });
+		JRBuffer temp = JRBuffer::bufferWithRect({ 0, 0, 2 * span.height, 1 });
+		for (size_t x = begin; x < end; x++) {
+			JRMorphologyLine<Op>(ry, columns.rowAt(out.x + int(x)), lines.rowAt(int(x - begin)), height,
+								 temp.data(), temp.data() + size_t(span.height) * 4);
+		}
+		JRTransposePixels(lines.data(), lines.rowFloats(), output.pixelAt(out.x + int(begin), out.y), output.rowFloats(),
+						  end - begin, height);
+	});
+}
+
+// MARK: - JRMorphologyKernel
+
+JRMorphologyKernel::JRMorphologyKernel(JRMorphologyOperation operation)
+: JRGeneralKernel(operation == kJRMorphologyMinimum ? "CIMorphologyRectangleMinimum" : "CIMorphologyRectangleMaximum")
+, _operation(operation)
+{
+}
+
+std::shared_ptr<const JRMorphologyKernel> JRMorphologyKernel::kernel(JRMorphologyOperation operation)
+{
+	static std::shared_ptr<const JRMorphologyKernel> minimum = std::make_shared<JRMorphologyKernel>(kJRMorphologyMinimum);
+	static std::shared_ptr<const JRMorphologyKernel> maximum = std::make_shared<JRMorphologyKernel>(kJRMorphologyMaximum);
+	return operation == kJRMorphologyMinimum ? minimum : maximum;
+}
+
+int JRMorphologyKernel::radius(double size)
+{
+	return size > 1 ? int(std::lround((size - 1) / 2)) : 0;
+}
+
+JRRect JRMorphologyKernel::extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments& args) const
+{
+	if (inputExtents.empty()) {
+		return JRRectNull;
+	}
+	/// 外面是透明的, 最小值不会超出输入的范围
+	if (_operation == kJRMorphologyMinimum) {
+		return inputExtents[0];
+	}
+	int rx = radius(args.size() > 0 ? args[0] : 0), ry = radius(args.size() > 1 ? args[1] : 0);
+	return JRRectInset(inputExtents[0], -rx, -ry);
+}
+
+JRRect JRMorphologyKernel::regionOfInterest(size_t, const JRRect& rect, const JRKernelArguments& args) const
+{
+	int rx = radius(args.size() > 0 ? args[0] : 0), ry = radius(args.size() > 1 ? args[1] : 0);
+	return JRRectInset(rect, -rx, -ry);
+}
+
+bool JRMorphologyKernel::transformArguments(const JRAffineTransform& t, const JRKernelArguments& args, JRKernelArguments* transformed) const
+{
+	/// 矩形只能随坐标轴方向的缩放变化
+	if (t.b != 0 || t.c != 0 || !JRAffineTransformIsInvertible(t) || args.size() < 2) {
+		return false;
+	}
+	*transformed = { float(args[0] * std::fabs(t.a)), float(args[1] * std::fabs(t.d)) };
+	return true;
+}
+
+void JRMorphologyKernel::apply(const std::vector<JRBuffer>& inputs, const JRBuffer& output, const JRKernelArguments& args) const
+{
+	int rx = radius(args.size() > 0 ? args[0] : 0), ry = radius(args.size() > 1 ? args[1] : 0);
+	if (_operation == kJRMorphologyMinimum) {
+		JRMorphology<JRMinimumOperation>(inputs[0], output, rx, ry);
+	} else {
+		JRMorphology<JRMaximumOperation>(inputs[0], output, rx, ry);
+	}
+}
+
+// MARK: - Median
+
+static inline int JRMedianBin(float v)
+{
+	float bin = v * 255.0f + 0.5f;
+	return bin <= 0 ? 0 : bin >= 255 ? 255 : int(bin);
+}
+
+/// 一条列 [x0, x1) 的一个通道. 列直方图覆盖 x0 - r 到 x1 + r, 方形的直方图沿行从左往右移动
+static void JRMedianStrip(const JRBuffer& input, const JRBuffer& output, int r, int x0, int x1, int channel,
+						  uint16_t* columnFine, uint16_t* columnCoarse)
+{
+	const JRIRect& out = output.rect();
+	const int columns = x1 - x0 + 2 * r;
+	const int window = 2 * r + 1;
+	const uint32_t half = uint32_t(window) * uint32_t(window) / 2 + 1;
+	std::memset(columnFine, 0, size_t(columns) * kJRMedianBins * sizeof(uint16_t));
+	std::memset(columnCoarse, 0, size_t(columns) * kJRMedianCoarseBins * sizeof(uint16_t));
+	auto update = [&](int y, int delta) {
+		const float* p = input.pixelAt(x0 - r, y) + channel;
+		for (int i = 0; i < columns; i++, p += 4) {
+			int bin = JRMedianBin(*p);
+			columnFine[size_t(i) * kJRMedianBins + size_t(bin)] += uint16_t(delta);
+			columnCoarse[size_t(i) * kJRMedianCoarseBins + size_t(bin >> 4)] += uint16_t(delta);
+		}
+	};
+	for (int y = out.y - r; y < out.y + r; y++) {
+		update(y, 1);
+	}
+
+	uint32_t coarse[kJRMedianCoarseBins];
+	uint32_t fine[kJRMedianBins];
+	/// fine 中每组 16 个 bin 对应的方形位置, -1 表示还没有计算
+	int current[kJRMedianCoarseBins];
+	for (int y = out.y; y < out.maxY(); y++) {
+		if (y > out.y) {
+			update(y - r - 1, -1);
+		}
+		update(y + r, 1);
+		std::fill(coarse, coarse + kJRMedianCoarseBins, 0u);
+		for (int i = 0; i < window; i++) {
+			for (int b = 0; b < kJRMedianCoarseBins; b++) {
+				coarse[b] += columnCoarse[size_t(i) * kJRMedianCoarseBins + size_t(b)];
+			}
+		}
+		std::fill(current, current + kJRMedianCoarseBins, -1);
+		float* o = output.pixelAt(x0, y) + channel;
+		for (int x = 0; x < x1 - x0; x++, o += 4) {
+			if (x > 0) {
+				const uint16_t* add = columnCoarse + size_t(x + 2 * r) * kJRMedianCoarseBins;
+				const uint16_t* remove = columnCoarse + size_t(x - 1) * kJRMedianCoarseBins;
+				for (int b = 0; b < kJRMedianCoarseBins; b++) {
+					coarse[b] += uint32_t(add[b]) - uint32_t(remove[b]);
+				}
+			}
+			uint32_t below = 0;
+			int group = 0;
+			while (below + coarse[group] < half) {
+				below += coarse[group++];
+			}
+			/// 只更新中值所在的一组: 离上次不远就逐列加减, 否则重新求和
+			uint32_t* f = fine + group * 16;
+			if (current[group] >= 0 && x - current[group] < window) {
+				for (int k = current[group] + 1; k <= x; k++) {
+					const uint16_t* add = columnFine + size_t(k + 2 * r) * kJRMedianBins + size_t(group) * 16;
+					const uint16_t* remove = columnFine + size_t(k - 1) * kJRMedianBins + size_t(group) * 16;
+					for (int b = 0; b < 16; b++) {
+						f[b] += uint32_t(add[b]) - uint32_t(remove[b]);
+					}
+				}
+			} else {
+				std::fill(f, f + 16, 0u);
+				for (int k = x; k < x + window; k++) {
+					const uint16_t* add = columnFine + size_t(k) * kJRMedianBins + size_t(group) * 16;
+					for (int b = 0; b < 16; b++) {
+						f[b] += add[b];
+					}
+				}
+			}
+			current[group] = x;
+			int bin = 0;
+			while (below + f[bin] < half) {
+				below += f[bin++];
+			}
+			*o = float(group * 16 + bin) * (1.0f / 255.0f);
+		}
+	}
+}
+
+JRMedianKernel::JRMedianKernel()
+: JRGeneralKernel("CIMedianFilter")
+{
+}
+
+std::shared_ptr<const JRMedianKernel> JRMedianKernel::kernel()
+{
+	static std::shared_ptr<const JRMedianKernel> kernel = std::make_shared<JRMedianKernel>();
+	return kernel;
+}
+
+static int JRMedianRadius(const JRKernelArguments& args)
+{
+	return args.empty() || !(args[0] > 0) ? 0 : int(std::lround(args[0]));
+}
+
+JRRect JRMedianKernel::extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments& args) const
+{
+	if (inputExtents.empty()) {
+		return JRRectNull;
+	}
+	int r = JRMedianRadius(args);
+	return JRRectInset(inputExtents[0], -r, -r);
+}
+
+JRRect JRMedianKernel::regionOfInterest(size_t, const JRRect& rect, const JRKernelArguments& args) const
+{
+	int r = JRMedianRadius(args);
+	return JRRectInset(rect, -r, -r);
+}
+
+bool JRMedianKernel::transformArguments(const JRAffineTransform& t, const JRKernelArguments& args, JRKernelArguments* transformed) const
+{
+	/// 方形窗口旋转后不再是方形, 只能随两轴相同的缩放变化
+	if (t.b != 0 || t.c != 0 || t.a == 0 || std::fabs(t.a) != std::fabs(t.d) || args.empty()) {
+		return false;
+	}
+	*transformed = { float(args[0] * std::fabs(t.a)) };
+	return true;
+}
+
+void JRMedianKernel::apply(const std::vector<JRBuffer>& inputs, const JRBuffer& output, const JRKernelArguments& args) const
+{
+	const int r = JRMedianRadius(args);
+	const JRIRect& out = output.rect();
+	const std::shared_ptr<JRBufferPool> pool = JRBufferPool::sharedPool();
+	/// 每条的列直方图要先累加 2r 行, 半径大时加宽以摊薄
+	const int stripWidth = std::max(kJRMedianStrip, 4 * r);
+	const size_t strips = (size_t(out.width) + size_t(stripWidth) - 1) / size_t(stripWidth);
+	JRParallelFor(strips, 1, [&](size_t begin, size_t end) {
+		size_t columns = size_t(stripWidth + 2 * r);
+		std::shared_ptr<float> histograms = pool->allocate(columns * (kJRMedianBins + kJRMedianCoarseBins) * sizeof(uint16_t));
+		uint16_t* columnFine = (uint16_t*)histograms.get();
+		uint16_t* columnCoarse = columnFine + columns * kJRMedianBins;
+		for (size_t strip = begin; strip < end; strip++) {
+			int x0 = out.x + int(strip) * stripWidth;
+			int x1 = std::min(x0 + stripWidth, out.maxX());
+			for (int channel = 0; channel < 4; channel++) {
+				JRMedianStrip(inputs[0], output, r, x0, x1, channel, columnFine, columnCoarse);
+			}
+		}
+	});
+}
@@ -0,0 +1,80 @@
+//
+//  jr_Morphology.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Morphology_h
+#define jr_Morphology_h
+
+#include "jr_Kernel.h"
+
+enum JRMorphologyOperation {
+	/* Erosion, CIMorphologyRectangleMinimum. */
+	kJRMorphologyMinimum = 0,
+	/* Dilation, CIMorphologyRectangleMaximum. */
+	kJRMorphologyMaximum,
+};
+
+/* The CIMorphologyRectangleMinimum and CIMorphologyRectangleMaximum kernels.
+ * args = [width, height] of the rectangle, rounded to the nearest odd number
+ * of pixels. Each channel of the output is the minimum or maximum of the
+ * premultiplied channel over the rectangle centred on the pixel.
+ *
+ * The rectangle is separable, and each axis uses the van Herk/Gil-Werman
+ * algorithm: three comparisons per pixel whatever the size. Pixels outside
+ * the input count as clear, so the minimum erodes from the edges of the
+ * extent and the maximum grows the extent by half the rectangle. Like the
+ * blur, the row and column passes are split across threads with
+ * JRParallelFor. */
+class JRMorphologyKernel : public JRGeneralKernel {
+public:
+	explicit JRMorphologyKernel(JRMorphologyOperation operation);
+
+	static std::shared_ptr<const JRMorphologyKernel> kernel(JRMorphologyOperation operation);
+
+	/* Half the rectangle side 'size', in pixels. */
+	static int radius(double size);
+
+	JRMorphologyOperation operation() const { return _operation; }
+
+	JRRect extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments& args) const override;
+	JRRect regionOfInterest(size_t index, const JRRect& rect, const JRKernelArguments& args) const override;
+	void apply(const std::vector<JRBuffer>& inputs, const JRBuffer& output, const JRKernelArguments& args) const override;
+	/* Scales the rectangle, for scales and translations. */
+	bool transformArguments(const JRAffineTransform& t, const JRKernelArguments& args, JRKernelArguments* transformed) const override;
+
+private:
+	JRMorphologyOperation _operation;
+};
+
+/* The CIMedianFilter kernel, extended with a radius. args = [radius]; a
+ * radius of 1 is the 3 x 3 median of Core Image. Each channel of the output
+ * is the median of the premultiplied channel over the square of side
+ * 2 * radius + 1, with pixels outside the input counted as clear.
+ *
+ * Values are ranked in 256 levels, so the result is exact for 8-bit content
+ * and within half a level otherwise, and clamped to [0, 1]. The square moves
+ * along a strip of columns with the histograms of Perreault and Hébert: one
+ * per column, updated by one pixel per row, and one for the square, updated
+ * by one column per pixel. A coarse level of 16 bins finds the median's bin
+ * group, and only that group's fine bins are brought up to date, so the cost
+ * per pixel does not depend on the radius. Strips run in parallel. */
+class JRMedianKernel : public JRGeneralKernel {
+public:
+	JRMedianKernel();
+
+	static std::shared_ptr<const JRMedianKernel> kernel();
+
+	JRRect extent(const std::vector<JRRect>& inputExtents, const JRKernelArguments& args) const override;
+	JRRect regionOfInterest(size_t index, const JRRect& rect, const JRKernelArguments& args) const override;
+	void apply(const std::vector<JRBuffer>& inputs, const JRBuffer& output, const JRKernelArguments& args) const override;
+	/* Scales the radius, for translations and scales that are the same on
+	 * both axes. A rotated square window is not a square, so rotations are
+	 * refused. */
+	bool transformArguments(const JRAffineTransform& t, const JRKernelArguments& args, JRKernelArguments* transformed) const override;
+};
+
+#endif /* jr_Morphology_h */
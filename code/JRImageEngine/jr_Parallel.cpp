@@ -0,0 +1,190 @@
+//
+//  jr_Parallel.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+
+struct JRThreadPool::Group {
+	std::atomic<size_t> pending;
+	std::mutex mutex;
+	std::condition_variable done;
+};
+
+struct JRThreadPool::Queue {
+	std::mutex mutex;
+	std::deque<Task> tasks;
+};
+
+/// 当前线程所属的池和队列
+static thread_local JRThreadPool* JRCurrentPool = nullptr;
+static thread_local size_t JRCurrentQueue = 0;
+
+JRThreadPool::JRThreadPool(size_t threadCount)
+: _queued(0), _stopping(false)
+{
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	for (size_t i = 0; i < threadCount; i++) {
+		_queues.push_back(std::unique_ptr<Queue>(new Queue()));
+	}
+	for (size_t i = 0; i + 1 < threadCount; i++) {
+		_threads.emplace_back(&JRThreadPool::workerMain, this, i);
+	}
+}
+
+JRThreadPool::~JRThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_wake.notify_all();
+	for (std::thread& thread : _threads) {
+		thread.join();
+	}
+}
+
+std::shared_ptr<JRThreadPool> JRThreadPool::sharedPool()
+{
+	static std::shared_ptr<JRThreadPool> pool = std::make_shared<JRThreadPool>();
+	return pool;
+}
+
+JRThreadPool* JRThreadPool::currentPool()
+{
+	return JRCurrentPool;
+}
+
+void JRThreadPool::workerMain(size_t index)
+{
+	JRCurrentPool = this;
+	JRCurrentQueue = index;
+	for (;;) {
+		if (runOne()) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(_mutex);
+		_wake.wait(lock, [this]() { return _stopping || _queued > 0; });
+		if (_stopping && _queued == 0) {
+			return;
+		}
+	}
+}
+
+bool JRThreadPool::runOne()
+{
+	const size_t count = _queues.size();
+	const size_t own = JRCurrentPool == this ? JRCurrentQueue : count - 1;
+	Task task;
+	bool found = false;
+	{
+		/// 自己的队列从尾部取, 刚放进去的数据还在缓存里
+		Queue& queue = *_queues[own];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = queue.tasks.back();
+			queue.tasks.pop_back();
+			found = true;
+		}
+	}
+	/// 从其他队列头部偷, 拿到的是最大最早的工作
+	for (size_t i = 1; !found && i < count; i++) {
+		Queue& queue = *_queues[(own + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = queue.tasks.front();
+			queue.tasks.pop_front();
+			found = true;
+		}
+	}
+	if (!found) {
+		return false;
+	}
+	_queued--;
+	runTask(task);
+	return true;
+}
+
+void JRThreadPool::runTask(const Task& task)
+{
+	(*task.body)(task.begin, task.end);
+	/// 加锁递减: 等待方看到 0 之后再加一次锁, 确保这里已经用完 group
+	std::lock_guard<std::mutex> lock(task.group->mutex);
+	if (--task.group->pending == 0) {
+		task.group->done.notify_all();
+	}
+}
+
+void JRThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body)
+{
+	grain = std::max<size_t>(grain, 1);
+	const size_t chunks = (count + grain - 1) / grain;
+
+	JRThreadPool* previousPool = JRCurrentPool;
+	size_t previousQueue = JRCurrentQueue;
+	if (JRCurrentPool != this) {
+		/// 池外的线程用最后一个队列, 嵌套的调用也会留在这个池里
+		JRCurrentPool = this;
+		JRCurrentQueue = _queues.size() - 1;
+	}
+
+	if (chunks <= 1 || _threads.empty()) {
+		for (size_t begin = 0; begin < count; begin += grain) {
+			body(begin, std::min(begin + grain, count));
+		}
+	} else {
+		Group group;
+		group.pending = chunks;
+		{
+			Queue& queue = *_queues[JRCurrentQueue];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			/// 倒序放入, 自己从尾部取时按顺序执行
+			for (size_t chunk = chunks - 1; chunk > 0; chunk--) {
+				queue.tasks.push_back({ &body, chunk * grain, std::min((chunk + 1) * grain, count), &group });
+			}
+		}
+		_queued += chunks - 1;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+		}
+		_wake.notify_all();
+
+		runTask({ &body, 0, std::min(grain, count), &group });
+		/// 等待时帮忙执行, 包括别的调用放进来的任务
+		while (group.pending > 0) {
+			if (!runOne()) {
+				std::unique_lock<std::mutex> lock(group.mutex);
+				group.done.wait_for(lock, std::chrono::microseconds(100), [&group]() { return group.pending == 0; });
+			}
+		}
+		std::lock_guard<std::mutex> lock(group.mutex);
+	}
+
+	JRCurrentPool = previousPool;
+	JRCurrentQueue = previousQueue;
+}
+
+size_t JRParallelThreadCount()
+{
+	JRThreadPool* pool = JRThreadPool::currentPool();
+	return pool ? pool->threadCount() : JRThreadPool::sharedPool()->threadCount();
+}
+
+void JRParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body)
+{
+	JRThreadPool* pool = JRThreadPool::currentPool();
+	if (pool) {
+		pool->parallelFor(count, grain, body);
+	} else {
+		JRThreadPool::sharedPool()->parallelFor(count, grain, body);
+	}
+}
@@ -0,0 +1,76 @@
+//
+//  jr_Parallel.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Parallel_h
+#define jr_Parallel_h
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* A work-stealing thread pool. Each worker owns a queue. It takes work from
+ * the back of its own queue and, when that is empty, steals from the front
+ * of the others. A thread waiting in parallelFor runs queued work while it
+ * waits, so nested calls (a tile that blurs in parallel) cannot deadlock. */
+class JRThreadPool {
+public:
+	/* 'threadCount' counts the calling thread, which always takes part, so a
+	 * pool of 1 runs everything on the caller. 0 means one per hardware
+	 * thread. */
+	explicit JRThreadPool(size_t threadCount = 0);
+	~JRThreadPool();
+
+	/* The pool used when no other is given, sized to the hardware. */
+	static std::shared_ptr<JRThreadPool> sharedPool();
+	/* The pool whose work the current thread is running, or nullptr. */
+	static JRThreadPool* currentPool();
+
+	size_t threadCount() const { return _threads.size() + 1; }
+
+	/* Calls 'body(begin, end)' for consecutive ranges of 'grain' items
+	 * covering [0, count), and returns when all of them are done. */
+	void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+private:
+	struct Group;
+	struct Task {
+		const std::function<void(size_t, size_t)>* body;
+		size_t begin;
+		size_t end;
+		Group* group;
+	};
+	struct Queue;
+
+	void workerMain(size_t index);
+	/// 取出一个任务并执行, 没有任务时返回 false
+	bool runOne();
+	void runTask(const Task& task);
+
+	/// 每个 worker 一个队列, 最后一个给池外的调用线程
+	std::vector<std::unique_ptr<Queue>> _queues;
+	std::vector<std::thread> _threads;
+	std::atomic<size_t> _queued;
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	bool _stopping;
+};
+
+/* The number of threads JRParallelFor uses: those of the current pool, or
+ * of the shared pool outside any. */
+size_t JRParallelThreadCount();
+
+/* parallelFor on the pool the current thread is working for, or on the
+ * shared pool. Kernels use this, so a context's threadCount limits them too. */
+void JRParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+#endif /* jr_Parallel_h */
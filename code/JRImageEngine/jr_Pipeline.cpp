@@ -0,0 +1,489 @@
+//
+//  jr_Pipeline.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Pipeline.h"
+#include "jr_GraphOptimizer.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+/* Stands for the input while a pipeline is compiled. Never rendered. */
+class JRPlaceholderImageProvider : public JRImageProvider {
+public:
+	explicit JRPlaceholderImageProvider(const JRIRect& extent) : _extent(extent) {}
+	JRIRect extent() const override { return _extent; }
+	void read(const JRIRect&, const JRBuffer& output) const override { output.clear(); }
+
+private:
+	JRIRect _extent;
+};
+
+/// 配方在两个大小不同的占位输入上各建一次, 依赖输入范围的参数在两次中不同
+static const JRIRect kJRPipelinePlaceholderExtent = { 0, 0, 1021, 769 };
+static const JRIRect kJRPipelineProbeExtent = { 0, 0, 1543, 1031 };
+
+/* Pairs the graphs a recipe built on two placeholders of different extents.
+ * They must match node for node, except crops and clamps to the
+ * placeholder's own extent, which are added to 'extentNodes' to be rebound
+ * to each input. Returns false if anything else differs, such as a rect or
+ * a transform computed from the extent. */
+static bool JRPairRecipeGraphs(const JRImage& image, const JRImage& probe, const JRImage& placeholder, const JRImage& probePlaceholder,
+							   std::unordered_map<const JRImage*, const JRImage*>& paired, std::unordered_set<const JRImage*>& extentNodes)
+{
+	auto found = paired.find(&image);
+	if (found != paired.end()) {
+		return found->second == &probe;
+	}
+	paired[&image] = &probe;
+	if (&image == &placeholder || &probe == &probePlaceholder) {
+		return &image == &placeholder && &probe == &probePlaceholder;
+	}
+	if (image.kind() != probe.kind() || image.inputs().size() != probe.inputs().size()) {
+		return false;
+	}
+	switch (image.kind()) {
+		case kJRImageKindEmpty:
+			break;
+		case kJRImageKindProvider:
+			/// 配方里新建的源 (例如水印) 每次都是新对象, 范围相同即可
+			if (image.provider() != probe.provider() && !JRRectEqualToRect(image.extent(), probe.extent())) {
+				return false;
+			}
+			break;
+		case kJRImageKindColor:
+			if (!(image.color() == probe.color())) {
+				return false;
+			}
+			break;
+		case kJRImageKindTransform: {
+			const JRAffineTransform& t = image.transform();
+			const JRAffineTransform& u = probe.transform();
+			if (t.a != u.a || t.b != u.b || t.c != u.c || t.d != u.d || t.tx != u.tx || t.ty != u.ty) {
+				return false;
+			}
+			break;
+		}
+		case kJRImageKindCrop:
+		case kJRImageKindClamp:
+			if (JRRectEqualToRect(image.rect(), probe.rect())) {
+				break;
+			}
+			if (!JRRectEqualToRect(image.rect(), placeholder.extent()) || !JRRectEqualToRect(probe.rect(), probePlaceholder.extent())) {
+				return false;
+			}
+			extentNodes.insert(&image);
+			break;
+		case kJRImageKindKernel:
+			if (!image.kernel()->isEqual(*probe.kernel()) || image.arguments() != probe.arguments()) {
+				return false;
+			}
+			break;
+	}
+	for (size_t i = 0; i < image.inputs().size(); i++) {
+		if (!JRPairRecipeGraphs(*image.inputs()[i], *probe.inputs()[i], placeholder, probePlaceholder, paired, extentNodes)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* A FIFO of at most 'capacity' items between two pipeline stages. */
+template <typename T>
+class JRBoundedQueue {
+public:
+	explicit JRBoundedQueue(size_t capacity) : _capacity(capacity > 0 ? capacity : 1), _open(true), _producers(1) {}
+
+	void setProducers(size_t producers)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_producers = producers;
+	}
+
+	/// 队列满时阻塞, 这就是反压
+	void push(T item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_notFull.wait(lock, [&] { return _items.size() < _capacity; });
+		_items.push_back(std::move(item));
+		_notEmpty.notify_one();
+	}
+
+	/// 队列为空且所有生产者都结束时返回 false
+	bool pop(T& item)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_notEmpty.wait(lock, [&] { return !_items.empty() || !_open; });
+		if (_items.empty()) {
+			return false;
+		}
+		item = std::move(_items.front());
+		_items.pop_front();
+		_notFull.notify_one();
+		return true;
+	}
+
+	void finishProducer()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (--_producers == 0) {
+			_open = false;
+			_notEmpty.notify_all();
+		}
+	}
+
+private:
+	std::mutex _mutex;
+	std::condition_variable _notEmpty;
+	std::condition_variable _notFull;
+	std::deque<T> _items;
+	size_t _capacity;
+	bool _open;
+	size_t _producers;
+};
+
+JRPipeline::JRPipeline(const JRImageRef& placeholder, const JRImageRef& output, const std::unordered_set<const JRImage*>& extentNodes,
+					   bool optimizesEachImage, const JRContextOptions& options)
+: _placeholder(placeholder), _output(output)
+{
+	/// 只有依赖输入的节点需要为每张图重建; 裁剪到输入范围的节点也依赖输入
+	std::unordered_map<const JRImage*, int> indices;
+	std::unordered_map<const JRImage*, bool> visited;
+	std::function<bool(const JRImage*)> visit = [&](const JRImage* image) -> bool {
+		if (image == placeholder.get()) {
+			return true;
+		}
+		auto found = visited.find(image);
+		if (found != visited.end()) {
+			return found->second;
+		}
+		Node node = { image, {}, extentNodes.count(image) > 0 };
+		bool depends = node.bindsExtent;
+		for (const JRImageRef& input : image->inputs()) {
+			bool inputDepends = visit(input.get());
+			node.slots.push_back(input == placeholder ? -1 : inputDepends ? indices[input.get()] : -2);
+			depends = depends || inputDepends;
+		}
+		visited[image] = depends;
+		if (depends) {
+			indices[image] = int(_nodes.size());
+			_nodes.push_back(node);
+		}
+		return depends;
+	};
+	visit(output.get());
+
+	/// 图已经优化过时, 每次渲染不再优化
+	JRContextOptions contextOptions = options;
+	contextOptions.optimizesGraph = optimizesEachImage;
+	_context = JRContext::context(contextOptions);
+}
+
+JRPipelineRef JRPipeline::pipelineWithRecipe(const JRPipelineRecipe& recipe, const JRContextOptions& options)
+{
+	JRImageRef placeholder = JRImage::imageWithImageProvider(std::make_shared<JRPlaceholderImageProvider>(kJRPipelinePlaceholderExtent));
+	JRImageRef probePlaceholder = JRImage::imageWithImageProvider(std::make_shared<JRPlaceholderImageProvider>(kJRPipelineProbeExtent));
+	JRImageRef output = recipe ? recipe(placeholder) : nullptr;
+	JRImageRef probe = recipe ? recipe(probePlaceholder) : nullptr;
+	if (!output || !probe) {
+		return nullptr;
+	}
+	if (!options.managesColor) {
+		output = JRImageRemovingColorMatching(output);
+		probe = JRImageRemovingColorMatching(probe);
+	}
+	/// 依赖输入范围的参数只能是裁剪到输入范围, 其余的无法为每张图重新计算
+	std::unordered_map<const JRImage*, const JRImage*> paired;
+	std::unordered_set<const JRImage*> extentNodes;
+	if (!JRPairRecipeGraphs(*output, *probe, *placeholder, *probePlaceholder, paired, extentNodes)) {
+		return nullptr;
+	}
+	/// 优化器会合并嵌套的裁剪, 裁剪到输入范围的图改为每张图优化一次.
+	/// 其余的图只优化一次, 前提是两个占位输入上优化出同样的图
+	bool optimizesEachImage = options.optimizesGraph && !extentNodes.empty();
+	if (options.optimizesGraph && extentNodes.empty()) {
+		JRImageRef optimized = JRGraphOptimizer(options.bakesColorCubes).optimize(output);
+		JRImageRef optimizedProbe = JRGraphOptimizer(options.bakesColorCubes).optimize(probe);
+		std::unordered_map<const JRImage*, const JRImage*> optimizedPairs;
+		if (JRPairRecipeGraphs(*optimized, *optimizedProbe, *placeholder, *probePlaceholder, optimizedPairs, extentNodes) && extentNodes.empty()) {
+			output = optimized;
+		} else {
+			extentNodes.clear();
+			optimizesEachImage = true;
+		}
+	}
+	JRPipelineRef pipeline(new JRPipeline(placeholder, output, extentNodes, optimizesEachImage, options));
+	if (output != placeholder && pipeline->_nodes.empty()) {
+		return nullptr;
+	}
+	return pipeline;
+}
+
+JRPipelineRef JRPipeline::pipelineWithFilters(const std::vector<std::pair<std::string, JRFilterParameters>>& filters,
+											  const JRContextOptions& options)
+{
+	return pipelineWithRecipe([&](const JRImageRef& input) {
+		JRImageRef image = input;
+		for (const std::pair<std::string, JRFilterParameters>& filter : filters) {
+			image = image ? image->applyingFilter(filter.first, filter.second) : nullptr;
+		}
+		return image;
+	}, options);
+}
+
+JRImageRef JRPipeline::imageWithInput(const JRImageRef& input) const
+{
+	if (!input) {
+		return nullptr;
+	}
+	if (_output == _placeholder) {
+		return input;
+	}
+	std::vector<JRImageRef> rebuilt(_nodes.size());
+	std::vector<JRImageRef> inputs;
+	for (size_t i = 0; i < _nodes.size(); i++) {
+		const Node& node = _nodes[i];
+		const std::vector<JRImageRef>& original = node.image->inputs();
+		inputs.resize(original.size());
+		for (size_t k = 0; k < original.size(); k++) {
+			int slot = node.slots[k];
+			inputs[k] = slot == -1 ? input : slot == -2 ? original[k] : rebuilt[size_t(slot)];
+		}
+		if (node.bindsExtent) {
+			rebuilt[i] = node.image->kind() == kJRImageKindCrop ? inputs[0]->cropping(input->extent()) : inputs[0]->clamping(input->extent());
+		} else {
+			rebuilt[i] = node.image->imageByReplacingInputs(inputs);
+		}
+	}
+	return rebuilt.back();
+}
+
+std::shared_ptr<JRBitmap> JRPipeline::render(const JRImageRef& input, JRFormat format) const
+{
+	JRImageRef image = imageWithInput(input);
+	return image ? _context->createBitmap(image, image->extent(), format) : nullptr;
+}
+
+size_t JRPipeline::processBatch(size_t count, const JRPipelineDecoder& decode, const JRPipelineEncoder& encode,
+								const JRPipelineBatchOptions& options) const
+{
+	typedef std::pair<size_t, JRImageRef> Decoded;
+	typedef std::pair<size_t, std::shared_ptr<JRBitmap>> Rendered;
+	size_t filterThreads = options.filterThreads > 0 ? size_t(options.filterThreads)
+		: std::max<size_t>(1, std::thread::hardware_concurrency());
+	JRBoundedQueue<Decoded> decoded(options.queueDepth);
+	JRBoundedQueue<Rendered> rendered(options.queueDepth);
+	rendered.setProducers(filterThreads);
+
+	std::thread decoder([&] {
+		for (size_t i = 0; i < count; i++) {
+			decoded.push({ i, decode(i) });
+		}
+		decoded.finishProducer();
+	});
+	std::vector<std::thread> filters;
+	for (size_t t = 0; t < filterThreads; t++) {
+		filters.emplace_back([&] {
+			Decoded item;
+			while (decoded.pop(item)) {
+				rendered.push({ item.first, render(item.second, options.format) });
+			}
+			rendered.finishProducer();
+		});
+	}
+
+	size_t encoded = 0;
+	Rendered item;
+	while (rendered.pop(item)) {
+		encode(item.first, item.second);
+		encoded += item.second ? 1 : 0;
+	}
+	decoder.join();
+	for (std::thread& thread : filters) {
+		thread.join();
+	}
+	return encoded;
+}
+
+// MARK: - JRVideoPipeline
+
+/// 静态图像先渲染一次, 之后当作像素读取. 范围无限、不是整像素或超出预算的保持原样
+static JRImageRef JRRenderStaticImage(const JRContext& context, const JRImageRef& image, size_t* budget)
+{
+	JRRect extent = image ? image->extent() : JRRectNull;
+	if (!image || image->kind() == kJRImageKindProvider || extent.isEmpty() || extent.isInfinite()
+		|| !JRRectEqualToRect(JRRectIntegral(extent), extent)) {
+		return image;
+	}
+	JRIRect rect = JRIRectFromRect(extent);
+	size_t bytes = size_t(rect.area()) * 4 * sizeof(float);
+	if (bytes > *budget) {
+		return image;
+	}
+	*budget -= bytes;
+	return JRImage::imageWithImageProvider(std::make_shared<JRBufferImageProvider>(context.render(image, rect)));
+}
+
+JRVideoPipelineRef JRVideoPipeline::videoPipelineWithNodes(const std::vector<JRVideoNode>& nodes, size_t staticBudget,
+															const JRContextOptions& options)
+{
+	if (nodes.empty()) {
+		return nullptr;
+	}
+	std::shared_ptr<JRVideoPipeline> pipeline(new JRVideoPipeline());
+	pipeline->_context = JRContext::context(options);
+
+	/// 每个节点或是静态图像, 或是 _dynamic 的下标; dependsOnFrame 记录是否依赖帧
+	std::vector<JRImageRef> staticImages(nodes.size());
+	std::vector<int> dynamicIndices(nodes.size(), -1);
+	std::vector<bool> dependsOnFrame(nodes.size(), false);
+	std::vector<bool> rendered(nodes.size(), false);
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const JRVideoNode& node = nodes[i];
+		JRFilterRef filter = JRFilter::filterWithName(node.filterName, node.parameters);
+		if (!filter) {
+			return nullptr;
+		}
+		bool dynamic = !node.animatedParameters.empty();
+		for (const std::pair<std::string, int>& input : node.imageInputs) {
+			if (input.second == kJRVideoFrameInput) {
+				dynamic = true;
+				dependsOnFrame[i] = true;
+			} else if (input.second < 0 || size_t(input.second) >= i) {
+				return nullptr;
+			} else if (dynamicIndices[size_t(input.second)] >= 0) {
+				dynamic = true;
+				dependsOnFrame[i] = dependsOnFrame[i] || dependsOnFrame[size_t(input.second)];
+			}
+		}
+		if (!dynamic) {
+			for (const std::pair<std::string, int>& input : node.imageInputs) {
+				filter->setValue(staticImages[size_t(input.second)], input.first);
+			}
+			staticImages[i] = filter->outputImage();
+			continue;
+		}
+
+		/// 静态的输入只设置一次, 先渲染成像素
+		Dynamic entry = { filter, {}, {} };
+		for (const std::pair<std::string, JRVideoParameter>& parameter : node.animatedParameters) {
+			entry.animatedParameters.emplace_back(JRFilterKeyForName(parameter.first), parameter.second);
+		}
+		for (const std::pair<std::string, int>& input : node.imageInputs) {
+			int source = input.second;
+			if (source == kJRVideoFrameInput) {
+				entry.inputs.emplace_back(JRFilterKeyForName(input.first), source);
+			} else if (dynamicIndices[size_t(source)] >= 0) {
+				entry.inputs.emplace_back(JRFilterKeyForName(input.first), dynamicIndices[size_t(source)]);
+			} else {
+				if (!rendered[size_t(source)]) {
+					JRImageRef image = JRRenderStaticImage(*pipeline->_context, staticImages[size_t(source)], &staticBudget);
+					pipeline->_renderedStaticCount += image != staticImages[size_t(source)] ? 1 : 0;
+					staticImages[size_t(source)] = image;
+					rendered[size_t(source)] = true;
+				}
+				filter->setValue(staticImages[size_t(source)], input.first);
+			}
+		}
+		dynamicIndices[i] = int(pipeline->_dynamic.size());
+		pipeline->_dynamic.push_back(std::move(entry));
+	}
+	if (!dependsOnFrame.back()) {
+		return nullptr;
+	}
+	return pipeline;
+}
+
+JRImageRef JRVideoPipeline::imageForFrame(const JRImageRef& frame, double time) const
+{
+	if (!frame) {
+		return nullptr;
+	}
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::vector<JRImageRef> outputs(_dynamic.size());
+	for (size_t i = 0; i < _dynamic.size(); i++) {
+		const Dynamic& node = _dynamic[i];
+		for (const std::pair<JRFilterKey, JRVideoParameter>& parameter : node.animatedParameters) {
+			node.filter->setValue(parameter.second(time), parameter.first);
+		}
+		for (const std::pair<JRFilterKey, int>& input : node.inputs) {
+			node.filter->setValue(input.second == kJRVideoFrameInput ? frame : outputs[size_t(input.second)], input.first);
+		}
+		outputs[i] = node.filter->outputImage();
+	}
+	return outputs.back();
+}
+
+size_t JRVideoPipeline::processFrames(size_t count, const JRPipelineDecoder& decode, const JRPipelineEncoder& encode,
+									  const JRVideoPipelineOptions& options) const
+{
+	/// 帧与输出图像; 帧为空表示跳过
+	typedef std::pair<size_t, std::pair<JRImageRef, JRImageRef>> Decoded;
+	const size_t inFlightLimit = std::max<size_t>(1, options.framesInFlight);
+	const size_t renderThreads = std::min(inFlightLimit, size_t(std::max(1u, std::thread::hardware_concurrency())));
+	JRBoundedQueue<Decoded> decoded(inFlightLimit);
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::map<size_t, std::shared_ptr<JRBitmap>> finished;
+	size_t inFlight = 0;
+
+	std::thread decoder([&] {
+		for (size_t i = 0; i < count; i++) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				changed.wait(lock, [&] { return inFlight < inFlightLimit; });
+				inFlight++;
+			}
+			JRImageRef frame = decode(i);
+			JRImageRef image = imageForFrame(frame, options.startTime + double(i) * options.frameDuration);
+			decoded.push({ i, { frame, image } });
+		}
+		decoded.finishProducer();
+	});
+	std::vector<std::thread> renderers;
+	for (size_t t = 0; t < renderThreads; t++) {
+		renderers.emplace_back([&] {
+			Decoded item;
+			while (decoded.pop(item)) {
+				const JRImageRef& frame = item.second.first;
+				const JRImageRef& image = item.second.second;
+				std::shared_ptr<JRBitmap> bitmap = image ? _context->createBitmap(image, frame->extent(), options.format) : nullptr;
+				std::lock_guard<std::mutex> lock(mutex);
+				finished[item.first] = bitmap;
+				changed.notify_all();
+			}
+		});
+	}
+
+	/// 按帧的顺序编码, 先完成的帧等待前面的帧
+	size_t encoded = 0;
+	for (size_t i = 0; i < count; i++) {
+		std::shared_ptr<JRBitmap> bitmap;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [&] { return finished.count(i) != 0; });
+			bitmap = std::move(finished[i]);
+			finished.erase(i);
+		}
+		encode(i, bitmap);
+		encoded += bitmap ? 1 : 0;
+		std::lock_guard<std::mutex> lock(mutex);
+		inFlight--;
+		changed.notify_all();
+	}
+	decoder.join();
+	for (std::thread& thread : renderers) {
+		thread.join();
+	}
+	return encoded;
+}
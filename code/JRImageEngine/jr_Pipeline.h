@@ -0,0 +1,197 @@
+//
+//  jr_Pipeline.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Pipeline_h
+#define jr_Pipeline_h
+
+#include "jr_Context.h"
+#include "jr_Filter.h"
+#include "jr_Image.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class JRPipeline;
+typedef std::shared_ptr<const JRPipeline> JRPipelineRef;
+
+/* Builds the recipe of a pipeline from its input. */
+typedef std::function<JRImageRef(const JRImageRef& input)> JRPipelineRecipe;
+/* Produces input 'index' of a batch, or nullptr to skip it. */
+typedef std::function<JRImageRef(size_t index)> JRPipelineDecoder;
+/* Consumes the output of input 'index'. 'bitmap' is nullptr if the input
+ * was skipped or its output extent is empty or infinite. */
+typedef std::function<void(size_t index, const std::shared_ptr<JRBitmap>& bitmap)> JRPipelineEncoder;
+
+struct JRPipelineBatchOptions {
+	JRFormat format = kJRFormatRGBA8;
+	/* Images that may wait between two stages. A full queue blocks the
+	 * stage before it, so at most about 2 x queueDepth + filterThreads
+	 * images are in flight. */
+	size_t queueDepth = 4;
+	/* Threads rendering images at the same time. 0 uses one per hardware
+	 * thread. Each render also splits its tiles over the context's pool. */
+	int filterThreads = 0;
+};
+
+/* A filter chain compiled once and applied to many inputs, for workloads
+ * such as thumbnailing where every image goes through the same filters with
+ * the same parameters.
+ *
+ * The recipe is built and optimised once, on a placeholder input. Applying
+ * the pipeline to an image rebuilds only the nodes that depend on the
+ * input, in a precomputed order, without looking up filters, parsing
+ * parameters or running JRGraphOptimizer again. Fused kernels are shared by
+ * every image.
+ *
+ * The recipe is also run on a second placeholder of another size, to find
+ * the parameters it derives from the input's extent. Crops and clamps to
+ * the input's extent, as in clampingToExtent() or cropping(input->extent()),
+ * are rebound to each input's extent; such a pipeline is optimised for each
+ * image instead of once. A recipe that derives anything else from the
+ * extent, such as a scale to fit or an inset crop, is rejected. */
+class JRPipeline {
+public:
+	/* Returns nullptr if 'recipe' does not use its input, or derives other
+	 * parameters than crops and clamps from the input's extent. */
+	static JRPipelineRef pipelineWithRecipe(const JRPipelineRecipe& recipe, const JRContextOptions& options = JRContextOptions());
+	/* Applies the filters in order, each to the output of the previous one.
+	 * Returns nullptr if a filter is not known. */
+	static JRPipelineRef pipelineWithFilters(const std::vector<std::pair<std::string, JRFilterParameters>>& filters,
+											 const JRContextOptions& options = JRContextOptions());
+
+	/* The compiled recipe applied to 'input'. */
+	JRImageRef imageWithInput(const JRImageRef& input) const;
+	/* Renders the extent of the pipeline applied to 'input'. Returns nullptr
+	 * for an empty or infinite extent. */
+	std::shared_ptr<JRBitmap> render(const JRImageRef& input, JRFormat format = kJRFormatRGBA8) const;
+
+	/* Runs inputs 0 ..< count through three stages at once: 'decode' on one
+	 * thread, rendering on 'filterThreads' threads, and 'encode' on the
+	 * calling thread, in the order renders finish. Bounded queues between
+	 * the stages apply backpressure, so a slow encoder stalls decoding
+	 * instead of piling up bitmaps. Returns the number of bitmaps encoded. */
+	size_t processBatch(size_t count, const JRPipelineDecoder& decode, const JRPipelineEncoder& encode,
+						const JRPipelineBatchOptions& options = JRPipelineBatchOptions()) const;
+
+	const JRContextRef& context() const { return _context; }
+
+private:
+	/// 依赖输入的节点, 按拓扑顺序; slots 中 -1 表示输入, -2 表示不变, 其余是 _nodes 的下标
+	struct Node {
+		const JRImage* image;
+		std::vector<int> slots;
+		/// 裁剪或 clamp 到输入的范围, 为每张图换成它的范围
+		bool bindsExtent;
+	};
+
+	JRPipeline(const JRImageRef& placeholder, const JRImageRef& output, const std::unordered_set<const JRImage*>& extentNodes,
+			   bool optimizesEachImage, const JRContextOptions& options);
+
+	JRImageRef _placeholder;
+	JRImageRef _output;
+	std::vector<Node> _nodes;
+	JRContextRef _context;
+};
+
+class JRVideoPipeline;
+typedef std::shared_ptr<const JRVideoPipeline> JRVideoPipelineRef;
+
+/* A filter parameter as a function of the frame time, in seconds. */
+typedef std::function<JRValue(double time)> JRVideoParameter;
+
+/* The input index of a JRVideoNode that stands for the current frame. */
+inline constexpr int kJRVideoFrameInput = -1;
+
+/* One filter of a video graph. */
+struct JRVideoNode {
+	std::string filterName;
+	/* Values that are the same for every frame. */
+	JRFilterParameters parameters;
+	/* Values evaluated for each frame, such as kJRInputTimeKey itself or
+	 * the offset of a film grain texture. */
+	std::vector<std::pair<std::string, JRVideoParameter>> animatedParameters;
+	/* Image inputs: the key and either the index of an earlier node or
+	 * kJRVideoFrameInput. */
+	std::vector<std::pair<std::string, int>> imageInputs;
+};
+
+struct JRVideoPipelineOptions {
+	JRFormat format = kJRFormatRGBA8;
+	/* Frame i is at startTime + i x frameDuration. */
+	double startTime = 0;
+	double frameDuration = 1.0 / 30.0;
+	/* Frames decoded but not yet encoded. The renders of up to this many
+	 * frames overlap, and decoding stalls while the encoder is behind. */
+	size_t framesInFlight = 3;
+};
+
+/* A graph of filters driven by time, applied to a sequence of frames, like
+ * the Old Film and transition recipes that animate kCIInputTimeKey.
+ *
+ * The graph is split once into three parts:
+ *  - static nodes depend on neither the frame nor the time, such as a
+ *    cropped noise texture or a vignette. They are evaluated once, and the
+ *    ones that feed the rest of the graph are rendered once, if their
+ *    extent is finite and fits 'staticBudget', and then read as pixels;
+ *  - time nodes depend on the time only, such as a texture moved by an
+ *    animated transform. They are evaluated for each frame;
+ *  - frame nodes depend on the frame.
+ * For each frame, only the time and frame nodes run their filters again,
+ * and only their animated parameters and image inputs change. Filters are
+ * looked up and their constant parameters set once. The rebuilt recipe
+ * still goes through JRGraphOptimizer each frame, because animated
+ * parameters can change what it bakes. */
+class JRVideoPipeline {
+public:
+	/* The last node is the output. Returns nullptr if a filter is not known,
+	 * an input refers to a later node, or the output does not depend on the
+	 * frame. */
+	static JRVideoPipelineRef videoPipelineWithNodes(const std::vector<JRVideoNode>& nodes, size_t staticBudget = 256 << 20,
+													 const JRContextOptions& options = JRContextOptions());
+
+	/* The graph applied to 'frame' at 'time'. Thread-safe; calls are
+	 * serialised because they share the filters. */
+	JRImageRef imageForFrame(const JRImageRef& frame, double time) const;
+
+	/* Runs frames 0 ..< count: 'decode' and imageForFrame on one thread,
+	 * renders of the frame's extent on up to framesInFlight threads, and
+	 * 'encode' on the calling thread, in frame order. Returns the number of
+	 * bitmaps encoded. */
+	size_t processFrames(size_t count, const JRPipelineDecoder& decode, const JRPipelineEncoder& encode,
+						 const JRVideoPipelineOptions& options = JRVideoPipelineOptions()) const;
+
+	/* Nodes whose filters run for every frame. */
+	size_t dynamicNodeCount() const { return _dynamic.size(); }
+	/* Static images rendered once at creation. */
+	size_t renderedStaticCount() const { return _renderedStaticCount; }
+	const JRContextRef& context() const { return _context; }
+
+private:
+	/// 每帧重新求值的节点. inputs 中 kJRVideoFrameInput 表示帧, 其余是 _dynamic 的下标. 键在构建时已经驻留
+	struct Dynamic {
+		JRFilterRef filter;
+		std::vector<std::pair<JRFilterKey, JRVideoParameter>> animatedParameters;
+		std::vector<std::pair<JRFilterKey, int>> inputs;
+	};
+
+	JRVideoPipeline() = default;
+
+	std::vector<Dynamic> _dynamic;
+	size_t _renderedStaticCount = 0;
+	JRContextRef _context;
+	/// 滤镜对象是可变的, 同一时间只能有一个线程求值
+	mutable std::mutex _mutex;
+};
+
+#endif /* jr_Pipeline_h */
@@ -0,0 +1,380 @@
+//
+//  jr_Profiler.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Profiler.h"
+#include "jr_BufferPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <unordered_set>
+
+/// 工作格式每个像素的字节数
+static const uint64_t kJRWorkingBytesPerPixel = 4 * sizeof(float);
+
+static const char* JRImageKindName(JRImageKind kind)
+{
+	switch (kind) {
+		case kJRImageKindEmpty:
+			return "empty";
+		case kJRImageKindProvider:
+			return "provider";
+		case kJRImageKindColor:
+			return "color";
+		case kJRImageKindTransform:
+			return "transform";
+		case kJRImageKindCrop:
+			return "crop";
+		case kJRImageKindClamp:
+			return "clamp";
+		case kJRImageKindKernel:
+			break;
+	}
+	return "kernel";
+}
+
+static std::string JRNodeName(const JRImage& image)
+{
+	return image.kind() == kJRImageKindKernel ? image.kernel()->name() : JRImageKindName(image.kind());
+}
+
+static JRProfiler::NodeStatistics JRZeroStatistics(const std::string& label)
+{
+	return { label, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+}
+
+static void JRAddStatistics(JRProfiler::NodeStatistics& to, const JRProfiler::NodeStatistics& from)
+{
+	to.tiles += from.tiles;
+	to.selfSeconds += from.selfSeconds;
+	to.totalSeconds += from.totalSeconds;
+	to.pixels += from.pixels;
+	to.bytesRead += from.bytesRead;
+	to.bytesWritten += from.bytesWritten;
+	to.cacheHits += from.cacheHits;
+	to.cacheMisses += from.cacheMisses;
+	to.allocations += from.allocations;
+	to.allocatedBytes += from.allocatedBytes;
+}
+
+static std::string JRJSONEscaped(const std::string& string)
+{
+	std::string result;
+	for (char c : string) {
+		if (c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		} else if (uint8_t(c) < 0x20) {
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", unsigned(c));
+			result += escaped;
+		} else {
+			result += c;
+		}
+	}
+	return result;
+}
+
+// MARK: - JRProfiler
+
+JRProfiler::JRProfiler(size_t eventLimit)
+: _eventLimit(eventLimit)
+, _origin(std::chrono::steady_clock::now())
+, _summary()
+{
+}
+
+std::shared_ptr<const std::unordered_map<const JRImage*, std::string>> JRProfiler::labelsForGraph(const JRImage& image)
+{
+	auto labels = std::make_shared<std::unordered_map<const JRImage*, std::string>>();
+	std::unordered_map<std::string, int> occurrences;
+	std::unordered_set<const JRImage*> visited;
+	/// 后序遍历, 与 JRRenderPlan 的顺序相同
+	std::function<void(const JRImage*)> visit = [&](const JRImage* node) {
+		for (const JRImageRef& input : node->inputs()) {
+			if (visited.insert(input.get()).second) {
+				visit(input.get());
+			}
+		}
+		std::string name = JRNodeName(*node);
+		int occurrence = ++occurrences[name];
+		(*labels)[node] = occurrence == 1 ? name : name + "#" + std::to_string(occurrence);
+	};
+	visited.insert(&image);
+	visit(&image);
+	return labels;
+}
+
+double JRProfiler::microsecondsSince(std::chrono::steady_clock::time_point time) const
+{
+	return std::chrono::duration<double, std::micro>(time - _origin).count();
+}
+
+void JRProfiler::merge(std::vector<NodeStatistics>& nodes, std::vector<Event>& events, const Summary& summary)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (const NodeStatistics& node : nodes) {
+		auto found = _nodes.find(node.label);
+		if (found == _nodes.end()) {
+			_nodes.emplace(node.label, node);
+		} else {
+			JRAddStatistics(found->second, node);
+		}
+	}
+	auto thread = _threads.emplace(std::this_thread::get_id(), uint32_t(_threads.size())).first->second;
+	for (Event& event : events) {
+		if (_events.size() >= _eventLimit) {
+			_summary.droppedEvents++;
+			continue;
+		}
+		event.thread = thread;
+		_events.push_back(std::move(event));
+	}
+	_summary.renders += summary.renders;
+	_summary.seconds += summary.seconds;
+	_summary.poolAllocations += summary.poolAllocations;
+	_summary.poolReuses += summary.poolReuses;
+	_summary.events = _events.size();
+}
+
+std::vector<JRProfiler::NodeStatistics> JRProfiler::nodeStatistics() const
+{
+	std::vector<NodeStatistics> result;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (const auto& node : _nodes) {
+			result.push_back(node.second);
+		}
+	}
+	std::sort(result.begin(), result.end(), [](const NodeStatistics& a, const NodeStatistics& b) {
+		return a.selfSeconds != b.selfSeconds ? a.selfSeconds > b.selfSeconds : a.label < b.label;
+	});
+	return result;
+}
+
+JRProfiler::Summary JRProfiler::summary() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _summary;
+}
+
+std::vector<JRProfiler::Event> JRProfiler::events() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _events;
+}
+
+void JRProfiler::reset()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_origin = std::chrono::steady_clock::now();
+	_nodes.clear();
+	_events.clear();
+	_threads.clear();
+	_summary = Summary();
+}
+
+std::string JRProfiler::chromeTrace() const
+{
+	std::vector<Event> events = this->events();
+	std::string json = "{\"traceEvents\":[";
+	char buffer[256];
+	for (size_t i = 0; i < events.size(); i++) {
+		const Event& event = events[i];
+		snprintf(buffer, sizeof(buffer), "\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"pixels\":%llu}}",
+				 event.category, event.start, event.duration, unsigned(event.thread), (unsigned long long)event.pixels);
+		json += i ? ",\n{\"name\":\"" : "\n{\"name\":\"";
+		json += JRJSONEscaped(event.name);
+		json += buffer;
+	}
+	json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return json;
+}
+
+bool JRProfiler::writeChromeTrace(const std::string& path) const
+{
+	std::string json = chromeTrace();
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) {
+		return false;
+	}
+	bool written = fwrite(json.data(), 1, json.size(), file) == json.size();
+	return fclose(file) == 0 && written;
+}
+
+std::string JRProfiler::report() const
+{
+	Summary summary = this->summary();
+	std::vector<NodeStatistics> nodes = nodeStatistics();
+	size_t width = 24;
+	for (const NodeStatistics& node : nodes) {
+		width = std::max(width, node.label.size());
+	}
+
+	char line[512];
+	snprintf(line, sizeof(line), "%zu renders, %.3f ms; buffer pool %zu allocations, %zu reuses; %zu events (%zu dropped)\n",
+			 summary.renders, summary.seconds * 1e3, summary.poolAllocations, summary.poolReuses, summary.events, summary.droppedEvents);
+	std::string report = line;
+	snprintf(line, sizeof(line), "%-*s %8s %10s %10s %10s %10s %10s %7s %7s %7s %10s\n", int(width), "node", "tiles", "self ms",
+			 "total ms", "Mpixels", "read MB", "write MB", "hits", "misses", "allocs", "alloc MB");
+	report += line;
+	for (const NodeStatistics& node : nodes) {
+		snprintf(line, sizeof(line), "%-*s %8zu %10.3f %10.3f %10.3f %10.3f %10.3f %7zu %7zu %7zu %10.3f\n", int(width),
+				 node.label.c_str(), node.tiles, node.selfSeconds * 1e3, node.totalSeconds * 1e3, double(node.pixels) / 1e6,
+				 double(node.bytesRead) / 1e6, double(node.bytesWritten) / 1e6, node.cacheHits, node.cacheMisses,
+				 node.allocations, double(node.allocatedBytes) / 1e6);
+		report += line;
+	}
+	return report;
+}
+
+// MARK: - JRProfileRecorder
+
+JRProfileRecorder::JRProfileRecorder(JRProfiler* profiler, const JRProfileLabelsRef& labels, const char* category, const std::string& name)
+: _profiler(profiler)
+, _category(category)
+, _poolAllocations(0)
+, _poolReuses(0)
+{
+	if (!_profiler) {
+		return;
+	}
+	_labels = labels;
+	_name = name.empty() ? category : name;
+	/// 只在整个渲染的层级上看 buffer pool, 它是共享的, 按 tile 看没有意义
+	if (std::string(category) == "render") {
+		JRBufferPool::Statistics statistics = JRBufferPool::sharedPool()->statistics();
+		_poolAllocations = statistics.allocations;
+		_poolReuses = statistics.reuses;
+	}
+	_start = std::chrono::steady_clock::now();
+}
+
+JRProfileRecorder::~JRProfileRecorder()
+{
+	if (!_profiler) {
+		return;
+	}
+	auto end = std::chrono::steady_clock::now();
+	JRProfiler::Summary summary = JRProfiler::Summary();
+	if (std::string(_category) == "render") {
+		JRBufferPool::Statistics statistics = JRBufferPool::sharedPool()->statistics();
+		summary.renders = 1;
+		summary.seconds = std::chrono::duration<double>(end - _start).count();
+		summary.poolAllocations = statistics.allocations - _poolAllocations;
+		summary.poolReuses = statistics.reuses - _poolReuses;
+	}
+
+	auto labelFor = [&](const JRImage* image) {
+		if (_labels) {
+			auto found = _labels->find(image);
+			if (found != _labels->end()) {
+				return found->second;
+			}
+		}
+		return JRNodeName(*image);
+	};
+	std::vector<JRProfiler::NodeStatistics> nodes;
+	nodes.reserve(_nodes.size());
+	for (auto& node : _nodes) {
+		node.second.label = labelFor(node.first);
+		nodes.push_back(std::move(node.second));
+	}
+
+	std::vector<JRProfiler::Event> events;
+	events.reserve(_events.size() + 1);
+	events.push_back({ _name, _category, _profiler->microsecondsSince(_start),
+					   std::chrono::duration<double, std::micro>(end - _start).count(), 0, 0 });
+	for (const NodeEvent& event : _events) {
+		events.push_back({ labelFor(event.image), "node", _profiler->microsecondsSince(event.start), event.duration * 1e6, 0, event.pixels });
+	}
+	_profiler->merge(nodes, events, summary);
+}
+
+JRProfiler::NodeStatistics& JRProfileRecorder::statisticsFor(const JRImage& image)
+{
+	auto found = _nodes.find(&image);
+	if (found == _nodes.end()) {
+		found = _nodes.emplace(&image, JRZeroStatistics(std::string())).first;
+	}
+	return found->second;
+}
+
+void JRProfileRecorder::beginNode()
+{
+	if (!_profiler) {
+		return;
+	}
+	_stack.push_back({ std::chrono::steady_clock::now(), 0, 0, 0, 0 });
+}
+
+void JRProfileRecorder::endNode(const JRImage& image, const JRIRect& rect)
+{
+	if (!_profiler || _stack.empty()) {
+		return;
+	}
+	auto end = std::chrono::steady_clock::now();
+	Frame frame = _stack.back();
+	_stack.pop_back();
+	double seconds = std::chrono::duration<double>(end - frame.start).count();
+	if (!_stack.empty()) {
+		_stack.back().childSeconds += seconds;
+	}
+
+	JRProfiler::NodeStatistics& statistics = statisticsFor(image);
+	uint64_t pixels = uint64_t(std::max<int64_t>(rect.area(), 0));
+	statistics.tiles++;
+	statistics.selfSeconds += std::max(seconds - frame.childSeconds, 0.0);
+	statistics.totalSeconds += seconds;
+	statistics.pixels += pixels;
+	statistics.bytesRead += frame.bytesRead;
+	statistics.bytesWritten += pixels * kJRWorkingBytesPerPixel;
+	statistics.allocations += frame.allocations;
+	statistics.allocatedBytes += frame.allocatedBytes;
+	_events.push_back({ &image, frame.start, seconds, pixels });
+}
+
+void JRProfileRecorder::recordRead(const JRIRect& rect)
+{
+	if (!_profiler || _stack.empty() || rect.isEmpty()) {
+		return;
+	}
+	_stack.back().bytesRead += uint64_t(rect.area()) * kJRWorkingBytesPerPixel;
+}
+
+void JRProfileRecorder::recordAllocation(const JRIRect& rect)
+{
+	if (!_profiler || _stack.empty() || rect.isEmpty()) {
+		return;
+	}
+	_stack.back().allocations++;
+	_stack.back().allocatedBytes += uint64_t(rect.area()) * kJRWorkingBytesPerPixel;
+}
+
+void JRProfileRecorder::recordAllocation(const JRImage& image, const JRIRect& rect)
+{
+	if (!_profiler || rect.isEmpty()) {
+		return;
+	}
+	JRProfiler::NodeStatistics& statistics = statisticsFor(image);
+	statistics.allocations++;
+	statistics.allocatedBytes += uint64_t(rect.area()) * kJRWorkingBytesPerPixel;
+}
+
+void JRProfileRecorder::recordCacheLookup(const JRImage& image, bool hit)
+{
+	if (!_profiler) {
+		return;
+	}
+	JRProfiler::NodeStatistics& statistics = statisticsFor(image);
+	if (hit) {
+		statistics.cacheHits++;
+	} else {
+		statistics.cacheMisses++;
+	}
+}
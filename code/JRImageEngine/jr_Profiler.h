@@ -0,0 +1,185 @@
+//
+//  jr_Profiler.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Profiler_h
+#define jr_Profiler_h
+
+#include "jr_Geometry.h"
+#include "jr_Image.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* Records where the time of a render goes, node by node. Set one as
+ * JRContextOptions::profiler and every render of that context is recorded,
+ * from any thread. Without a profiler the renderer does no more than test a
+ * null pointer per node.
+ *
+ * Nodes are recorded as the renderer sees them, after JRGraphOptimizer: a
+ * fused colour chain is one "fused(...)" node, and a folded transform has
+ * disappeared. Turn optimizesGraph off to see each filter on its own. A
+ * node's label is its kernel name or its kind. A name that occurs more than
+ * once in a graph gets "#2", "#3"... in the order inputs come before their
+ * consumers, so repeated renders of the same graph add up to the same rows.
+ *
+ * Statistics are kept per label for every render. Timed events (renders,
+ * tiles, materialised intermediates and node evaluations) are kept up to
+ * 'eventLimit', for the Chrome trace. */
+class JRProfiler {
+public:
+	struct NodeStatistics {
+		std::string label;
+		/* Times the node was evaluated: once per tile that needed it, and
+		 * once per tile of its materialisation. */
+		size_t tiles;
+		/* Seconds in the node itself, and including its inputs. The sum of
+		 * every thread, so it can exceed the wall time of the render. */
+		double selfSeconds;
+		double totalSeconds;
+		/* Pixels produced, and working-format bytes read from the node's
+		 * inputs (or its source) and written to its output. */
+		uint64_t pixels;
+		uint64_t bytesRead;
+		uint64_t bytesWritten;
+		/* Reads answered from a materialised intermediate or from the
+		 * intermediate cache, and intermediate-cache lookups that missed. */
+		size_t cacheHits;
+		size_t cacheMisses;
+		/* Buffers allocated to hold the node's inputs or to materialise it. */
+		size_t allocations;
+		uint64_t allocatedBytes;
+	};
+
+	struct Summary {
+		size_t renders;
+		/* Wall time of the renders, summed. */
+		double seconds;
+		/* Blocks JRBufferPool::sharedPool() took from the system, and
+		 * requests it answered from idle blocks, during the renders. The pool
+		 * is shared, so renders on other contexts are counted too. */
+		size_t poolAllocations;
+		size_t poolReuses;
+		size_t events;
+		size_t droppedEvents;
+	};
+
+	/* A timed span on one thread, for the trace. */
+	struct Event {
+		std::string name;
+		/// "render", "prepare", "cache", "materialize", "tile" 或 "node"
+		const char* category;
+		/// 相对于 profiler 创建 (或 reset) 的微秒数
+		double start;
+		double duration;
+		uint32_t thread;
+		uint64_t pixels;
+	};
+
+	explicit JRProfiler(size_t eventLimit = size_t(1) << 20);
+
+	/* Node statistics, the most expensive (selfSeconds) first. */
+	std::vector<NodeStatistics> nodeStatistics() const;
+	Summary summary() const;
+	std::vector<Event> events() const;
+
+	/* The events in the Chrome trace event format, for chrome://tracing or
+	 * Perfetto. Node events nest inside the tile that evaluated them. */
+	std::string chromeTrace() const;
+	bool writeChromeTrace(const std::string& path) const;
+	/* A flat table of nodeStatistics() under the summary. */
+	std::string report() const;
+
+	/* Forgets every statistic and event, and restarts the clock. */
+	void reset();
+
+	/* The label of every node of 'image', as described above. */
+	static std::shared_ptr<const std::unordered_map<const JRImage*, std::string>> labelsForGraph(const JRImage& image);
+
+private:
+	friend class JRProfileRecorder;
+
+	void merge(std::vector<NodeStatistics>& nodes, std::vector<Event>& events, const Summary& summary);
+	double microsecondsSince(std::chrono::steady_clock::time_point time) const;
+
+	mutable std::mutex _mutex;
+	size_t _eventLimit;
+	std::chrono::steady_clock::time_point _origin;
+	std::unordered_map<std::string, NodeStatistics> _nodes;
+	std::vector<Event> _events;
+	std::unordered_map<std::thread::id, uint32_t> _threads;
+	Summary _summary;
+};
+
+typedef std::shared_ptr<JRProfiler> JRProfilerRef;
+typedef std::shared_ptr<const std::unordered_map<const JRImage*, std::string>> JRProfileLabelsRef;
+
+/* Records the work of one thread during one span (a render, a tile, one
+ * materialisation) and hands it to the profiler when destroyed, so recording
+ * takes no lock per node. With a null profiler every call returns at once.
+ * Internal to JRContext and JRRenderer. */
+class JRProfileRecorder {
+public:
+	/* 'category' names the span itself. Nodes are labelled from 'labels'
+	 * when given, and by JRProfiler::labelsForGraph's rule otherwise. */
+	JRProfileRecorder(JRProfiler* profiler, const JRProfileLabelsRef& labels, const char* category, const std::string& name = std::string());
+	~JRProfileRecorder();
+
+	JRProfileRecorder(const JRProfileRecorder&) = delete;
+	JRProfileRecorder& operator=(const JRProfileRecorder&) = delete;
+
+	bool enabled() const { return _profiler != nullptr; }
+
+	/* Brackets the evaluation of 'image' into 'rect'. Calls nest like the
+	 * renderer's recursion; time spent in nested nodes is taken out of the
+	 * outer node's self time. */
+	void beginNode();
+	void endNode(const JRImage& image, const JRIRect& rect);
+
+	/* Charged to the node being evaluated. */
+	void recordRead(const JRIRect& rect);
+	void recordAllocation(const JRIRect& rect);
+
+	void recordAllocation(const JRImage& image, const JRIRect& rect);
+	void recordCacheLookup(const JRImage& image, bool hit);
+
+private:
+	struct Frame {
+		std::chrono::steady_clock::time_point start;
+		double childSeconds;
+		uint64_t bytesRead;
+		size_t allocations;
+		uint64_t allocatedBytes;
+	};
+	struct NodeEvent {
+		const JRImage* image;
+		std::chrono::steady_clock::time_point start;
+		double duration;
+		uint64_t pixels;
+	};
+
+	JRProfiler::NodeStatistics& statisticsFor(const JRImage& image);
+
+	JRProfiler* _profiler;
+	JRProfileLabelsRef _labels;
+	const char* _category;
+	std::string _name;
+	std::chrono::steady_clock::time_point _start;
+	size_t _poolAllocations;
+	size_t _poolReuses;
+	std::vector<Frame> _stack;
+	std::unordered_map<const JRImage*, JRProfiler::NodeStatistics> _nodes;
+	std::vector<NodeEvent> _events;
+};
+
+#endif /* jr_Profiler_h */
@@ -0,0 +1,434 @@
+//
+//  jr_Recipe.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Recipe.h"
+#include "jr_MappedImageProvider.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+/// 文件中的记录, 都按 memcpy 读写, 不要求对齐
+struct JRRecipeHeader {
+	char magic[4];
+	uint16_t version;
+	uint16_t headerSize;
+	uint32_t nodeCount;
+	uint32_t parameterCount;
+	uint32_t inputCount;
+	uint32_t stringCount;
+	uint32_t stringBytes;
+	uint32_t reserved;
+};
+
+struct JRRecipeNodeRecord {
+	uint32_t name;
+	uint32_t firstParameter;
+	uint32_t firstInput;
+	uint16_t parameterCount;
+	uint16_t inputCount;
+};
+
+struct JRRecipeParameterRecord {
+	uint32_t key;
+	uint32_t type;
+	/// 字符串类型时前 4 个字节是字符串表的下标
+	double values[6];
+};
+
+struct JRRecipeInputRecord {
+	uint32_t key;
+	int32_t source;
+};
+
+struct JRRecipeStringRecord {
+	uint32_t offset;
+	uint32_t length;
+};
+
+static_assert(sizeof(JRRecipeHeader) == 32, "recipe header layout");
+static_assert(sizeof(JRRecipeNodeRecord) == 16, "recipe node layout");
+static_assert(sizeof(JRRecipeParameterRecord) == 56, "recipe parameter layout");
+static_assert(sizeof(JRRecipeInputRecord) == 8, "recipe input layout");
+static_assert(sizeof(JRRecipeStringRecord) == 8, "recipe string layout");
+
+static const char kJRRecipeMagic[4] = { 'J', 'R', 'R', 'C' };
+
+/// 参数值的类型, 与 JRValue 的可选类型对应 (图像除外)
+enum JRRecipeValueType : uint32_t {
+	kJRRecipeValueDouble = 1,
+	kJRRecipeValueVector,
+	kJRRecipeValueColor,
+	kJRRecipeValueTransform,
+	kJRRecipeValueRect,
+	kJRRecipeValueString,
+};
+
+template <typename T>
+static T JRReadRecord(const uint8_t* table, size_t index)
+{
+	T record;
+	std::memcpy(&record, table + index * sizeof(T), sizeof(T));
+	return record;
+}
+
+/// 槽位已经是这个类型时, 读出的值可以直接放进去
+static bool JRSlotAccepts(JRFilterSlotType slot, uint32_t type)
+{
+	switch (slot) {
+		case kJRFilterSlotTypeAny:
+			return true;
+		case kJRFilterSlotTypeDouble:
+			return type == kJRRecipeValueDouble;
+		case kJRFilterSlotTypeVector:
+			return type == kJRRecipeValueVector;
+		case kJRFilterSlotTypeColor:
+			return type == kJRRecipeValueColor;
+		case kJRFilterSlotTypeTransform:
+			return type == kJRRecipeValueTransform;
+		case kJRFilterSlotTypeRect:
+			return type == kJRRecipeValueRect;
+		case kJRFilterSlotTypeImage:
+			break;
+	}
+	return false;
+}
+
+// MARK: - Encoding
+
+/// 把节点编码成字节, 名字和键只存一次
+class JRRecipeEncoder {
+public:
+	uint32_t string(const std::string& string)
+	{
+		auto found = _stringIndices.find(string);
+		if (found != _stringIndices.end()) {
+			return found->second;
+		}
+		uint32_t index = uint32_t(_strings.size());
+		_strings.push_back({ uint32_t(_stringBytes.size()), uint32_t(string.size()) });
+		_stringBytes.insert(_stringBytes.end(), string.begin(), string.end());
+		_stringIndices.emplace(string, index);
+		return index;
+	}
+
+	bool addParameter(uint32_t key, const JRValue& value)
+	{
+		JRRecipeParameterRecord record = { key, 0, { 0, 0, 0, 0, 0, 0 } };
+		if (const double* d = std::get_if<double>(&value)) {
+			record.type = kJRRecipeValueDouble;
+			record.values[0] = *d;
+		} else if (const JRVector* v = std::get_if<JRVector>(&value)) {
+			record.type = kJRRecipeValueVector;
+			record.values[0] = v->x;
+			record.values[1] = v->y;
+			record.values[2] = v->z;
+			record.values[3] = v->w;
+			record.values[4] = v->count;
+		} else if (const JRColor* c = std::get_if<JRColor>(&value)) {
+			record.type = kJRRecipeValueColor;
+			record.values[0] = c->red;
+			record.values[1] = c->green;
+			record.values[2] = c->blue;
+			record.values[3] = c->alpha;
+		} else if (const JRAffineTransform* t = std::get_if<JRAffineTransform>(&value)) {
+			record.type = kJRRecipeValueTransform;
+			record.values[0] = t->a;
+			record.values[1] = t->b;
+			record.values[2] = t->c;
+			record.values[3] = t->d;
+			record.values[4] = t->tx;
+			record.values[5] = t->ty;
+		} else if (const JRRect* r = std::get_if<JRRect>(&value)) {
+			record.type = kJRRecipeValueRect;
+			record.values[0] = r->x;
+			record.values[1] = r->y;
+			record.values[2] = r->width;
+			record.values[3] = r->height;
+		} else if (const std::string* s = std::get_if<std::string>(&value)) {
+			record.type = kJRRecipeValueString;
+			uint32_t index = string(*s);
+			std::memcpy(record.values, &index, sizeof(index));
+		} else {
+			return false;
+		}
+		_parameters.push_back(record);
+		return true;
+	}
+
+	std::vector<JRRecipeNodeRecord> nodes;
+	std::vector<JRRecipeInputRecord> inputs;
+
+	size_t parameterCount() const { return _parameters.size(); }
+
+	std::vector<uint8_t> data() const
+	{
+		JRRecipeHeader header = {};
+		std::memcpy(header.magic, kJRRecipeMagic, sizeof(kJRRecipeMagic));
+		header.version = kJRRecipeVersion;
+		header.headerSize = sizeof(JRRecipeHeader);
+		header.nodeCount = uint32_t(nodes.size());
+		header.parameterCount = uint32_t(_parameters.size());
+		header.inputCount = uint32_t(inputs.size());
+		header.stringCount = uint32_t(_strings.size());
+		header.stringBytes = uint32_t(_stringBytes.size());
+
+		std::vector<uint8_t> data;
+		auto append = [&](const void* bytes, size_t length) {
+			data.insert(data.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + length);
+		};
+		append(&header, sizeof(header));
+		append(nodes.data(), nodes.size() * sizeof(JRRecipeNodeRecord));
+		append(_parameters.data(), _parameters.size() * sizeof(JRRecipeParameterRecord));
+		append(inputs.data(), inputs.size() * sizeof(JRRecipeInputRecord));
+		append(_strings.data(), _strings.size() * sizeof(JRRecipeStringRecord));
+		append(_stringBytes.data(), _stringBytes.size());
+		return data;
+	}
+
+private:
+	std::vector<JRRecipeParameterRecord> _parameters;
+	std::vector<JRRecipeStringRecord> _strings;
+	std::vector<char> _stringBytes;
+	std::unordered_map<std::string, uint32_t> _stringIndices;
+};
+
+JRRecipeRef JRRecipe::recipeWithNodes(const std::vector<JRRecipeNode>& nodes)
+{
+	if (nodes.empty()) {
+		return nullptr;
+	}
+	JRRecipeEncoder encoder;
+	for (size_t i = 0; i < nodes.size(); i++) {
+		const JRRecipeNode& node = nodes[i];
+		/// 经过滤镜校验一次, 存下的是槽位中转换并限制范围之后的值
+		JRFilterRef filter = JRFilter::filterWithName(node.filterName);
+		if (!filter || node.parameters.size() > UINT16_MAX || node.imageInputs.size() > UINT16_MAX) {
+			return nullptr;
+		}
+		JRRecipeNodeRecord record = { encoder.string(node.filterName), uint32_t(encoder.parameterCount()),
+									  uint32_t(encoder.inputs.size()), uint16_t(node.parameters.size()),
+									  uint16_t(node.imageInputs.size()) };
+		for (const auto& parameter : node.parameters) {
+			if (std::holds_alternative<JRImageRef>(parameter.second) || !filter->setValue(parameter.second, parameter.first)) {
+				return nullptr;
+			}
+			JRValue stored = filter->valueForKey(parameter.first);
+			if (std::holds_alternative<std::monostate>(stored)) {
+				record.parameterCount--;
+				continue;
+			}
+			if (!encoder.addParameter(encoder.string(parameter.first), stored)) {
+				return nullptr;
+			}
+		}
+		for (const std::pair<std::string, int>& input : node.imageInputs) {
+			if (input.second >= int(i)) {
+				return nullptr;
+			}
+			encoder.inputs.push_back({ encoder.string(input.first), int32_t(input.second) });
+		}
+		encoder.nodes.push_back(record);
+	}
+
+	auto data = std::make_shared<std::vector<uint8_t>>(encoder.data());
+	return recipeWithBytes(std::shared_ptr<const uint8_t>(data, data->data()), data->size());
+}
+
+// MARK: - Loading
+
+JRRecipeRef JRRecipe::recipeWithBytes(std::shared_ptr<const uint8_t> bytes, size_t length)
+{
+	JRRecipeHeader header;
+	if (!bytes || length < sizeof(header)) {
+		return nullptr;
+	}
+	std::memcpy(&header, bytes.get(), sizeof(header));
+	if (std::memcmp(header.magic, kJRRecipeMagic, sizeof(kJRRecipeMagic)) != 0 || header.version == 0 ||
+		header.version > kJRRecipeVersion || header.headerSize < sizeof(header) || header.headerSize % 8 != 0 ||
+		header.nodeCount == 0) {
+		return nullptr;
+	}
+
+	/// 各表的位置, 64 位计算不会溢出
+	uint64_t nodes = header.headerSize;
+	uint64_t parameters = nodes + uint64_t(header.nodeCount) * sizeof(JRRecipeNodeRecord);
+	uint64_t inputs = parameters + uint64_t(header.parameterCount) * sizeof(JRRecipeParameterRecord);
+	uint64_t strings = inputs + uint64_t(header.inputCount) * sizeof(JRRecipeInputRecord);
+	uint64_t stringBytes = strings + uint64_t(header.stringCount) * sizeof(JRRecipeStringRecord);
+	if (stringBytes + header.stringBytes > length) {
+		return nullptr;
+	}
+
+	std::shared_ptr<JRRecipe> recipe(new JRRecipe());
+	const uint8_t* base = bytes.get();
+	recipe->_nodes = base + nodes;
+	recipe->_parameters = base + parameters;
+	recipe->_inputs = base + inputs;
+	recipe->_nodeCount = header.nodeCount;
+	recipe->_strings.reserve(header.stringCount);
+	for (uint32_t i = 0; i < header.stringCount; i++) {
+		JRRecipeStringRecord string = JRReadRecord<JRRecipeStringRecord>(base + strings, i);
+		if (uint64_t(string.offset) + string.length > header.stringBytes) {
+			return nullptr;
+		}
+		recipe->_strings.emplace_back(reinterpret_cast<const char*>(base + stringBytes + string.offset), size_t(string.length));
+	}
+
+	/// 检查下标, 同时记下每个字符串用作滤镜名 (1) 还是键 (2)
+	std::vector<uint8_t> uses(header.stringCount, 0);
+	for (uint32_t i = 0; i < header.nodeCount; i++) {
+		JRRecipeNodeRecord node = JRReadRecord<JRRecipeNodeRecord>(recipe->_nodes, i);
+		if (node.name >= header.stringCount || uint64_t(node.firstParameter) + node.parameterCount > header.parameterCount ||
+			uint64_t(node.firstInput) + node.inputCount > header.inputCount) {
+			return nullptr;
+		}
+		uses[node.name] |= 1;
+		for (uint32_t p = node.firstParameter; p < node.firstParameter + node.parameterCount; p++) {
+			JRRecipeParameterRecord parameter = JRReadRecord<JRRecipeParameterRecord>(recipe->_parameters, p);
+			uint32_t string;
+			std::memcpy(&string, parameter.values, sizeof(string));
+			/// 向量的分量数按 int 读出, 超出 1...4 (或为 NaN) 的文件不接受
+			double count = parameter.values[4];
+			if (parameter.key >= header.stringCount || parameter.type < kJRRecipeValueDouble || parameter.type > kJRRecipeValueString ||
+				(parameter.type == kJRRecipeValueString && string >= header.stringCount) ||
+				(parameter.type == kJRRecipeValueVector && (!(count >= 1 && count <= 4) || count != double(int(count))))) {
+				return nullptr;
+			}
+			uses[parameter.key] |= 2;
+		}
+		for (uint32_t k = node.firstInput; k < node.firstInput + node.inputCount; k++) {
+			JRRecipeInputRecord input = JRReadRecord<JRRecipeInputRecord>(recipe->_inputs, k);
+			if (input.key >= header.stringCount || input.source >= int32_t(i)) {
+				return nullptr;
+			}
+			uses[input.key] |= 2;
+		}
+	}
+
+	recipe->_filterIDs.assign(header.stringCount, kJRFilterIDNotFound);
+	recipe->_keys.assign(header.stringCount, 0);
+	for (uint32_t i = 0; i < header.stringCount; i++) {
+		/// 只作为参数值的字符串 (如 inputCubeData) 不需要解析
+		if (!uses[i]) {
+			continue;
+		}
+		std::string string(recipe->_strings[i].first, recipe->_strings[i].second);
+		if (uses[i] & 1) {
+			recipe->_filterIDs[i] = JRFilter::filterIDForName(string);
+		}
+		if (uses[i] & 2) {
+			recipe->_keys[i] = JRFilterKeyForName(string);
+		}
+	}
+	recipe->_bytes = std::move(bytes);
+	recipe->_length = length;
+	return recipe;
+}
+
+JRRecipeRef JRRecipe::recipeWithContentsOfFile(const std::string& path)
+{
+	size_t length = 0;
+	std::shared_ptr<const uint8_t> bytes = JRMapFile(path, &length);
+	return bytes ? recipeWithBytes(std::move(bytes), length) : nullptr;
+}
+
+bool JRRecipe::writeToFile(const std::string& path) const
+{
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) {
+		return false;
+	}
+	bool written = fwrite(_bytes.get(), 1, _length, file) == _length;
+	return fclose(file) == 0 && written;
+}
+
+/// 从记录读出参数值
+static JRValue JRRecipeValue(const JRRecipeParameterRecord& record, const std::vector<std::pair<const char*, size_t>>& strings)
+{
+	const double* v = record.values;
+	switch (record.type) {
+		case kJRRecipeValueDouble:
+			return v[0];
+		case kJRRecipeValueVector:
+			return JRVector{ v[0], v[1], v[2], v[3], int(v[4]) };
+		case kJRRecipeValueColor:
+			return JRColor::colorWithRed(float(v[0]), float(v[1]), float(v[2]), float(v[3]));
+		case kJRRecipeValueTransform:
+			return JRAffineTransformMake(v[0], v[1], v[2], v[3], v[4], v[5]);
+		case kJRRecipeValueRect:
+			return JRRectMake(v[0], v[1], v[2], v[3]);
+		case kJRRecipeValueString: {
+			uint32_t index;
+			std::memcpy(&index, v, sizeof(index));
+			return std::string(strings[index].first, strings[index].second);
+		}
+	}
+	return JRValue();
+}
+
+std::vector<JRRecipeNode> JRRecipe::nodes() const
+{
+	std::vector<JRRecipeNode> result(_nodeCount);
+	auto string = [&](uint32_t index) {
+		return std::string(_strings[index].first, _strings[index].second);
+	};
+	for (size_t i = 0; i < _nodeCount; i++) {
+		JRRecipeNodeRecord node = JRReadRecord<JRRecipeNodeRecord>(_nodes, i);
+		result[i].filterName = string(node.name);
+		for (uint32_t p = node.firstParameter; p < node.firstParameter + node.parameterCount; p++) {
+			JRRecipeParameterRecord parameter = JRReadRecord<JRRecipeParameterRecord>(_parameters, p);
+			result[i].parameters[string(parameter.key)] = JRRecipeValue(parameter, _strings);
+		}
+		for (uint32_t k = node.firstInput; k < node.firstInput + node.inputCount; k++) {
+			JRRecipeInputRecord input = JRReadRecord<JRRecipeInputRecord>(_inputs, k);
+			result[i].imageInputs.emplace_back(string(input.key), int(input.source));
+		}
+	}
+	return result;
+}
+
+JRImageRef JRRecipe::imageWithSources(const std::vector<JRImageRef>& sources) const
+{
+	std::vector<JRImageRef> outputs(_nodeCount);
+	for (size_t i = 0; i < _nodeCount; i++) {
+		JRRecipeNodeRecord node = JRReadRecord<JRRecipeNodeRecord>(_nodes, i);
+		JRFilterRef filter = JRFilter::filterWithID(_filterIDs[node.name]);
+		if (!filter) {
+			return nullptr;
+		}
+		const JRFilterLayout& layout = *filter->layout();
+		for (uint32_t p = node.firstParameter; p < node.firstParameter + node.parameterCount; p++) {
+			JRRecipeParameterRecord parameter = JRReadRecord<JRRecipeParameterRecord>(_parameters, p);
+			JRFilterKey key = _keys[parameter.key];
+			int slot = layout.slotForKey(key);
+			/// 类型相符时直接写入槽位, 省去转换; 文件可能被改过, 数值仍按硬边界截断
+			if (slot >= 0 && JRSlotAccepts(layout.typeAtSlot(slot), parameter.type)) {
+				if (parameter.type == kJRRecipeValueDouble) {
+					const JRFilterAttribute& attribute = layout.attributes()[size_t(slot)];
+					double d = parameter.values[0];
+					filter->_slots[size_t(slot)] = d < attribute.minimum ? attribute.minimum : d > attribute.maximum ? attribute.maximum : d;
+				} else {
+					filter->_slots[size_t(slot)] = JRRecipeValue(parameter, _strings);
+				}
+			} else {
+				filter->setValue(JRRecipeValue(parameter, _strings), key);
+			}
+		}
+		for (uint32_t k = node.firstInput; k < node.firstInput + node.inputCount; k++) {
+			JRRecipeInputRecord input = JRReadRecord<JRRecipeInputRecord>(_inputs, k);
+			size_t source = size_t(-1 - int64_t(input.source));
+			if (input.source < 0 && source >= sources.size()) {
+				return nullptr;
+			}
+			filter->setValue(input.source >= 0 ? outputs[size_t(input.source)] : sources[source], _keys[input.key]);
+		}
+		outputs[i] = filter->outputImage();
+	}
+	return outputs.back();
+}
@@ -0,0 +1,110 @@
+//
+//  jr_Recipe.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Recipe_h
+#define jr_Recipe_h
+
+#include "jr_Filter.h"
+#include "jr_Image.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/* The input index that reads source image 'index' of
+ * JRRecipe::imageWithSources rather than an earlier node. Source 0 is -1,
+ * the same as kJRVideoFrameInput. */
+inline constexpr int JRRecipeSource(int index) { return -1 - index; }
+
+/* The format version JRRecipe writes. Recipes of a later version are
+ * rejected. */
+inline constexpr uint16_t kJRRecipeVersion = 1;
+
+/* One filter of a recipe. */
+struct JRRecipeNode {
+	std::string filterName;
+	/* Every input that is not an image: numbers, vectors, colours,
+	 * transforms, rects and byte strings (such as inputCubeData). */
+	JRFilterParameters parameters;
+	/* Image inputs: the key, and either the index of an earlier node or
+	 * JRRecipeSource(n). */
+	std::vector<std::pair<std::string, int>> imageInputs;
+};
+
+class JRRecipe;
+typedef std::shared_ptr<const JRRecipe> JRRecipeRef;
+
+/* A filter graph in a compact binary form, for storing edit recipes and
+ * rendering them again later. It covers any graph of registered filters, where
+ * CIFilter.serializedXMP only keeps a few geometry and auto-adjust
+ * filters. Source images are not stored; they are numbered, and supplied
+ * when the graph is built.
+ *
+ * A recipe is its bytes. recipeWithBytes wraps them without copying, so a
+ * recipe can live in an mmap'ed file or a database page. The file is checked
+ * once when it is loaded: bounds, indices, vector sizes, and that every
+ * node reads only earlier nodes. Its names are then resolved to filter IDs
+ * and keys. imageWithSources builds the graph straight from the records.
+ * A value whose type matches its slot is written into the slot without
+ * being converted. Numbers are still clamped to the attribute's hard
+ * minimum and maximum, because the bytes may not come from recipeWithNodes.
+ *
+ * Layout (version 1, little-endian, every table 8-byte aligned):
+ *   header      "JRRC", version, counts of each table, string bytes
+ *   nodes       16 bytes: name, first parameter, first input, counts
+ *   parameters  56 bytes: key, type, six doubles (or a string reference)
+ *   inputs       8 bytes: key, source (node index or JRRecipeSource)
+ *   strings      8 bytes: offset and length in the string bytes
+ *   string bytes
+ * Each filter name and key is stored once, however many nodes use it. */
+class JRRecipe {
+public:
+	/* Validates 'nodes' against the registered filters and encodes them.
+	 * Values are converted and clamped as JRFilter::setValue would.
+	 * Returns nullptr if a filter is not registered, a value has the wrong
+	 * type, a parameter holds an image, or a node reads a later node. */
+	static JRRecipeRef recipeWithNodes(const std::vector<JRRecipeNode>& nodes);
+	/* Wraps serialized bytes. 'bytes' owns the memory and must stay
+	 * unchanged while the recipe exists. Returns nullptr for malformed data
+	 * or a newer version. */
+	static JRRecipeRef recipeWithBytes(std::shared_ptr<const uint8_t> bytes, size_t length);
+	/* Maps a file written by writeToFile. */
+	static JRRecipeRef recipeWithContentsOfFile(const std::string& path);
+
+	const uint8_t* bytes() const { return _bytes.get(); }
+	size_t length() const { return _length; }
+	bool writeToFile(const std::string& path) const;
+
+	size_t nodeCount() const { return _nodeCount; }
+	/* Decodes the nodes, for inspecting or editing a recipe. */
+	std::vector<JRRecipeNode> nodes() const;
+
+	/* Builds the graph reading 'sources' and returns the image of the last
+	 * node. Returns nullptr if a filter is no longer registered or a
+	 * source is missing. */
+	JRImageRef imageWithSources(const std::vector<JRImageRef>& sources) const;
+
+private:
+	JRRecipe() = default;
+
+	std::shared_ptr<const uint8_t> _bytes;
+	size_t _length = 0;
+	size_t _nodeCount = 0;
+	/// 各个表在 _bytes 中的位置
+	const uint8_t* _nodes = nullptr;
+	const uint8_t* _parameters = nullptr;
+	const uint8_t* _inputs = nullptr;
+	/// 每个字符串解析后的滤镜 ID 与键
+	std::vector<JRFilterID> _filterIDs;
+	std::vector<JRFilterKey> _keys;
+	std::vector<std::pair<const char*, size_t>> _strings;
+};
+
+#endif /* jr_Recipe_h */
@@ -0,0 +1,382 @@
+//
+//  jr_Reduction.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Reduction.h"
+#include "jr_SIMD.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#if defined(JR_SIMD_X86)
+#include <immintrin.h>
+#elif defined(JR_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+/// 每次求 bin 的像素数
+static const size_t kJRReductionChunk = 64;
+/// 每个直方图交错的份数, 相邻像素计入不同的份, 减少对同一计数的连续依赖
+static const size_t kJRReductionCopies = 2;
+
+static const float kJRLumaRed = 0.2126f;
+static const float kJRLumaGreen = 0.7152f;
+static const float kJRLumaBlue = 0.0722f;
+
+/// 求 bin 的参数: bin = trunc(clamp((v - offset) * scale, 0, last))
+struct JRBinning {
+	float offset;
+	float scale;
+	float last;
+	size_t binCount;
+};
+
+/// 一个线程的部分结果
+struct JRReductionPartial {
+	/// [通道][份][bin]
+	std::vector<uint64_t> bins;
+	float minimum[kJRReductionChannelCount];
+	float maximum[kJRReductionChannelCount];
+	double sum[kJRReductionChannelCount];
+	uint64_t count;
+
+	explicit JRReductionPartial(size_t binCount)
+	: bins(kJRReductionChannelCount * kJRReductionCopies * binCount), sum(), count(0)
+	{
+		std::fill(minimum, minimum + kJRReductionChannelCount, INFINITY);
+		std::fill(maximum, maximum + kJRReductionChannelCount, -INFINITY);
+	}
+};
+
+static inline int JRBinIndex(const JRBinning& b, float v)
+{
+	float x = (v - b.offset) * b.scale;
+	x = x > 0 ? x : 0;
+	x = x < b.last ? x : b.last;
+	return int(x);
+}
+
+/// 把 bins 中 count 个像素的下标计入直方图. rgba 按像素排列, luma 一个像素一个
+static void JRCountBins(JRReductionPartial& partial, const JRBinning& b, const int32_t* rgba, const int32_t* luma, size_t count)
+{
+	uint64_t* bins = partial.bins.data();
+	const size_t channelStride = kJRReductionCopies * b.binCount;
+	for (size_t i = 0; i < count; i++) {
+		size_t copy = (i & 1) * b.binCount;
+		for (size_t c = 0; c < 4; c++) {
+			bins[c * channelStride + copy + size_t(rgba[i * 4 + c])]++;
+		}
+		bins[kJRReductionChannelLuminance * channelStride + copy + size_t(luma[i])]++;
+	}
+}
+
+/// count <= kJRReductionChunk 个像素的标量版本
+static void JRReduceChunk(const float* p, size_t count, const JRBinning& b, JRReductionPartial& partial)
+{
+	int32_t rgba[kJRReductionChunk * 4];
+	int32_t luma[kJRReductionChunk];
+	float minimum[kJRReductionChannelCount], maximum[kJRReductionChannelCount], sum[kJRReductionChannelCount] = {};
+	std::copy(partial.minimum, partial.minimum + kJRReductionChannelCount, minimum);
+	std::copy(partial.maximum, partial.maximum + kJRReductionChannelCount, maximum);
+	for (size_t i = 0; i < count; i++, p += 4) {
+		float l = p[0] * kJRLumaRed + p[1] * kJRLumaGreen + p[2] * kJRLumaBlue;
+		for (int c = 0; c < 5; c++) {
+			float v = c < 4 ? p[c] : l;
+			minimum[c] = v < minimum[c] ? v : minimum[c];
+			maximum[c] = v > maximum[c] ? v : maximum[c];
+			sum[c] += v;
+		}
+		for (int c = 0; c < 4; c++) {
+			rgba[i * 4 + size_t(c)] = JRBinIndex(b, p[c]);
+		}
+		luma[i] = JRBinIndex(b, l);
+	}
+	JRCountBins(partial, b, rgba, luma, count);
+	for (int c = 0; c < 5; c++) {
+		partial.minimum[c] = minimum[c];
+		partial.maximum[c] = maximum[c];
+		partial.sum[c] += sum[c];
+	}
+}
+
+#if defined(JR_SIMD_X86)
+
+#define JR_TARGET_AVX2 __attribute__((target("avx2")))
+
+JR_TARGET_AVX2 static inline __m256i JRBinIndexAVX2(__m256 v, __m256 offset, __m256 scale, __m256 last)
+{
+	__m256 x = _mm256_mul_ps(_mm256_sub_ps(v, offset), scale);
+	/// max/min 遇到 NaN 时返回第二个操作数, 与标量的比较写法一致
+	x = _mm256_max_ps(x, _mm256_setzero_ps());
+	x = _mm256_min_ps(x, last);
+	return _mm256_cvttps_epi32(x);
+}
+
+/// 一次 8 个像素: 4 个向量各含两个像素, 亮度由两次 hadd 得到 (像素顺序 0 2 4 6 1 3 5 7, 计数与顺序无关)
+JR_TARGET_AVX2 static void JRReduceChunkAVX2(const float* p, size_t count, const JRBinning& b, JRReductionPartial& partial)
+{
+	alignas(32) int32_t rgba[kJRReductionChunk * 4];
+	alignas(32) int32_t luma[kJRReductionChunk];
+	const __m256 offset = _mm256_set1_ps(b.offset), scale = _mm256_set1_ps(b.scale), last = _mm256_set1_ps(b.last);
+	const __m256 weights = _mm256_setr_ps(kJRLumaRed, kJRLumaGreen, kJRLumaBlue, 0, kJRLumaRed, kJRLumaGreen, kJRLumaBlue, 0);
+	__m256 minimum = _mm256_set1_ps(INFINITY), maximum = _mm256_set1_ps(-INFINITY), sum = _mm256_setzero_ps();
+	__m256 lumaMinimum = minimum, lumaMaximum = maximum, lumaSum = sum;
+	size_t n = count & ~size_t(7);
+	for (size_t i = 0; i < n; i += 8) {
+		__m256 v[4];
+		for (int k = 0; k < 4; k++) {
+			v[k] = _mm256_loadu_ps(p + (i + size_t(k) * 2) * 4);
+			minimum = _mm256_min_ps(v[k], minimum);
+			maximum = _mm256_max_ps(v[k], maximum);
+			sum = _mm256_add_ps(sum, v[k]);
+			_mm256_store_si256((__m256i*)(rgba + (i + size_t(k) * 2) * 4), JRBinIndexAVX2(v[k], offset, scale, last));
+		}
+		__m256 h0 = _mm256_hadd_ps(_mm256_mul_ps(v[0], weights), _mm256_mul_ps(v[1], weights));
+		__m256 h1 = _mm256_hadd_ps(_mm256_mul_ps(v[2], weights), _mm256_mul_ps(v[3], weights));
+		__m256 l = _mm256_hadd_ps(h0, h1);
+		lumaMinimum = _mm256_min_ps(l, lumaMinimum);
+		lumaMaximum = _mm256_max_ps(l, lumaMaximum);
+		lumaSum = _mm256_add_ps(lumaSum, l);
+		_mm256_store_si256((__m256i*)(luma + i), JRBinIndexAVX2(l, offset, scale, last));
+	}
+	JRCountBins(partial, b, rgba, luma, n);
+
+	alignas(32) float lanes[3][8], lumaLanes[3][8];
+	_mm256_store_ps(lanes[0], minimum);
+	_mm256_store_ps(lanes[1], maximum);
+	_mm256_store_ps(lanes[2], sum);
+	_mm256_store_ps(lumaLanes[0], lumaMinimum);
+	_mm256_store_ps(lumaLanes[1], lumaMaximum);
+	_mm256_store_ps(lumaLanes[2], lumaSum);
+	for (int k = 0; k < 8; k++) {
+		int c = k < 4 ? k : k - 4;
+		partial.minimum[c] = std::min(partial.minimum[c], lanes[0][k]);
+		partial.maximum[c] = std::max(partial.maximum[c], lanes[1][k]);
+		partial.sum[c] += lanes[2][k];
+		partial.minimum[kJRReductionChannelLuminance] = std::min(partial.minimum[kJRReductionChannelLuminance], lumaLanes[0][k]);
+		partial.maximum[kJRReductionChannelLuminance] = std::max(partial.maximum[kJRReductionChannelLuminance], lumaLanes[1][k]);
+		partial.sum[kJRReductionChannelLuminance] += lumaLanes[2][k];
+	}
+	if (n < count) {
+		JRReduceChunk(p + n * 4, count - n, b, partial);
+	}
+}
+
+#elif defined(JR_SIMD_NEON)
+
+/// 一次一个像素的 RGBA; 用比较加选择代替 max/min, 对 NaN 的处理与标量相同
+static void JRReduceChunkNEON(const float* p, size_t count, const JRBinning& b, JRReductionPartial& partial)
+{
+	int32_t rgba[kJRReductionChunk * 4];
+	int32_t luma[kJRReductionChunk];
+	const float32x4_t offset = vdupq_n_f32(b.offset), scale = vdupq_n_f32(b.scale), last = vdupq_n_f32(b.last);
+	const float32x4_t zero = vdupq_n_f32(0);
+	float32x4_t minimum = vld1q_f32(partial.minimum), maximum = vld1q_f32(partial.maximum), sum = vdupq_n_f32(0);
+	float lumaMinimum = partial.minimum[kJRReductionChannelLuminance], lumaMaximum = partial.maximum[kJRReductionChannelLuminance];
+	float lumaSum = 0;
+	for (size_t i = 0; i < count; i++, p += 4) {
+		float32x4_t v = vld1q_f32(p);
+		minimum = vbslq_f32(vcltq_f32(v, minimum), v, minimum);
+		maximum = vbslq_f32(vcgtq_f32(v, maximum), v, maximum);
+		sum = vaddq_f32(sum, v);
+		float32x4_t x = vmulq_f32(vsubq_f32(v, offset), scale);
+		x = vbslq_f32(vcgtq_f32(x, zero), x, zero);
+		x = vbslq_f32(vcltq_f32(x, last), x, last);
+		vst1q_s32(rgba + i * 4, vcvtq_s32_f32(x));
+		float l = p[0] * kJRLumaRed + p[1] * kJRLumaGreen + p[2] * kJRLumaBlue;
+		lumaMinimum = l < lumaMinimum ? l : lumaMinimum;
+		lumaMaximum = l > lumaMaximum ? l : lumaMaximum;
+		lumaSum += l;
+		luma[i] = JRBinIndex(b, l);
+	}
+	JRCountBins(partial, b, rgba, luma, count);
+	float sums[4];
+	vst1q_f32(partial.minimum, minimum);
+	vst1q_f32(partial.maximum, maximum);
+	vst1q_f32(sums, sum);
+	for (int c = 0; c < 4; c++) {
+		partial.sum[c] += sums[c];
+	}
+	partial.minimum[kJRReductionChannelLuminance] = lumaMinimum;
+	partial.maximum[kJRReductionChannelLuminance] = lumaMaximum;
+	partial.sum[kJRReductionChannelLuminance] += lumaSum;
+}
+
+#endif
+
+/// 每 kJRReductionChunk 个像素求一次 bin 并计数, float 的和每块并入 double
+static void JRReduceSpan(const float* p, size_t count, const JRBinning& b, JRReductionPartial& partial)
+{
+	partial.count += count;
+	for (size_t i = 0; i < count; i += kJRReductionChunk) {
+		size_t n = std::min(kJRReductionChunk, count - i);
+#if defined(JR_SIMD_X86)
+		if (JRSIMDActiveLevel() >= kJRSIMDLevelAVX2) {
+			JRReduceChunkAVX2(p + i * 4, n, b, partial);
+			continue;
+		}
+#elif defined(JR_SIMD_NEON)
+		if (JRSIMDActiveLevel() == kJRSIMDLevelNEON) {
+			JRReduceChunkNEON(p + i * 4, n, b, partial);
+			continue;
+		}
+#endif
+		JRReduceChunk(p + i * 4, n, b, partial);
+	}
+}
+
+/// 同时运行的 tile 各取一个部分结果, 用完放回; 个数不超过同时运行的线程数
+class JRReductionPartials {
+public:
+	explicit JRReductionPartials(size_t binCount)
+	: _binCount(binCount)
+	{
+	}
+
+	JRReductionPartial* acquire()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_free.empty()) {
+			_all.emplace_back(new JRReductionPartial(_binCount));
+			return _all.back().get();
+		}
+		JRReductionPartial* partial = _free.back();
+		_free.pop_back();
+		return partial;
+	}
+
+	void release(JRReductionPartial* partial)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_free.push_back(partial);
+	}
+
+	const std::vector<std::unique_ptr<JRReductionPartial>>& all() const { return _all; }
+
+private:
+	size_t _binCount;
+	std::mutex _mutex;
+	std::vector<std::unique_ptr<JRReductionPartial>> _all;
+	std::vector<JRReductionPartial*> _free;
+};
+
+/// 抽样时第 index 段 (长 step, 最后一段可能更短) 中选中的位置
+static int JRJitteredPosition(uint64_t seed, int index, int step, int length)
+{
+	int start = index * step;
+	int span = std::min(step, length - start);
+	return start + int(JRHashCombine(seed, uint64_t(index)) % uint64_t(span));
+}
+
+JRImageStatisticsRef JRImageStatistics::statisticsWithImage(const JRImageRef& image, const JRIRect& bounds, const JRContext& context,
+														  const JRReductionOptions& options)
+{
+	if (!image || bounds.isEmpty() || options.binCount <= 0 || options.binCount > 65536
+		|| !(options.maximumValue > options.minimumValue) || std::isinf(options.maximumValue - options.minimumValue)) {
+		return nullptr;
+	}
+	std::shared_ptr<JRImageStatistics> result(new JRImageStatistics());
+	result->_options = options;
+	result->_bounds = bounds;
+
+	const size_t binCount = size_t(options.binCount);
+	JRBinning binning = { options.minimumValue, float(options.binCount) / (options.maximumValue - options.minimumValue),
+						  float(options.binCount - 1), binCount };
+
+	/// DKW: n >= ln(2 / delta) / (2 * epsilon^2) 个样本时, 经验分布函数的误差处处不超过 epsilon
+	const double logTerm = std::log(2.0 / (1.0 - kJRReductionConfidence));
+	double area = double(bounds.width) * double(bounds.height);
+	int step = 1;
+	if (options.maximumError > 0) {
+		double samples = logTerm / (2.0 * options.maximumError * options.maximumError);
+		step = std::max(1, int(std::floor(std::sqrt(area / samples))));
+	}
+
+	JRReductionPartials partials(binCount);
+	if (step == 1) {
+		context.renderTiles(image, bounds, [&](const JRBuffer& tile) {
+			JRReductionPartial* partial = partials.acquire();
+			const JRIRect& r = tile.rect();
+			for (int y = r.y; y < r.maxY(); y++) {
+				JRReduceSpan(tile.rowAt(y), size_t(r.width), binning, *partial);
+			}
+			partials.release(partial);
+		});
+	} else {
+		/// 每 step 行选一行, 行内每 step 个像素选一个, 位置由哈希决定
+		const uint64_t seed = JRHashCombine(uint64_t(bounds.x) * 31 + uint64_t(bounds.y), uint64_t(step));
+		std::vector<JRIRect> rows;
+		for (int band = 0; band * step < bounds.height; band++) {
+			rows.push_back({ bounds.x, bounds.y + JRJitteredPosition(seed, band, step, bounds.height), bounds.width, 1 });
+		}
+		context.renderTiles(image, rows, [&](const JRBuffer& row) {
+			JRReductionPartial* partial = partials.acquire();
+			const uint64_t rowSeed = JRHashCombine(seed, uint64_t(row.rect().y));
+			float samples[kJRReductionChunk * 4];
+			size_t n = 0;
+			for (int run = 0; run * step < bounds.width; run++) {
+				const float* p = row.rowAt(row.rect().y) + size_t(JRJitteredPosition(rowSeed, run, step, bounds.width)) * 4;
+				std::copy(p, p + 4, samples + n * 4);
+				if (++n == kJRReductionChunk) {
+					JRReduceSpan(samples, n, binning, *partial);
+					n = 0;
+				}
+			}
+			JRReduceSpan(samples, n, binning, *partial);
+			partials.release(partial);
+		});
+	}
+
+	/// 合并各线程的部分结果
+	for (int c = 0; c < kJRReductionChannelCount; c++) {
+		result->_histograms[c].assign(binCount, 0);
+		result->_minimum[c] = INFINITY;
+		result->_maximum[c] = -INFINITY;
+	}
+	double sum[kJRReductionChannelCount] = {};
+	for (const auto& partial : partials.all()) {
+		result->_pixelCount += partial->count;
+		for (int c = 0; c < kJRReductionChannelCount; c++) {
+			const uint64_t* bins = partial->bins.data() + size_t(c) * kJRReductionCopies * binCount;
+			for (size_t copy = 0; copy < kJRReductionCopies; copy++) {
+				for (size_t i = 0; i < binCount; i++) {
+					result->_histograms[c][i] += bins[copy * binCount + i];
+				}
+			}
+			result->_minimum[c] = std::min(result->_minimum[c], partial->minimum[c]);
+			result->_maximum[c] = std::max(result->_maximum[c], partial->maximum[c]);
+			sum[c] += partial->sum[c];
+		}
+	}
+	for (int c = 0; c < kJRReductionChannelCount; c++) {
+		result->_mean[c] = result->_pixelCount ? sum[c] / double(result->_pixelCount) : 0;
+	}
+	result->_sampleStep = step;
+	result->_errorBound = step > 1 && result->_pixelCount ? std::sqrt(logTerm / (2.0 * double(result->_pixelCount))) : 0;
+	return result;
+}
+
+double JRImageStatistics::percentile(JRReductionChannel channel, double fraction) const
+{
+	if (_pixelCount == 0) {
+		return 0;
+	}
+	const std::vector<uint64_t>& bins = _histograms[channel];
+	double width = double(_options.maximumValue - _options.minimumValue) / double(bins.size());
+	double target = std::min(std::max(fraction, 0.0), 1.0) * double(_pixelCount);
+	double below = 0;
+	double value = _options.maximumValue;
+	for (size_t i = 0; i < bins.size(); i++) {
+		if (bins[i] && below + double(bins[i]) >= target) {
+			value = _options.minimumValue + (double(i) + (target - below) / double(bins[i])) * width;
+			break;
+		}
+		below += double(bins[i]);
+	}
+	return std::min(std::max(value, double(_minimum[channel])), double(_maximum[channel]));
+}
@@ -0,0 +1,111 @@
+//
+//  jr_Reduction.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Reduction_h
+#define jr_Reduction_h
+
+#include "jr_Context.h"
+#include "jr_Image.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/* The channels a reduction measures. Luminance is the Rec. 709 luma of the
+ * working-space RGB, as auto-adjustment uses it. */
+enum JRReductionChannel {
+	kJRReductionChannelRed = 0,
+	kJRReductionChannelGreen,
+	kJRReductionChannelBlue,
+	kJRReductionChannelAlpha,
+	kJRReductionChannelLuminance,
+	kJRReductionChannelCount,
+};
+
+/* The probability with which a sampled analysis stays within its error
+ * bound. */
+inline constexpr double kJRReductionConfidence = 0.999;
+
+struct JRReductionOptions {
+	/* Bins per channel, like inputCount of CIAreaHistogram. */
+	int binCount = 256;
+	/* The range the bins cover. Values outside it are counted in the first
+	 * or last bin; minimum, maximum and mean still see them exactly. */
+	float minimumValue = 0.0f;
+	float maximumValue = 1.0f;
+	/* 0 analyses every pixel. Otherwise only enough pixels are analysed that,
+	 * with probability kJRReductionConfidence, every percentile is within this
+	 * fraction of the pixel count of its exact rank, and the mean of values
+	 * inside the range within this fraction of the range. */
+	double maximumError = 0.0;
+};
+
+class JRImageStatistics;
+typedef std::shared_ptr<const JRImageStatistics> JRImageStatisticsRef;
+
+/* Histograms, minimum, maximum, mean and percentiles of a region of an image,
+ * the numbers behind the area-reduction filters (kJRCategoryReduction) and
+ * auto-adjustment.
+ *
+ * The region is rendered in tiles on the context's threads and each tile is
+ * reduced and dropped, so a 50 MP photo never exists in the working format
+ * as a whole. A tile adds its pixels to one of a few partial results, one per
+ * thread that is running at the time, which are merged at the end. Bins are
+ * found for eight values at once with AVX2 or NEON, with the same rounding
+ * as the scalar code, and counted into two interleaved copies of each
+ * histogram so that neighbouring pixels do not wait on each other.
+ *
+ * With JRReductionOptions::maximumError, the analysis renders only a jittered
+ * grid of rows and of pixels within them: one row in each band of 'step'
+ * rows, one pixel in each run of 'step' pixels. The sample is sized by the
+ * Dvoretzky-Kiefer-Wolfowitz inequality, which bounds the error of every
+ * percentile at once. Minimum and maximum are then those of the sample. */
+class JRImageStatistics {
+public:
+	/* Returns nullptr for an empty or infinite 'bounds' or an invalid range
+	 * or bin count. Values are premultiplied, as rendered. */
+	static JRImageStatisticsRef statisticsWithImage(const JRImageRef& image, const JRIRect& bounds, const JRContext& context,
+													const JRReductionOptions& options = JRReductionOptions());
+
+	const JRReductionOptions& options() const { return _options; }
+	const JRIRect& bounds() const { return _bounds; }
+	/* The pixels analysed: all of bounds, or the sample. */
+	uint64_t pixelCount() const { return _pixelCount; }
+	/* The distance between sampled rows and pixels, 1 for every pixel. */
+	int sampleStep() const { return _sampleStep; }
+	/* The bound on percentile rank error this result guarantees with
+	 * probability kJRReductionConfidence, 0 for an exhaustive analysis. */
+	double errorBound() const { return _errorBound; }
+
+	/* options().binCount counts, bin i covering minimumValue + i * width up to
+	 * the next bin. */
+	const std::vector<uint64_t>& histogram(JRReductionChannel channel) const { return _histograms[channel]; }
+	float minimum(JRReductionChannel channel) const { return _minimum[channel]; }
+	float maximum(JRReductionChannel channel) const { return _maximum[channel]; }
+	double mean(JRReductionChannel channel) const { return _mean[channel]; }
+	/* The value below which 'fraction' (0 to 1) of the pixels fall, found in
+	 * the histogram and interpolated within its bin, so an exhaustive
+	 * analysis is exact to one bin width. Clamped to minimum and maximum. */
+	double percentile(JRReductionChannel channel, double fraction) const;
+
+private:
+	JRImageStatistics() = default;
+
+	JRReductionOptions _options;
+	JRIRect _bounds;
+	uint64_t _pixelCount = 0;
+	int _sampleStep = 1;
+	double _errorBound = 0;
+	std::vector<uint64_t> _histograms[kJRReductionChannelCount];
+	float _minimum[kJRReductionChannelCount] = {};
+	float _maximum[kJRReductionChannelCount] = {};
+	double _mean[kJRReductionChannelCount] = {};
+};
+
+#endif /* jr_Reduction_h */
@@ -0,0 +1,123 @@
+//
+//  jr_RenderBudget.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_RenderBudget.h"
+#include "jr_BufferPool.h"
+#include "jr_Parallel.h"
+
+#include <algorithm>
+#include <chrono>
+
+/// 当前线程持有的预留数. 预留在创建它的线程上释放
+static thread_local size_t JRHeldReservations = 0;
+
+JRRenderReservation::JRRenderReservation(JRRenderReservation&& other)
+: _budget(other._budget), _bytes(other._bytes)
+{
+	other._budget = nullptr;
+	other._bytes = 0;
+}
+
+JRRenderReservation& JRRenderReservation::operator=(JRRenderReservation&& other)
+{
+	if (this != &other) {
+		if (_budget) {
+			_budget->release(_bytes);
+		}
+		_budget = other._budget;
+		_bytes = other._bytes;
+		other._budget = nullptr;
+		other._bytes = 0;
+	}
+	return *this;
+}
+
+JRRenderReservation::~JRRenderReservation()
+{
+	if (_budget) {
+		_budget->release(_bytes);
+	}
+}
+
+JRRenderBudget::JRRenderBudget(size_t bytes)
+: _bytes(bytes), _bufferPool(JRBufferPool::sharedPool()), _nextTicket(0), _servingTicket(0), _statistics()
+{
+}
+
+JRRenderReservation JRRenderBudget::reserve(size_t bytes, JRRenderFit fit)
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_statistics.admitted++;
+	_statistics.smallerTiles += fit == kJRRenderFitSmallerTiles ? 1 : 0;
+	_statistics.bands += fit == kJRRenderFitBands ? 1 : 0;
+	_statistics.largestReservation = std::max(_statistics.largestReservation, bytes);
+
+	/// 线程已在另一次渲染之中 (持有预留, 或是线程池中的线程), 等待会让那次渲染永远完不成
+	if (JRHeldReservations == 0 && !JRThreadPool::currentPool()) {
+		/// 超出整个预算的渲染等到没有别的渲染时单独运行
+		bool exclusive = bytes > _bytes;
+		auto fits = [&]() { return exclusive ? _statistics.reservedBytes == 0 : _statistics.reservedBytes + bytes <= _bytes; };
+		_statistics.exclusive += exclusive ? 1 : 0;
+		uint64_t ticket = _nextTicket++;
+		if (ticket != _servingTicket || !fits()) {
+			_statistics.waited++;
+			_statistics.queueDepth++;
+			_statistics.peakQueueDepth = std::max(_statistics.peakQueueDepth, _statistics.queueDepth);
+			auto start = std::chrono::steady_clock::now();
+			_admitted.wait(lock, [&]() { return ticket == _servingTicket && fits(); });
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			_statistics.queueDepth--;
+			_statistics.waitSeconds += seconds;
+			_statistics.maximumWaitSeconds = std::max(_statistics.maximumWaitSeconds, seconds);
+		}
+		_servingTicket++;
+	}
+	_statistics.reservedBytes += bytes;
+	_statistics.peakReservedBytes = std::max(_statistics.peakReservedBytes, _statistics.reservedBytes);
+	size_t reservedBytes = _statistics.reservedBytes;
+	lock.unlock();
+	trimPool(reservedBytes);
+	JRHeldReservations++;
+	/// 下一个号码可能也放得下
+	_admitted.notify_all();
+	return JRRenderReservation(this, bytes);
+}
+
+void JRRenderBudget::release(size_t bytes)
+{
+	JRHeldReservations--;
+	size_t reservedBytes;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_statistics.reservedBytes -= bytes;
+		reservedBytes = _statistics.reservedBytes;
+	}
+	/// 这次渲染的块已回到池中, 只留下预算剩余的部分
+	trimPool(reservedBytes);
+	_admitted.notify_all();
+}
+
+void JRRenderBudget::trimPool(size_t reservedBytes)
+{
+	_bufferPool->trim(reservedBytes < _bytes ? _bytes - reservedBytes : 0);
+}
+
+JRRenderBudget::Statistics JRRenderBudget::statistics() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _statistics;
+}
+
+void JRRenderBudget::resetPeaks()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_statistics.peakQueueDepth = _statistics.queueDepth;
+	_statistics.peakReservedBytes = _statistics.reservedBytes;
+	_statistics.largestReservation = 0;
+	_statistics.maximumWaitSeconds = 0;
+}
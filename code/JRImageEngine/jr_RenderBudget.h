@@ -0,0 +1,133 @@
+//
+//  jr_RenderBudget.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_RenderBudget_h
+#define jr_RenderBudget_h
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+class JRBufferPool;
+class JRRenderBudget;
+
+/* How a render was made to fit its budget. */
+enum JRRenderFit {
+	/* With the context's tile size. */
+	kJRRenderFitAsAsked = 0,
+	/* With smaller tiles, so each thread holds less. */
+	kJRRenderFitSmallerTiles,
+	/* In bands, like renderBands, so intermediates only cover a band. */
+	kJRRenderFitBands,
+};
+
+/* The bytes one render holds in a JRRenderBudget, released when the
+ * reservation is destroyed, on the thread that made it. Movable, not
+ * copyable. */
+class JRRenderReservation {
+public:
+	JRRenderReservation() : _budget(nullptr), _bytes(0) {}
+	JRRenderReservation(JRRenderReservation&& other);
+	JRRenderReservation& operator=(JRRenderReservation&& other);
+	~JRRenderReservation();
+
+	JRRenderReservation(const JRRenderReservation&) = delete;
+	JRRenderReservation& operator=(const JRRenderReservation&) = delete;
+
+	size_t bytes() const { return _bytes; }
+
+private:
+	friend class JRRenderBudget;
+	JRRenderReservation(JRRenderBudget* budget, size_t bytes) : _budget(budget), _bytes(bytes) {}
+
+	JRRenderBudget* _budget;
+	size_t _bytes;
+};
+
+/* A memory budget shared by the renders of one or more contexts, the
+ * admission control of a service where many requests share a process. Set
+ * it as JRContextOptions::renderBudget.
+ *
+ * Before a render starts, its context estimates the working-format bytes it
+ * will hold at its peak (see JRRenderPlan::peakBytes) and reserves them
+ * here. A render that does not fit waits in a queue, in arrival order, so a
+ * large render is not starved by a stream of small ones. A render that could
+ * never fit is first made smaller: smaller tiles, then bands. If it still
+ * does not fit, it waits until no other render holds any of the budget and
+ * runs alone, over the budget, instead of being refused.
+ *
+ * Blocks idle in JRBufferPool::sharedPool() are resident too, so they are
+ * charged against the same bytes: when a render is admitted or releases its
+ * reservation, the pool frees idle blocks until reserved plus idle bytes fit
+ * the budget. The pool's own idleLimit() still applies on top.
+ *
+ * Two kinds of render skip admission and are reserved at once, even over the
+ * budget: a render started on a thread that already holds a reservation (a
+ * renderBands consumer that renders, or a render nested in another), and any
+ * render started on a JRThreadPool thread, such as one inside a kernel or a
+ * parallel loop. Waiting there could block the render that thread is serving
+ * forever. Their bytes still count against the renders that wait. Thread-safe;
+ * the budget must outlive the contexts using it. */
+class JRRenderBudget {
+public:
+	struct Statistics {
+		/* Renders admitted, and of those, how many had to wait. */
+		size_t admitted;
+		size_t waited;
+		/* Renders admitted with smaller tiles, in bands, and alone over the
+		 * budget. */
+		size_t smallerTiles;
+		size_t bands;
+		size_t exclusive;
+		/* Renders waiting now, and the most that ever waited together. */
+		size_t queueDepth;
+		size_t peakQueueDepth;
+		/* Bytes reserved by running renders, and the highest value. */
+		size_t reservedBytes;
+		size_t peakReservedBytes;
+		/* The largest single reservation. */
+		size_t largestReservation;
+		/* Time spent waiting, in total and the longest single wait. */
+		double waitSeconds;
+		double maximumWaitSeconds;
+	};
+
+	explicit JRRenderBudget(size_t bytes);
+
+	size_t bytes() const { return _bytes; }
+
+	/* Blocks until 'bytes' can be reserved, as described above. 'fit' is
+	 * only counted in statistics(). */
+	JRRenderReservation reserve(size_t bytes, JRRenderFit fit = kJRRenderFitAsAsked);
+
+	Statistics statistics() const;
+	/* Restarts the peaks, the largest reservation and the longest wait. */
+	void resetPeaks();
+
+private:
+	friend class JRRenderReservation;
+
+	void release(size_t bytes);
+	/// 空闲块与预留一起不超过预算
+	void trimPool(size_t reservedBytes);
+
+	const size_t _bytes;
+	const std::shared_ptr<JRBufferPool> _bufferPool;
+	mutable std::mutex _mutex;
+	std::condition_variable _admitted;
+	/// 排队的号码: 按到达顺序放行
+	uint64_t _nextTicket;
+	uint64_t _servingTicket;
+	Statistics _statistics;
+};
+
+typedef std::shared_ptr<JRRenderBudget> JRRenderBudgetRef;
+
+#endif /* jr_RenderBudget_h */
@@ -0,0 +1,199 @@
+//
+//  jr_RenderCache.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_RenderCache.h"
+
+static size_t JRBufferBytes(const JRBuffer& buffer)
+{
+	return buffer.rowFloats() * size_t(buffer.rect().height) * sizeof(float);
+}
+
+JRRenderCache::JRRenderCache(size_t budget)
+: _budget(budget), _bytes(0), _clock(0), _statistics()
+{
+}
+
+size_t JRRenderCache::budget() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _budget;
+}
+
+void JRRenderCache::setBudget(size_t budget)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_budget = budget;
+	evictToFit(budget);
+}
+
+JRBuffer JRRenderCache::lookup(const JRImage& image, const JRIRect& rect)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	removeEntriesWithExpiredSources();
+	auto range = _entries.equal_range(image.structuralHash());
+	for (auto it = range.first; it != range.second; ++it) {
+		Entry& entry = it->second;
+		std::set<std::pair<size_t, const JRImage*>> compared;
+		if (entry.buffer.rect().contains(rect) && matches(entry.nodes, entry.nodes.size() - 1, image, compared)) {
+			entry.priority = _clock + entry.cost / double(entry.bytes);
+			_statistics.hits++;
+			return entry.buffer;
+		}
+	}
+	_statistics.misses++;
+	return JRBuffer();
+}
+
+void JRRenderCache::insert(const JRImageRef& image, const JRBuffer& buffer, double cost)
+{
+	size_t bytes = JRBufferBytes(buffer);
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!image || bytes == 0 || bytes > _budget) {
+		return;
+	}
+	removeEntriesWithExpiredSources();
+	/// 同一 image 已有的、被新区域覆盖的条目不再需要
+	auto range = _entries.equal_range(image->structuralHash());
+	for (auto it = range.first; it != range.second;) {
+		std::set<std::pair<size_t, const JRImage*>> compared;
+		if (buffer.rect().contains(it->second.buffer.rect()) && matches(it->second.nodes, it->second.nodes.size() - 1, *image, compared)) {
+			_bytes -= it->second.bytes;
+			it = _entries.erase(it);
+		} else {
+			++it;
+		}
+	}
+	evictToFit(_budget - bytes);
+	Entry entry = { {}, buffer, bytes, cost, _clock + cost / double(bytes) };
+	std::unordered_map<const JRImage*, size_t> indices;
+	appendNodes(*image, entry.nodes, indices);
+	_entries.insert({ image->structuralHash(), std::move(entry) });
+	_bytes += bytes;
+}
+
+void JRRenderCache::removeAllEntries()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries.clear();
+	_bytes = 0;
+}
+
+JRRenderCache::Statistics JRRenderCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	Statistics statistics = _statistics;
+	statistics.entries = _entries.size();
+	statistics.bytes = _bytes;
+	return statistics;
+}
+
+size_t JRRenderCache::appendNodes(const JRImage& image, std::vector<Node>& nodes, std::unordered_map<const JRImage*, size_t>& indices)
+{
+	auto found = indices.find(&image);
+	if (found != indices.end()) {
+		return found->second;
+	}
+	std::vector<size_t> inputs;
+	for (const JRImageRef& input : image.inputs()) {
+		inputs.push_back(appendNodes(*input, nodes, indices));
+	}
+	nodes.push_back({ image.kind(), image.provider(), image.color(), image.transform(), image.rect(), image.kernel(), image.arguments(), std::move(inputs) });
+	indices[&image] = nodes.size() - 1;
+	return nodes.size() - 1;
+}
+
+bool JRRenderCache::matches(const std::vector<Node>& nodes, size_t index, const JRImage& image, std::set<std::pair<size_t, const JRImage*>>& compared)
+{
+	const Node& node = nodes[index];
+	if (node.kind != image.kind() || node.inputs.size() != image.inputs().size()) {
+		return false;
+	}
+	/// 与 JRImage::isStructurallyEqual 相同: 不匹配会一路返回, 见过的节点对都匹配
+	if (!compared.insert({ index, &image }).second) {
+		return true;
+	}
+	switch (node.kind) {
+		case kJRImageKindEmpty:
+			break;
+		case kJRImageKindProvider:
+			/// 已销毁的源不等于任何活着的源
+			if (node.provider.owner_before(image.provider()) || image.provider().owner_before(node.provider)) {
+				return false;
+			}
+			break;
+		case kJRImageKindColor:
+			if (!(node.color == image.color())) {
+				return false;
+			}
+			break;
+		case kJRImageKindTransform: {
+			const JRAffineTransform& t = node.transform;
+			const JRAffineTransform& u = image.transform();
+			if (t.a != u.a || t.b != u.b || t.c != u.c || t.d != u.d || t.tx != u.tx || t.ty != u.ty) {
+				return false;
+			}
+			break;
+		}
+		case kJRImageKindCrop:
+		case kJRImageKindClamp:
+			if (!JRRectEqualToRect(node.rect, image.rect())) {
+				return false;
+			}
+			break;
+		case kJRImageKindKernel:
+			if (!node.kernel->isEqual(*image.kernel()) || node.arguments != image.arguments()) {
+				return false;
+			}
+			break;
+	}
+	for (size_t i = 0; i < node.inputs.size(); i++) {
+		if (!matches(nodes, node.inputs[i], *image.inputs()[i], compared)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool JRRenderCache::hasExpiredSource(const Entry& entry)
+{
+	for (const Node& node : entry.nodes) {
+		if (node.kind == kJRImageKindProvider && node.provider.expired()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void JRRenderCache::removeEntriesWithExpiredSources()
+{
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		if (hasExpiredSource(it->second)) {
+			_bytes -= it->second.bytes;
+			it = _entries.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void JRRenderCache::evictToFit(size_t budget)
+{
+	/// 条目数很少 (每次渲染几个), 线性查找最小优先级即可
+	while (_bytes > budget && !_entries.empty()) {
+		auto victim = _entries.begin();
+		for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+			if (it->second.priority < victim->second.priority) {
+				victim = it;
+			}
+		}
+		_clock = victim->second.priority;
+		_bytes -= victim->second.bytes;
+		_entries.erase(victim);
+		_statistics.evictions++;
+	}
+}
@@ -0,0 +1,100 @@
+//
+//  jr_RenderCache.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_RenderCache_h
+#define jr_RenderCache_h
+
+#include "jr_Buffer.h"
+#include "jr_Image.h"
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+/* Rendered intermediates keyed by JRImage::structuralHash() and rect. A
+ * recipe rebuilt with the same filters and parameters finds the pixels of
+ * the previous render, even though its JRImage objects are new.
+ *
+ * Entries are evicted cost-aware (GreedyDual-Size): each entry's priority is
+ * the clock at its last use plus the seconds it took to render per byte. The
+ * entry with the lowest priority goes first, and the clock advances to it.
+ * With equal costs this is LRU; an expensive small entry outlives a cheap
+ * large one.
+ *
+ * Entries do not keep the images they were rendered from alive. Each one
+ * stores a copy of the recipe with its sources held weakly, and an entry
+ * whose source has been destroyed can never match again, so it is dropped
+ * on the next lookup or insert. Thread-safe. */
+class JRRenderCache {
+public:
+	struct Statistics {
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+		size_t entries;
+		size_t bytes;
+	};
+
+	explicit JRRenderCache(size_t budget);
+
+	size_t budget() const;
+	/* Evicts as needed to fit the new budget. */
+	void setBudget(size_t budget);
+
+	/* The pixels of 'image' covering 'rect', or an empty buffer. The result
+	 * may cover more than 'rect' and must not be written. */
+	JRBuffer lookup(const JRImage& image, const JRIRect& rect);
+	/* Stores the pixels of 'image'. 'cost' is the time in seconds it took to
+	 * render them. Entries larger than the budget are not stored, and neither
+	 * is 'image' itself. */
+	void insert(const JRImageRef& image, const JRBuffer& buffer, double cost);
+
+	void removeAllEntries();
+	Statistics statistics() const;
+
+private:
+	/// 子图的一个节点, 不持有源. 共享的节点只存一次
+	struct Node {
+		JRImageKind kind;
+		/// weak_ptr 按控制块比较身份, 控制块在它销毁前不会被复用
+		std::weak_ptr<const JRImageProvider> provider;
+		JRColor color;
+		JRAffineTransform transform;
+		JRRect rect;
+		JRKernelRef kernel;
+		JRKernelArguments arguments;
+		/// 输入在 nodes 中的下标, 都在本节点之前
+		std::vector<size_t> inputs;
+	};
+
+	struct Entry {
+		/// 子图的节点, 后序排列, 最后一个是根
+		std::vector<Node> nodes;
+		JRBuffer buffer;
+		size_t bytes;
+		double cost;
+		double priority;
+	};
+
+	static size_t appendNodes(const JRImage& image, std::vector<Node>& nodes, std::unordered_map<const JRImage*, size_t>& indices);
+	static bool matches(const std::vector<Node>& nodes, size_t index, const JRImage& image, std::set<std::pair<size_t, const JRImage*>>& compared);
+	static bool hasExpiredSource(const Entry& entry);
+	void removeEntriesWithExpiredSources();
+	void evictToFit(size_t budget);
+
+	mutable std::mutex _mutex;
+	std::unordered_multimap<uint64_t, Entry> _entries;
+	size_t _budget;
+	size_t _bytes;
+	double _clock;
+	Statistics _statistics;
+};
+
+#endif /* jr_RenderCache_h */
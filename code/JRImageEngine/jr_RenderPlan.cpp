@@ -0,0 +1,227 @@
+//
+//  jr_RenderPlan.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_RenderPlan.h"
+#include "jr_BufferPool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+/// 超过这个大小 (1 GiB) 的中间结果不保留, 仍按 tile 计算
+static const int64_t kJRRenderPlanMaximumPixels = int64_t(1) << 26;
+
+/// 后序遍历: 每个节点排在它的输入之后. 同时统计每个节点的使用者
+static void JRVisitGraph(const JRImage& image, std::vector<const JRImage*>& order,
+						 std::unordered_map<const JRImage*, int>& consumers)
+{
+	std::function<void(const JRImage*)> visit = [&](const JRImage* node) {
+		for (const JRImageRef& input : node->inputs()) {
+			if (consumers[input.get()]++ == 0) {
+				visit(input.get());
+			}
+		}
+		order.push_back(node);
+	};
+	visit(&image);
+}
+
+static std::unordered_map<const JRImage*, JRRect> JRRegionsOfInterest(const std::vector<const JRImage*>& order, const JRIRect& bounds)
+{
+	/// 从输出往回, 求每个节点在整个渲染中需要的区域
+	std::unordered_map<const JRImage*, JRRect> rois;
+	rois[order.back()] = JRRectFromIRect(bounds);
+	for (auto it = order.rbegin(); it != order.rend(); ++it) {
+		const JRImage* node = *it;
+		auto found = rois.find(node);
+		if (found == rois.end() || found->second.isNull()) {
+			continue;
+		}
+		JRRect roi = found->second;
+		for (size_t i = 0; i < node->inputs().size(); i++) {
+			const JRImage* input = node->inputs()[i].get();
+			auto existing = rois.find(input);
+			JRRect inputROI = node->inputRegionOfInterest(i, roi);
+			rois[input] = existing == rois.end() ? inputROI : JRRectUnion(existing->second, inputROI);
+		}
+	}
+	return rois;
+}
+
+JRRenderPlan::JRRenderPlan(const JRImage& image, const JRIRect& bounds, int tileSize, bool streams)
+: _tileSize(tileSize)
+{
+	std::vector<const JRImage*> order;
+	std::unordered_map<const JRImage*, int> consumers;
+	JRVisitGraph(image, order, consumers);
+	std::unordered_map<const JRImage*, JRRect> rois = JRRegionsOfInterest(order, bounds);
+
+	std::unordered_map<const JRImage*, bool> readByGeneralKernel;
+	for (const JRImage* node : order) {
+		if (node->kind() == kJRImageKindKernel && node->kernel()->type() == kJRKernelTypeGeneral) {
+			for (const JRImageRef& input : node->inputs()) {
+				readByGeneralKernel[input.get()] = true;
+			}
+		}
+	}
+
+	bool tiled = !streams && (bounds.width > tileSize || bounds.height > tileSize);
+	for (const JRImage* node : order) {
+		if (node->kind() == kJRImageKindEmpty || node->kind() == kJRImageKindColor) {
+			continue;
+		}
+		/// 条带中有多个使用者的源也物化: 它们读取的行不同, 逐行解码的源只能前进
+		bool shared = consumers[node] >= 2;
+		if (node->kind() == kJRImageKindProvider ? !(streams && shared)
+			: node == &image || (!shared && !(tiled && readByGeneralKernel[node]))) {
+			continue;
+		}
+		JRRect needed = JRRectIntersection(rois[node], node->extent());
+		if (needed.isNull() || needed.isEmpty() || needed.isInfinite()) {
+			continue;
+		}
+		JRIRect rect = JRIRectFromRect(needed);
+		if (rect.isEmpty() || rect.area() > kJRRenderPlanMaximumPixels) {
+			continue;
+		}
+		_intermediates.push_back({ node, rect, 0 });
+	}
+
+	/// 活跃分析: 每次渲染会经过未物化的节点读到哪些中间结果
+	std::unordered_map<const JRImage*, size_t> indices;
+	for (size_t i = 0; i < _intermediates.size(); i++) {
+		indices[_intermediates[i].image] = i;
+	}
+	auto markReads = [&](const JRImage* root, size_t reader) {
+		std::unordered_map<const JRImage*, bool> visited;
+		std::function<void(const JRImage*)> visit = [&](const JRImage* node) {
+			for (const JRImageRef& input : node->inputs()) {
+				if (visited[input.get()]) {
+					continue;
+				}
+				visited[input.get()] = true;
+				auto found = indices.find(input.get());
+				if (found != indices.end()) {
+					_intermediates[found->second].lastUse = reader;
+				} else {
+					visit(input.get());
+				}
+			}
+		};
+		visit(root);
+	};
+	/// 按顺序标记, 后面的读取覆盖前面的
+	for (size_t i = 0; i < _intermediates.size(); i++) {
+		markReads(_intermediates[i].image, i);
+	}
+	markReads(&image, kJRRenderPlanFinal);
+	auto root = indices.find(&image);
+	if (root != indices.end()) {
+		_intermediates[root->second].lastUse = kJRRenderPlanFinal;
+	}
+}
+
+std::unordered_map<const JRImage*, JRRect> JRRenderPlan::regionsOfInterest(const JRImage& image, const JRIRect& bounds)
+{
+	std::vector<const JRImage*> order;
+	std::unordered_map<const JRImage*, int> consumers;
+	JRVisitGraph(image, order, consumers);
+	return JRRegionsOfInterest(order, bounds);
+}
+
+/// 按 JRBufferPool 的档位取整, 大的中间结果可能多出近 25%
+static size_t JRBytesForRect(const JRIRect& rect)
+{
+	return rect.isEmpty() ? 0 : JRBufferPool::blockBytes(size_t(rect.area()) * 4 * sizeof(float));
+}
+
+/// tile 经过的每个节点分配一块它需要的区域; 下标小于 limit 的中间结果已物化, 不再往下
+static size_t JRTileBytes(const JRImage& node, const JRRect& roi, const std::unordered_map<const JRImage*, size_t>& indices, size_t limit)
+{
+	JRRect needed = JRRectIntersection(roi, node.extent());
+	if (needed.isNull() || needed.isEmpty() || needed.isInfinite()) {
+		return 0;
+	}
+	size_t bytes = JRBytesForRect(JRIRectFromRect(needed));
+	/// 可分离的 kernel (模糊, 形态学) 先把一个方向的结果写进同样大小的临时 buffer
+	if (node.kind() == kJRImageKindKernel && node.kernel()->type() == kJRKernelTypeGeneral) {
+		bytes *= 2;
+	}
+	for (size_t i = 0; i < node.inputs().size(); i++) {
+		const JRImage* input = node.inputs()[i].get();
+		auto found = indices.find(input);
+		if (found == indices.end() || found->second >= limit) {
+			bytes += JRTileBytes(*input, node.inputRegionOfInterest(i, roi), indices, limit);
+		}
+	}
+	return bytes;
+}
+
+size_t JRRenderPlan::tileBytes(const JRImage& image, const JRIRect& tile, const JRRenderPlan* plan)
+{
+	std::unordered_map<const JRImage*, size_t> indices;
+	for (size_t i = 0; plan && i < plan->_intermediates.size(); i++) {
+		indices[plan->_intermediates[i].image] = i;
+	}
+	return JRTileBytes(image, JRRectFromIRect(tile), indices, indices.size());
+}
+
+size_t JRRenderPlan::peakBytes(const JRImage& image, const JRIRect& bounds, size_t threads) const
+{
+	std::unordered_map<const JRImage*, size_t> indices;
+	for (size_t i = 0; i < _intermediates.size(); i++) {
+		indices[_intermediates[i].image] = i;
+	}
+	/// 第一个 tile 代表所有 tile; 同时进行的 tile 不超过线程数
+	auto tiles = [&](const JRImage& root, const JRIRect& rect, size_t limit) {
+		JRIRect first = { rect.x, rect.y, std::min(_tileSize, rect.width), std::min(_tileSize, rect.height) };
+		size_t count = size_t((rect.width + _tileSize - 1) / _tileSize) * size_t((rect.height + _tileSize - 1) / _tileSize);
+		return JRTileBytes(root, JRRectFromIRect(first), indices, limit) * std::max<size_t>(1, std::min(threads, count));
+	};
+
+	/// 与 JRContext::materialize 的顺序相同: 渲染第 i 个, 然后释放最后由它读取的
+	size_t live = 0;
+	size_t peak = 0;
+	for (size_t i = 0; i < _intermediates.size(); i++) {
+		const Intermediate& intermediate = _intermediates[i];
+		live += JRBytesForRect(intermediate.rect);
+		/// 数据源整块读入自己的 buffer, 不经过 tile
+		size_t working = intermediate.image->kind() == kJRImageKindProvider ? 0 : tiles(*intermediate.image, intermediate.rect, i);
+		peak = std::max(peak, live + working);
+		for (size_t j = 0; j < i; j++) {
+			if (_intermediates[j].lastUse == i) {
+				live -= JRBytesForRect(_intermediates[j].rect);
+			}
+		}
+	}
+	return std::max(peak, live + tiles(image, bounds, _intermediates.size()));
+}
+
+size_t JRRenderPlan::intermediateBytes() const
+{
+	size_t bytes = 0;
+	for (const Intermediate& intermediate : _intermediates) {
+		bytes += JRBytesForRect(intermediate.rect);
+	}
+	return bytes;
+}
+
+void JRRenderPlan::setBuffer(const JRImage* image, const JRBuffer& buffer)
+{
+	if (buffer.rect().isEmpty()) {
+		_buffers.erase(image);
+	} else {
+		_buffers[image] = buffer;
+	}
+}
+
+const JRBuffer* JRRenderPlan::bufferForImage(const JRImage* image) const
+{
+	auto found = _buffers.find(image);
+	return found == _buffers.end() ? nullptr : &found->second;
+}
@@ -0,0 +1,83 @@
+//
+//  jr_RenderPlan.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_RenderPlan_h
+#define jr_RenderPlan_h
+
+#include "jr_Buffer.h"
+#include "jr_Image.h"
+
+#include <unordered_map>
+#include <vector>
+
+inline constexpr size_t kJRRenderPlanFinal = size_t(-1);
+
+/* Decides which nodes of a graph one render computes once, up front, rather
+ * than again in every tile. Internal to JRContext.
+ *
+ * A node is materialised when it has more than one consumer, or when it feeds
+ * a JRGeneralKernel and the render spans several tiles. In the second case
+ * neighbouring tiles read overlapping halos of it. Sources (providers and
+ * colours) are never materialised, because reading them again is as cheap as
+ * copying. */
+class JRRenderPlan {
+public:
+	struct Intermediate {
+		const JRImage* image;
+		/// 整个渲染需要的区域, 已与 extent 求交
+		JRIRect rect;
+		/* The index of the last intermediate that reads this one, or
+		 * kJRRenderPlanFinal if the output tiles read it. After that
+		 * intermediate is rendered, the buffer can be released. */
+		size_t lastUse;
+	};
+
+	/* With 'streams', the plan is for one band of JRContext::renderBands and
+	 * only nodes with several consumers are materialised, sources included,
+	 * so a shared source is still read once per band, in row order. The
+	 * inputs of general kernels are rendered again with each tile's halo, as
+	 * in a render too large to materialise, so a band holds no full-width
+	 * copy of them. */
+	JRRenderPlan(const JRImage& image, const JRIRect& bounds, int tileSize, bool streams = false);
+
+	/* The rect of every node of 'image' needed to render 'bounds' of it: the
+	 * union of what each of its consumers asks for. */
+	static std::unordered_map<const JRImage*, JRRect> regionsOfInterest(const JRImage& image, const JRIRect& bounds);
+
+	/* The nodes to materialise, each listed after the ones it reads. */
+	const std::vector<Intermediate>& intermediates() const { return _intermediates; }
+	int tileSize() const { return _tileSize; }
+
+	/* An estimate of the working-format bytes the render holds at its peak,
+	 * for JRRenderBudget: the intermediates alive at once (see lastUse),
+	 * plus the buffers 'threads' tiles allocate together while an
+	 * intermediate or the output is rendered. A general kernel counts twice,
+	 * for the pass a separable filter keeps between its two directions. Sizes
+	 * are rounded up to JRBufferPool size classes. */
+	size_t peakBytes(const JRImage& image, const JRIRect& bounds, size_t threads) const;
+	/* The bytes of every intermediate together. */
+	size_t intermediateBytes() const;
+	/* The buffers one tile allocates through the nodes of 'image' that
+	 * 'plan' (which may be null) does not materialise, 'tile' itself
+	 * included. */
+	static size_t tileBytes(const JRImage& image, const JRIRect& tile, const JRRenderPlan* plan);
+
+	/* Records the pixels of a materialised node, or drops them when
+	 * 'buffer' is empty. Called between renders, never while tiles are being
+	 * rendered. */
+	void setBuffer(const JRImage* image, const JRBuffer& buffer);
+	/* The pixels of 'image' if they have been materialised, or nullptr. */
+	const JRBuffer* bufferForImage(const JRImage* image) const;
+
+private:
+	std::vector<Intermediate> _intermediates;
+	int _tileSize;
+	std::unordered_map<const JRImage*, JRBuffer> _buffers;
+};
+
+#endif /* jr_RenderPlan_h */
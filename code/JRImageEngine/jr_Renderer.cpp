@@ -0,0 +1,420 @@
+//
+//  jr_Renderer.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Renderer.h"
+#include "jr_Compositing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/// 清除 valid 以外的部分
+static void JRClearOutside(const JRBuffer& output, const JRIRect& valid)
+{
+	const JRIRect& r = output.rect();
+	if (valid.isEmpty()) {
+		output.clear();
+		return;
+	}
+	if (valid == r) {
+		return;
+	}
+	output.clear({ r.x, r.y, r.width, valid.y - r.y });
+	output.clear({ r.x, valid.maxY(), r.width, r.maxY() - valid.maxY() });
+	output.clear({ r.x, valid.y, valid.x - r.x, valid.height });
+	output.clear({ valid.maxX(), valid.y, r.maxX() - valid.maxX(), valid.height });
+}
+
+/// 合成时逐块判断覆盖情况的边长
+static const int kJRCompositeBlock = 64;
+
+/// 不渲染就能知道的覆盖情况: extent 以外透明, 纯色, 以及穿过裁剪和整数平移
+static JRAlphaCoverage JRKnownCoverage(const JRImage& image, const JRIRect& rect)
+{
+	if (JRIRectIntersection(rect, JRIRectFromRect(image.extent())).isEmpty()) {
+		return kJRAlphaClear;
+	}
+	switch (image.kind()) {
+		case kJRImageKindColor: {
+			JRColor c = image.color();
+			return c.alpha == 1 ? kJRAlphaOpaque : c.alpha == 0 ? kJRAlphaClear : kJRAlphaPartial;
+		}
+		case kJRImageKindCrop:
+			if (JRIRectFromRect(image.rect()).contains(rect)) {
+				return JRKnownCoverage(*image.inputs()[0], rect);
+			}
+			break;
+		case kJRImageKindTransform: {
+			const JRAffineTransform& t = image.transform();
+			if (t.isIntegerTranslation()) {
+				return JRKnownCoverage(*image.inputs()[0], { rect.x - int(t.tx), rect.y - int(t.ty), rect.width, rect.height });
+			}
+			break;
+		}
+		default:
+			break;
+	}
+	return kJRAlphaPartial;
+}
+
+/// 双线性采样, buffer 以外视为透明
+static inline void JRSampleBilinear(const JRBuffer& src, double fx, double fy, float* out)
+{
+	const JRIRect& r = src.rect();
+	double x0f = std::floor(fx);
+	double y0f = std::floor(fy);
+	float wx = float(fx - x0f);
+	float wy = float(fy - y0f);
+	int x0 = int(x0f);
+	int y0 = int(y0f);
+	out[0] = out[1] = out[2] = out[3] = 0;
+
+	const float weights[4] = { (1 - wx) * (1 - wy), wx * (1 - wy), (1 - wx) * wy, wx * wy };
+	const int xs[4] = { x0, x0 + 1, x0, x0 + 1 };
+	const int ys[4] = { y0, y0, y0 + 1, y0 + 1 };
+	for (int i = 0; i < 4; i++) {
+		if (weights[i] == 0 || xs[i] < r.x || xs[i] >= r.maxX() || ys[i] < r.y || ys[i] >= r.maxY()) {
+			continue;
+		}
+		const float* p = src.pixelAt(xs[i], ys[i]);
+		out[0] += p[0] * weights[i];
+		out[1] += p[1] * weights[i];
+		out[2] += p[2] * weights[i];
+		out[3] += p[3] * weights[i];
+	}
+}
+
+JRRenderer::JRRenderer(const JRRenderPlan* plan, JRProfileRecorder* recorder)
+: _plan(plan)
+, _recorder(recorder)
+{
+}
+
+void JRRenderer::render(const JRImage& image, const JRBuffer& output)
+{
+	if (output.rect().isEmpty()) {
+		return;
+	}
+	if (!_recorder) {
+		renderNode(image, output);
+		return;
+	}
+	_recorder->beginNode();
+	renderNode(image, output);
+	_recorder->endNode(image, output.rect());
+}
+
+void JRRenderer::renderNode(const JRImage& image, const JRBuffer& output)
+{
+	const JRBuffer* materialized = _plan ? _plan->bufferForImage(&image) : nullptr;
+	if (materialized) {
+		if (_recorder) {
+			_recorder->recordCacheLookup(image, true);
+		}
+		/// 已经算好的中间结果, 之外的部分在 extent 以外
+		JRIRect valid = JRIRectIntersection(output.rect(), materialized->rect());
+		JRClearOutside(output, valid);
+		if (!valid.isEmpty()) {
+			output.view(valid).copyFrom(*materialized);
+		}
+		return;
+	}
+	switch (image.kind()) {
+		case kJRImageKindEmpty:
+			output.clear();
+			break;
+		case kJRImageKindColor: {
+			JRColor c = image.color();
+			output.fill(JRColor::colorWithRed(c.red * c.alpha, c.green * c.alpha, c.blue * c.alpha, c.alpha));
+			break;
+		}
+		case kJRImageKindProvider:
+			renderProvider(image, output);
+			break;
+		case kJRImageKindTransform:
+			renderTransform(image, output);
+			break;
+		case kJRImageKindCrop:
+			renderCrop(image, output);
+			break;
+		case kJRImageKindClamp:
+			renderClamp(image, output);
+			break;
+		case kJRImageKindKernel:
+			if (dynamic_cast<const JRCompositeKernel*>(image.kernel().get())) {
+				renderCompositeKernel(image, output);
+			} else if (image.kernel()->type() == kJRKernelTypeColor) {
+				renderColorKernel(image, output);
+			} else {
+				renderGeneralKernel(image, output);
+			}
+			break;
+	}
+}
+
+JRBuffer JRRenderer::renderInput(const JRImage& input, const JRIRect& roi)
+{
+	/// 输入只读, 可以直接用中间结果的内存
+	const JRBuffer* materialized = _plan ? _plan->bufferForImage(&input) : nullptr;
+	if (_recorder) {
+		_recorder->recordRead(roi);
+	}
+	if (materialized && !roi.isEmpty() && materialized->rect().contains(roi)) {
+		if (_recorder) {
+			_recorder->recordCacheLookup(input, true);
+		}
+		return materialized->view(roi);
+	}
+	const JRBuffer* pixels = input.kind() == kJRImageKindProvider ? input.provider()->pixels() : nullptr;
+	if (pixels && !roi.isEmpty() && pixels->rect().contains(roi)) {
+		return pixels->view(roi);
+	}
+	if (_recorder) {
+		_recorder->recordAllocation(roi);
+	}
+	JRBuffer buffer = JRBuffer::bufferWithRect(roi);
+	render(input, buffer);
+	return buffer;
+}
+
+void JRRenderer::renderProvider(const JRImage& image, const JRBuffer& output)
+{
+	JRIRect valid = JRIRectIntersection(output.rect(), image.provider()->extent());
+	JRClearOutside(output, valid);
+	if (!valid.isEmpty()) {
+		if (_recorder) {
+			_recorder->recordRead(valid);
+		}
+		image.provider()->read(valid, output.view(valid));
+	}
+}
+
+void JRRenderer::renderTransform(const JRImage& image, const JRBuffer& output)
+{
+	const JRImage& input = *image.inputs()[0];
+	const JRAffineTransform& t = image.transform();
+	const JRIRect& r = output.rect();
+
+	if (t.isIntegerTranslation()) {
+		/// 整数平移: 直接把输出内存当作平移后的 input buffer
+		JRIRect shifted = { r.x - int(t.tx), r.y - int(t.ty), r.width, r.height };
+		render(input, JRBuffer::bufferWithPixels(output.data(), output.rowFloats(), shifted));
+		return;
+	}
+
+	JRIRect valid = JRIRectIntersection(r, JRIRectFromRect(image.extent()));
+	JRIRect roi = JRIRectFromRect(image.inputRegionOfInterest(0, JRRectFromIRect(valid)));
+	roi = JRIRectIntersection(roi, JRIRectFromRect(input.extent()));
+	if (valid.isEmpty() || roi.isEmpty()) {
+		output.clear();
+		return;
+	}
+	JRClearOutside(output, valid);
+	JRBuffer source = renderInput(input, roi);
+
+	JRAffineTransform inv = JRAffineTransformInvert(t);
+	for (int y = valid.y; y < valid.maxY(); y++) {
+		double sx, sy;
+		JRAffineTransformApply(inv, valid.x + 0.5, y + 0.5, &sx, &sy);
+		float* p = output.pixelAt(valid.x, y);
+		for (int x = 0; x < valid.width; x++, p += 4) {
+			JRSampleBilinear(source, sx - 0.5, sy - 0.5, p);
+			sx += inv.a;
+			sy += inv.b;
+		}
+	}
+}
+
+void JRRenderer::renderCrop(const JRImage& image, const JRBuffer& output)
+{
+	JRIRect valid = JRIRectIntersection(output.rect(), JRIRectFromRect(image.rect()));
+	JRClearOutside(output, valid);
+	if (!valid.isEmpty()) {
+		render(*image.inputs()[0], output.view(valid));
+	}
+}
+
+void JRRenderer::renderClamp(const JRImage& image, const JRBuffer& output)
+{
+	const JRIRect& r = output.rect();
+	JRIRect roi = JRIRectFromRect(image.inputRegionOfInterest(0, JRRectFromIRect(r)));
+	if (roi.isEmpty()) {
+		output.clear();
+		return;
+	}
+	if (roi == r) {
+		render(*image.inputs()[0], output);
+		return;
+	}
+
+	JRBuffer source = renderInput(*image.inputs()[0], roi);
+	/// 中间部分整行拷贝, 两侧复制边缘像素
+	int innerX0 = std::max(r.x, roi.x);
+	int innerX1 = std::min(r.maxX(), roi.maxX());
+	for (int y = r.y; y < r.maxY(); y++) {
+		int sy = std::min(std::max(y, roi.y), roi.maxY() - 1);
+		float* dst = output.rowAt(y);
+		const float* left = source.pixelAt(roi.x, sy);
+		const float* right = source.pixelAt(roi.maxX() - 1, sy);
+		int x = r.x;
+		for (; x < innerX0; x++, dst += 4) {
+			std::memcpy(dst, left, 4 * sizeof(float));
+		}
+		if (innerX1 > innerX0) {
+			std::memcpy(dst, source.pixelAt(innerX0, sy), size_t(innerX1 - innerX0) * 4 * sizeof(float));
+			dst += size_t(innerX1 - innerX0) * 4;
+			x = innerX1;
+		}
+		for (; x < r.maxX(); x++, dst += 4) {
+			std::memcpy(dst, right, 4 * sizeof(float));
+		}
+	}
+}
+
+void JRRenderer::renderColorKernel(const JRImage& image, const JRBuffer& output)
+{
+	const JRColorKernel& kernel = static_cast<const JRColorKernel&>(*image.kernel());
+	const std::vector<JRImageRef>& inputs = image.inputs();
+	JRIRect valid = JRIRectIntersection(output.rect(), JRIRectFromRect(image.extent()));
+	if (valid.isEmpty()) {
+		output.clear();
+		return;
+	}
+	JRClearOutside(output, valid);
+
+	JRBuffer pixels = output.view(valid);
+	if (inputs.empty()) {
+		pixels.clear();
+	} else {
+		/// 第一个输入就地渲染到输出中, 也算作读取
+		if (_recorder) {
+			_recorder->recordRead(valid);
+		}
+		render(*inputs[0], pixels);
+	}
+	std::vector<JRBuffer> extras;
+	for (size_t i = 1; i < inputs.size(); i++) {
+		extras.push_back(renderInput(*inputs[i], valid));
+	}
+
+	std::vector<const float*> rows(extras.size());
+	for (int y = valid.y; y < valid.maxY(); y++) {
+		for (size_t i = 0; i < extras.size(); i++) {
+			rows[i] = extras[i].rowAt(y);
+		}
+		kernel.apply(pixels.rowAt(y), rows.data(), size_t(valid.width), image.arguments().data());
+	}
+}
+
+void JRRenderer::renderCompositeKernel(const JRImage& image, const JRBuffer& output)
+{
+	const JRCompositeKernel& kernel = static_cast<const JRCompositeKernel&>(*image.kernel());
+	const std::vector<JRImageRef>& inputs = image.inputs();
+	JRIRect valid = JRIRectIntersection(output.rect(), JRIRectFromRect(image.extent()));
+	if (valid.isEmpty()) {
+		output.clear();
+		return;
+	}
+	JRClearOutside(output, valid);
+	JRBuffer pixels = output.view(valid);
+	if (_recorder) {
+		_recorder->recordRead(valid);
+	}
+
+	/// 整个区域已经能确定结果时, 只渲染用到的那个输入
+	const size_t n = inputs.size();
+	std::vector<JRAlphaCoverage> known(n);
+	for (size_t i = 0; i < n; i++) {
+		known[i] = JRKnownCoverage(*inputs[i], valid);
+	}
+	int whole = kernel.shortcut(known.data());
+	if (whole == kJRCompositeShortcutClear) {
+		pixels.clear();
+		return;
+	}
+	if (whole >= 0) {
+		render(*inputs[size_t(whole)], pixels);
+		return;
+	}
+
+	/// 图像就地渲染到输出中, 然后按块统计每个输入的覆盖情况
+	render(*inputs[0], pixels);
+	const int columns = (valid.width + kJRCompositeBlock - 1) / kJRCompositeBlock;
+	const int rows = (valid.height + kJRCompositeBlock - 1) / kJRCompositeBlock;
+	std::vector<JRIRect> blocks;
+	std::vector<JRAlphaCoverage> coverage;
+	for (int by = 0; by < rows; by++) {
+		for (int bx = 0; bx < columns; bx++) {
+			JRIRect block = JRIRectIntersection(valid, { valid.x + bx * kJRCompositeBlock, valid.y + by * kJRCompositeBlock,
+														 kJRCompositeBlock, kJRCompositeBlock });
+			blocks.push_back(block);
+			coverage.push_back(known[0] == kJRAlphaPartial ? JRBufferAlphaCoverage(pixels, block) : known[0]);
+			for (size_t i = 1; i < n; i++) {
+				coverage.push_back(known[i] == kJRAlphaPartial ? JRKnownCoverage(*inputs[i], block) : known[i]);
+			}
+		}
+	}
+
+	/// 其余输入从后往前 (蒙版先于背景) 渲染, 只渲染仍需要它们的块的外接矩形.
+	/// 覆盖情况只会越来越确定, 已经有结果的块不再需要后面的输入
+	std::vector<JRBuffer> extras(n);
+	for (size_t i = n; i-- > 1;) {
+		JRIRect needed = { 0, 0, 0, 0 };
+		for (size_t k = 0; k < blocks.size(); k++) {
+			int s = kernel.shortcut(&coverage[k * n]);
+			if (s == kJRCompositeShortcutNone || s == int(i)) {
+				needed = needed.isEmpty() ? blocks[k] : JRIRectUnion(needed, blocks[k]);
+			}
+		}
+		if (needed.isEmpty()) {
+			continue;
+		}
+		extras[i] = renderInput(*inputs[i], needed);
+		for (size_t k = 0; k < blocks.size(); k++) {
+			if (coverage[k * n + i] == kJRAlphaPartial && needed.contains(blocks[k])) {
+				coverage[k * n + i] = JRBufferAlphaCoverage(extras[i], blocks[k]);
+			}
+		}
+	}
+
+	std::vector<const float*> spans(n > 1 ? n - 1 : 1);
+	for (size_t k = 0; k < blocks.size(); k++) {
+		const JRIRect& block = blocks[k];
+		int s = kernel.shortcut(&coverage[k * n]);
+		if (s == kJRCompositeShortcutClear) {
+			pixels.clear(block);
+		} else if (s > 0) {
+			pixels.view(block).copyFrom(extras[size_t(s)]);
+		} else if (s == kJRCompositeShortcutNone) {
+			for (int y = block.y; y < block.maxY(); y++) {
+				for (size_t i = 1; i < n; i++) {
+					spans[i - 1] = extras[i].pixelAt(block.x, y);
+				}
+				kernel.apply(pixels.pixelAt(block.x, y), spans.data(), size_t(block.width), image.arguments().data());
+			}
+		}
+	}
+}
+
+void JRRenderer::renderGeneralKernel(const JRImage& image, const JRBuffer& output)
+{
+	const JRGeneralKernel& kernel = static_cast<const JRGeneralKernel&>(*image.kernel());
+	JRIRect valid = JRIRectIntersection(output.rect(), JRIRectFromRect(image.extent()));
+	if (valid.isEmpty()) {
+		output.clear();
+		return;
+	}
+	JRClearOutside(output, valid);
+
+	std::vector<JRBuffer> inputs;
+	for (size_t i = 0; i < image.inputs().size(); i++) {
+		JRIRect roi = JRIRectFromRect(image.inputRegionOfInterest(i, JRRectFromIRect(valid)));
+		inputs.push_back(renderInput(*image.inputs()[i], roi));
+	}
+	kernel.apply(inputs, output.view(valid), image.arguments());
+}
@@ -0,0 +1,48 @@
+//
+//  jr_Renderer.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Renderer_h
+#define jr_Renderer_h
+
+#include "jr_Buffer.h"
+#include "jr_Image.h"
+#include "jr_Profiler.h"
+#include "jr_RenderPlan.h"
+
+/* Evaluates one output rect of an image graph. The request rect is pulled
+ * backwards through every node with inputRegionOfInterest, so each node only
+ * produces the pixels its consumer asked for. Internal to JRContext. */
+class JRRenderer {
+public:
+	/* Nodes materialised by 'plan' are copied from its buffers instead of
+	 * being evaluated. Every node evaluated is reported to 'recorder' when it
+	 * is not null. Renderers are cheap; use one per thread. */
+	explicit JRRenderer(const JRRenderPlan* plan = nullptr, JRProfileRecorder* recorder = nullptr);
+
+	/* Fills output.rect() of 'image' into 'output'. */
+	void render(const JRImage& image, const JRBuffer& output);
+
+private:
+	void renderNode(const JRImage& image, const JRBuffer& output);
+	void renderProvider(const JRImage& image, const JRBuffer& output);
+	void renderTransform(const JRImage& image, const JRBuffer& output);
+	void renderCrop(const JRImage& image, const JRBuffer& output);
+	void renderClamp(const JRImage& image, const JRBuffer& output);
+	void renderColorKernel(const JRImage& image, const JRBuffer& output);
+	/// 合成: 按块跳过被覆盖或为空的输入
+	void renderCompositeKernel(const JRImage& image, const JRBuffer& output);
+	void renderGeneralKernel(const JRImage& image, const JRBuffer& output);
+
+	/// 渲染 input 的 roi 到新的 buffer
+	JRBuffer renderInput(const JRImage& input, const JRIRect& roi);
+
+	const JRRenderPlan* _plan;
+	JRProfileRecorder* _recorder;
+};
+
+#endif /* jr_Renderer_h */
@@ -0,0 +1,54 @@
+//
+//  jr_SIMD.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_SIMD.h"
+
+#include <algorithm>
+#include <atomic>
+
+static std::atomic<int> JRSIMDMaximumLevel(kJRSIMDLevelAVX512);
+
+JRSIMDLevel JRSIMDSupportedLevel()
+{
+	static const JRSIMDLevel level = [] {
+#if defined(JR_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+		__builtin_cpu_init();
+		bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+		if (avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+			return kJRSIMDLevelAVX512;
+		}
+		return avx2 ? kJRSIMDLevelAVX2 : kJRSIMDLevelScalar;
+#elif defined(JR_SIMD_NEON)
+		return kJRSIMDLevelNEON;
+#else
+		return kJRSIMDLevelScalar;
+#endif
+	}();
+	return level;
+}
+
+JRSIMDLevel JRSIMDActiveLevel()
+{
+	return JRSIMDLevel(std::min(int(JRSIMDSupportedLevel()), JRSIMDMaximumLevel.load(std::memory_order_relaxed)));
+}
+
+void JRSIMDSetMaximumLevel(JRSIMDLevel level)
+{
+	JRSIMDMaximumLevel.store(level, std::memory_order_relaxed);
+}
+
+const char* JRSIMDLevelName(JRSIMDLevel level)
+{
+	switch (level) {
+		case kJRSIMDLevelScalar: return "scalar";
+		case kJRSIMDLevelNEON: return "NEON";
+		case kJRSIMDLevelAVX2: return "AVX2";
+		case kJRSIMDLevelAVX512: return "AVX-512";
+	}
+	return "unknown";
+}
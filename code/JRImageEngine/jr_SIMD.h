@@ -0,0 +1,43 @@
+//
+//  jr_SIMD.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_SIMD_h
+#define jr_SIMD_h
+
+/* Instruction sets the pixel kernels are compiled for. Every kernel has a
+ * scalar version; the others are picked at run time from what the CPU
+ * supports. */
+enum JRSIMDLevel {
+	kJRSIMDLevelScalar = 0,
+	kJRSIMDLevelNEON,
+	kJRSIMDLevelAVX2,
+	kJRSIMDLevelAVX512,
+};
+
+/* The best level this CPU supports. */
+JRSIMDLevel JRSIMDSupportedLevel();
+
+/* The level the kernels currently use: the supported level, lowered by
+ * JRSIMDSetMaximumLevel. */
+JRSIMDLevel JRSIMDActiveLevel();
+
+/* Caps the level used by the kernels, for benchmarks and for checking SIMD
+ * results against the scalar ones. Not meant to be changed while rendering. */
+void JRSIMDSetMaximumLevel(JRSIMDLevel level);
+
+const char* JRSIMDLevelName(JRSIMDLevel level);
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define JR_SIMD_X86 1
+#endif
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define JR_SIMD_NEON 1
+#endif
+
+#endif /* jr_SIMD_h */
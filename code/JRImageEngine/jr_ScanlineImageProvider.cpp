@@ -0,0 +1,86 @@
+//
+//  jr_ScanlineImageProvider.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_ScanlineImageProvider.h"
+
+#include <algorithm>
+#include <cstring>
+
+JRScanlineDecoder::~JRScanlineDecoder()
+{
+}
+
+JRScanlineImageProvider::JRScanlineImageProvider(std::unique_ptr<JRScanlineDecoder> decoder)
+: _decoder(std::move(decoder)), _top(0), _next(0), _failed(false), _rewinds(0)
+{
+	_rowBytes = size_t(_decoder->width()) * JRFormatBytesPerPixel(_decoder->format());
+}
+
+JRIRect JRScanlineImageProvider::extent() const
+{
+	return { 0, 0, _decoder->width(), _decoder->height() };
+}
+
+size_t JRScanlineImageProvider::rewinds() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _rewinds;
+}
+
+bool JRScanlineImageProvider::skipRows(int y) const
+{
+	const int kChunk = 16;
+	std::vector<uint8_t> scratch(_rowBytes * size_t(std::min(kChunk, y - _next)));
+	while (_next < y) {
+		int count = std::min(kChunk, y - _next);
+		if (!_decoder->readRows(scratch.data(), _rowBytes, count)) {
+			return false;
+		}
+		_next += count;
+	}
+	return true;
+}
+
+void JRScanlineImageProvider::read(const JRIRect& rect, const JRBuffer& output) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (rect.y < _top) {
+		_failed = !_decoder->rewind();
+		_window.clear();
+		_top = 0;
+		_next = 0;
+		_rewinds++;
+	}
+
+	/// 丢掉 rect 上方的行, 窗口为空时跳到 rect.y
+	int drop = std::min(rect.y, _next) - _top;
+	_window.erase(_window.begin(), _window.begin() + ptrdiff_t(size_t(drop) * _rowBytes));
+	_top += drop;
+	if (!_failed && _next < rect.y) {
+		_failed = !skipRows(rect.y);
+		_top = _next;
+	}
+	if (!_failed && _next < rect.maxY()) {
+		int count = rect.maxY() - _next;
+		size_t size = _window.size();
+		_window.resize(size + size_t(count) * _rowBytes);
+		_failed = !_decoder->readRows(_window.data() + size, _rowBytes, count);
+		_next += count;
+	}
+	if (_failed) {
+		output.clear(rect);
+		return;
+	}
+
+	JRFormat format = _decoder->format();
+	size_t bpp = JRFormatBytesPerPixel(format);
+	for (int y = rect.y; y < rect.maxY(); y++) {
+		const uint8_t* row = _window.data() + size_t(y - _top) * _rowBytes + size_t(rect.x) * bpp;
+		JRFormatUnpackRow(format, row, output.rowAt(y), size_t(rect.width));
+	}
+}
@@ -0,0 +1,66 @@
+//
+//  jr_ScanlineImageProvider.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_ScanlineImageProvider_h
+#define jr_ScanlineImageProvider_h
+
+#include "jr_Image.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* A decoder that can only produce rows in order, from y = 0 down, like a
+ * PNG or JPEG stream. Implementations do not need to be thread-safe. */
+class JRScanlineDecoder {
+public:
+	virtual ~JRScanlineDecoder();
+
+	virtual int width() const = 0;
+	virtual int height() const = 0;
+	virtual JRFormat format() const = 0;
+
+	/* Decodes the next 'count' rows into 'rows', 'rowBytes' apart. Returns
+	 * false if the stream ended early or is corrupt. */
+	virtual bool readRows(void* rows, size_t rowBytes, int count) = 0;
+	/* Goes back to row 0. Returns false if the stream cannot seek. */
+	virtual bool rewind() = 0;
+};
+
+/* Feeds a JRScanlineDecoder to the engine. Only the rows of the last read
+ * are kept, so memory stays at one band when the image is rendered with
+ * JRContext::renderBands(). A read above those rows rewinds the decoder and
+ * decodes from the top again, which is correct but slow; graphs that move
+ * rows upwards (flips, rotations) cause it. */
+class JRScanlineImageProvider : public JRImageProvider {
+public:
+	explicit JRScanlineImageProvider(std::unique_ptr<JRScanlineDecoder> decoder);
+
+	JRIRect extent() const override;
+	void read(const JRIRect& rect, const JRBuffer& output) const override;
+
+	/* How many times the decoder went back to row 0. */
+	size_t rewinds() const;
+
+private:
+	/// 解码 [_next, y), 丢弃结果
+	bool skipRows(int y) const;
+
+	std::unique_ptr<JRScanlineDecoder> _decoder;
+	size_t _rowBytes;
+	mutable std::mutex _mutex;
+	/// 已解码的行 [_top, _next), 解码器停在 _next
+	mutable std::vector<uint8_t> _window;
+	mutable int _top;
+	mutable int _next;
+	mutable bool _failed;
+	mutable size_t _rewinds;
+};
+
+#endif /* jr_ScanlineImageProvider_h */
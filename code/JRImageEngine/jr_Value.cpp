@@ -0,0 +1,83 @@
+//
+//  jr_Value.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_Value.h"
+
+bool JRValueGetDouble(const JRValue& value, double* out)
+{
+	if (const double* d = std::get_if<double>(&value)) {
+		*out = *d;
+		return true;
+	}
+	if (const JRVector* v = std::get_if<JRVector>(&value)) {
+		if (v->count == 1) {
+			*out = v->x;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JRValueGetVector(const JRValue& value, JRVector* out)
+{
+	if (const JRVector* v = std::get_if<JRVector>(&value)) {
+		*out = *v;
+		return true;
+	}
+	if (const JRRect* r = std::get_if<JRRect>(&value)) {
+		*out = JRVector::vectorWithRect(*r);
+		return true;
+	}
+	return false;
+}
+
+bool JRValueGetColor(const JRValue& value, JRColor* out)
+{
+	if (const JRColor* c = std::get_if<JRColor>(&value)) {
+		*out = *c;
+		return true;
+	}
+	if (const JRVector* v = std::get_if<JRVector>(&value)) {
+		*out = JRColor::colorWithRed(float(v->x), float(v->y), float(v->z), v->count == 4 ? float(v->w) : 1.0f);
+		return true;
+	}
+	return false;
+}
+
+bool JRValueGetTransform(const JRValue& value, JRAffineTransform* out)
+{
+	if (const JRAffineTransform* t = std::get_if<JRAffineTransform>(&value)) {
+		*out = *t;
+		return true;
+	}
+	return false;
+}
+
+bool JRValueGetRect(const JRValue& value, JRRect* out)
+{
+	if (const JRRect* r = std::get_if<JRRect>(&value)) {
+		*out = *r;
+		return true;
+	}
+	/// CICrop 的 inputRectangle 是一个 CIVector
+	if (const JRVector* v = std::get_if<JRVector>(&value)) {
+		if (v->count == 4) {
+			*out = JRRectMake(v->x, v->y, v->z, v->w);
+			return true;
+		}
+	}
+	return false;
+}
+
+JRImageRef JRValueGetImage(const JRValue& value)
+{
+	if (const JRImageRef* image = std::get_if<JRImageRef>(&value)) {
+		return *image;
+	}
+	return nullptr;
+}
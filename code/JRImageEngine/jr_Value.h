@@ -0,0 +1,53 @@
+//
+//  jr_Value.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_Value_h
+#define jr_Value_h
+
+#include "jr_Color.h"
+#include "jr_Geometry.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <variant>
+
+class JRImage;
+typedef std::shared_ptr<const JRImage> JRImageRef;
+
+/* Up to four components, the counterpart of CIVector. */
+struct JRVector {
+	double x;
+	double y;
+	double z;
+	double w;
+	int count;
+
+	static JRVector vectorWithX(double x) { return { x, 0, 0, 0, 1 }; }
+	static JRVector vectorWithXY(double x, double y) { return { x, y, 0, 0, 2 }; }
+	static JRVector vectorWithXYZW(double x, double y, double z, double w) { return { x, y, z, w, 4 }; }
+	static JRVector vectorWithRect(const JRRect& r) { return { r.x, r.y, r.width, r.height, 4 }; }
+
+	double valueAtIndex(int index) const { return index == 0 ? x : index == 1 ? y : index == 2 ? z : w; }
+};
+
+/* A filter parameter value, the counterpart of the 'Any' in [String : Any]. */
+typedef std::variant<std::monostate, double, JRVector, JRColor, JRAffineTransform, JRRect, JRImageRef, std::string> JRValue;
+
+/* Filter parameters keyed by input name, as passed to applyingFilter. */
+typedef std::map<std::string, JRValue> JRFilterParameters;
+
+/// 取值, 类型不匹配时返回 false
+bool JRValueGetDouble(const JRValue& value, double* out);
+bool JRValueGetVector(const JRValue& value, JRVector* out);
+bool JRValueGetColor(const JRValue& value, JRColor* out);
+bool JRValueGetTransform(const JRValue& value, JRAffineTransform* out);
+bool JRValueGetRect(const JRValue& value, JRRect* out);
+JRImageRef JRValueGetImage(const JRValue& value);
+
+#endif /* jr_Value_h */
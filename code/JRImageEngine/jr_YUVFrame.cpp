@@ -0,0 +1,239 @@
+//
+//  jr_YUVFrame.cpp
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#include "jr_YUVFrame.h"
+#include "jr_GaussianBlur.h"
+#include "jr_Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+
+/// 每个任务处理的行数
+static const size_t kJRYUVRowBlock = 16;
+
+/// 亮度的 R, B 权重 (Kr, Kb)
+static void JRYUVMatrixWeights(JRYUVMatrix matrix, double* kr, double* kb)
+{
+	if (matrix == kJRYUVMatrixBT601) {
+		*kr = 0.299;
+		*kb = 0.114;
+	} else {
+		*kr = 0.2126;
+		*kb = 0.0722;
+	}
+}
+
+static std::shared_ptr<uint8_t> JRAllocatePlane(size_t bytes)
+{
+	return std::shared_ptr<uint8_t>(new uint8_t[bytes], std::default_delete<uint8_t[]>());
+}
+
+/// 第 index 个平面的宽度 (样本数) 和每个像素的字节数
+static void JRPlaneGeometry(JRYUVLayout layout, int width, int height, size_t index, int* planeWidth, int* planeHeight, int* channels)
+{
+	*planeWidth = index == 0 ? width : (width + 1) / 2;
+	*planeHeight = index == 0 ? height : (height + 1) / 2;
+	*channels = index == 1 && layout == kJRYUVLayoutNV12 ? 2 : 1;
+}
+
+// MARK: - JRYUVFrame
+
+JRYUVFrame::JRYUVFrame(JRYUVLayout layout, int width, int height, std::vector<JRYUVPlane> planes, JRYUVMatrix matrix, bool fullRange)
+: _layout(layout), _width(width), _height(height), _planes(std::move(planes)), _matrix(matrix), _fullRange(fullRange)
+{
+}
+
+JRYUVFrameRef JRYUVFrame::frameWithPlanes(JRYUVLayout layout, int width, int height, std::vector<JRYUVPlane> planes,
+										  JRYUVMatrix matrix, bool fullRange)
+{
+	size_t count = layout == kJRYUVLayoutNV12 ? 2 : 3;
+	if (width <= 0 || height <= 0 || planes.size() != count) {
+		return nullptr;
+	}
+	for (size_t i = 0; i < count; i++) {
+		int w, h, channels;
+		JRPlaneGeometry(layout, width, height, i, &w, &h, &channels);
+		if (!planes[i].bytes || planes[i].bytesPerRow < size_t(w) * size_t(channels)) {
+			return nullptr;
+		}
+	}
+	return JRYUVFrameRef(new JRYUVFrame(layout, width, height, std::move(planes), matrix, fullRange));
+}
+
+JRYUVFrameRef JRYUVFrame::frameWithPlanes(std::vector<JRYUVPlane> planes) const
+{
+	return JRYUVFrameRef(new JRYUVFrame(_layout, _width, _height, std::move(planes), _matrix, _fullRange));
+}
+
+JRYUVFrameRef JRYUVFrame::applyingGaussianBlur(double sigma) const
+{
+	std::vector<JRYUVPlane> planes;
+	for (size_t i = 0; i < _planes.size(); i++) {
+		int w, h, channels;
+		JRPlaneGeometry(_layout, _width, _height, i, &w, &h, &channels);
+		size_t bytesPerRow = size_t(w) * size_t(channels);
+		std::shared_ptr<uint8_t> bytes = JRAllocatePlane(bytesPerRow * size_t(h));
+		JRGaussianBlurPlane(_planes[i].bytes.get(), _planes[i].bytesPerRow, bytes.get(), bytesPerRow,
+							w, h, channels, i == 0 ? sigma : sigma / 2);
+		planes.push_back({ bytes, bytesPerRow });
+	}
+	return frameWithPlanes(std::move(planes));
+}
+
+JRYUVFrameRef JRYUVFrame::sharpeningLuminance(double sharpness, double radius) const
+{
+	const JRYUVPlane& luma = _planes[0];
+	size_t bytesPerRow = size_t(_width);
+	std::shared_ptr<uint8_t> bytes = JRAllocatePlane(bytesPerRow * size_t(_height));
+	/// 先把模糊结果写进输出平面, 再逐行换成 Y + s * (Y - blur)
+	JRGaussianBlurPlane(luma.bytes.get(), luma.bytesPerRow, bytes.get(), bytesPerRow, _width, _height, 1, radius);
+	const float amount = float(sharpness);
+	JRParallelFor(size_t(_height), kJRYUVRowBlock, [&](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; y++) {
+			const uint8_t* s = luma.bytes.get() + y * luma.bytesPerRow;
+			uint8_t* d = bytes.get() + y * bytesPerRow;
+			for (int x = 0; x < _width; x++) {
+				float v = float(s[x]) + amount * (float(s[x]) - float(d[x])) + 0.5f;
+				d[x] = uint8_t(v <= 0 ? 0 : v >= 255 ? 255 : v);
+			}
+		}
+	});
+	std::vector<JRYUVPlane> planes = _planes;
+	planes[0] = { bytes, bytesPerRow };
+	return frameWithPlanes(std::move(planes));
+}
+
+JRYUVFrameRef JRYUVFrame::applyingLuminanceCurve(const std::vector<JRVector>& points) const
+{
+	if (points.size() < 2) {
+		return nullptr;
+	}
+	/// 曲线在归一化的亮度上定义, 视频范围要先换算到 [0, 1]
+	const double lo = _fullRange ? 0 : 16, scale = _fullRange ? 255 : 219;
+	uint8_t table[256];
+	for (int i = 0; i < 256; i++) {
+		double x = std::min(std::max((i - lo) / scale, 0.0), 1.0);
+		size_t k = 1;
+		while (k + 1 < points.size() && points[k].x < x) {
+			k++;
+		}
+		const JRVector& a = points[k - 1];
+		const JRVector& b = points[k];
+		double t = b.x > a.x ? std::min(std::max((x - a.x) / (b.x - a.x), 0.0), 1.0) : 1.0;
+		double v = (a.y + (b.y - a.y) * t) * scale + lo;
+		table[i] = uint8_t(std::min(std::max(v + 0.5, 0.0), 255.0));
+	}
+
+	const JRYUVPlane& luma = _planes[0];
+	size_t bytesPerRow = size_t(_width);
+	std::shared_ptr<uint8_t> bytes = JRAllocatePlane(bytesPerRow * size_t(_height));
+	JRParallelFor(size_t(_height), kJRYUVRowBlock, [&](size_t begin, size_t end) {
+		for (size_t y = begin; y < end; y++) {
+			const uint8_t* s = luma.bytes.get() + y * luma.bytesPerRow;
+			uint8_t* d = bytes.get() + y * bytesPerRow;
+			for (int x = 0; x < _width; x++) {
+				d[x] = table[s[x]];
+			}
+		}
+	});
+	std::vector<JRYUVPlane> planes = _planes;
+	planes[0] = { bytes, bytesPerRow };
+	return frameWithPlanes(std::move(planes));
+}
+
+// MARK: - JRYUVImageProvider
+
+JRYUVImageProvider::JRYUVImageProvider(const JRYUVFrameRef& frame)
+: _frame(frame)
+{
+	double kr, kb;
+	JRYUVMatrixWeights(frame->matrix(), &kr, &kb);
+	double kg = 1 - kr - kb;
+	double lumaOffset = frame->fullRange() ? 0 : 16, lumaScale = frame->fullRange() ? 255 : 219;
+	double chromaScale = frame->fullRange() ? 255 : 224;
+	for (int i = 0; i < 256; i++) {
+		double c = (i - 128) / chromaScale;
+		_luma[i] = float((i - lumaOffset) / lumaScale);
+		_crToR[i] = float(2 * (1 - kr) * c);
+		_cbToG[i] = float(-2 * kb * (1 - kb) / kg * c);
+		_crToG[i] = float(-2 * kr * (1 - kr) / kg * c);
+		_cbToB[i] = float(2 * (1 - kb) * c);
+	}
+}
+
+JRIRect JRYUVImageProvider::extent() const
+{
+	return { 0, 0, _frame->width(), _frame->height() };
+}
+
+void JRYUVImageProvider::read(const JRIRect& rect, const JRBuffer& output) const
+{
+	const std::vector<JRYUVPlane>& planes = _frame->planes();
+	const bool interleaved = _frame->layout() == kJRYUVLayoutNV12;
+	for (int y = rect.y; y < rect.maxY(); y++) {
+		const uint8_t* luma = planes[0].bytes.get() + size_t(y) * planes[0].bytesPerRow;
+		size_t chromaRow = size_t(y / 2);
+		const uint8_t* cb = planes[1].bytes.get() + chromaRow * planes[1].bytesPerRow;
+		const uint8_t* cr = interleaved ? cb + 1 : planes[2].bytes.get() + chromaRow * planes[2].bytesPerRow;
+		const size_t step = interleaved ? 2 : 1;
+		float* p = output.rowAt(y);
+		for (int x = rect.x; x < rect.maxX(); x++, p += 4) {
+			size_t c = size_t(x / 2) * step;
+			float l = _luma[luma[x]];
+			p[0] = l + _crToR[cr[c]];
+			p[1] = l + _cbToG[cb[c]] + _crToG[cr[c]];
+			p[2] = l + _cbToB[cb[c]];
+			p[3] = 1.0f;
+		}
+	}
+}
+
+// MARK: - Encoding
+
+void JRYUVEncodeRows(const float* rows, size_t rowBytes, int width, int height, JRYUVMatrix matrix, bool fullRange,
+					 uint8_t* luma, size_t lumaRowBytes, uint8_t* cb, uint8_t* cr, size_t chromaRowBytes, size_t chromaStep)
+{
+	double kr, kb;
+	JRYUVMatrixWeights(matrix, &kr, &kb);
+	const float wr = float(kr), wb = float(kb), wg = float(1 - kr - kb);
+	const float cbScale = float(1 / (2 * (1 - kb))), crScale = float(1 / (2 * (1 - kr)));
+	const float lumaOffset = fullRange ? 0.0f : 16.0f, lumaScale = fullRange ? 255.0f : 219.0f;
+	const float chromaScale = fullRange ? 255.0f : 224.0f;
+	auto store = [](float v) { v += 0.5f; return uint8_t(v <= 0 ? 0 : v >= 255 ? 255 : v); };
+
+	for (int y = 0; y < height; y += 2) {
+		const float* top = (const float*)((const uint8_t*)rows + size_t(y) * rowBytes);
+		const float* bottom = y + 1 < height ? (const float*)((const uint8_t*)top + rowBytes) : top;
+		uint8_t* l0 = luma + size_t(y) * lumaRowBytes;
+		uint8_t* l1 = y + 1 < height ? l0 + lumaRowBytes : nullptr;
+		uint8_t* b = cb + size_t(y / 2) * chromaRowBytes;
+		uint8_t* c = cr + size_t(y / 2) * chromaRowBytes;
+		for (int x = 0; x < width; x += 2, b += chromaStep, c += chromaStep) {
+			/// 2 x 2 块的 RGB 平均值决定色度
+			float sr = 0, sg = 0, sb = 0;
+			int n = 0;
+			for (int dy = 0; dy < 2; dy++) {
+				const float* row = dy ? bottom : top;
+				uint8_t* out = dy ? l1 : l0;
+				for (int dx = 0; dx < 2 && x + dx < width; dx++, n++) {
+					const float* p = row + size_t(x + dx) * 4;
+					if (out) {
+						out[x + dx] = store((wr * p[0] + wg * p[1] + wb * p[2]) * lumaScale + lumaOffset);
+					}
+					sr += p[0];
+					sg += p[1];
+					sb += p[2];
+				}
+			}
+			float inv = 1.0f / float(n);
+			float yAverage = (wr * sr + wg * sg + wb * sb) * inv;
+			*b = store((sb * inv - yAverage) * cbScale * chromaScale + 128.0f);
+			*c = store((sr * inv - yAverage) * crScale * chromaScale + 128.0f);
+		}
+	}
+}
@@ -0,0 +1,127 @@
+//
+//  jr_YUVFrame.h
+//  JRImageEngine
+//
+//  Created by 王潇 on 2026/10/16.
+//  Copyright © 2026年 王潇. All rights reserved.
+//
+
+#ifndef jr_YUVFrame_h
+#define jr_YUVFrame_h
+
+#include "jr_Image.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/* Plane layouts of 8-bit 4:2:0 frames, as decoders and cameras deliver them
+ * (kCVPixelFormatType_420YpCbCr8BiPlanar* and *Planar). */
+enum JRYUVLayout {
+	/// Y, 然后是交错的 CbCr
+	kJRYUVLayoutNV12 = 0,
+	/// Y, Cb, Cr 三个平面
+	kJRYUVLayoutI420,
+};
+
+enum JRYUVMatrix {
+	kJRYUVMatrixBT601 = 0,
+	kJRYUVMatrixBT709,
+};
+
+/* One plane: 'bytes' owns the memory, which holds the plane's rows
+ * 'bytesPerRow' apart. */
+struct JRYUVPlane {
+	std::shared_ptr<const uint8_t> bytes;
+	size_t bytesPerRow;
+};
+
+class JRYUVFrame;
+typedef std::shared_ptr<const JRYUVFrame> JRYUVFrameRef;
+
+/* An immutable 8-bit 4:2:0 frame. Chroma planes are (width + 1) / 2 x
+ * (height + 1) / 2 samples, one per 2 x 2 block of luma.
+ *
+ * The filters below run on the planes themselves and return a new frame,
+ * so a transcode that only blurs, sharpens or grades luma never expands to
+ * RGBA: luma runs at full resolution, chroma at a quarter, 1.5 bytes per
+ * pixel in total against 4 for RGBA8. Planes a filter does not change are
+ * shared with the new frame, not copied. For anything else, wrap the frame
+ * with JRImage::imageWithYUVFrame and render back with
+ * JRContext::createYUVFrame. */
+class JRYUVFrame {
+public:
+	/* 'planes' is { Y, CbCr } for NV12 and { Y, Cb, Cr } for I420. The memory
+	 * is not copied. Returns nullptr if a plane is missing or its rows are
+	 * too short. */
+	static JRYUVFrameRef frameWithPlanes(JRYUVLayout layout, int width, int height, std::vector<JRYUVPlane> planes,
+										 JRYUVMatrix matrix = kJRYUVMatrixBT709, bool fullRange = false);
+
+	JRYUVLayout layout() const { return _layout; }
+	int width() const { return _width; }
+	int height() const { return _height; }
+	int chromaWidth() const { return (_width + 1) / 2; }
+	int chromaHeight() const { return (_height + 1) / 2; }
+	JRYUVMatrix matrix() const { return _matrix; }
+	/* Whether samples use 0-255, rather than 16-235 for Y and 16-240 for
+	 * chroma. */
+	bool fullRange() const { return _fullRange; }
+	const std::vector<JRYUVPlane>& planes() const { return _planes; }
+
+	/* Blurs luma by 'sigma' and chroma by sigma / 2, which is the same
+	 * distance at chroma resolution. Edges repeat rather than fade. */
+	JRYUVFrameRef applyingGaussianBlur(double sigma) const;
+	/* Unsharp mask on luma only, like CISharpenLuminance: Y + sharpness *
+	 * (Y - blur(Y, radius)). Chroma is shared. */
+	JRYUVFrameRef sharpeningLuminance(double sharpness = 0.4, double radius = 1.69) const;
+	/* Maps luma through the curve with straight segments between 'points'
+	 * (x, y in [0, 1], x increasing), like the luma of CIToneCurve. Chroma
+	 * is shared. Returns nullptr for fewer than two points. */
+	JRYUVFrameRef applyingLuminanceCurve(const std::vector<JRVector>& points) const;
+
+private:
+	JRYUVFrame(JRYUVLayout layout, int width, int height, std::vector<JRYUVPlane> planes, JRYUVMatrix matrix, bool fullRange);
+	JRYUVFrameRef frameWithPlanes(std::vector<JRYUVPlane> planes) const;
+
+	JRYUVLayout _layout;
+	int _width;
+	int _height;
+	std::vector<JRYUVPlane> _planes;
+	JRYUVMatrix _matrix;
+	bool _fullRange;
+};
+
+/* Converts tiles of a JRYUVFrame straight into the working format, so the
+ * frame is never expanded to RGBA as a whole: a tile reads its luma rows and
+ * the chroma rows under them and writes RGBA once, and the first kernel then
+ * runs on that tile in place. Lookup tables hold each sample's contribution
+ * to R, G and B. Chroma is replicated over its 2 x 2 block. The output is
+ * opaque and, like the frame, gamma encoded: use matchedToWorkingSpace for
+ * linear filtering. */
+class JRYUVImageProvider : public JRImageProvider {
+public:
+	explicit JRYUVImageProvider(const JRYUVFrameRef& frame);
+
+	const JRYUVFrameRef& frame() const { return _frame; }
+
+	JRIRect extent() const override;
+	void read(const JRIRect& rect, const JRBuffer& output) const override;
+
+private:
+	JRYUVFrameRef _frame;
+	float _luma[256];
+	float _crToR[256];
+	float _cbToG[256];
+	float _crToG[256];
+	float _cbToB[256];
+};
+
+/* Writes 'height' rows of premultiplied float RGBA, 'rowBytes' apart, to
+ * 8-bit planes, for JRContext::createYUVFrame. 'height' is even except for
+ * the last rows of a frame. Each chroma sample comes from the average RGB of
+ * its 2 x 2 block; 'chromaStep' is 2 for interleaved CbCr and 1 otherwise. */
+void JRYUVEncodeRows(const float* rows, size_t rowBytes, int width, int height, JRYUVMatrix matrix, bool fullRange,
+					 uint8_t* luma, size_t lumaRowBytes, uint8_t* cb, uint8_t* cr, size_t chromaRowBytes, size_t chromaStep);
+
+#endif /* jr_YUVFrame_h */